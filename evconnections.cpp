@@ -253,7 +253,9 @@ int process_events(const char* infilename,
     // Open output file.
     int fd;
     if ((fd = open(outfilename, O_CREAT | O_TRUNC | O_WRONLY, 0644)) != -1) {
+      // The events are written sorted, without blocks (version 1).
       net::mon::event::file::header header;
+      header.version = 1;
       header.timestamp.first = ULLONG_MAX;
       header.timestamp.last = 0;
 
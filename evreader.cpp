@@ -503,12 +503,14 @@ void usage(const char* program)
   fprintf(stderr, "\n");
 
   fprintf(stderr,
-          "    <event-type> ::= \"icmp\"      |\n"
-          "                     \"udp\"       |\n"
-          "                     \"dns\"       |\n"
-          "                     \"tcp-begin\" |\n"
-          "                     \"tcp-data\"  |\n"
-          "                     \"tcp-end\"\n");
+          "    <event-type> ::= \"icmp\"          |\n"
+          "                     \"udp\"           |\n"
+          "                     \"dns\"           |\n"
+          "                     \"tcp-begin\"     |\n"
+          "                     \"tcp-data\"      |\n"
+          "                     \"tcp-end\"       |\n"
+          "                     \"tcp-half-open\" |\n"
+          "                     \"tcp-update\"\n");
 
   fprintf(stderr, "\n");
 
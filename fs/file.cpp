@@ -1,6 +1,80 @@
+#include <string.h>
 #include <errno.h>
 #include "fs/file.h"
 
+bool fs::file::open(const char* filename)
+{
+  if ((_M_fd = ::open(filename, O_CREAT | O_RDWR, 0644)) != -1) {
+    // Get filesize.
+    off_t filesize;
+    if ((filesize = lseek(_M_fd, 0, SEEK_END)) != -1) {
+      // Save filesize.
+      _M_size = filesize;
+      _M_used = filesize;
+
+      if (reserve(_M_allocation_size)) {
+        // If the data is not appended with direct I/O...
+        if (!_M_direct) {
+          return true;
+        }
+
+        // The direct I/O starts at the last (partial) block of the file,
+        // which is loaded into the buffer.
+        _M_direct_offset = _M_used - (_M_used % direct_alignment);
+
+        size_t len = _M_used - _M_direct_offset;
+
+        _M_direct_buf.clear();
+
+        if ((_M_direct_buf.allocate_aligned(direct_buffer_size,
+                                            direct_alignment)) &&
+            (read_all(_M_fd,
+                      _M_direct_buf.data(),
+                      len,
+                      _M_direct_offset) == static_cast<ssize_t>(len)) &&
+            ((_M_direct_fd = ::open(filename, O_WRONLY | O_DIRECT)) != -1)) {
+          _M_direct_buf.increment_length(len);
+          return true;
+        }
+      }
+    }
+
+    ::close(_M_fd);
+    _M_fd = -1;
+  }
+
+  return false;
+}
+
+bool fs::file::close()
+{
+  if (_M_fd != -1) {
+    bool ret = true;
+
+    // If the data is appended with direct I/O...
+    if (_M_direct_fd != -1) {
+      // Write the last block.
+      ret = direct_flush(true);
+
+      ::close(_M_direct_fd);
+      _M_direct_fd = -1;
+    }
+
+    // Truncate the file at the end of the data (this also releases the
+    // space allocated after it).
+    if (ftruncate(_M_fd, _M_used) != 0) {
+      ret = false;
+    }
+
+    ::close(_M_fd);
+    _M_fd = -1;
+
+    return ret;
+  }
+
+  return true;
+}
+
 ssize_t fs::file::pread(void* buf, size_t count, uint64_t off)
 {
   uint64_t end;
@@ -8,36 +82,32 @@ ssize_t fs::file::pread(void* buf, size_t count, uint64_t off)
     // If the offset is not beyond the end of the file...
     if (off < _M_used) {
       if (end > _M_used) {
+        end = _M_used;
         count = _M_used - off;
       }
 
-      uint8_t* b = static_cast<uint8_t*>(buf);
-      size_t read = 0;
-
-      do {
-        ssize_t ret;
-        switch (ret = ::pread(_M_fd, b, count, off)) {
-          default:
-            read += ret;
+      // If the data is appended with direct I/O and the end of the range
+      // has not been written yet...
+      if ((_M_direct_fd != -1) && (end > _M_direct_offset)) {
+        uint64_t from = (off > _M_direct_offset) ? off : _M_direct_offset;
 
-            if ((count -= ret) == 0) {
-              return read;
-            }
+        // Copy the data from the direct I/O buffer.
+        memcpy(static_cast<uint8_t*>(buf) + (from - off),
+               _M_direct_buf.data() + (from - _M_direct_offset),
+               end - from);
 
-            b += ret;
-            off += ret;
+        // If the beginning of the range is in the file...
+        if (from > off) {
+          ssize_t ret = read_all(_M_fd, buf, from - off, off);
+          if (ret != static_cast<ssize_t>(from - off)) {
+            return ret;
+          }
+        }
 
-            break;
-          case 0:
-            return read;
-          case -1:
-            if (errno != EINTR) {
-              return (read > 0) ? read : -1;
-            }
+        return count;
+      }
 
-            break;
-        }
-      } while (true);
+      return read_all(_M_fd, buf, count, off);
     } else if (off == _M_used) {
       return 0;
     }
@@ -50,55 +120,237 @@ bool fs::file::pwrite(const void* buf, size_t count, uint64_t off)
 {
   uint64_t end;
   if ((end = off + count) >= off) {
-    // If the file has to be extended...
-    if (end > _M_size) {
-      uint64_t size = _M_allocation_size;
-      uint64_t diff = end - _M_size;
-
-      while (size < diff) {
-        uint64_t tmp;
-        if ((tmp = size + _M_allocation_size) > size) {
-          size = tmp;
-        } else {
-          // Overflow.
+    // If the data is appended with direct I/O...
+    if (_M_direct_fd != -1) {
+      // Append?
+      if (off == _M_used) {
+        return direct_write(buf, count);
+      } else if (end > _M_used) {
+        return false;
+      }
+
+      const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+      // The data before the direct I/O buffer is written through the page
+      // cache.
+      if (off < _M_direct_offset) {
+        size_t n = (end < _M_direct_offset) ? count : _M_direct_offset - off;
+
+        if (!write_all(_M_fd, b, n, off)) {
           return false;
         }
+
+        b += n;
+        off += n;
+        count -= n;
       }
 
-      if (!reserve(size)) {
-        return false;
+      // The rest is written to the direct I/O buffer.
+      if (count > 0) {
+        memcpy(_M_direct_buf.data() + (off - _M_direct_offset), b, count);
       }
+
+      return true;
     }
 
-    const uint8_t* b = static_cast<const uint8_t*>(buf);
+    if ((extend(end)) && (write_all(_M_fd, buf, count, off))) {
+      if (end > _M_used) {
+        _M_used = end;
+      }
 
-    do {
-      ssize_t ret;
-      switch (ret = ::pwrite(_M_fd, b, count, off)) {
-        default:
-          if ((count -= ret) == 0) {
-            if (end > _M_used) {
-              _M_used = end;
-            }
+      return true;
+    }
+  }
 
-            return true;
-          }
+  return false;
+}
 
-          b += ret;
-          off += ret;
+bool fs::file::reserve(uint64_t count)
+{
+  if (count == 0) {
+    return true;
+  }
 
-          break;
-        case 0:
-          return (count == 0);
-        case -1:
-          if (errno != EINTR) {
-            return false;
-          }
+  uint64_t size;
+  if ((size = _M_size + count) >= _M_size) {
+    if (_M_fallocate) {
+      // Allocate the space without changing the filesize.
+      if (fallocate(_M_fd,
+                    FALLOC_FL_KEEP_SIZE,
+                    static_cast<off_t>(_M_size),
+                    static_cast<off_t>(count)) == 0) {
+        _M_size = size;
+        return true;
+      }
+
+      // If the error is not caused by the filesystem not supporting
+      // fallocate()...
+      if ((errno != EOPNOTSUPP) && (errno != ENOSYS)) {
+        return false;
+      }
+
+      // Fall back to ftruncate() (sparse file).
+      _M_fallocate = false;
+    }
+
+    if (ftruncate(_M_fd, size) == 0) {
+      _M_size = size;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool fs::file::extend(uint64_t end)
+{
+  // If the file has to be extended...
+  if (end > _M_size) {
+    uint64_t size = _M_allocation_size;
+    uint64_t diff = end - _M_size;
 
-          break;
+    while (size < diff) {
+      uint64_t tmp;
+      if ((tmp = size + _M_allocation_size) > size) {
+        size = tmp;
+      } else {
+        // Overflow.
+        return false;
       }
-    } while (true);
+    }
+
+    return reserve(size);
+  }
+
+  return true;
+}
+
+bool fs::file::direct_write(const void* buf, size_t count)
+{
+  const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+  while (count > 0) {
+    size_t n = direct_buffer_size - _M_direct_buf.length();
+    if (n > count) {
+      n = count;
+    }
+
+    memcpy(_M_direct_buf.end(), b, n);
+    _M_direct_buf.increment_length(n);
+
+    _M_used += n;
+
+    b += n;
+    count -= n;
+
+    // If the buffer is full...
+    if ((_M_direct_buf.length() == direct_buffer_size) &&
+        (!direct_flush(false))) {
+      return false;
+    }
+  }
+
+  // Write the complete blocks.
+  return direct_flush(false);
+}
+
+bool fs::file::direct_flush(bool tail)
+{
+  char* data = _M_direct_buf.data();
+  size_t len = _M_direct_buf.length();
+
+  // Complete blocks.
+  size_t n = len & ~(direct_alignment - 1);
+
+  if ((tail) && (n < len)) {
+    // Pad the last block with zeros (the file is truncated when it is
+    // closed).
+    n = (len + direct_alignment - 1) & ~(direct_alignment - 1);
+    memset(data + len, 0, n - len);
+  }
+
+  if (n == 0) {
+    return true;
+  }
+
+  if ((extend(_M_direct_offset + n)) &&
+      (write_all(_M_direct_fd, data, n, _M_direct_offset))) {
+    if (!tail) {
+      // Move the partial block (if any) to the beginning of the buffer.
+      len -= n;
+      memmove(data, data + n, len);
+
+      _M_direct_buf.clear();
+      _M_direct_buf.increment_length(len);
+
+      _M_direct_offset += n;
+    }
+
+    return true;
   }
 
   return false;
 }
+
+ssize_t fs::file::read_all(int fd, void* buf, size_t count, uint64_t off)
+{
+  uint8_t* b = static_cast<uint8_t*>(buf);
+  size_t read = 0;
+
+  do {
+    ssize_t ret;
+    switch (ret = ::pread(fd, b, count, off)) {
+      default:
+        read += ret;
+
+        if ((count -= ret) == 0) {
+          return read;
+        }
+
+        b += ret;
+        off += ret;
+
+        break;
+      case 0:
+        return read;
+      case -1:
+        if (errno != EINTR) {
+          return (read > 0) ? read : -1;
+        }
+
+        break;
+    }
+  } while (true);
+}
+
+bool fs::file::write_all(int fd,
+                         const void* buf,
+                         size_t count,
+                         uint64_t off)
+{
+  const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+  do {
+    ssize_t ret;
+    switch (ret = ::pwrite(fd, b, count, off)) {
+      default:
+        if ((count -= ret) == 0) {
+          return true;
+        }
+
+        b += ret;
+        off += ret;
+
+        break;
+      case 0:
+        return (count == 0);
+      case -1:
+        if (errno != EINTR) {
+          return false;
+        }
+
+        break;
+    }
+  } while (true);
+}
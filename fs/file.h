@@ -4,16 +4,36 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include "string/buffer.h"
 
 namespace fs {
+  // File which grows in steps of 'allocation_size' bytes: the space is
+  // allocated with fallocate(FALLOC_FL_KEEP_SIZE) (ftruncate() if the
+  // filesystem doesn't support it), so the file doesn't get fragmented
+  // when many files are written at once, and it is released when the file
+  // is closed.
+  //
+  // With direct I/O, the data appended to the file is written with
+  // O_DIRECT in blocks of 'direct_alignment' bytes from an aligned buffer;
+  // the last (partial) block is kept in the buffer until more data is
+  // appended or the file is closed (then it is written padded and the file
+  // is truncated). The data before the end of the file can still be read
+  // and overwritten.
   class file {
     public:
       // Default allocation size.
       static constexpr const uint64_t
              default_allocation_size = 1024ull * 1024ull * 1024ull;
 
+      // Alignment of the offsets, lengths and buffers of the direct I/O.
+      static constexpr const size_t direct_alignment = 4096;
+
+      // Size of the buffer of the direct I/O.
+      static constexpr const size_t direct_buffer_size = 256 * 1024;
+
       // Constructor.
-      file(uint64_t allocation_size = default_allocation_size);
+      file(uint64_t allocation_size = default_allocation_size,
+           bool direct = false);
 
       // Destructor.
       ~file();
@@ -33,7 +53,8 @@ namespace fs {
       // Write.
       bool write(const void* buf, size_t count);
 
-      // Write at a given offset.
+      // Write at a given offset (with direct I/O, only before the end of
+      // the file or at the end of the file).
       bool pwrite(const void* buf, size_t count, uint64_t off);
 
       // Get filesize.
@@ -45,21 +66,57 @@ namespace fs {
     private:
       int _M_fd = -1;
 
+      // File descriptor opened with O_DIRECT (direct I/O).
+      int _M_direct_fd = -1;
+
+      // Allocated size.
       uint64_t _M_size;
+
       uint64_t _M_used;
 
       uint64_t _M_allocation_size;
 
+      // Allocate the space with fallocate()?
+      bool _M_fallocate = true;
+
+      // Direct I/O?
+      bool _M_direct;
+
+      // Data appended with direct I/O not written yet; it starts at the
+      // offset '_M_direct_offset' (aligned).
+      string::buffer _M_direct_buf;
+      uint64_t _M_direct_offset;
+
       // Reserve space in the file.
       bool reserve(uint64_t count);
 
+      // Reserve space (if needed) for writing up to 'end'.
+      bool extend(uint64_t end);
+
+      // Append with direct I/O.
+      bool direct_write(const void* buf, size_t count);
+
+      // Write the complete blocks of the direct I/O buffer, or all of it
+      // (padded) if 'tail' is true.
+      bool direct_flush(bool tail);
+
+      // Read 'count' bytes at a given offset.
+      static ssize_t read_all(int fd, void* buf, size_t count, uint64_t off);
+
+      // Write 'count' bytes at a given offset.
+      static bool write_all(int fd,
+                            const void* buf,
+                            size_t count,
+                            uint64_t off);
+
       // Disable copy constructor and assignment operator.
       file(const file&) = delete;
       file& operator=(const file&) = delete;
   };
 
-  inline file::file(uint64_t allocation_size)
-    : _M_allocation_size(allocation_size)
+  inline file::file(uint64_t allocation_size, bool direct)
+    : _M_allocation_size(allocation_size),
+      _M_direct(direct)
   {
   }
 
@@ -68,42 +125,11 @@ namespace fs {
     close();
   }
 
-  inline bool file::open(const char* filename)
-  {
-    if ((_M_fd = ::open(filename, O_CREAT | O_RDWR, 0644)) != -1) {
-      // Get filesize.
-      off_t filesize;
-      if ((filesize = lseek(_M_fd, 0, SEEK_END)) != -1) {
-        // Save filesize.
-        _M_size = filesize;
-        _M_used = filesize;
-
-        return reserve(_M_allocation_size);
-      }
-    }
-
-    return false;
-  }
-
   inline bool file::open() const
   {
     return (_M_fd != -1);
   }
 
-  inline bool file::close()
-  {
-    if (_M_fd != -1) {
-      bool ret = (ftruncate(_M_fd, _M_used) == 0);
-
-      ::close(_M_fd);
-      _M_fd = -1;
-
-      return ret;
-    }
-
-    return true;
-  }
-
   inline bool file::write(const void* buf, size_t count)
   {
     return pwrite(buf, count, _M_used);
@@ -118,20 +144,6 @@ namespace fs {
   {
     return (_M_used == 0);
   }
-
-  inline bool file::reserve(uint64_t count)
-  {
-    uint64_t size;
-    if ((size = _M_size + count) >= _M_size) {
-      if (ftruncate(_M_fd, size) == 0) {
-        _M_size = size;
-
-        return true;
-      }
-    }
-
-    return false;
-  }
 }
 
 #endif // FS_FILE_H
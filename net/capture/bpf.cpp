@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "net/capture/bpf.h"
+
+int net::capture::bpf::create_map(enum bpf_map_type type,
+                                  uint32_t key_size,
+                                  uint32_t value_size,
+                                  uint32_t max_entries)
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(union bpf_attr));
+
+  attr.map_type = type;
+  attr.key_size = key_size;
+  attr.value_size = value_size;
+  attr.max_entries = max_entries;
+
+  return sys_bpf(BPF_MAP_CREATE, &attr);
+}
+
+bool net::capture::bpf::update_map(int fd, const void* key, const void* value)
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(union bpf_attr));
+
+  attr.map_fd = fd;
+  attr.key = reinterpret_cast<uintptr_t>(key);
+  attr.value = reinterpret_cast<uintptr_t>(value);
+  attr.flags = BPF_ANY;
+
+  return (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr) == 0);
+}
+
+int net::capture::bpf::load_program(enum bpf_prog_type type,
+                                    const struct bpf_insn* insns,
+                                    size_t count)
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(union bpf_attr));
+
+  attr.prog_type = type;
+  attr.insns = reinterpret_cast<uintptr_t>(insns);
+  attr.insn_cnt = static_cast<uint32_t>(count);
+  attr.license = reinterpret_cast<uintptr_t>(license);
+
+  int fd;
+  if ((fd = sys_bpf(BPF_PROG_LOAD, &attr)) != -1) {
+    return fd;
+  }
+
+  // Load the program again, this time with the verifier log, so the
+  // reason of the failure can be shown.
+  char* log;
+  if ((log = static_cast<char*>(malloc(log_size))) != nullptr) {
+    *log = 0;
+
+    attr.log_buf = reinterpret_cast<uintptr_t>(log);
+    attr.log_size = log_size;
+    attr.log_level = 1;
+
+    if ((fd = sys_bpf(BPF_PROG_LOAD, &attr)) == -1) {
+      if (*log) {
+        fprintf(stderr, "BPF verifier:\n%s\n", log);
+      }
+    }
+
+    free(log);
+  }
+
+  return fd;
+}
+
+int net::capture::bpf::get_object(const char* pathname)
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(union bpf_attr));
+
+  attr.pathname = reinterpret_cast<uintptr_t>(pathname);
+
+  return sys_bpf(BPF_OBJ_GET, &attr);
+}
+
+int net::capture::bpf::attach_xdp(int fd, unsigned ifindex, uint32_t flags)
+{
+  union bpf_attr attr;
+  memset(&attr, 0, sizeof(union bpf_attr));
+
+  attr.link_create.prog_fd = fd;
+  attr.link_create.target_ifindex = ifindex;
+  attr.link_create.attach_type = BPF_XDP;
+  attr.link_create.flags = flags;
+
+  return sys_bpf(BPF_LINK_CREATE, &attr);
+}
+
+int net::capture::bpf::sys_bpf(enum bpf_cmd cmd, union bpf_attr* attr)
+{
+  return static_cast<int>(syscall(__NR_bpf, cmd, attr, sizeof(union bpf_attr)));
+}
@@ -0,0 +1,46 @@
+#ifndef NET_CAPTURE_BPF_H
+#define NET_CAPTURE_BPF_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <linux/bpf.h>
+
+namespace net {
+  namespace capture {
+    // Thin wrappers around the bpf(2) system call.
+    class bpf {
+      public:
+        // Create map.
+        static int create_map(enum bpf_map_type type,
+                              uint32_t key_size,
+                              uint32_t value_size,
+                              uint32_t max_entries);
+
+        // Update map element.
+        static bool update_map(int fd, const void* key, const void* value);
+
+        // Load program.
+        static int load_program(enum bpf_prog_type type,
+                                const struct bpf_insn* insns,
+                                size_t count);
+
+        // Get pinned object.
+        static int get_object(const char* pathname);
+
+        // Attach program to a network interface (XDP).
+        static int attach_xdp(int fd, unsigned ifindex, uint32_t flags);
+
+      private:
+        // Size of the verifier log.
+        static constexpr const size_t log_size = 64 * 1024;
+
+        // License of the programs.
+        static constexpr const char* const license = "GPL";
+
+        // System call.
+        static int sys_bpf(enum bpf_cmd cmd, union bpf_attr* attr);
+    };
+  }
+}
+
+#endif // NET_CAPTURE_BPF_H
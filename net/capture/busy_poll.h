@@ -0,0 +1,112 @@
+#ifndef NET_CAPTURE_BUSY_POLL_H
+#define NET_CAPTURE_BUSY_POLL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <limits.h>
+#include <sys/socket.h>
+
+namespace net {
+  namespace capture {
+    // Busy poll: spin waiting for packets before sleeping in poll().
+    class busy_poll {
+      public:
+        static constexpr const size_t max_spins = 1000000000;
+        static constexpr const int max_usecs = INT_MAX;
+
+        // Constructor.
+        busy_poll() = default;
+
+        // Destructor.
+        ~busy_poll() = default;
+
+        // Initialize.
+        // 'spins': number of empty checks before sleeping (0: don't spin).
+        // 'usecs': value of SO_BUSY_POLL (0: not set).
+        bool init(int fd, size_t spins, int usecs);
+
+        // Get number of spins.
+        size_t spins() const;
+
+        // Packets found while spinning.
+        void hit();
+
+        // Sleeping in poll().
+        void sleep();
+
+        // Show statistics.
+        void show_statistics() const;
+
+        // Hint the processor that we are spinning.
+        static void relax();
+
+      private:
+        // Number of empty checks before sleeping.
+        size_t _M_spins = 0;
+
+        // Number of times packets were found while spinning.
+        uint64_t _M_hits = 0;
+
+        // Number of times poll() was called.
+        uint64_t _M_sleeps = 0;
+    };
+
+    inline bool busy_poll::init(int fd, size_t spins, int usecs)
+    {
+      if ((spins <= max_spins) && (usecs >= 0)) {
+        _M_spins = spins;
+
+#if defined(SO_BUSY_POLL)
+        if (usecs > 0) {
+          return (setsockopt(fd,
+                             SOL_SOCKET,
+                             SO_BUSY_POLL,
+                             &usecs,
+                             sizeof(int)) == 0);
+        }
+#endif // defined(SO_BUSY_POLL)
+
+        return true;
+      }
+
+      return false;
+    }
+
+    inline size_t busy_poll::spins() const
+    {
+      return _M_spins;
+    }
+
+    inline void busy_poll::hit()
+    {
+      _M_hits++;
+    }
+
+    inline void busy_poll::sleep()
+    {
+      _M_sleeps++;
+    }
+
+    inline void busy_poll::show_statistics() const
+    {
+      printf("  %llu times packets were found while spinning.\n",
+             static_cast<unsigned long long>(_M_hits));
+
+      printf("  %llu times slept in poll().\n",
+             static_cast<unsigned long long>(_M_sleeps));
+    }
+
+    inline void busy_poll::relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__aarch64__)
+      __asm__ __volatile__("yield" ::: "memory");
+#else
+      __asm__ __volatile__("" ::: "memory");
+#endif
+    }
+  }
+}
+
+#endif // NET_CAPTURE_BUSY_POLL_H
@@ -1,26 +1,71 @@
 #ifndef NET_CAPTURE_CALLBACKS_H
 #define NET_CAPTURE_CALLBACKS_H
 
+#include <stdint.h>
 #include <sys/types.h>
-#include <time.h>
+#include <sys/time.h>
 
 namespace net {
   namespace capture {
+    // Captured frame.
+    struct frame {
+      // Frame.
+      const void* buf;
+
+      // Number of bytes captured.
+      size_t len;
+
+      // Length of the frame on the wire.
+      size_t wirelen;
+
+      // Timestamp.
+      struct timeval timestamp;
+
+      // Hash computed by the kernel (0: not available).
+      uint32_t rxhash;
+    };
+
     // Capture callbacks.
     struct callbacks {
+      // Maximum number of frames passed to 'batch'.
+      static constexpr const size_t max_batch = 256;
+
+      // 'len': number of bytes captured.
+      // 'wirelen': length of the frame on the wire.
       typedef bool (*ethernet_t)(const void* buf,
                                  size_t len,
+                                 size_t wirelen,
                                  const struct timeval& timestamp,
                                  void* user);
 
+      // Batch of frames (a TPACKET_V3 block, a recvmmsg() batch, ...).
+      // If set, it is used instead of 'ethernet'.
+      typedef bool (*batch_t)(const frame* frames, size_t nframes, void* user);
+
       typedef void (*idle_t)(void* user);
 
+      // Only used by the ring buffer: if 'held' is set, the blocks
+      // (TPACKET_V3) / frames (TPACKET_V2) are not returned to the kernel
+      // after processing them, so the frames can be used afterwards.
+      // 'held' is called after each block / frame has been processed and
+      // the oldest held block / frame is returned to the kernel when
+      // 'releasable' returns true.
+      typedef void (*held_t)(void* user);
+      typedef bool (*releasable_t)(void* user);
+
       // Constructor.
       callbacks() = default;
       callbacks(ethernet_t ethernet, idle_t idle);
+      callbacks(ethernet_t ethernet,
+                idle_t idle,
+                held_t held,
+                releasable_t releasable);
 
       ethernet_t ethernet = nullptr;
+      batch_t batch = nullptr;
       idle_t idle = nullptr;
+      held_t held = nullptr;
+      releasable_t releasable = nullptr;
     };
 
     inline callbacks::callbacks(ethernet_t ethernet, idle_t idle)
@@ -28,6 +73,17 @@ namespace net {
         idle(idle)
     {
     }
+
+    inline callbacks::callbacks(ethernet_t ethernet,
+                                idle_t idle,
+                                held_t held,
+                                releasable_t releasable)
+      : ethernet(ethernet),
+        idle(idle),
+        held(held),
+        releasable(releasable)
+    {
+    }
   }
 }
 
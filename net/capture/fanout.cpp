@@ -0,0 +1,251 @@
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <netinet/in.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+#include "net/capture/fanout.h"
+#include "net/capture/bpf.h"
+
+void net::capture::fanout::clear()
+{
+  if (_M_prog != -1) {
+    close(_M_prog);
+    _M_prog = -1;
+  }
+}
+
+bool net::capture::fanout::init(mode m,
+                                bool rollover,
+                                int group,
+                                const char* program)
+{
+  if ((group == no_group) || ((group >= 0) && (group <= max_group))) {
+    _M_mode = m;
+    _M_rollover = rollover;
+    _M_group = group;
+
+    if (m == mode::ebpf) {
+      if (program) {
+        // Get pinned program.
+        return ((_M_prog = bpf::get_object(program)) != -1);
+      } else {
+        return load_program();
+      }
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+bool net::capture::fanout::join(int fd, unsigned ifindex) const
+{
+#if defined(PACKET_FANOUT)
+  int type;
+  switch (_M_mode) {
+    case mode::hash:
+      type = PACKET_FANOUT_HASH;
+      break;
+    case mode::cpu:
+      type = PACKET_FANOUT_CPU;
+      break;
+    case mode::qm:
+      type = PACKET_FANOUT_QM;
+      break;
+    case mode::lb:
+      type = PACKET_FANOUT_LB;
+      break;
+    case mode::rollover:
+      type = PACKET_FANOUT_ROLLOVER;
+      break;
+    case mode::ebpf:
+      type = PACKET_FANOUT_EBPF;
+      break;
+    default:
+      return false;
+  }
+
+  type |= PACKET_FANOUT_FLAG_DEFRAG;
+
+  if (_M_rollover) {
+    type |= PACKET_FANOUT_FLAG_ROLLOVER;
+  }
+
+  int group = (_M_group != no_group) ? _M_group : (getpid() ^ ifindex);
+
+  // Join fanout group.
+  int optval = (type << 16) | (group & 0xffff);
+
+  if (setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &optval, sizeof(int)) == 0) {
+    if (_M_mode == mode::ebpf) {
+      // Set the steering program of the group.
+      return (setsockopt(fd,
+                         SOL_PACKET,
+                         PACKET_FANOUT_DATA,
+                         &_M_prog,
+                         sizeof(int)) == 0);
+    }
+
+    return true;
+  }
+
+  return false;
+#else
+  return true;
+#endif // defined(PACKET_FANOUT)
+}
+
+bool net::capture::fanout::load_program()
+{
+  // Symmetric 5-tuple hash: the source and destination addresses and ports
+  // are combined with commutative operations (sum and xor), so both
+  // directions of a flow select the same socket. The kernel uses the
+  // returned value modulo the number of sockets in the group.
+  //
+  // Registers:
+  //   r6: context (required by the LD_ABS / LD_IND instructions).
+  //   r7: sum of the addresses and ports.
+  //   r8: xor of the addresses and ports.
+  //   r9: IPv4 header length.
+  static constexpr const int32_t net = SKF_NET_OFF;
+
+  static constexpr const int16_t protocol = offsetof(struct __sk_buff,
+                                                     protocol);
+
+  const struct bpf_insn insns[] = {
+    // 0: r6 = r1
+    {BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0},
+
+    // 1: r0 = skb->protocol
+    {BPF_LDX | BPF_MEM | BPF_W, BPF_REG_0, BPF_REG_6, protocol, 0},
+
+    // 2: if (r0 == ETH_P_IP) goto 6
+    {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 3, htons(ETH_P_IP)},
+
+    // 3: if (r0 == ETH_P_IPV6) goto 31
+    {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 27, htons(ETH_P_IPV6)},
+
+    // 4: return 0
+    {BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, 0},
+    {BPF_JMP | BPF_EXIT, 0, 0, 0, 0},
+
+    ////////////////////////////////////////////////////////////////////////
+    // IPv4.                                                              //
+    ////////////////////////////////////////////////////////////////////////
+
+    // 6: r7 = r8 = saddr
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 12},
+    {BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+
+    // 9: r7 += daddr, r8 ^= daddr
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 16},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+
+    // 12: if (fragment offset != 0) goto 68
+    {BPF_LD | BPF_ABS | BPF_H, 0, 0, 0, net + 6},
+    {BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_0, 0, 0, 0x1fff},
+    {BPF_JMP | BPF_JNE | BPF_K, BPF_REG_0, 0, 53, 0},
+
+    // 15: if (protocol is TCP, UDP or SCTP) goto 20 else goto 68
+    {BPF_LD | BPF_ABS | BPF_B, 0, 0, 0, net + 9},
+    {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 3, IPPROTO_TCP},
+    {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 2, IPPROTO_UDP},
+    {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 1, IPPROTO_SCTP},
+    {BPF_JMP | BPF_JA, 0, 0, 48, 0},
+
+    // 20: r9 = IPv4 header length
+    {BPF_LD | BPF_ABS | BPF_B, 0, 0, 0, net},
+    {BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_0, 0, 0, 0x0f},
+    {BPF_ALU64 | BPF_LSH | BPF_K, BPF_REG_0, 0, 0, 2},
+    {BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_9, BPF_REG_0, 0, 0},
+
+    // 24: r7 += source port, r8 ^= source port
+    {BPF_LD | BPF_IND | BPF_H, 0, BPF_REG_9, 0, net},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+
+    // 27: r7 += destination port, r8 ^= destination port
+    {BPF_LD | BPF_IND | BPF_H, 0, BPF_REG_9, 0, net + 2},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+
+    // 30: goto 68
+    {BPF_JMP | BPF_JA, 0, 0, 37, 0},
+
+    ////////////////////////////////////////////////////////////////////////
+    // IPv6.                                                              //
+    ////////////////////////////////////////////////////////////////////////
+
+    // 31: r7 = r8 = 0
+    {BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_7, 0, 0, 0},
+    {BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_8, 0, 0, 0},
+
+    // 33: r7 += word, r8 ^= word (source and destination addresses)
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 8},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 12},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 16},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 20},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 24},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 28},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 32},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+    {BPF_LD | BPF_ABS | BPF_W, 0, 0, 0, net + 36},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+
+    // 57: if (next header is TCP, UDP or SCTP) goto 62 else goto 68
+    // (the ports after extension headers are not used).
+    {BPF_LD | BPF_ABS | BPF_B, 0, 0, 0, net + 6},
+    {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 3, IPPROTO_TCP},
+    {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 2, IPPROTO_UDP},
+    {BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_0, 0, 1, IPPROTO_SCTP},
+    {BPF_JMP | BPF_JA, 0, 0, 6, 0},
+
+    // 62: r7 += ports, r8 ^= ports
+    {BPF_LD | BPF_ABS | BPF_H, 0, 0, 0, net + 40},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+    {BPF_LD | BPF_ABS | BPF_H, 0, 0, 0, net + 42},
+    {BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0},
+    {BPF_ALU64 | BPF_XOR | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0},
+
+    ////////////////////////////////////////////////////////////////////////
+    // Mix.                                                               //
+    ////////////////////////////////////////////////////////////////////////
+
+    // 68: r8 = ((r8 * 0x9e3779b1) + r7) * 0x85ebca6b
+    {BPF_ALU | BPF_MUL | BPF_K, BPF_REG_8, 0, 0, int32_t(0x9e3779b1)},
+    {BPF_ALU | BPF_ADD | BPF_X, BPF_REG_8, BPF_REG_7, 0, 0},
+    {BPF_ALU | BPF_MUL | BPF_K, BPF_REG_8, 0, 0, int32_t(0x85ebca6b)},
+
+    // 71: return r8 ^ (r8 >> 16)
+    {BPF_ALU | BPF_MOV | BPF_X, BPF_REG_0, BPF_REG_8, 0, 0},
+    {BPF_ALU | BPF_RSH | BPF_K, BPF_REG_0, 0, 0, 16},
+    {BPF_ALU | BPF_XOR | BPF_X, BPF_REG_0, BPF_REG_8, 0, 0},
+    {BPF_JMP | BPF_EXIT, 0, 0, 0, 0}
+  };
+
+  return ((_M_prog = bpf::load_program(BPF_PROG_TYPE_SOCKET_FILTER,
+                                       insns,
+                                       sizeof(insns) / sizeof(insns[0]))) !=
+          -1);
+}
@@ -0,0 +1,76 @@
+#ifndef NET_CAPTURE_FANOUT_H
+#define NET_CAPTURE_FANOUT_H
+
+#include <stdint.h>
+
+namespace net {
+  namespace capture {
+    // Packet fanout group.
+    class fanout {
+      public:
+        static constexpr const int max_group = 0xffff;
+
+        // No group id.
+        static constexpr const int no_group = -1;
+
+        // Fanout mode.
+        enum class mode {
+          hash,
+          cpu,
+          qm,
+          lb,
+          rollover,
+          ebpf
+        };
+
+        // Constructor.
+        fanout() = default;
+
+        // Destructor.
+        ~fanout();
+
+        // Clear.
+        void clear();
+
+        // Initialize.
+        // 'group': group id or 'no_group' (derived from the process id and
+        //          the interface index).
+        // 'program': path of a pinned eBPF program (mode::ebpf) or nullptr
+        //            for the built-in symmetric 5-tuple hash.
+        bool init(mode m,
+                  bool rollover,
+                  int group = no_group,
+                  const char* program = nullptr);
+
+        // Join fanout group.
+        bool join(int fd, unsigned ifindex) const;
+
+      private:
+        // Fanout mode.
+        mode _M_mode = mode::hash;
+
+        // Roll over to another socket when the selected one is full?
+        bool _M_rollover = false;
+
+        // Group id.
+        int _M_group = no_group;
+
+        // eBPF steering program.
+        int _M_prog = -1;
+
+        // Load the built-in steering program.
+        bool load_program();
+
+        // Disable copy constructor and assignment operator.
+        fanout(const fanout&) = delete;
+        fanout& operator=(const fanout&) = delete;
+    };
+
+    inline fanout::~fanout()
+    {
+      clear();
+    }
+  }
+}
+
+#endif // NET_CAPTURE_FANOUT_H
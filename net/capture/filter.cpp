@@ -0,0 +1,15 @@
+#include <sys/socket.h>
+#include "net/capture/filter.h"
+
+bool net::capture::filter::attach(int fd) const
+{
+  struct sock_fprog prog;
+  prog.len = static_cast<unsigned short>(_M_ninsns);
+  prog.filter = const_cast<struct sock_filter*>(_M_insns);
+
+  return (setsockopt(fd,
+                     SOL_SOCKET,
+                     SO_ATTACH_FILTER,
+                     &prog,
+                     sizeof(struct sock_fprog)) == 0);
+}
@@ -0,0 +1,95 @@
+#ifndef NET_CAPTURE_FILTER_H
+#define NET_CAPTURE_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/filter.h>
+
+namespace net {
+  namespace capture {
+    // Classic BPF socket filter.
+    class filter {
+      public:
+        static constexpr const size_t max_instructions = BPF_MAXINSNS;
+
+        // Constructor.
+        filter() = default;
+
+        // Destructor.
+        ~filter() = default;
+
+        // Clear.
+        void clear();
+
+        // Add instruction.
+        bool add(uint16_t code, uint32_t k, uint8_t jt = 0, uint8_t jf = 0);
+
+        // Get number of instructions.
+        size_t size() const;
+
+        // Empty?
+        bool empty() const;
+
+        // Get instruction.
+        struct sock_filter& operator[](size_t idx);
+        const struct sock_filter& operator[](size_t idx) const;
+
+        // Attach filter to the socket.
+        bool attach(int fd) const;
+
+      private:
+        // Instructions.
+        struct sock_filter _M_insns[max_instructions];
+
+        // Number of instructions.
+        size_t _M_ninsns = 0;
+
+        // Disable copy constructor and assignment operator.
+        filter(const filter&) = delete;
+        filter& operator=(const filter&) = delete;
+    };
+
+    inline void filter::clear()
+    {
+      _M_ninsns = 0;
+    }
+
+    inline bool filter::add(uint16_t code, uint32_t k, uint8_t jt, uint8_t jf)
+    {
+      if (_M_ninsns < max_instructions) {
+        struct sock_filter* insn = &_M_insns[_M_ninsns++];
+
+        insn->code = code;
+        insn->jt = jt;
+        insn->jf = jf;
+        insn->k = k;
+
+        return true;
+      }
+
+      return false;
+    }
+
+    inline size_t filter::size() const
+    {
+      return _M_ninsns;
+    }
+
+    inline bool filter::empty() const
+    {
+      return (_M_ninsns == 0);
+    }
+
+    inline struct sock_filter& filter::operator[](size_t idx)
+    {
+      return _M_insns[idx];
+    }
+
+    inline const struct sock_filter& filter::operator[](size_t idx) const
+    {
+      return _M_insns[idx];
+    }
+  }
+}
+
+#endif // NET_CAPTURE_FILTER_H
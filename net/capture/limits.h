@@ -1,10 +1,19 @@
 #ifndef NET_CAPTURE_LIMITS_H
 #define NET_CAPTURE_LIMITS_H
 
+#include <stddef.h>
+
 namespace net {
   namespace capture {
     // Minimum size of the socket receive buffer.
     static constexpr const int min_rcvbuf_size = 2 * 1024;
+
+    // Minimum snapshot length (big enough for the link, network and
+    // transport headers).
+    static constexpr const size_t min_snaplen = 128;
+
+    // Maximum snapshot length.
+    static constexpr const size_t max_snaplen = 64 * 1024;
   }
 }
 
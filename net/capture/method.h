@@ -6,7 +6,8 @@ namespace net {
     // Capture method.
     enum class method {
       ring_buffer,
-      socket
+      socket,
+      xdp
     };
   }
 }
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <poll.h>
+#include <sched.h>
 
 #if !defined(PACKET_TIMESTAMP)
   #include <sys/time.h>
@@ -36,6 +37,9 @@ void net::capture::ring_buffer::clear()
   }
 
   _M_idx = 0;
+
+  _M_held = 0;
+  _M_held_idx = 0;
 }
 
 bool net::capture::ring_buffer::create(unsigned ifindex,
@@ -43,7 +47,8 @@ bool net::capture::ring_buffer::create(unsigned ifindex,
                                        bool promiscuous_mode,
                                        size_t block_size,
                                        size_t frame_size,
-                                       size_t frame_count)
+                                       size_t frame_count,
+                                       const fanout& fanout)
 {
   if ((ifindex > 0) &&
       ((rcvbuf_size == 0) || (rcvbuf_size >= min_rcvbuf_size)) &&
@@ -58,19 +63,8 @@ bool net::capture::ring_buffer::create(unsigned ifindex,
         (setup_ring(block_size, frame_size, frame_count)) &&
         (mmap_ring()) &&
         (bind_ring(ifindex, promiscuous_mode))) {
-#if defined(PACKET_FANOUT)
-      // Create fanout group.
-      int optval = ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16) |
-                   ((getpid() ^ ifindex) & 0xffff);
-
-      return (setsockopt(_M_fd,
-                         SOL_PACKET,
-                         PACKET_FANOUT,
-                         &optval,
-                         sizeof(int)) == 0);
-#else
-      return true;
-#endif
+      // Join fanout group.
+      return fanout.join(_M_fd, ifindex);
     }
   }
 
@@ -91,16 +85,44 @@ bool net::capture::ring_buffer::loop(const callbacks& callbacks, void* user)
   _M_running = true;
 
   do {
+    if (_M_busy_poll.spins() > 0) {
+      // Spin waiting for new packets before sleeping.
+      bool received = false;
+      size_t spins = _M_busy_poll.spins();
+
+      do {
+        if (recv()) {
+          _M_busy_poll.hit();
+          received = true;
+
+          break;
+        }
+
+        busy_poll::relax();
+      } while (--spins > 0);
+
+      if (received) {
+        continue;
+      }
+    }
+
+    _M_busy_poll.sleep();
+
     switch (poll(&pfd, 1, timeout)) {
       case 1:
-#if HAVE_TPACKET_V3
-        recv_v3();
-#else
-        recv_v2();
-#endif
+        // If there are no new packets (poll() reports the held blocks /
+        // frames as readable), let the threads processing them run.
+        if ((!recv()) && (_M_held > 0)) {
+          sched_yield();
+        }
 
         break;
       case 0: // Timeout.
+        // If the blocks / frames are held...
+        if (callbacks.held) {
+          release();
+        }
+
         if (callbacks.idle) {
           callbacks.idle(user);
         }
@@ -130,12 +152,41 @@ bool net::capture::ring_buffer::show_statistics()
     printf("  %u packets received.\n", stats.tp_packets);
     printf("  %u packets dropped by kernel.\n", stats.tp_drops);
 
+    _M_busy_poll.show_statistics();
+
     return true;
   }
 
   return false;
 }
 
+void net::capture::ring_buffer::release()
+{
+  while ((_M_held > 0) && (_M_callbacks.releasable(_M_user))) {
+#if HAVE_TPACKET_V3
+    struct tpacket_block_desc* block_desc =
+                               reinterpret_cast<struct tpacket_block_desc*>(
+                                 _M_frames[_M_held_idx].iov_base
+                               );
+
+    // Mark block as free.
+    __atomic_store_n(&block_desc->hdr.bh1.block_status,
+                     TP_STATUS_KERNEL,
+                     __ATOMIC_RELEASE);
+#else
+    struct tpacket2_hdr* hdr = reinterpret_cast<struct tpacket2_hdr*>(
+                                 _M_frames[_M_held_idx].iov_base
+                               );
+
+    // Mark frame as free.
+    __atomic_store_n(&hdr->tp_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+#endif
+
+    _M_held_idx = (_M_held_idx + 1) % _M_count;
+    _M_held--;
+  }
+}
+
 bool net::capture::ring_buffer::setup_socket(int rcvbuf_size)
 {
   // Create socket.
@@ -290,7 +341,8 @@ bool net::capture::ring_buffer::bind_ring(unsigned ifindex,
                                );
 
     // If there is a new block...
-    if ((block_desc->hdr.bh1.block_status & TP_STATUS_USER) != 0) {
+    if ((__atomic_load_n(&block_desc->hdr.bh1.block_status,
+                         __ATOMIC_ACQUIRE) & TP_STATUS_USER) != 0) {
       struct tpacket3_hdr* hdr = reinterpret_cast<struct tpacket3_hdr*>(
                                    reinterpret_cast<uint8_t*>(block_desc) +
                                    block_desc->hdr.bh1.offset_to_first_pkt
@@ -305,6 +357,8 @@ bool net::capture::ring_buffer::bind_ring(unsigned ifindex,
 
       uint32_t num_pkts = block_desc->hdr.bh1.num_pkts;
 
+      size_t nframes = 0;
+
       // Process packets in the block.
       for (uint32_t i = 0; i < num_pkts; i++) {
 #if defined(PACKET_TIMESTAMP)
@@ -312,22 +366,51 @@ bool net::capture::ring_buffer::bind_ring(unsigned ifindex,
         tv.tv_usec = hdr->tp_nsec / 1000;
 #endif // defined(PACKET_TIMESTAMP)
 
-        _M_callbacks.ethernet(reinterpret_cast<const uint8_t*>(hdr) +
-                              hdr->tp_mac,
-                              hdr->tp_snaplen,
-                              tv,
-                              _M_user);
+        if (_M_callbacks.batch) {
+          frame& f = _M_batch[nframes];
+
+          f.buf = reinterpret_cast<const uint8_t*>(hdr) + hdr->tp_mac;
+          f.len = hdr->tp_snaplen;
+          f.wirelen = hdr->tp_len;
+          f.timestamp = tv;
+          f.rxhash = hdr->hv1.tp_rxhash;
+
+          // If the batch is full...
+          if (++nframes == callbacks::max_batch) {
+            _M_callbacks.batch(_M_batch, nframes, _M_user);
+            nframes = 0;
+          }
+        } else {
+          _M_callbacks.ethernet(reinterpret_cast<const uint8_t*>(hdr) +
+                                hdr->tp_mac,
+                                hdr->tp_snaplen,
+                                hdr->tp_len,
+                                tv,
+                                _M_user);
+        }
 
         hdr = reinterpret_cast<struct tpacket3_hdr*>(
                 reinterpret_cast<uint8_t*>(hdr) + hdr->tp_next_offset
               );
       }
 
-      // Mark block as free.
-      block_desc->hdr.bh1.block_status = TP_STATUS_KERNEL;
+      // Process the remaining frames of the batch (if any).
+      if (nframes > 0) {
+        _M_callbacks.batch(_M_batch, nframes, _M_user);
+      }
 
       _M_idx = (_M_idx + 1) % _M_count;
 
+      // If the blocks are held...
+      if (_M_callbacks.held) {
+        _M_held++;
+
+        _M_callbacks.held(_M_user);
+      } else {
+        // Mark block as free.
+        block_desc->hdr.bh1.block_status = TP_STATUS_KERNEL;
+      }
+
       return true;
     } else {
       return false;
@@ -357,12 +440,18 @@ bool net::capture::ring_buffer::bind_ring(unsigned ifindex,
 
   bool net::capture::ring_buffer::recv_v2()
   {
+    // Batch callback?
+    if (_M_callbacks.batch) {
+      return recv_batch_v2();
+    }
+
     struct tpacket2_hdr* hdr = reinterpret_cast<struct tpacket2_hdr*>(
                                  _M_frames[_M_idx].iov_base
                                );
 
     // If there is a new packet...
-    if ((hdr->tp_status & TP_STATUS_USER) == TP_STATUS_USER) {
+    if ((__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) &
+         TP_STATUS_USER) == TP_STATUS_USER) {
       struct timeval tv;
 
 #if defined(PACKET_TIMESTAMP)
@@ -376,17 +465,93 @@ bool net::capture::ring_buffer::bind_ring(unsigned ifindex,
       // Process packet.
       _M_callbacks.ethernet(reinterpret_cast<const uint8_t*>(hdr) + hdr->tp_mac,
                             hdr->tp_snaplen,
+                            hdr->tp_len,
                             tv,
                             _M_user);
 
-      // Mark frame as free.
-      hdr->tp_status = TP_STATUS_KERNEL;
-
       _M_idx = (_M_idx + 1) % _M_count;
 
+      // If the frames are held...
+      if (_M_callbacks.held) {
+        _M_held++;
+
+        _M_callbacks.held(_M_user);
+      } else {
+        // Mark frame as free.
+        hdr->tp_status = TP_STATUS_KERNEL;
+      }
+
       return true;
     } else {
       return false;
     }
   }
+
+  bool net::capture::ring_buffer::recv_batch_v2()
+  {
+    size_t nframes = 0;
+    size_t idx = _M_idx;
+
+    // Collect the new frames (without reaching the held frames).
+    while ((nframes < callbacks::max_batch) &&
+           (_M_held + nframes < _M_count)) {
+      struct tpacket2_hdr* hdr = reinterpret_cast<struct tpacket2_hdr*>(
+                                   _M_frames[idx].iov_base
+                                 );
+
+      // If there is no new packet...
+      if ((__atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE) &
+           TP_STATUS_USER) != TP_STATUS_USER) {
+        break;
+      }
+
+      frame& f = _M_batch[nframes++];
+
+#if defined(PACKET_TIMESTAMP)
+      f.timestamp.tv_sec = hdr->tp_sec;
+      f.timestamp.tv_usec = hdr->tp_nsec / 1000;
+#else
+      // Get current time.
+      gettimeofday(&f.timestamp, nullptr);
+#endif
+
+      f.buf = reinterpret_cast<const uint8_t*>(hdr) + hdr->tp_mac;
+      f.len = hdr->tp_snaplen;
+      f.wirelen = hdr->tp_len;
+      f.rxhash = 0;
+
+      idx = (idx + 1) % _M_count;
+    }
+
+    if (nframes > 0) {
+      // Process frames.
+      _M_callbacks.batch(_M_batch, nframes, _M_user);
+
+      for (size_t i = 0; i < nframes; i++) {
+        _M_idx = (_M_idx + 1) % _M_count;
+
+        // If the frames are held...
+        if (_M_callbacks.held) {
+          _M_held++;
+
+          _M_callbacks.held(_M_user);
+        } else {
+          struct tpacket2_hdr* hdr = reinterpret_cast<struct tpacket2_hdr*>(
+                                       _M_frames[
+                                         (_M_idx + _M_count - 1) % _M_count
+                                       ].iov_base
+                                     );
+
+          // Mark frame as free.
+          __atomic_store_n(&hdr->tp_status,
+                           TP_STATUS_KERNEL,
+                           __ATOMIC_RELEASE);
+        }
+      }
+
+      return true;
+    }
+
+    return false;
+  }
 #endif
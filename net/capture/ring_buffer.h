@@ -6,6 +6,9 @@
 #include <linux/if_packet.h>
 #include <limits.h>
 #include "net/capture/callbacks.h"
+#include "net/capture/busy_poll.h"
+#include "net/capture/fanout.h"
+#include "net/capture/filter.h"
 
 namespace net {
   namespace capture {
@@ -27,6 +30,10 @@ namespace net {
         static constexpr const size_t
                default_frames = static_cast<size_t>(1) << 9;
 
+        // Get the frame size needed for capturing 'snaplen' bytes of each
+        // frame.
+        static size_t frame_size(size_t snaplen);
+
         // Constructor.
         ring_buffer() = default;
 
@@ -42,14 +49,22 @@ namespace net {
                     bool promiscuous_mode,
                     size_t block_size,
                     size_t frame_size,
-                    size_t frame_count);
+                    size_t frame_count,
+                    const fanout& fanout);
 
         bool create(unsigned ifindex,
                     int rcvbuf_size,
                     bool promiscuous_mode,
                     size_t block_size,
                     size_t frame_size,
-                    size_t frame_count);
+                    size_t frame_count,
+                    const fanout& fanout);
+
+        // Enable busy poll.
+        bool enable_busy_poll(size_t spins, int usecs);
+
+        // Attach filter.
+        bool attach_filter(const filter& filter);
 
         // Loop.
         bool loop(const callbacks& callbacks, void* user = nullptr);
@@ -60,6 +75,9 @@ namespace net {
         // Show statistics.
         bool show_statistics();
 
+        // Get number of blocks (TPACKET_V3) / frames (TPACKET_V2).
+        size_t count() const;
+
       private:
         int _M_fd = -1;
 
@@ -82,10 +100,22 @@ namespace net {
 
         size_t _M_idx = 0;
 
+        // Blocks / frames held (see callbacks::held).
+        size_t _M_held = 0;
+
+        // Index of the oldest held block / frame.
+        size_t _M_held_idx = 0;
+
         // Callbacks.
         callbacks _M_callbacks;
         void* _M_user;
 
+        // Frames passed to the batch callback.
+        frame _M_batch[callbacks::max_batch];
+
+        // Busy poll.
+        busy_poll _M_busy_poll;
+
         // Running?
         bool _M_running = false;
 
@@ -103,6 +133,13 @@ namespace net {
         // Bind packet ring.
         bool bind_ring(unsigned ifindex, bool promiscuous_mode);
 
+        // Receive packets.
+        bool recv();
+
+        // Return the held blocks / frames which are releasable to the
+        // kernel.
+        void release();
+
 #if HAVE_TPACKET_V3
         // Configure for TPACKET_V3.
         void config_v3(size_t block_size,
@@ -121,6 +158,9 @@ namespace net {
 
         // Receive packet for TPACKET_V2.
         bool recv_v2();
+
+        // Receive packets for TPACKET_V2 (batch callback).
+        bool recv_batch_v2();
 #endif
 
         // Disable copy constructor and assignment operator.
@@ -128,6 +168,26 @@ namespace net {
         ring_buffer& operator=(const ring_buffer&) = delete;
     };
 
+    inline size_t ring_buffer::frame_size(size_t snaplen)
+    {
+#if HAVE_TPACKET_V3
+      static constexpr const size_t hdrlen = TPACKET3_HDRLEN;
+#else
+      static constexpr const size_t hdrlen = TPACKET2_HDRLEN;
+#endif
+
+      // The kernel leaves room for a MAC header of at least 16 bytes.
+      size_t size = TPACKET_ALIGN(hdrlen + 16) + snaplen;
+
+      // Round up to a power of 2, so the frames fill the blocks.
+      size_t frame_size = min_frame_size;
+      while (frame_size < size) {
+        frame_size <<= 1;
+      }
+
+      return frame_size;
+    }
+
     inline ring_buffer::~ring_buffer()
     {
       clear();
@@ -138,14 +198,50 @@ namespace net {
                                     bool promiscuous_mode,
                                     size_t block_size,
                                     size_t frame_size,
-                                    size_t frame_count)
+                                    size_t frame_count,
+                                    const fanout& fanout)
     {
       return create(if_nametoindex(interface),
                     rcvbuf_size,
                     promiscuous_mode,
                     block_size,
                     frame_size,
-                    frame_count);
+                    frame_count,
+                    fanout);
+    }
+
+    inline bool ring_buffer::enable_busy_poll(size_t spins, int usecs)
+    {
+      return _M_busy_poll.init(_M_fd, spins, usecs);
+    }
+
+    inline bool ring_buffer::attach_filter(const filter& filter)
+    {
+      return filter.attach(_M_fd);
+    }
+
+    inline size_t ring_buffer::count() const
+    {
+      return _M_count;
+    }
+
+    inline bool ring_buffer::recv()
+    {
+      // If the blocks / frames are held...
+      if (_M_callbacks.held) {
+        release();
+
+        // If all the blocks / frames are held...
+        if (_M_held == _M_count) {
+          return false;
+        }
+      }
+
+#if HAVE_TPACKET_V3
+      return recv_v3();
+#else
+      return recv_v2();
+#endif
     }
 
     inline void ring_buffer::stop()
@@ -10,6 +10,7 @@
 #include <arpa/inet.h>
 #include <net/ethernet.h>
 #include <linux/if_packet.h>
+#include <linux/sockios.h>
 #include <errno.h>
 #include "net/capture/socket.h"
 #include "net/capture/limits.h"
@@ -29,44 +30,49 @@ void net::capture::socket::clear()
 
 bool net::capture::socket::create(unsigned ifindex,
                                   int rcvbuf_size,
-                                  bool promiscuous_mode)
+                                  bool promiscuous_mode,
+                                  size_t snaplen,
+                                  const fanout& fanout)
 {
   if ((ifindex > 0) &&
       ((rcvbuf_size == 0) || (rcvbuf_size >= min_rcvbuf_size))) {
+    // Compute message size.
+    size_t message_size;
+    if (snaplen == 0) {
+      message_size = max_message_size;
+    } else if (snaplen < min_snap_message_size) {
+      message_size = min_snap_message_size;
+    } else if (snaplen < max_message_size) {
+      message_size = snaplen;
+    } else {
+      message_size = max_message_size;
+    }
+
     if ((setup_socket(rcvbuf_size)) &&
         (bind(ifindex, promiscuous_mode)) &&
         ((_M_buf = static_cast<uint8_t*>(
-                     malloc(max_messages * max_message_size)
+                     malloc(max_messages * message_size)
                    )) != nullptr)) {
-#if defined(PACKET_FANOUT)
-      // Create fanout group.
-      int optval = ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16) |
-                   ((getpid() ^ ifindex) & 0xffff);
-
-      if (setsockopt(_M_fd,
-                     SOL_PACKET,
-                     PACKET_FANOUT,
-                     &optval,
-                     sizeof(int)) < 0) {
+      // Join fanout group.
+      if (!fanout.join(_M_fd, ifindex)) {
         return false;
       }
-#endif // defined(PACKET_FANOUT)
 
       // Initialize messages.
       uint8_t* buf = _M_buf;
       for (size_t i = 0; i < max_messages; i++) {
         _M_iov[i].iov_base = buf;
-        _M_iov[i].iov_len = max_message_size;
+        _M_iov[i].iov_len = message_size;
 
         _M_msg[i].msg_hdr.msg_name = nullptr;
         _M_msg[i].msg_hdr.msg_namelen = 0;
         _M_msg[i].msg_hdr.msg_iov = _M_iov + i;
         _M_msg[i].msg_hdr.msg_iovlen = 1;
-        _M_msg[i].msg_hdr.msg_control = nullptr;
-        _M_msg[i].msg_hdr.msg_controllen = 0;
+        _M_msg[i].msg_hdr.msg_control = _M_control[i];
+        _M_msg[i].msg_hdr.msg_controllen = control_size;
         _M_msg[i].msg_hdr.msg_flags = 0;
 
-        buf += max_message_size;
+        buf += message_size;
       }
 
       return true;
@@ -90,6 +96,29 @@ bool net::capture::socket::loop(const callbacks& callbacks, void* user)
   _M_running = true;
 
   do {
+    if (_M_busy_poll.spins() > 0) {
+      // Spin waiting for new packets before sleeping.
+      bool received = false;
+      size_t spins = _M_busy_poll.spins();
+
+      do {
+        if (recv()) {
+          _M_busy_poll.hit();
+          received = true;
+
+          break;
+        }
+
+        busy_poll::relax();
+      } while (--spins > 0);
+
+      if (received) {
+        continue;
+      }
+    }
+
+    _M_busy_poll.sleep();
+
     switch (poll(&pfd, 1, timeout)) {
       case 1:
         recv();
@@ -119,6 +148,8 @@ bool net::capture::socket::show_statistics()
     printf("  %u packets received.\n", stats.tp_packets);
     printf("  %u packets dropped by kernel.\n", stats.tp_drops);
 
+    _M_busy_poll.show_statistics();
+
     return true;
   }
 
@@ -130,14 +161,23 @@ bool net::capture::socket::setup_socket(int rcvbuf_size)
   // Create socket.
   if ((_M_fd = ::socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ALL))) != -1) {
     if (rcvbuf_size != 0) {
-      return (setsockopt(_M_fd,
-                         SOL_SOCKET,
-                         SO_RCVBUF,
-                         &rcvbuf_size,
-                         sizeof(int)) == 0);
+      if (setsockopt(_M_fd,
+                     SOL_SOCKET,
+                     SO_RCVBUF,
+                     &rcvbuf_size,
+                     sizeof(int)) < 0) {
+        return false;
+      }
     }
 
-    return true;
+    // Receive the length of the frames on the wire (the frames might have
+    // been truncated by the socket filter).
+    int optval = 1;
+    return (setsockopt(_M_fd,
+                       SOL_PACKET,
+                       PACKET_AUXDATA,
+                       &optval,
+                       sizeof(int)) == 0);
   }
 
   return false;
@@ -188,14 +228,55 @@ bool net::capture::socket::recv()
     if (ioctl(_M_fd, SIOCGSTAMP, &tv) != -1) {
       // For each received message...
       for (int i = 0; i < nmsgs; i++) {
-        // Process packet.
-        _M_callbacks.ethernet(_M_msg[i].msg_hdr.msg_iov->iov_base,
-                              _M_msg[i].msg_len,
-                              tv,
-                              _M_user);
+        struct msghdr* msg = &_M_msg[i].msg_hdr;
+
+        // Number of bytes captured (as MSG_TRUNC is set, 'msg_len' might be
+        // bigger than the buffer).
+        size_t len = (_M_msg[i].msg_len < msg->msg_iov->iov_len) ?
+                       _M_msg[i].msg_len :
+                       msg->msg_iov->iov_len;
+
+        // Get length of the frame on the wire.
+        size_t wirelen = _M_msg[i].msg_len;
+
+        const struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg);
+        if ((cmsg) &&
+            (cmsg->cmsg_level == SOL_PACKET) &&
+            (cmsg->cmsg_type == PACKET_AUXDATA)) {
+          wirelen = reinterpret_cast<const struct tpacket_auxdata*>(
+                      CMSG_DATA(cmsg)
+                    )->tp_len;
+        }
+
+        if (_M_callbacks.batch) {
+          frame& f = _M_batch[i];
+
+          f.buf = msg->msg_iov->iov_base;
+          f.len = len;
+          f.wirelen = wirelen;
+          f.timestamp = tv;
+          f.rxhash = 0;
+        } else {
+          // Process packet.
+          _M_callbacks.ethernet(msg->msg_iov->iov_base,
+                                len,
+                                wirelen,
+                                tv,
+                                _M_user);
+        }
+
+        // Reset length of the control message.
+        msg->msg_controllen = control_size;
+      }
+
+      // Process the batch of packets.
+      if (_M_callbacks.batch) {
+        _M_callbacks.batch(_M_batch, static_cast<size_t>(nmsgs), _M_user);
       }
     }
+
+    return true;
   }
 
-  return true;
+  return false;
 }
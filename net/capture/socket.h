@@ -2,8 +2,13 @@
 #define NET_CAPTURE_SOCKET_H
 
 #include <stdint.h>
+#include <sys/socket.h>
 #include <net/if.h>
+#include <linux/if_packet.h>
 #include "net/capture/callbacks.h"
+#include "net/capture/busy_poll.h"
+#include "net/capture/fanout.h"
+#include "net/capture/filter.h"
 
 namespace net {
   namespace capture {
@@ -20,11 +25,25 @@ namespace net {
         void clear();
 
         // Create.
+        // 'snaplen': snapshot length set by the socket filter (0: the whole
+        // frames are captured).
         bool create(const char* interface,
                     int rcvbuf_size,
-                    bool promiscuous_mode);
+                    bool promiscuous_mode,
+                    size_t snaplen,
+                    const fanout& fanout);
 
-        bool create(unsigned ifindex, int rcvbuf_size, bool promiscuous_mode);
+        bool create(unsigned ifindex,
+                    int rcvbuf_size,
+                    bool promiscuous_mode,
+                    size_t snaplen,
+                    const fanout& fanout);
+
+        // Enable busy poll.
+        bool enable_busy_poll(size_t spins, int usecs);
+
+        // Attach filter.
+        bool attach_filter(const filter& filter);
 
         // Loop.
         bool loop(const callbacks& callbacks, void* user = nullptr);
@@ -42,17 +61,35 @@ namespace net {
         // Maximum message size.
         static constexpr const size_t max_message_size = 64 * 1024;
 
+        // Minimum message size when a snapshot length is set (DNS messages
+        // are captured whole).
+        static constexpr const size_t min_snap_message_size = 8 * 1024;
+
+        // Size of the control message (auxiliary data).
+        static constexpr const size_t
+               control_size = CMSG_SPACE(sizeof(struct tpacket_auxdata));
+
         int _M_fd = -1;
 
         struct mmsghdr _M_msg[max_messages];
         struct iovec _M_iov[max_messages];
 
+        // Control messages (they contain the length of the frames on the
+        // wire).
+        uint8_t _M_control[max_messages][control_size];
+
         uint8_t* _M_buf = nullptr;
 
         // Callbacks.
         callbacks _M_callbacks;
         void* _M_user;
 
+        // Frames passed to the batch callback.
+        frame _M_batch[max_messages];
+
+        // Busy poll.
+        busy_poll _M_busy_poll;
+
         // Running?
         bool _M_running = false;
 
@@ -77,9 +114,25 @@ namespace net {
 
     inline bool socket::create(const char* interface,
                                int rcvbuf_size,
-                               bool promiscuous_mode)
+                               bool promiscuous_mode,
+                               size_t snaplen,
+                               const fanout& fanout)
+    {
+      return create(if_nametoindex(interface),
+                    rcvbuf_size,
+                    promiscuous_mode,
+                    snaplen,
+                    fanout);
+    }
+
+    inline bool socket::enable_busy_poll(size_t spins, int usecs)
+    {
+      return _M_busy_poll.init(_M_fd, spins, usecs);
+    }
+
+    inline bool socket::attach_filter(const filter& filter)
     {
-      return create(if_nametoindex(interface), rcvbuf_size, promiscuous_mode);
+      return filter.attach(_M_fd);
     }
 
     inline void socket::stop()
@@ -0,0 +1,448 @@
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <linux/if_link.h>
+#include <errno.h>
+#include "net/capture/xdp.h"
+#include "net/capture/bpf.h"
+
+#ifndef AF_XDP
+  #define AF_XDP 44
+#endif
+
+#ifndef SOL_XDP
+  #define SOL_XDP 283
+#endif
+
+void net::capture::xdp::program::clear()
+{
+  // Closing the link detaches the program from the interface.
+  if (_M_link != -1) {
+    close(_M_link);
+    _M_link = -1;
+  }
+
+  if (_M_prog != -1) {
+    close(_M_prog);
+    _M_prog = -1;
+  }
+
+  if (_M_map != -1) {
+    close(_M_map);
+    _M_map = -1;
+  }
+
+  _M_ifindex = 0;
+}
+
+bool net::capture::xdp::program::create(unsigned ifindex,
+                                        mode m,
+                                        unsigned nqueues)
+{
+  if ((ifindex > 0) && (nqueues > 0)) {
+    // Create XSK map (queue index -> XDP socket).
+    if ((_M_map = bpf::create_map(BPF_MAP_TYPE_XSKMAP,
+                                  sizeof(uint32_t),
+                                  sizeof(uint32_t),
+                                  nqueues)) != -1) {
+      // r2 = ctx->rx_queue_index
+      // r1 = map
+      // r3 = XDP_PASS (action when there is no socket for the queue)
+      // return bpf_redirect_map(r1, r2, r3)
+      const struct bpf_insn insns[] = {
+        {
+          BPF_LDX | BPF_MEM | BPF_W,
+          BPF_REG_2,
+          BPF_REG_1,
+          offsetof(struct xdp_md, rx_queue_index),
+          0
+        },
+        {BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, _M_map},
+        {0, 0, 0, 0, 0},
+        {BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS},
+        {BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map},
+        {BPF_JMP | BPF_EXIT, 0, 0, 0, 0}
+      };
+
+      // Load program.
+      if ((_M_prog = bpf::load_program(BPF_PROG_TYPE_XDP,
+                                       insns,
+                                       sizeof(insns) / sizeof(insns[0]))) !=
+          -1) {
+        // Attach program to the interface.
+        if ((_M_link = bpf::attach_xdp(_M_prog,
+                                       ifindex,
+                                       (m == mode::skb) ?
+                                         XDP_FLAGS_SKB_MODE :
+                                         XDP_FLAGS_DRV_MODE)) != -1) {
+          _M_ifindex = ifindex;
+          _M_mode = m;
+
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+bool net::capture::xdp::program::add(unsigned queue, int fd)
+{
+  uint32_t key = queue;
+  uint32_t value = static_cast<uint32_t>(fd);
+
+  return bpf::update_map(_M_map, &key, &value);
+}
+
+void net::capture::xdp::clear()
+{
+  munmap_ring(_M_rx);
+  munmap_ring(_M_fill);
+  munmap_ring(_M_completion);
+
+  if (_M_fd != -1) {
+    close(_M_fd);
+    _M_fd = -1;
+  }
+
+  if (_M_umem != MAP_FAILED) {
+    munmap(_M_umem, _M_umem_size);
+    _M_umem = static_cast<uint8_t*>(MAP_FAILED);
+  }
+
+  _M_npackets = 0;
+}
+
+bool net::capture::xdp::create(program& prog,
+                               unsigned queue,
+                               bool zero_copy,
+                               size_t frame_size,
+                               size_t frame_count)
+{
+  // The frame size and the number of frames have to be powers of 2.
+  if ((prog.ifindex() > 0) &&
+      (frame_size >= min_frame_size) &&
+      (frame_size <= max_frame_size) &&
+      ((frame_size & (frame_size - 1)) == 0) &&
+      (frame_count >= min_frames) &&
+      (frame_count <= max_frames) &&
+      ((frame_count & (frame_count - 1)) == 0)) {
+    // Create socket.
+    if ((_M_fd = socket(AF_XDP, SOCK_RAW, 0)) != -1) {
+      uint16_t flags = XDP_USE_NEED_WAKEUP;
+
+      if (zero_copy) {
+        flags |= XDP_ZEROCOPY;
+      } else if (prog.xdp_mode() == mode::skb) {
+        flags |= XDP_COPY;
+      }
+
+      if ((setup_umem(frame_size, frame_count)) &&
+          (setup_rings(frame_count)) &&
+          (bind(prog.ifindex(), queue, flags)) &&
+          (prog.add(queue, _M_fd))) {
+        populate_fill_ring(frame_size, frame_count);
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool net::capture::xdp::loop(const callbacks& callbacks, void* user)
+{
+  static constexpr const int timeout = 100;
+
+  _M_callbacks = callbacks;
+  _M_user = user;
+
+  struct pollfd pfd;
+  pfd.fd = _M_fd;
+  pfd.events = POLLIN;
+
+  _M_running = true;
+
+  do {
+    if (_M_busy_poll.spins() > 0) {
+      // Spin waiting for new packets before sleeping.
+      bool received = false;
+      size_t spins = _M_busy_poll.spins();
+
+      do {
+        if (recv()) {
+          _M_busy_poll.hit();
+          received = true;
+
+          break;
+        }
+
+        busy_poll::relax();
+      } while (--spins > 0);
+
+      if (received) {
+        continue;
+      }
+    }
+
+    _M_busy_poll.sleep();
+
+    switch (poll(&pfd, 1, timeout)) {
+      case 1:
+        recv();
+        break;
+      case 0: // Timeout.
+        if (callbacks.idle) {
+          callbacks.idle(user);
+        }
+
+        break;
+      default:
+        if (errno != EINTR) {
+          return false;
+        }
+    }
+  } while (_M_running);
+
+  return true;
+}
+
+bool net::capture::xdp::show_statistics()
+{
+  struct xdp_statistics stats;
+  socklen_t optlen = static_cast<socklen_t>(sizeof(struct xdp_statistics));
+
+  if (getsockopt(_M_fd, SOL_XDP, XDP_STATISTICS, &stats, &optlen) == 0) {
+    printf("  %llu packets received.\n",
+           static_cast<unsigned long long>(_M_npackets));
+
+    printf("  %llu packets dropped by kernel.\n",
+           static_cast<unsigned long long>(stats.rx_dropped));
+
+    printf("  %llu packets dropped (RX ring full).\n",
+           static_cast<unsigned long long>(stats.rx_ring_full));
+
+    printf("  %llu times the fill ring was empty.\n",
+           static_cast<unsigned long long>(stats.rx_fill_ring_empty_descs));
+
+    printf("  %llu invalid descriptors.\n",
+           static_cast<unsigned long long>(stats.rx_invalid_descs));
+
+    _M_busy_poll.show_statistics();
+
+    return true;
+  }
+
+  return false;
+}
+
+bool net::capture::xdp::setup_umem(size_t frame_size, size_t frame_count)
+{
+  _M_umem_size = frame_size * frame_count;
+
+  // Allocate UMEM.
+  if ((_M_umem = static_cast<uint8_t*>(
+                   mmap(nullptr,
+                        _M_umem_size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE,
+                        -1,
+                        0)
+                 )) != MAP_FAILED) {
+    // Register UMEM.
+    struct xdp_umem_reg reg;
+    memset(&reg, 0, sizeof(struct xdp_umem_reg));
+    reg.addr = reinterpret_cast<uintptr_t>(_M_umem);
+    reg.len = _M_umem_size;
+    reg.chunk_size = static_cast<uint32_t>(frame_size);
+    reg.headroom = 0;
+
+    if (setsockopt(_M_fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) == 0) {
+      _M_frame_mask = ~(static_cast<uint64_t>(frame_size) - 1);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool net::capture::xdp::setup_rings(size_t frame_count)
+{
+  int size = static_cast<int>(frame_count);
+
+  // Set the size of the rings.
+  if ((setsockopt(_M_fd,
+                  SOL_XDP,
+                  XDP_UMEM_FILL_RING,
+                  &size,
+                  sizeof(int)) == 0) &&
+      (setsockopt(_M_fd,
+                  SOL_XDP,
+                  XDP_UMEM_COMPLETION_RING,
+                  &size,
+                  sizeof(int)) == 0) &&
+      (setsockopt(_M_fd, SOL_XDP, XDP_RX_RING, &size, sizeof(int)) == 0)) {
+    // Get the offsets of the rings.
+    struct xdp_mmap_offsets off;
+    socklen_t optlen = static_cast<socklen_t>(sizeof(struct xdp_mmap_offsets));
+
+    if (getsockopt(_M_fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) == 0) {
+      // Map rings into memory.
+      return ((mmap_ring(_M_rx,
+                         off.rx,
+                         frame_count,
+                         sizeof(struct xdp_desc),
+                         XDP_PGOFF_RX_RING)) &&
+              (mmap_ring(_M_fill,
+                         off.fr,
+                         frame_count,
+                         sizeof(uint64_t),
+                         XDP_UMEM_PGOFF_FILL_RING)) &&
+              (mmap_ring(_M_completion,
+                         off.cr,
+                         frame_count,
+                         sizeof(uint64_t),
+                         XDP_UMEM_PGOFF_COMPLETION_RING)));
+    }
+  }
+
+  return false;
+}
+
+bool net::capture::xdp::mmap_ring(ring& r,
+                                  const struct xdp_ring_offset& off,
+                                  size_t size,
+                                  size_t descsize,
+                                  uint64_t pgoff)
+{
+  r.len = off.desc + (size * descsize);
+
+  if ((r.base = mmap(nullptr,
+                     r.len,
+                     PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE,
+                     _M_fd,
+                     pgoff)) != MAP_FAILED) {
+    uint8_t* base = static_cast<uint8_t*>(r.base);
+
+    r.producer = reinterpret_cast<uint32_t*>(base + off.producer);
+    r.consumer = reinterpret_cast<uint32_t*>(base + off.consumer);
+    r.flags = reinterpret_cast<uint32_t*>(base + off.flags);
+    r.descs = base + off.desc;
+
+    r.mask = static_cast<uint32_t>(size - 1);
+
+    return true;
+  }
+
+  return false;
+}
+
+void net::capture::xdp::munmap_ring(ring& r)
+{
+  if (r.base != MAP_FAILED) {
+    munmap(r.base, r.len);
+    r.base = MAP_FAILED;
+  }
+}
+
+void net::capture::xdp::populate_fill_ring(size_t frame_size,
+                                           size_t frame_count)
+{
+  uint64_t* addrs = static_cast<uint64_t*>(_M_fill.descs);
+  uint32_t prod = *_M_fill.producer;
+
+  for (size_t i = 0; i < frame_count; i++) {
+    addrs[(prod + i) & _M_fill.mask] = i * frame_size;
+  }
+
+  __atomic_store_n(_M_fill.producer,
+                   prod + static_cast<uint32_t>(frame_count),
+                   __ATOMIC_RELEASE);
+}
+
+bool net::capture::xdp::bind(unsigned ifindex, unsigned queue, uint16_t flags)
+{
+  struct sockaddr_xdp addr;
+  memset(&addr, 0, sizeof(struct sockaddr_xdp));
+  addr.sxdp_family = AF_XDP;
+  addr.sxdp_flags = flags;
+  addr.sxdp_ifindex = ifindex;
+  addr.sxdp_queue_id = queue;
+
+  return (::bind(_M_fd,
+                 reinterpret_cast<const struct sockaddr*>(&addr),
+                 static_cast<socklen_t>(sizeof(struct sockaddr_xdp))) == 0);
+}
+
+bool net::capture::xdp::recv()
+{
+  uint32_t cons = *_M_rx.consumer;
+  uint32_t n = __atomic_load_n(_M_rx.producer, __ATOMIC_ACQUIRE) - cons;
+
+  // If there are new packets...
+  if (n > 0) {
+    const struct xdp_desc* descs = static_cast<const struct xdp_desc*>(
+                                     _M_rx.descs
+                                   );
+
+    uint64_t* addrs = static_cast<uint64_t*>(_M_fill.descs);
+    uint32_t prod = *_M_fill.producer;
+
+    // Get current time.
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+
+    size_t nframes = 0;
+
+    // Process packets.
+    for (uint32_t i = 0; i < n; i++) {
+      const struct xdp_desc& desc = descs[(cons + i) & _M_rx.mask];
+
+      if (_M_callbacks.batch) {
+        frame& f = _M_batch[nframes];
+
+        f.buf = _M_umem + desc.addr;
+        f.len = desc.len;
+        f.wirelen = desc.len;
+        f.timestamp = tv;
+        f.rxhash = 0;
+
+        // If the batch is full or this is the last packet...
+        if ((++nframes == callbacks::max_batch) || (i + 1 == n)) {
+          _M_callbacks.batch(_M_batch, nframes, _M_user);
+          nframes = 0;
+        }
+      } else {
+        _M_callbacks.ethernet(_M_umem + desc.addr,
+                              desc.len,
+                              desc.len,
+                              tv,
+                              _M_user);
+      }
+
+      // Give the frame back to the kernel. The fill ring has room for all
+      // the frames, so it cannot be full.
+      addrs[(prod + i) & _M_fill.mask] = desc.addr & _M_frame_mask;
+    }
+
+    __atomic_store_n(_M_rx.consumer, cons + n, __ATOMIC_RELEASE);
+    __atomic_store_n(_M_fill.producer, prod + n, __ATOMIC_RELEASE);
+
+    _M_npackets += n;
+
+    // Wake up the kernel if it is waiting for frames.
+    if ((*_M_fill.flags & XDP_RING_NEED_WAKEUP) != 0) {
+      recvfrom(_M_fd, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    }
+
+    return true;
+  }
+
+  return false;
+}
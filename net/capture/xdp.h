@@ -0,0 +1,223 @@
+#ifndef NET_CAPTURE_XDP_H
+#define NET_CAPTURE_XDP_H
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <net/if.h>
+#include <linux/if_xdp.h>
+#include "net/capture/callbacks.h"
+#include "net/capture/busy_poll.h"
+
+namespace net {
+  namespace capture {
+    // AF_XDP socket.
+    class xdp {
+      public:
+        static constexpr const size_t min_frame_size = 2048;
+        static constexpr const size_t max_frame_size = 4096;
+        static constexpr const size_t default_frame_size = 2048;
+
+        static constexpr const size_t min_frames = 64;
+        static constexpr const size_t max_frames = static_cast<size_t>(1) << 20;
+        static constexpr const size_t
+               default_frames = static_cast<size_t>(1) << 12;
+
+        // XDP mode.
+        enum class mode {
+          native,
+          skb
+        };
+
+        // XDP program which redirects the packets received on each queue to
+        // the XDP socket bound to that queue.
+        class program {
+          public:
+            // Constructor.
+            program() = default;
+
+            // Destructor.
+            ~program();
+
+            // Clear.
+            void clear();
+
+            // Create.
+            bool create(const char* interface, mode m, unsigned nqueues);
+            bool create(unsigned ifindex, mode m, unsigned nqueues);
+
+            // Add XDP socket.
+            bool add(unsigned queue, int fd);
+
+            // Get interface index.
+            unsigned ifindex() const;
+
+            // Get XDP mode.
+            mode xdp_mode() const;
+
+          private:
+            // XSK map.
+            int _M_map = -1;
+
+            // Program.
+            int _M_prog = -1;
+
+            // Link.
+            int _M_link = -1;
+
+            // Interface index.
+            unsigned _M_ifindex = 0;
+
+            // XDP mode.
+            mode _M_mode = mode::native;
+
+            // Disable copy constructor and assignment operator.
+            program(const program&) = delete;
+            program& operator=(const program&) = delete;
+        };
+
+        // Constructor.
+        xdp() = default;
+
+        // Destructor.
+        ~xdp();
+
+        // Clear.
+        void clear();
+
+        // Create.
+        bool create(program& prog,
+                    unsigned queue,
+                    bool zero_copy,
+                    size_t frame_size,
+                    size_t frame_count);
+
+        // Enable busy poll.
+        bool enable_busy_poll(size_t spins, int usecs);
+
+        // Loop.
+        bool loop(const callbacks& callbacks, void* user = nullptr);
+
+        // Stop.
+        void stop();
+
+        // Show statistics.
+        bool show_statistics();
+
+      private:
+        // Ring shared with the kernel.
+        struct ring {
+          uint32_t* producer;
+          uint32_t* consumer;
+          uint32_t* flags;
+          void* descs;
+
+          uint32_t mask;
+
+          void* base = MAP_FAILED;
+          size_t len;
+        };
+
+        int _M_fd = -1;
+
+        // UMEM.
+        uint8_t* _M_umem = static_cast<uint8_t*>(MAP_FAILED);
+        size_t _M_umem_size;
+
+        // Mask for getting the beginning of a frame.
+        uint64_t _M_frame_mask;
+
+        // RX ring.
+        ring _M_rx;
+
+        // Fill ring.
+        ring _M_fill;
+
+        // Completion ring.
+        ring _M_completion;
+
+        // Number of packets received.
+        uint64_t _M_npackets = 0;
+
+        // Callbacks.
+        callbacks _M_callbacks;
+        void* _M_user;
+
+        // Busy poll.
+        busy_poll _M_busy_poll;
+
+        // Running?
+        bool _M_running = false;
+
+        // Frames passed to the batch callback.
+        frame _M_batch[callbacks::max_batch];
+
+        // Set up UMEM.
+        bool setup_umem(size_t frame_size, size_t frame_count);
+
+        // Set up rings.
+        bool setup_rings(size_t frame_count);
+
+        // Map ring.
+        bool mmap_ring(ring& r,
+                       const struct xdp_ring_offset& off,
+                       size_t size,
+                       size_t descsize,
+                       uint64_t pgoff);
+
+        // Unmap ring.
+        static void munmap_ring(ring& r);
+
+        // Fill the fill ring with all the frames.
+        void populate_fill_ring(size_t frame_size, size_t frame_count);
+
+        // Bind.
+        bool bind(unsigned ifindex, unsigned queue, uint16_t flags);
+
+        // Receive packets.
+        bool recv();
+
+        // Disable copy constructor and assignment operator.
+        xdp(const xdp&) = delete;
+        xdp& operator=(const xdp&) = delete;
+    };
+
+    inline xdp::program::~program()
+    {
+      clear();
+    }
+
+    inline bool xdp::program::create(const char* interface,
+                                     mode m,
+                                     unsigned nqueues)
+    {
+      return create(if_nametoindex(interface), m, nqueues);
+    }
+
+    inline unsigned xdp::program::ifindex() const
+    {
+      return _M_ifindex;
+    }
+
+    inline xdp::mode xdp::program::xdp_mode() const
+    {
+      return _M_mode;
+    }
+
+    inline xdp::~xdp()
+    {
+      clear();
+    }
+
+    inline bool xdp::enable_busy_poll(size_t spins, int usecs)
+    {
+      return _M_busy_poll.init(_M_fd, spins, usecs);
+    }
+
+    inline void xdp::stop()
+    {
+      _M_running = false;
+    }
+  }
+}
+
+#endif // NET_CAPTURE_XDP_H
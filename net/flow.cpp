@@ -0,0 +1,173 @@
+#include <string.h>
+#include <net/ethernet.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <arpa/inet.h>
+#include "net/flow.h"
+#include "util/hash.h"
+
+uint32_t net::flow::hash_ethernet(const void* buf, size_t len)
+{
+  // If the frame is big enough...
+  if (len > sizeof(struct ether_header)) {
+    // Make 'b' point to the ether_type.
+    const uint8_t* b = static_cast<const uint8_t*>(buf) +
+                       (sizeof(struct ether_addr) << 1);
+
+    // Subtract length of the ethernet header.
+    len -= sizeof(struct ether_header);
+
+    do {
+      // Check ether_type.
+      switch ((static_cast<uint16_t>(*b) << 8) | b[1]) {
+        case ETH_P_IP:
+          return hash_ipv4(b + 2, len);
+        case ETH_P_IPV6:
+          return hash_ipv6(b + 2, len);
+        case ETH_P_8021Q:
+        case ETH_P_8021AD:
+          // If the frame is big enough...
+          if (len > 4) {
+            // Make 'b' point to the ether_type.
+            b += 4;
+
+            len -= 4;
+          } else {
+            return 0;
+          }
+
+          break;
+        case ETH_P_MPLS_UC:
+        case ETH_P_MPLS_MC:
+          // Skip ether_type.
+          b += 2;
+
+          do {
+            // If the frame is big enough...
+            if (len > 4) {
+              // Bottom of the stack?
+              if (b[2] & 0x01) {
+                // Check IP version.
+                switch (b[4] & 0xf0) {
+                  case 0x40: // IPv4.
+                    return hash_ipv4(b + 4, len - 4);
+                  case 0x60: // IPv6.
+                    return hash_ipv6(b + 4, len - 4);
+                  default:
+                    return 0;
+                }
+              } else {
+                // Skip MPLS label.
+                b += 4;
+
+                len -= 4;
+              }
+            } else {
+              return 0;
+            }
+          } while (true);
+
+          break;
+        default:
+          return 0;
+      }
+    } while (true);
+  }
+
+  return 0;
+}
+
+uint32_t net::flow::hash_ipv4(const void* buf, size_t len)
+{
+  // If the packet is big enough...
+  if (len >= sizeof(struct iphdr)) {
+    const struct iphdr* iphdr = static_cast<const struct iphdr*>(buf);
+
+    size_t iphdrsize = static_cast<size_t>(iphdr->ihl) << 2;
+
+    uint16_t port1 = 0;
+    uint16_t port2 = 0;
+
+    // If the packet is not a fragment and the ports have been captured...
+    if (((iphdr->protocol == IPPROTO_TCP) ||
+         (iphdr->protocol == IPPROTO_UDP)) &&
+        ((iphdr->frag_off & htons(IP_MF | IP_OFFMASK)) == 0) &&
+        (iphdrsize + 4 <= len)) {
+      const uint8_t* ports = static_cast<const uint8_t*>(buf) + iphdrsize;
+
+      memcpy(&port1, ports, 2);
+      memcpy(&port2, ports + 2, 2);
+    }
+
+    return hash(iphdr->saddr, iphdr->daddr, port1, port2);
+  }
+
+  return 0;
+}
+
+uint32_t net::flow::hash_ipv6(const void* buf, size_t len)
+{
+  // If the packet is big enough...
+  if (len >= sizeof(struct ip6_hdr)) {
+    const struct ip6_hdr* iphdr = static_cast<const struct ip6_hdr*>(buf);
+
+    // Fold the addresses into 32 bits.
+    uint32_t addr1 = iphdr->ip6_src.s6_addr32[0] ^
+                     iphdr->ip6_src.s6_addr32[1] ^
+                     iphdr->ip6_src.s6_addr32[2] ^
+                     iphdr->ip6_src.s6_addr32[3];
+
+    uint32_t addr2 = iphdr->ip6_dst.s6_addr32[0] ^
+                     iphdr->ip6_dst.s6_addr32[1] ^
+                     iphdr->ip6_dst.s6_addr32[2] ^
+                     iphdr->ip6_dst.s6_addr32[3];
+
+    uint16_t port1 = 0;
+    uint16_t port2 = 0;
+
+    // If there are no extension headers and the ports have been captured...
+    if (((iphdr->ip6_nxt == IPPROTO_TCP) || (iphdr->ip6_nxt == IPPROTO_UDP)) &&
+        (sizeof(struct ip6_hdr) + 4 <= len)) {
+      const uint8_t* ports = static_cast<const uint8_t*>(buf) +
+                             sizeof(struct ip6_hdr);
+
+      memcpy(&port1, ports, 2);
+      memcpy(&port2, ports + 2, 2);
+    }
+
+    return hash(addr1, addr2, port1, port2);
+  }
+
+  return 0;
+}
+
+uint32_t net::flow::hash(uint32_t addr1,
+                         uint32_t addr2,
+                         uint16_t port1,
+                         uint16_t port2)
+{
+  // Sort the addresses and the ports, so both directions of the flow have
+  // the same hash.
+  if (addr1 > addr2) {
+    uint32_t addr = addr1;
+    addr1 = addr2;
+    addr2 = addr;
+  }
+
+  if (port1 > port2) {
+    uint16_t port = port1;
+    port1 = port2;
+    port2 = port;
+  }
+
+  // The initial value is different from the one used for selecting the
+  // bucket of the connections, otherwise the workers would only use some
+  // of the buckets (the worker is selected by the lowest bits of the hash).
+  static constexpr const uint32_t initval = 0x9e3779b9;
+
+  return util::hash::hash_3words(addr1,
+                                 addr2,
+                                 (static_cast<uint32_t>(port1) << 16) | port2,
+                                 initval);
+}
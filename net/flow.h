@@ -0,0 +1,32 @@
+#ifndef NET_FLOW_H
+#define NET_FLOW_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+namespace net {
+  // Flow hashing.
+  //
+  // The hash is symmetric: both directions of a flow (addresses and ports
+  // of TCP / UDP) have the same hash. Non-IP frames have the hash 0.
+  class flow {
+    public:
+      // Hash of the flow of an ethernet frame.
+      static uint32_t hash_ethernet(const void* buf, size_t len);
+
+      // Hash of the flow of an IPv4 packet.
+      static uint32_t hash_ipv4(const void* buf, size_t len);
+
+      // Hash of the flow of an IPv6 packet.
+      static uint32_t hash_ipv6(const void* buf, size_t len);
+
+    private:
+      // Hash addresses and ports.
+      static uint32_t hash(uint32_t addr1,
+                           uint32_t addr2,
+                           uint16_t port1,
+                           uint16_t port2);
+  };
+}
+
+#endif // NET_FLOW_H
@@ -26,6 +26,14 @@ namespace net {
       bool match(const struct in6_addr& addr) const;
       bool match(const void* addr, size_t addrlen) const;
 
+      // Is it an IPv4 mask?
+      bool ipv4() const;
+
+      // Get the 'idx'-th 32-bit word of the network address / network mask
+      // in host byte order (IPv4: 'idx' = 0, IPv6: 'idx' = 0 .. 3).
+      uint32_t network(size_t idx) const;
+      uint32_t netmask(size_t idx) const;
+
     private:
       enum class type {
         ipv4,
@@ -96,6 +104,23 @@ namespace net {
         return false;
     }
   }
+
+  inline bool mask::ipv4() const
+  {
+    return (_M_type == type::ipv4);
+  }
+
+  inline uint32_t mask::network(size_t idx) const
+  {
+    return (_M_type == type::ipv4) ? _M_netmask.addr32[idx] :
+                                     ntohl(_M_netmask.addr32[idx]);
+  }
+
+  inline uint32_t mask::netmask(size_t idx) const
+  {
+    return (_M_type == type::ipv4) ? _M_mask.addr32[idx] :
+                                     ntohl(_M_mask.addr32[idx]);
+  }
 }
 
 #endif // NET_MASK_H
@@ -6,9 +6,15 @@
 #include <net/if.h>
 #include "net/mon/configuration.h"
 #include "net/capture/limits.h"
+#include "net/mon/event/grammar/parser.h"
+#include "net/mon/event/grammar/compiler.h"
 #include "util/parser/number.h"
 #include "util/parser/size.h"
 
+static bool compile_filter(const char* expression,
+                           size_t snaplen,
+                           net::capture::filter& filter);
+
 bool net::mon::configuration::capture::ring_buffer::valid() const
 {
   if ((block_size < net::capture::ring_buffer::min_block_size) ||
@@ -70,6 +76,9 @@ void net::mon::configuration::capture::ring_buffer::print() const
 
   printf("  Ring buffer size: %zu.\n", block_count * block_size);
 
+  printf("  Dispatcher (software RSS)? %s.\n", dispatcher ? "yes" : "no");
+  printf("  Use kernel RX hash? %s.\n", rxhash ? "yes" : "no");
+
   printf("\n");
 }
 
@@ -98,17 +107,263 @@ void net::mon::configuration::capture::ring_buffer::help()
           "    --ring-buffer-frame-count <number>\n"
           "      <number>: number of frames in the ring buffer.\n"
           "      Range: %zu .. %zu, default: %zu.\n"
-          "      Optional.\n",
+          "      Optional.\n\n",
           net::capture::ring_buffer::min_frames,
           net::capture::ring_buffer::max_frames,
           net::capture::ring_buffer::default_frames);
 
+  fprintf(stderr,
+          "    --ring-buffer-dispatcher\n"
+          "      Capture with a single ring buffer (no fanout) and dispatch "
+          "the frames\n"
+          "      to the workers by the hash of their flow (software RSS).\n"
+          "      Default: no.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --ring-buffer-rxhash\n"
+          "      Use the hash computed by the kernel (TPACKET_V3) for "
+          "selecting the\n"
+          "      bucket of the TCP/IPv4 connections. The hash must be "
+          "symmetric: don't\n"
+          "      use it if the NIC computes the hash with an asymmetric "
+          "RSS key.\n"
+          "      Default: no.\n"
+          "      Optional.\n");
+
+  fprintf(stderr, "\n\n");
+}
+
+bool net::mon::configuration::capture::fanout::valid() const
+{
+  if ((program) && (m != net::capture::fanout::mode::ebpf)) {
+    fprintf(stderr,
+            "\"--fanout-ebpf-program\" requires the fanout mode \"ebpf\"."
+            "\n\n");
+
+    return false;
+  }
+
+  return true;
+}
+
+void net::mon::configuration::capture::fanout::print() const
+{
+  static const char* const modes[] = {
+    "hash",
+    "cpu",
+    "qm",
+    "lb",
+    "rollover",
+    "ebpf"
+  };
+
+  printf("Fanout configuration:\n");
+
+  printf("  Fanout mode: \"%s\".\n", modes[static_cast<unsigned>(m)]);
+  printf("  Rollover? %s.\n", rollover ? "yes" : "no");
+
+  if (group != net::capture::fanout::no_group) {
+    printf("  Group id: %d.\n", group);
+  } else {
+    printf("  Group id: not set.\n");
+  }
+
+  if (m == net::capture::fanout::mode::ebpf) {
+    if (program) {
+      printf("  eBPF steering program: \"%s\".\n", program);
+    } else {
+      printf("  eBPF steering program: built-in (symmetric 5-tuple hash).\n");
+    }
+  }
+
+  printf("\n");
+}
+
+void net::mon::configuration::capture::fanout::help()
+{
+  fprintf(stderr, "  Fanout configuration (\"ring-buffer\" and \"socket\"):\n");
+  fprintf(stderr,
+          "    --fanout-mode <mode>\n"
+          "      <mode> ::= \"hash\" | \"cpu\" | \"qm\" | \"lb\" | "
+          "\"rollover\" | \"ebpf\"\n"
+          "      \"hash\": symmetric hash of the flow (kernel).\n"
+          "      \"cpu\": CPU which received the packet.\n"
+          "      \"qm\": receive queue of the packet.\n"
+          "      \"lb\": round-robin.\n"
+          "      \"rollover\": fill a worker before moving to the next one."
+          "\n"
+          "      \"ebpf\": eBPF steering program.\n"
+          "      Only \"hash\" and \"ebpf\" (with a symmetric program) keep "
+          "both\n"
+          "      directions of a flow in the same worker; \"cpu\" and \"qm\" "
+          "do it\n"
+          "      only if the NIC is configured with a symmetric RSS hash.\n"
+          "      Default: \"hash\".\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --fanout-rollover\n"
+          "      When the selected worker is backlogged, deliver the packet "
+          "to\n"
+          "      another worker instead of dropping it (that worker won't "
+          "find\n"
+          "      the TCP connection of the packet).\n"
+          "      Default: no.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --fanout-group <number>\n"
+          "      <number>: fanout group id.\n"
+          "      Range: 0 .. %d, default: process id ^ interface index.\n"
+          "      Optional.\n\n",
+          net::capture::fanout::max_group);
+
+  fprintf(stderr,
+          "    --fanout-ebpf-program <filename>\n"
+          "      <filename>: pinned eBPF steering program (BPF file system)."
+          "\n"
+          "      Default: built-in symmetric 5-tuple hash.\n"
+          "      Optional.\n");
+
+  fprintf(stderr, "\n\n");
+}
+
+bool net::mon::configuration::capture::xdp::valid() const
+{
+  if ((frame_size < net::capture::xdp::min_frame_size) ||
+      (frame_size > net::capture::xdp::max_frame_size) ||
+      ((frame_size & (frame_size - 1)) != 0)) {
+    fprintf(stderr,
+            "Frame size (%zu) must be a power of 2 in the range %zu .. %zu."
+            "\n\n",
+            frame_size,
+            net::capture::xdp::min_frame_size,
+            net::capture::xdp::max_frame_size);
+
+    return false;
+  }
+
+  if ((frame_count < net::capture::xdp::min_frames) ||
+      (frame_count > net::capture::xdp::max_frames) ||
+      ((frame_count & (frame_count - 1)) != 0)) {
+    fprintf(stderr,
+            "Number of frames (%zu) must be a power of 2 in the range "
+            "%zu .. %zu.\n\n",
+            frame_count,
+            net::capture::xdp::min_frames,
+            net::capture::xdp::max_frames);
+
+    return false;
+  }
+
+  return true;
+}
+
+void net::mon::configuration::capture::xdp::print() const
+{
+  printf("AF_XDP configuration:\n");
+
+  printf("  XDP mode: \"%s\".\n",
+         (m == net::capture::xdp::mode::native) ? "native" : "skb");
+
+  printf("  First queue: %u.\n", queue);
+  printf("  Zero-copy? %s.\n", zero_copy ? "yes" : "no");
+  printf("  Frame size: %zu.\n", frame_size);
+  printf("  Number of frames: %zu.\n", frame_count);
+  printf("  UMEM size: %zu.\n", frame_count * frame_size);
+
+  printf("\n");
+}
+
+void net::mon::configuration::capture::xdp::help()
+{
+  fprintf(stderr, "  AF_XDP configuration:\n");
+  fprintf(stderr,
+          "    --xdp-mode <mode>\n"
+          "      <mode> ::= \"native\" | \"skb\"\n"
+          "      \"native\": the XDP program runs in the driver.\n"
+          "      \"skb\": generic XDP (works with every driver, slower).\n"
+          "      Default: \"native\".\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --xdp-queue <number>\n"
+          "      <number>: first receive queue. The worker 'n' receives the\n"
+          "                packets of the queue '<number> + n'.\n"
+          "      Default: 0.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --xdp-zero-copy\n"
+          "      Require zero-copy mode (the driver has to support it).\n"
+          "      Default: no.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --xdp-frame-size <size>\n"
+          "      <size>: size of the UMEM frame (power of 2).\n"
+          "      Range: %zu .. %zu, default: %zu.\n"
+          "      Optional.\n\n",
+          net::capture::xdp::min_frame_size,
+          net::capture::xdp::max_frame_size,
+          net::capture::xdp::default_frame_size);
+
+  fprintf(stderr,
+          "    --xdp-frame-count <number>\n"
+          "      <number>: number of UMEM frames per worker (power of 2).\n"
+          "      Range: %zu .. %zu, default: %zu.\n"
+          "      Optional.\n",
+          net::capture::xdp::min_frames,
+          net::capture::xdp::max_frames,
+          net::capture::xdp::default_frames);
+
   fprintf(stderr, "\n\n");
 }
 
 bool net::mon::configuration::capture::valid() const
 {
   if (device) {
+    if ((filter) && (m != method::ring_buffer) && (m != method::socket)) {
+      fprintf(stderr,
+              "Filters are only supported by the capture methods "
+              "\"ring-buffer\" and \"socket\".\n\n");
+
+      return false;
+    }
+
+    if ((ndevices > 1) && (m != method::pcap)) {
+      fprintf(stderr,
+              "Only the capture method \"pcap\" supports more than one "
+              "capture device.\n\n");
+
+      return false;
+    }
+
+    if ((rb.rxhash) && (m != method::ring_buffer)) {
+      fprintf(stderr,
+              "The kernel RX hash is only supported by the capture method "
+              "\"ring-buffer\".\n\n");
+
+      return false;
+    }
+
+    if ((rb.dispatcher) && (m != method::ring_buffer)) {
+      fprintf(stderr,
+              "The dispatcher is only supported by the capture method "
+              "\"ring-buffer\".\n\n");
+
+      return false;
+    }
+
+    if ((snaplen != 0) && (m != method::ring_buffer) && (m != method::socket)) {
+      fprintf(stderr,
+              "The snapshot length is only supported by the capture methods "
+              "\"ring-buffer\" and \"socket\".\n\n");
+
+      return false;
+    }
+
     switch (m) {
       case method::pcap:
         return true;
@@ -117,7 +372,11 @@ bool net::mon::configuration::capture::valid() const
         if (ifindex > 0) {
           if ((rcvbuf_size == 0) ||
               (rcvbuf_size >= net::capture::min_rcvbuf_size)) {
-            return (m == method::ring_buffer) ? rb.valid() : true;
+            if (fo.valid()) {
+              return (m == method::ring_buffer) ? rb.valid() : true;
+            }
+
+            return false;
           } else {
             fprintf(stderr,
                     "Invalid size of the socket receive buffer %d.\n\n",
@@ -127,6 +386,20 @@ bool net::mon::configuration::capture::valid() const
           fprintf(stderr, "Unknown network interface '%s'.\n\n", device);
         }
 
+        break;
+      case method::xdp:
+        if (ifindex > 0) {
+          if (!promiscuous_mode) {
+            return xsk.valid();
+          } else {
+            fprintf(stderr,
+                    "Promiscuous mode is not supported by the capture method "
+                    "\"xdp\".\n\n");
+          }
+        } else {
+          fprintf(stderr, "Unknown network interface '%s'.\n\n", device);
+        }
+
         break;
       case method::none:
         fprintf(stderr, "Capture method not set.\n\n");
@@ -155,9 +428,20 @@ void net::mon::configuration::capture::print() const
     case method::socket:
       printf("  Capture method: \"socket\".\n");
       break;
+    case method::xdp:
+      printf("  Capture method: \"xdp\".\n");
+      break;
   }
 
-  if (device) {
+  if (ndevices > 1) {
+    printf("  Capture devices:");
+
+    for (size_t i = 0; i < ndevices; i++) {
+      printf("%s \"%s\"", (i > 0) ? "," : "", devices[i]);
+    }
+
+    printf(".\n");
+  } else if (device) {
     printf("  Capture device: \"%s\".\n", device);
   } else {
     printf("  Capture device not set.\n");
@@ -166,6 +450,7 @@ void net::mon::configuration::capture::print() const
   switch (m) {
     case method::none:
     case method::pcap:
+    case method::xdp:
       break;
     case method::ring_buffer:
     case method::socket:
@@ -174,13 +459,51 @@ void net::mon::configuration::capture::print() const
       }
 
       printf("  Promiscuous mode? %s.\n", promiscuous_mode ? "yes" : "no");
+
+      if (filter) {
+        printf("  Filter: '%s'.\n", filter);
+      }
+
+      if (snaplen != 0) {
+        printf("  Snapshot length: %zu (DNS messages are captured whole).\n",
+               snaplen);
+      }
+
+      if (!filter_program.empty()) {
+        printf("  BPF filter: %zu instructions.\n", filter_program.size());
+      }
+
+      break;
+  }
+
+  switch (m) {
+    case method::none:
+    case method::pcap:
+      break;
+    case method::ring_buffer:
+    case method::socket:
+    case method::xdp:
+      if (busy_poll_spins > 0) {
+        printf("  Busy poll spins: %zu.\n", busy_poll_spins);
+      }
+
+      if (busy_poll_usecs > 0) {
+        printf("  SO_BUSY_POLL: %d microseconds.\n", busy_poll_usecs);
+      }
+
       break;
   }
 
   printf("\n");
 
+  if ((m == method::ring_buffer) || (m == method::socket)) {
+    fo.print();
+  }
+
   if (m == method::ring_buffer) {
     rb.print();
+  } else if (m == method::xdp) {
+    xsk.print();
   }
 }
 
@@ -189,15 +512,20 @@ void net::mon::configuration::capture::help()
   fprintf(stderr, "  Capture configuration:\n");
   fprintf(stderr,
           "    --capture-method <method>\n"
-          "      <method> ::= \"pcap\" | \"ring-buffer\" | \"socket\"\n"
+          "      <method> ::= \"pcap\" | \"ring-buffer\" | \"socket\" | "
+          "\"xdp\"\n"
           "      Mandatory.\n\n");
 
   fprintf(stderr,
           "    --capture-device <device>\n"
-          "      <device>: either a PCAP filename for the capture method "
-          "\"pcap\" or\n"
-          "                the name of a network interface.\n"
-          "      Mandatory.\n\n");
+          "      <device>: either a PCAP filename or a directory of PCAP "
+          "files for the\n"
+          "                capture method \"pcap\" or the name of a network "
+          "interface.\n"
+          "      Mandatory. The capture method \"pcap\" accepts up to %zu "
+          "capture devices,\n"
+          "      which are processed in order.\n\n",
+          max_devices);
 
   fprintf(stderr,
           "    --rcvbuf-size <size>\n"
@@ -210,11 +538,62 @@ void net::mon::configuration::capture::help()
           "    --promiscuous-mode\n"
           "      Enable interface's promiscuous mode.\n"
           "      Default: no.\n"
-          "      Optional.\n");
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --busy-poll-spins <number>\n"
+          "      <number>: number of times the receive ring (or socket) is "
+          "checked\n"
+          "                for new packets before sleeping in poll().\n"
+          "      Range: 0 .. %zu, default: 0 (don't spin).\n"
+          "      Optional.\n\n",
+          net::capture::busy_poll::max_spins);
+
+  fprintf(stderr,
+          "    --busy-poll-usecs <number>\n"
+          "      <number>: value of the socket option SO_BUSY_POLL "
+          "(microseconds).\n"
+          "      Range: 0 .. %d, default: 0 (not set).\n"
+          "      Optional.\n\n",
+          net::capture::busy_poll::max_usecs);
+
+  fprintf(stderr,
+          "    --filter <expression>\n"
+          "      <expression>: filter expression (same syntax as evreader's "
+          "filter),\n"
+          "                    compiled into a BPF socket filter.\n"
+          "                    Only packet-level identifiers can be used:\n"
+          "                    ip, source_ip, destination_ip, port, "
+          "source_port,\n"
+          "                    destination_port, icmp_type, icmp_code and "
+          "event_type.\n"
+          "      Only for the capture methods \"ring-buffer\" and "
+          "\"socket\".\n"
+          "      Default: not set.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --snaplen <size>\n"
+          "      <size>: number of bytes captured of each frame, except for "
+          "DNS\n"
+          "              messages, which are captured whole. The byte "
+          "counters use\n"
+          "              the length of the frames on the wire.\n"
+          "              If \"--ring-buffer-frame-size\" is not set, the "
+          "frame size\n"
+          "              is adjusted to the snapshot length.\n"
+          "      Range: %zu .. %zu, default: not set (capture whole frames).\n"
+          "      Only for the capture methods \"ring-buffer\" and "
+          "\"socket\".\n"
+          "      Optional.\n",
+          net::capture::min_snaplen,
+          net::capture::max_snaplen);
 
   fprintf(stderr, "\n\n");
 
+  fanout::help();
   ring_buffer::help();
+  xdp::help();
 }
 
 template<typename Connection>
@@ -248,6 +627,17 @@ bool net::mon::configuration::tcp<Connection>::valid() const
     return false;
   }
 
+  if ((table == net::mon::tcp::table::bucketed) &&
+      (maxconns > net::mon::tcp::bucketed_table<Connection>::max_connections)) {
+    fprintf(stderr,
+            "Maximum number of connections (%zu) of the bucketed hash table "
+            "must be less or equal than %zu.\n\n",
+            maxconns,
+            net::mon::tcp::bucketed_table<Connection>::max_connections);
+
+    return false;
+  }
+
   if (timeout < connections_type::min_timeout) {
     fprintf(stderr,
             "Connection timeout (%" PRIu64 ") must be greater or equal than %"
@@ -268,6 +658,36 @@ bool net::mon::configuration::tcp<Connection>::valid() const
     return false;
   }
 
+  if (untracked > net::mon::tcp::untracked_cache::max_entries) {
+    fprintf(stderr,
+            "Size of the cache of untracked connections (%zu) must be less or "
+            "equal than %zu.\n\n",
+            untracked,
+            net::mon::tcp::untracked_cache::max_entries);
+
+    return false;
+  }
+
+  if (half_open > half_open_table_type::max_entries) {
+    fprintf(stderr,
+            "Size of the table of half-open connections (%zu) must be less "
+            "or equal than %zu.\n\n",
+            half_open,
+            half_open_table_type::max_entries);
+
+    return false;
+  }
+
+  if ((memory > 0) && (memory < util::slab_pool::slab_size)) {
+    fprintf(stderr,
+            "Memory of the TCP connections (%zu) must be 0 or greater or "
+            "equal than %zu.\n\n",
+            memory,
+            util::slab_pool::slab_size);
+
+    return false;
+  }
+
   return true;
 }
 
@@ -282,6 +702,34 @@ void net::mon::configuration::tcp<Connection>::print() const
   printf("  Maximum number of connections: %zu.\n", maxconns);
   printf("  Connection timeout: %" PRIu64 ".\n", timeout);
   printf("  TCP time wait: %" PRIu64 ".\n", time_wait);
+  printf("  TCP update interval: %" PRIu64 ".\n", update_interval);
+  printf("  Hash table type: %s.\n",
+         (table == net::mon::tcp::table::chained) ? "chained" : "bucketed");
+
+  switch (hash) {
+    case net::mon::tcp::hash_function::lookup3:
+      printf("  Hash function: lookup3.\n");
+      break;
+    case net::mon::tcp::hash_function::crc32c:
+      printf("  Hash function: CRC32C.\n");
+      break;
+    case net::mon::tcp::hash_function::siphash:
+      printf("  Hash function: SipHash-1-3.\n");
+      break;
+  }
+
+  printf("  Cache of untracked connections: %zu entries.\n", untracked);
+  printf("  Adopt connections? %s.\n", adopt ? "yes" : "no");
+  printf("  Table of half-open connections: %zu entries.\n", half_open);
+  printf("  SYN flood threshold: %u.\n", syn_flood_threshold);
+
+  if (memory > 0) {
+    printf("  Memory of the TCP connections: %zu MiB.\n",
+           (memory / util::slab_pool::slab_size) *
+           (util::slab_pool::slab_size >> 20));
+  } else {
+    printf("  Memory of the TCP connections: no limit.\n");
+  }
 
   printf("\n");
 }
@@ -297,7 +745,9 @@ void net::mon::configuration::tcp<Connection>::help()
 
   fprintf(stderr,
           "    --tcp-ipv%u-hash-size <number>\n"
-          "      <number>: size of the hash table.\n"
+          "      <number>: initial size of the hash table (it grows and\n"
+          "      shrinks with the number of connections, but never below\n"
+          "      this size).\n"
           "      Range: %zu .. %zu, default: %zu.\n"
           "      Optional.\n\n",
           ip_version,
@@ -327,10 +777,98 @@ void net::mon::configuration::tcp<Connection>::help()
           "    --tcp-time-wait <number>\n"
           "      <number>: TCP time wait (seconds).\n"
           "      Greater or equal than: %" PRIu64 ", default: %" PRIu64 ".\n"
-          "      Optional.\n",
+          "      Optional.\n\n",
           connections_type::min_time_wait,
           connections_type::default_time_wait);
 
+  fprintf(stderr,
+          "    --tcp-update-interval <number>\n"
+          "      <number>: interval (seconds) of the 'Update TCP connection'\n"
+          "      events, with the traffic of each active connection since\n"
+          "      its previous update (0: no events).\n"
+          "      Range: 0 .. %u, default: 0.\n"
+          "      Optional.\n\n",
+          UINT32_MAX);
+
+  fprintf(stderr,
+          "    --tcp-hash-table <type>\n"
+          "      <type>:\n"
+          "        chained: chained buckets (linked lists of connections).\n"
+          "        bucketed: open addressing with buckets of 8 slots (one\n"
+          "                  cache line per bucket).\n"
+          "      Default: chained.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --tcp-hash-function <function>\n"
+          "      <function>: hash function of the connections (keyed with a\n"
+          "      random key generated at start-up):\n"
+          "        lookup3: Bob Jenkins' lookup3.\n"
+          "        crc32c: CRC32C (instruction crc32 of SSE4.2 if\n"
+          "                available), fast but the key doesn't prevent\n"
+          "                collisions.\n"
+          "        siphash: SipHash-1-3 (resists hash flooding attacks).\n"
+          "      Not used for the hashes computed by the kernel\n"
+          "      (\"--ring-buffer-rxhash\").\n"
+          "      Default: lookup3.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --tcp-untracked-cache <number>\n"
+          "      <number>: number of entries of the cache of untracked\n"
+          "      connections (connections established before the capture\n"
+          "      started or whose SYN was lost), their packets are ignored\n"
+          "      without searching the hash table (0: disabled).\n"
+          "      Range: 0 .. %zu, default: %zu.\n"
+          "      Optional.\n\n",
+          net::mon::tcp::untracked_cache::max_entries,
+          net::mon::tcp::untracked_cache::default_entries);
+
+  fprintf(stderr,
+          "    --tcp-adopt-connections\n"
+          "      Adopt the connections whose establishment has not been seen:\n"
+          "      an ACK with payload which doesn't belong to any connection\n"
+          "      creates a connection in the data transfer state (the\n"
+          "      connection begins with this packet and the client is assumed\n"
+          "      to be the host with the highest port).\n"
+          "      Default: no.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --tcp-half-open-connections <number>\n"
+          "      <number>: number of entries of the table of half-open\n"
+          "      connections. The SYNs are kept in this table and the\n"
+          "      connection is created when the handshake completes, so a\n"
+          "      SYN flood doesn't exhaust the connections (0: the SYNs\n"
+          "      create connections).\n"
+          "      Range: 0 .. %zu, default: 0.\n"
+          "      Optional.\n\n",
+          half_open_table_type::max_entries);
+
+  fprintf(stderr,
+          "    --tcp-syn-flood-threshold <number>\n"
+          "      <number>: number of failed connection attempts per second\n"
+          "      (reset or not answered) which generate a 'Half-open TCP\n"
+          "      connections' event (only with a table of half-open\n"
+          "      connections, 0: no events).\n"
+          "      Range: 0 .. %u, default: %u.\n"
+          "      Optional.\n\n",
+          UINT32_MAX,
+          connections_type::default_syn_flood_threshold);
+
+  fprintf(stderr,
+          "    --tcp-memory <size>\n"
+          "      <size>: memory of the TCP connections of all the workers\n"
+          "      (IPv4 and IPv6), rounded down to a multiple of %zu MiB.\n"
+          "      The workers share a pool of free slabs, so the memory\n"
+          "      released by a worker can be used by the others and the\n"
+          "      connections are only exhausted when the whole budget is in\n"
+          "      use (the maximum number of connections of each table still\n"
+          "      applies, 0: no limit).\n"
+          "      Default: 0.\n"
+          "      Optional.\n",
+          util::slab_pool::slab_size >> 20);
+
   fprintf(stderr, "\n\n");
 }
 
@@ -338,10 +876,21 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
 {
   using namespace util::parser;
 
+  bool have_busy_poll_spins = false;
+  bool have_busy_poll_usecs = false;
+
+  bool have_fanout_mode = false;
+  bool have_fanout_group = false;
+
   bool have_block_size = false;
   bool have_frame_size = false;
   bool have_frame_count = false;
 
+  bool have_xdp_mode = false;
+  bool have_xdp_queue = false;
+  bool have_xdp_frame_size = false;
+  bool have_xdp_frame_count = false;
+
   bool have_tcp4_size = false;
   bool have_tcp4_maxconns = false;
   bool have_tcp6_size = false;
@@ -349,9 +898,21 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
 
   bool have_timeout = false;
   bool have_time_wait = false;
+  bool have_update_interval = false;
+  bool have_tcp_table = false;
+  bool have_tcp_hash_function = false;
+  bool have_tcp_untracked = false;
+  bool have_tcp_half_open = false;
+  bool have_tcp_syn_flood_threshold = false;
+  bool have_tcp_memory = false;
 
   bool have_file_allocation_size = false;
   bool have_buffer_size = false;
+  bool have_compression = false;
+  bool have_writer_buffers = false;
+  bool have_backpressure = false;
+  bool have_rotation_size = false;
+  bool have_rotation_interval = false;
 
   size_t i = 1;
   while (i < argc) {
@@ -372,6 +933,8 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
             cap.m = capture::method::ring_buffer;
           } else if (strcasecmp(argv[i + 1], "socket") == 0) {
             cap.m = capture::method::socket;
+          } else if (strcasecmp(argv[i + 1], "xdp") == 0) {
+            cap.m = capture::method::xdp;
           } else {
             fprintf(stderr, "Invalid capture method '%s'.\n\n", argv[i + 1]);
             return false;
@@ -391,13 +954,14 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
     } else if (strcasecmp(argv[i], "--capture-device") == 0) {
       // If not the last argument...
       if (i + 1 < argc) {
-        // If the capture device has not been already set...
-        if (!cap.device) {
-          cap.device = argv[i + 1];
+        // If there is space for the capture device...
+        if (cap.ndevices < capture::max_devices) {
+          cap.devices[cap.ndevices++] = argv[i + 1];
+          cap.device = cap.devices[0];
 
           i += 2;
         } else {
-          fprintf(stderr, "\"--capture-device\" appears more than once.\n\n");
+          fprintf(stderr, "Too many capture devices.\n\n");
           return false;
         }
       } else {
@@ -448,53 +1012,256 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
         return false;
       }
 
-    ////////////////////////////////////
-    //                                //
-    // Ring buffer configuration.     //
-    //                                //
-    ////////////////////////////////////
-
-    } else if (strcasecmp(argv[i], "--ring-buffer-block-size") == 0) {
+    } else if (strcasecmp(argv[i], "--busy-poll-spins") == 0) {
       // If not the last argument...
       if (i + 1 < argc) {
-        // If the block size has not been already set...
-        if (!have_block_size) {
-          if (size::parse(argv[i + 1],
-                          cap.rb.block_size,
-                          net::capture::ring_buffer::min_block_size,
-                          net::capture::ring_buffer::max_block_size)) {
-            have_block_size = true;
+        // If the number of spins has not been already set...
+        if (!have_busy_poll_spins) {
+          uint64_t n;
+          if (number::parse(argv[i + 1],
+                            n,
+                            0,
+                            net::capture::busy_poll::max_spins)) {
+            cap.busy_poll_spins = static_cast<size_t>(n);
+
+            have_busy_poll_spins = true;
 
             i += 2;
           } else {
             fprintf(stderr,
-                    "Invalid ring buffer block size '%s'.\n\n",
+                    "Invalid number of busy poll spins '%s'.\n\n",
                     argv[i + 1]);
 
             return false;
           }
         } else {
-          fprintf(stderr,
-                  "\"--ring-buffer-block-size\" appears more than once.\n\n");
-
+          fprintf(stderr, "\"--busy-poll-spins\" appears more than once.\n\n");
           return false;
         }
       } else {
         fprintf(stderr,
-                "Expected ring buffer block size after "
-                "\"--ring-buffer-block-size\".\n\n");
+                "Expected number of spins after \"--busy-poll-spins\".\n\n");
 
         return false;
       }
-    } else if (strcasecmp(argv[i], "--ring-buffer-frame-size") == 0) {
+    } else if (strcasecmp(argv[i], "--busy-poll-usecs") == 0) {
       // If not the last argument...
       if (i + 1 < argc) {
-        // If the frame size has not been already set...
-        if (!have_frame_size) {
-          if (size::parse(argv[i + 1],
-                          cap.rb.frame_size,
-                          net::capture::ring_buffer::min_frame_size,
-                          net::capture::ring_buffer::max_frame_size)) {
+        // If SO_BUSY_POLL has not been already set...
+        if (!have_busy_poll_usecs) {
+          uint64_t n;
+          if (number::parse(argv[i + 1],
+                            n,
+                            0,
+                            net::capture::busy_poll::max_usecs)) {
+            cap.busy_poll_usecs = static_cast<int>(n);
+
+            have_busy_poll_usecs = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid busy poll microseconds '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr, "\"--busy-poll-usecs\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected microseconds after \"--busy-poll-usecs\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--filter") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the filter has not been already set...
+        if (!cap.filter) {
+          // The filter is compiled once the snapshot length is known.
+          cap.filter = argv[i + 1];
+
+          i += 2;
+        } else {
+          fprintf(stderr, "\"--filter\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr, "Expected filter expression after \"--filter\".\n\n");
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--snaplen") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the snapshot length has not been already set...
+        if (cap.snaplen == 0) {
+          if (size::parse(argv[i + 1],
+                          cap.snaplen,
+                          net::capture::min_snaplen,
+                          net::capture::max_snaplen)) {
+            i += 2;
+          } else {
+            fprintf(stderr, "Invalid snapshot length '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+        } else {
+          fprintf(stderr, "\"--snaplen\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr, "Expected snapshot length after \"--snaplen\".\n\n");
+        return false;
+      }
+
+    ////////////////////////////////////
+    //                                //
+    // Fanout configuration.          //
+    //                                //
+    ////////////////////////////////////
+
+    } else if (strcasecmp(argv[i], "--fanout-mode") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the fanout mode has not been already set...
+        if (!have_fanout_mode) {
+          if (strcasecmp(argv[i + 1], "hash") == 0) {
+            cap.fo.m = net::capture::fanout::mode::hash;
+          } else if (strcasecmp(argv[i + 1], "cpu") == 0) {
+            cap.fo.m = net::capture::fanout::mode::cpu;
+          } else if (strcasecmp(argv[i + 1], "qm") == 0) {
+            cap.fo.m = net::capture::fanout::mode::qm;
+          } else if (strcasecmp(argv[i + 1], "lb") == 0) {
+            cap.fo.m = net::capture::fanout::mode::lb;
+          } else if (strcasecmp(argv[i + 1], "rollover") == 0) {
+            cap.fo.m = net::capture::fanout::mode::rollover;
+          } else if (strcasecmp(argv[i + 1], "ebpf") == 0) {
+            cap.fo.m = net::capture::fanout::mode::ebpf;
+          } else {
+            fprintf(stderr, "Invalid fanout mode '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+
+          have_fanout_mode = true;
+
+          i += 2;
+        } else {
+          fprintf(stderr, "\"--fanout-mode\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr, "Expected fanout mode after \"--fanout-mode\".\n\n");
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--fanout-rollover") == 0) {
+      // If the rollover has not been already set...
+      if (!cap.fo.rollover) {
+        cap.fo.rollover = true;
+
+        i++;
+      } else {
+        fprintf(stderr, "\"--fanout-rollover\" appears more than once.\n\n");
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--fanout-group") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the group id has not been already set...
+        if (!have_fanout_group) {
+          uint64_t n;
+          if (number::parse(argv[i + 1],
+                            n,
+                            0,
+                            net::capture::fanout::max_group)) {
+            cap.fo.group = static_cast<int>(n);
+
+            have_fanout_group = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr, "Invalid fanout group id '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+        } else {
+          fprintf(stderr, "\"--fanout-group\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected fanout group id after \"--fanout-group\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--fanout-ebpf-program") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the eBPF steering program has not been already set...
+        if (!cap.fo.program) {
+          cap.fo.program = argv[i + 1];
+
+          i += 2;
+        } else {
+          fprintf(stderr,
+                  "\"--fanout-ebpf-program\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected eBPF program after \"--fanout-ebpf-program\".\n\n");
+
+        return false;
+      }
+
+    ////////////////////////////////////
+    //                                //
+    // Ring buffer configuration.     //
+    //                                //
+    ////////////////////////////////////
+
+    } else if (strcasecmp(argv[i], "--ring-buffer-block-size") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the block size has not been already set...
+        if (!have_block_size) {
+          if (size::parse(argv[i + 1],
+                          cap.rb.block_size,
+                          net::capture::ring_buffer::min_block_size,
+                          net::capture::ring_buffer::max_block_size)) {
+            have_block_size = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid ring buffer block size '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--ring-buffer-block-size\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected ring buffer block size after "
+                "\"--ring-buffer-block-size\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--ring-buffer-frame-size") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the frame size has not been already set...
+        if (!have_frame_size) {
+          if (size::parse(argv[i + 1],
+                          cap.rb.frame_size,
+                          net::capture::ring_buffer::min_frame_size,
+                          net::capture::ring_buffer::max_frame_size)) {
             cap.rb.frame_size = TPACKET_ALIGN(cap.rb.frame_size);
 
             have_frame_size = true;
@@ -555,6 +1322,156 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
 
         return false;
       }
+    } else if (strcasecmp(argv[i], "--ring-buffer-dispatcher") == 0) {
+      // If the dispatcher has not been already set...
+      if (!cap.rb.dispatcher) {
+        cap.rb.dispatcher = true;
+
+        i++;
+      } else {
+        fprintf(stderr,
+                "\"--ring-buffer-dispatcher\" appears more than once.\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--ring-buffer-rxhash") == 0) {
+      // If the RX hash has not been already set...
+      if (!cap.rb.rxhash) {
+        cap.rb.rxhash = true;
+
+        i++;
+      } else {
+        fprintf(stderr,
+                "\"--ring-buffer-rxhash\" appears more than once.\n\n");
+
+        return false;
+      }
+
+    ////////////////////////////////////
+    //                                //
+    // AF_XDP configuration.          //
+    //                                //
+    ////////////////////////////////////
+
+    } else if (strcasecmp(argv[i], "--xdp-mode") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the XDP mode has not been already set...
+        if (!have_xdp_mode) {
+          if (strcasecmp(argv[i + 1], "native") == 0) {
+            cap.xsk.m = net::capture::xdp::mode::native;
+          } else if (strcasecmp(argv[i + 1], "skb") == 0) {
+            cap.xsk.m = net::capture::xdp::mode::skb;
+          } else {
+            fprintf(stderr, "Invalid XDP mode '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+
+          have_xdp_mode = true;
+
+          i += 2;
+        } else {
+          fprintf(stderr, "\"--xdp-mode\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr, "Expected XDP mode after \"--xdp-mode\".\n\n");
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--xdp-queue") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the first queue has not been already set...
+        if (!have_xdp_queue) {
+          uint64_t n;
+          if (number::parse(argv[i + 1], n, 0, workers::max_workers - 1)) {
+            cap.xsk.queue = static_cast<unsigned>(n);
+
+            have_xdp_queue = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr, "Invalid XDP queue '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+        } else {
+          fprintf(stderr, "\"--xdp-queue\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr, "Expected XDP queue after \"--xdp-queue\".\n\n");
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--xdp-zero-copy") == 0) {
+      // If the zero-copy mode has not been already set...
+      if (!cap.xsk.zero_copy) {
+        cap.xsk.zero_copy = true;
+
+        i++;
+      } else {
+        fprintf(stderr, "\"--xdp-zero-copy\" appears more than once.\n\n");
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--xdp-frame-size") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the frame size has not been already set...
+        if (!have_xdp_frame_size) {
+          if (size::parse(argv[i + 1],
+                          cap.xsk.frame_size,
+                          net::capture::xdp::min_frame_size,
+                          net::capture::xdp::max_frame_size)) {
+            have_xdp_frame_size = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr, "Invalid XDP frame size '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+        } else {
+          fprintf(stderr, "\"--xdp-frame-size\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected XDP frame size after \"--xdp-frame-size\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--xdp-frame-count") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the frame count has not been already set...
+        if (!have_xdp_frame_count) {
+          uint64_t n;
+          if (number::parse(argv[i + 1],
+                            n,
+                            net::capture::xdp::min_frames,
+                            net::capture::xdp::max_frames)) {
+            cap.xsk.frame_count = static_cast<size_t>(n);
+
+            have_xdp_frame_count = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid XDP frame count '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--xdp-frame-count\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected XDP frame count after \"--xdp-frame-count\".\n\n");
+
+        return false;
+      }
 
     ////////////////////////////////////
     //                                //
@@ -635,138 +1552,389 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
     //                                //
     ////////////////////////////////////
 
-    } else if (strcasecmp(argv[i], "--tcp-ipv6-hash-size") == 0) {
+    } else if (strcasecmp(argv[i], "--tcp-ipv6-hash-size") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the size has not been already set...
+        if (!have_tcp6_size) {
+          uint64_t n;
+          if (number::parse(argv[i + 1],
+                            n,
+                            tcp6_type::connections_type::min_size,
+                            tcp6_type::connections_type::max_size)) {
+            tcp6.size = static_cast<size_t>(n);
+
+            have_tcp6_size = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr, "Invalid hash table size '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--tcp-ipv6-hash-size\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected hash table size after \"--tcp-ipv6-hash-size\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--tcp-ipv6-max-connections") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the maximum number of connections has not been already set...
+        if (!have_tcp6_maxconns) {
+          uint64_t n;
+          if (number::parse(argv[i + 1],
+                            n,
+                            tcp6_type::connections_type::min_connections,
+                            tcp6_type::connections_type::max_connections)) {
+            tcp6.maxconns = static_cast<size_t>(n);
+
+            have_tcp6_maxconns = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid maximum number of connections '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--tcp-ipv6-max-connections\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected maximum number of connections after "
+                "\"--tcp-ipv6-max-connections\".\n\n");
+
+        return false;
+      }
+
+    ////////////////////////////////////
+    //                                //
+    // TCP/IP configuration.          //
+    //                                //
+    ////////////////////////////////////
+
+    } else if (strcasecmp(argv[i], "--connection-timeout") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the connection timeout has not been already set...
+        if (!have_timeout) {
+          if (number::parse(argv[i + 1],
+                            tcp4.timeout,
+                            tcp4_type::connections_type::min_timeout)) {
+            tcp6.timeout = tcp4.timeout;
+
+            have_timeout = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid connection timeout '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--connection-timeout\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected connection timeout after "
+                "\"--connection-timeout\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--tcp-time-wait") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the TCP time wait has not been already set...
+        if (!have_time_wait) {
+          if (number::parse(argv[i + 1],
+                            tcp4.time_wait,
+                            tcp4_type::connections_type::min_time_wait)) {
+            tcp6.time_wait = tcp4.time_wait;
+
+            have_time_wait = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr, "Invalid TCP time wait '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--tcp-time-wait\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected TCP time wait after \"--tcp-time-wait\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--tcp-update-interval") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the update interval has not been already set...
+        if (!have_update_interval) {
+          if (number::parse(argv[i + 1], tcp4.update_interval, 0, UINT32_MAX)) {
+            tcp6.update_interval = tcp4.update_interval;
+
+            have_update_interval = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid TCP update interval '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--tcp-update-interval\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected TCP update interval after "
+                "\"--tcp-update-interval\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--tcp-hash-table") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the type of hash table has not been already set...
+        if (!have_tcp_table) {
+          if (strcasecmp(argv[i + 1], "chained") == 0) {
+            tcp4.table = net::mon::tcp::table::chained;
+          } else if (strcasecmp(argv[i + 1], "bucketed") == 0) {
+            tcp4.table = net::mon::tcp::table::bucketed;
+          } else {
+            fprintf(stderr,
+                    "Invalid type of hash table '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+
+          tcp6.table = tcp4.table;
+
+          have_tcp_table = true;
+
+          i += 2;
+        } else {
+          fprintf(stderr,
+                  "\"--tcp-hash-table\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected type of hash table after \"--tcp-hash-table\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--tcp-hash-function") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the hash function has not been already set...
+        if (!have_tcp_hash_function) {
+          if (strcasecmp(argv[i + 1], "lookup3") == 0) {
+            tcp4.hash = net::mon::tcp::hash_function::lookup3;
+          } else if (strcasecmp(argv[i + 1], "crc32c") == 0) {
+            tcp4.hash = net::mon::tcp::hash_function::crc32c;
+          } else if (strcasecmp(argv[i + 1], "siphash") == 0) {
+            tcp4.hash = net::mon::tcp::hash_function::siphash;
+          } else {
+            fprintf(stderr, "Invalid hash function '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+
+          tcp6.hash = tcp4.hash;
+
+          have_tcp_hash_function = true;
+
+          i += 2;
+        } else {
+          fprintf(stderr,
+                  "\"--tcp-hash-function\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected hash function after \"--tcp-hash-function\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--tcp-untracked-cache") == 0) {
       // If not the last argument...
       if (i + 1 < argc) {
-        // If the size has not been already set...
-        if (!have_tcp6_size) {
+        // If the size of the cache has not been already set...
+        if (!have_tcp_untracked) {
           uint64_t n;
           if (number::parse(argv[i + 1],
                             n,
-                            tcp6_type::connections_type::min_size,
-                            tcp6_type::connections_type::max_size)) {
-            tcp6.size = static_cast<size_t>(n);
+                            0,
+                            net::mon::tcp::untracked_cache::max_entries)) {
+            tcp4.untracked = static_cast<size_t>(n);
+            tcp6.untracked = tcp4.untracked;
 
-            have_tcp6_size = true;
+            have_tcp_untracked = true;
 
             i += 2;
           } else {
-            fprintf(stderr, "Invalid hash table size '%s'.\n\n", argv[i + 1]);
+            fprintf(stderr,
+                    "Invalid size of the cache of untracked connections "
+                    "'%s'.\n\n",
+                    argv[i + 1]);
+
             return false;
           }
         } else {
           fprintf(stderr,
-                  "\"--tcp-ipv6-hash-size\" appears more than once.\n\n");
+                  "\"--tcp-untracked-cache\" appears more than once.\n\n");
 
           return false;
         }
       } else {
         fprintf(stderr,
-                "Expected hash table size after \"--tcp-ipv6-hash-size\".\n\n");
+                "Expected size of the cache of untracked connections after "
+                "\"--tcp-untracked-cache\".\n\n");
 
         return false;
       }
-    } else if (strcasecmp(argv[i], "--tcp-ipv6-max-connections") == 0) {
+    } else if (strcasecmp(argv[i], "--tcp-adopt-connections") == 0) {
+      // If the adoption of connections has not been already set...
+      if (!tcp4.adopt) {
+        tcp4.adopt = true;
+        tcp6.adopt = true;
+
+        i++;
+      } else {
+        fprintf(stderr,
+                "\"--tcp-adopt-connections\" appears more than once.\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--tcp-half-open-connections") == 0) {
       // If not the last argument...
       if (i + 1 < argc) {
-        // If the maximum number of connections has not been already set...
-        if (!have_tcp6_maxconns) {
+        // If the size of the table has not been already set...
+        if (!have_tcp_half_open) {
           uint64_t n;
           if (number::parse(argv[i + 1],
                             n,
-                            tcp6_type::connections_type::min_connections,
-                            tcp6_type::connections_type::max_connections)) {
-            tcp6.maxconns = static_cast<size_t>(n);
+                            0,
+                            tcp4_type::half_open_table_type::max_entries)) {
+            tcp4.half_open = static_cast<size_t>(n);
+            tcp6.half_open = tcp4.half_open;
 
-            have_tcp6_maxconns = true;
+            have_tcp_half_open = true;
 
             i += 2;
           } else {
             fprintf(stderr,
-                    "Invalid maximum number of connections '%s'.\n\n",
+                    "Invalid size of the table of half-open connections "
+                    "'%s'.\n\n",
                     argv[i + 1]);
 
             return false;
           }
         } else {
           fprintf(stderr,
-                  "\"--tcp-ipv6-max-connections\" appears more than once.\n\n");
+                  "\"--tcp-half-open-connections\" appears more than "
+                  "once.\n\n");
 
           return false;
         }
       } else {
         fprintf(stderr,
-                "Expected maximum number of connections after "
-                "\"--tcp-ipv6-max-connections\".\n\n");
+                "Expected size of the table of half-open connections after "
+                "\"--tcp-half-open-connections\".\n\n");
 
         return false;
       }
-
-    ////////////////////////////////////
-    //                                //
-    // TCP/IP configuration.          //
-    //                                //
-    ////////////////////////////////////
-
-    } else if (strcasecmp(argv[i], "--connection-timeout") == 0) {
+    } else if (strcasecmp(argv[i], "--tcp-syn-flood-threshold") == 0) {
       // If not the last argument...
       if (i + 1 < argc) {
-        // If the connection timeout has not been already set...
-        if (!have_timeout) {
-          if (number::parse(argv[i + 1],
-                            tcp4.timeout,
-                            tcp4_type::connections_type::min_timeout)) {
-            tcp6.timeout = tcp4.timeout;
+        // If the threshold has not been already set...
+        if (!have_tcp_syn_flood_threshold) {
+          uint64_t n;
+          if (number::parse(argv[i + 1], n, 0, UINT32_MAX)) {
+            tcp4.syn_flood_threshold = static_cast<uint32_t>(n);
+            tcp6.syn_flood_threshold = tcp4.syn_flood_threshold;
 
-            have_timeout = true;
+            have_tcp_syn_flood_threshold = true;
 
             i += 2;
           } else {
             fprintf(stderr,
-                    "Invalid connection timeout '%s'.\n\n",
+                    "Invalid SYN flood threshold '%s'.\n\n",
                     argv[i + 1]);
 
             return false;
           }
         } else {
           fprintf(stderr,
-                  "\"--connection-timeout\" appears more than once.\n\n");
+                  "\"--tcp-syn-flood-threshold\" appears more than "
+                  "once.\n\n");
 
           return false;
         }
       } else {
         fprintf(stderr,
-                "Expected connection timeout after "
-                "\"--connection-timeout\".\n\n");
+                "Expected SYN flood threshold after "
+                "\"--tcp-syn-flood-threshold\".\n\n");
 
         return false;
       }
-    } else if (strcasecmp(argv[i], "--tcp-time-wait") == 0) {
+    } else if (strcasecmp(argv[i], "--tcp-memory") == 0) {
       // If not the last argument...
       if (i + 1 < argc) {
-        // If the TCP time wait has not been already set...
-        if (!have_time_wait) {
-          if (number::parse(argv[i + 1],
-                            tcp4.time_wait,
-                            tcp4_type::connections_type::min_time_wait)) {
-            tcp6.time_wait = tcp4.time_wait;
+        // If the memory of the TCP connections has not been already set...
+        if (!have_tcp_memory) {
+          uint64_t n;
+          if (size::parse(argv[i + 1], n, 0, SIZE_MAX)) {
+            tcp4.memory = static_cast<size_t>(n);
+            tcp6.memory = tcp4.memory;
 
-            have_time_wait = true;
+            have_tcp_memory = true;
 
             i += 2;
           } else {
-            fprintf(stderr, "Invalid TCP time wait '%s'.\n\n", argv[i + 1]);
+            fprintf(stderr,
+                    "Invalid memory of the TCP connections '%s'.\n\n",
+                    argv[i + 1]);
+
             return false;
           }
         } else {
-          fprintf(stderr,
-                  "\"--tcp-time-wait\" appears more than once.\n\n");
-
+          fprintf(stderr, "\"--tcp-memory\" appears more than once.\n\n");
           return false;
         }
       } else {
         fprintf(stderr,
-                "Expected TCP time wait after \"--tcp-time-wait\".\n\n");
+                "Expected memory of the TCP connections after "
+                "\"--tcp-memory\".\n\n");
 
         return false;
       }
@@ -864,6 +2032,24 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
         fprintf(stderr,
                 "Expected events directory after \"--events-directory\".\n\n");
 
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--merge-events") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the merge file has not been already set...
+        if (!merge_filename) {
+          merge_filename = argv[i + 1];
+
+          i += 2;
+        } else {
+          fprintf(stderr, "\"--merge-events\" appears more than once.\n\n");
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected filename after \"--merge-events\".\n\n");
+
         return false;
       }
     } else if (strcasecmp(argv[i], "--file-allocation-size") == 0) {
@@ -895,6 +2081,16 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
 
         return false;
       }
+    } else if (strcasecmp(argv[i], "--direct-io") == 0) {
+      // If the direct I/O has not been already set...
+      if (!direct_io) {
+        direct_io = true;
+
+        i++;
+      } else {
+        fprintf(stderr, "\"--direct-io\" appears more than once.\n\n");
+        return false;
+      }
     } else if (strcasecmp(argv[i], "--event-writer-buffer-size") == 0) {
       // If not the last argument...
       if (i + 1 < argc) {
@@ -902,7 +2098,8 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
         if (!have_buffer_size) {
           if (size::parse(argv[i + 1],
                           buffer_size,
-                          event::writer::min_buffer_size)) {
+                          event::writer::min_buffer_size,
+                          event::writer::max_buffer_size)) {
             have_buffer_size = true;
 
             i += 2;
@@ -924,6 +2121,164 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
                 "Expected size of the event writer buffer after "
                 "\"--event-writer-buffer-size\".\n\n");
 
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--event-compression") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the compression has not been already set...
+        if (!have_compression) {
+          if (strcasecmp(argv[i + 1], "none") == 0) {
+            compression = event::compression::none;
+          } else if (strcasecmp(argv[i + 1], "lz4") == 0) {
+            compression = event::compression::lz4;
+          } else {
+            fprintf(stderr, "Invalid compression '%s'.\n\n", argv[i + 1]);
+            return false;
+          }
+
+          have_compression = true;
+
+          i += 2;
+        } else {
+          fprintf(stderr,
+                  "\"--event-compression\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected compression after \"--event-compression\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--event-writer-buffers") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the number of buffers has not been already set...
+        if (!have_writer_buffers) {
+          uint64_t n;
+          if (number::parse(argv[i + 1], n, 0, event::writer::max_buffers)) {
+            writer_buffers = static_cast<size_t>(n);
+
+            have_writer_buffers = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid number of event writer buffers '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--event-writer-buffers\" appears more than once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected number of event writer buffers after "
+                "\"--event-writer-buffers\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--event-writer-backpressure") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the backpressure policy has not been already set...
+        if (!have_backpressure) {
+          if (strcasecmp(argv[i + 1], "wait") == 0) {
+            backpressure = event::backpressure::wait;
+          } else if (strcasecmp(argv[i + 1], "drop") == 0) {
+            backpressure = event::backpressure::drop;
+          } else {
+            fprintf(stderr,
+                    "Invalid backpressure policy '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+
+          have_backpressure = true;
+
+          i += 2;
+        } else {
+          fprintf(stderr,
+                  "\"--event-writer-backpressure\" appears more than "
+                  "once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected backpressure policy after "
+                "\"--event-writer-backpressure\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--event-file-rotation-size") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the rotation size has not been already set...
+        if (!have_rotation_size) {
+          if (size::parse(argv[i + 1], rotation_size)) {
+            have_rotation_size = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid rotation size '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--event-file-rotation-size\" appears more than "
+                  "once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected rotation size after "
+                "\"--event-file-rotation-size\".\n\n");
+
+        return false;
+      }
+    } else if (strcasecmp(argv[i], "--event-file-rotation-interval") == 0) {
+      // If not the last argument...
+      if (i + 1 < argc) {
+        // If the rotation interval has not been already set...
+        if (!have_rotation_interval) {
+          if (number::parse(argv[i + 1],
+                            rotation_interval,
+                            0,
+                            event::writer::max_rotation_interval)) {
+            have_rotation_interval = true;
+
+            i += 2;
+          } else {
+            fprintf(stderr,
+                    "Invalid rotation interval '%s'.\n\n",
+                    argv[i + 1]);
+
+            return false;
+          }
+        } else {
+          fprintf(stderr,
+                  "\"--event-file-rotation-interval\" appears more than "
+                  "once.\n\n");
+
+          return false;
+        }
+      } else {
+        fprintf(stderr,
+                "Expected rotation interval after "
+                "\"--event-file-rotation-interval\".\n\n");
+
         return false;
       }
     } else if (strcasecmp(argv[i], "--help") == 0) {
@@ -940,6 +2295,7 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
       break;
     case capture::method::ring_buffer:
     case capture::method::socket:
+    case capture::method::xdp:
       if (cap.device) {
         cap.ifindex = if_nametoindex(cap.device);
       }
@@ -952,6 +2308,26 @@ bool net::mon::configuration::parse(size_t argc, const char** argv)
       nworkers = workers::default_workers;
     }
 
+    // Compile filter and snapshot length (if any).
+    if ((cap.filter) || (cap.snaplen != 0)) {
+      if (!compile_filter(cap.filter, cap.snaplen, cap.filter_program)) {
+        if (cap.filter) {
+          fprintf(stderr, "Invalid filter '%s'.\n\n", cap.filter);
+        } else {
+          fprintf(stderr,
+                  "Error compiling the snapshot length into a BPF filter."
+                  "\n\n");
+        }
+
+        return false;
+      }
+
+      // Use small ring buffer frames if the frame size has not been set.
+      if ((cap.snaplen != 0) && (!have_frame_size)) {
+        cap.rb.frame_size = net::capture::ring_buffer::frame_size(cap.snaplen);
+      }
+    }
+
     if (!_M_evdir) {
       _M_evdir = worker::default_directory;
     }
@@ -1004,12 +2380,49 @@ bool net::mon::configuration::valid() const
     return false;
   }
 
-  if (buffer_size < event::writer::min_buffer_size) {
+  if ((buffer_size < event::writer::min_buffer_size) ||
+      (buffer_size > event::writer::max_buffer_size)) {
     fprintf(stderr,
-            "Size of the event writer buffer (%zu) must be greater or equal "
-            "than %zu.\n\n",
+            "Size of the event writer buffer (%zu) not in the range "
+            "%zu .. %zu.\n\n",
             buffer_size,
-            event::writer::min_buffer_size);
+            event::writer::min_buffer_size,
+            event::writer::max_buffer_size);
+
+    return false;
+  }
+
+  if (writer_buffers > event::writer::max_buffers) {
+    fprintf(stderr,
+            "Number of event writer buffers (%zu) not in the range "
+            "0 .. %zu.\n\n",
+            writer_buffers,
+            event::writer::max_buffers);
+
+    return false;
+  }
+
+  if (rotation_interval > event::writer::max_rotation_interval) {
+    fprintf(stderr,
+            "Rotation interval (%" PRIu64 ") not in the range "
+            "0 .. %" PRIu64 ".\n\n",
+            rotation_interval,
+            event::writer::max_rotation_interval);
+
+    return false;
+  }
+
+  if ((merge_filename) && ((rotation_size > 0) || (rotation_interval > 0))) {
+    fprintf(stderr,
+            "Merging the event files is not supported with rotation.\n\n");
+
+    return false;
+  }
+
+  if ((merge_filename) && (cap.m != capture::method::pcap)) {
+    fprintf(stderr,
+            "Merging the event files is only supported by the capture method "
+            "\"pcap\".\n\n");
 
     return false;
   }
@@ -1039,8 +2452,32 @@ void net::mon::configuration::print() const
   }
 
   printf("  Events directory: \"%s/\".\n", evdir);
+
+  if (merge_filename) {
+    printf("  Merge events into: \"%s\".\n", merge_filename);
+  }
+
   printf("  File allocation size: %" PRIu64 ".\n", file_allocation_size);
+  printf("  Direct I/O? %s.\n", direct_io ? "yes" : "no");
   printf("  Size of the event writer buffer: %zu.\n", buffer_size);
+  printf("  Compression of the event files: %s.\n",
+         (compression == event::compression::lz4) ? "LZ4" : "none");
+  printf("  Event writer buffers handed over to the I/O thread: %zu.\n",
+         ((writer_buffers == 0) && (compression != event::compression::none)) ?
+           1 :
+           writer_buffers);
+  printf("  Event writer backpressure: %s.\n",
+         (backpressure == event::backpressure::drop) ? "drop" : "wait");
+
+  if (rotation_size > 0) {
+    printf("  Rotation size of the event files: %" PRIu64 ".\n",
+           rotation_size);
+  }
+
+  if (rotation_interval > 0) {
+    printf("  Rotation interval of the event files: %" PRIu64 " seconds.\n",
+           rotation_interval);
+  }
 
   printf("\n");
 }
@@ -1079,6 +2516,14 @@ void net::mon::configuration::help(const char* program)
           "      Optional.\n\n",
           worker::default_directory);
 
+  fprintf(stderr,
+          "    --merge-events <filename>\n"
+          "      <filename>: file where to merge the event files of the "
+          "workers (the\n"
+          "                  event files of the workers are removed).\n"
+          "      Only for the capture method \"pcap\".\n"
+          "      Optional.\n\n");
+
   fprintf(stderr,
           "    --file-allocation-size <size>\n"
           "      <size>: file allocation size.\n"
@@ -1086,14 +2531,64 @@ void net::mon::configuration::help(const char* program)
           "      Optional.\n\n",
           fs::file::default_allocation_size);
 
+  fprintf(stderr,
+          "    --direct-io\n"
+          "      Append to the event files with direct I/O (O_DIRECT).\n"
+          "      Optional.\n\n");
+
   fprintf(stderr,
           "    --event-writer-buffer-size <size>\n"
-          "      <size>: size of the event writer buffer.\n"
-          "      Greater or equal than: %zu, default: %zu.\n"
-          "      Optional.\n",
+          "      <size>: size of the event writer buffer (and of the blocks\n"
+          "              of the event files).\n"
+          "      Range: %zu .. %zu, default: %zu.\n"
+          "      Optional.\n\n",
           event::writer::min_buffer_size,
+          event::writer::max_buffer_size,
           event::writer::default_buffer_size);
 
+  fprintf(stderr,
+          "    --event-compression \"none\" | \"lz4\"\n"
+          "      Compression of the blocks of the event files (new files),\n"
+          "      done by the I/O thread of the event writer.\n"
+          "      Default: \"none\".\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --event-writer-buffers <number>\n"
+          "      <number>: number of full buffers which can be handed over\n"
+          "                to the I/O thread of the event writer (one per\n"
+          "                worker), 0: the workers write the events\n"
+          "                themselves.\n"
+          "      Range: 0 .. %zu, default: 0 (1 with compression).\n"
+          "      Optional.\n\n",
+          event::writer::max_buffers);
+
+  fprintf(stderr,
+          "    --event-writer-backpressure \"wait\" | \"drop\"\n"
+          "      What the event writer does with a full buffer when all the\n"
+          "      buffers are in flight: wait for the I/O thread or drop the\n"
+          "      events of the buffer (both are counted).\n"
+          "      Default: \"wait\".\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --event-file-rotation-size <size>\n"
+          "      <size>: seal the event file and start a new one when it\n"
+          "              reaches this size (uncompressed bytes, including\n"
+          "              the file and block headers), 0: no rotation by\n"
+          "              size.\n"
+          "      Default: 0.\n"
+          "      Optional.\n\n");
+
+  fprintf(stderr,
+          "    --event-file-rotation-interval <seconds>\n"
+          "      <seconds>: seal the event file and start a new one when\n"
+          "                 the time of the events reaches the next\n"
+          "                 multiple of <seconds>, 0: no rotation by time.\n"
+          "      Range: 0 .. %" PRIu64 ", default: 0.\n"
+          "      Optional.\n",
+          event::writer::max_rotation_interval);
+
   fprintf(stderr, "\n");
 
   fprintf(stderr, "<number> ::= <digit>+\n");
@@ -1163,3 +2658,26 @@ bool net::mon::configuration::parse_number_list(const char* s,
 
   return false;
 }
+
+bool compile_filter(const char* expression,
+                    size_t snaplen,
+                    net::capture::filter& filter)
+{
+  using namespace net::mon::event::grammar;
+
+  // Parse expression (if any).
+  conditional_expression* expr = nullptr;
+  if ((!expression) || ((expr = parser::parse(expression)) != nullptr)) {
+    // Compile expression.
+    compiler c;
+    bool ret = c.compile(expr, snaplen, filter);
+
+    if (expr) {
+      delete expr;
+    }
+
+    return ret;
+  }
+
+  return false;
+}
@@ -5,7 +5,11 @@
 #include <string.h>
 #include <limits.h>
 #include "net/capture/ring_buffer.h"
+#include "net/capture/xdp.h"
+#include "net/capture/fanout.h"
+#include "net/capture/filter.h"
 #include "net/mon/workers.h"
+#include "net/mon/tcp/options.h"
 #include "fs/file.h"
 
 namespace net {
@@ -44,6 +48,80 @@ namespace net {
 
                 // Frame count.
                 size_t frame_count = net::capture::ring_buffer::default_frames;
+
+                // Capture with a single ring buffer and dispatch the packets
+                // to the workers (software RSS)?
+                bool dispatcher = false;
+
+                // Use the hash computed by the kernel for the TCP/IPv4
+                // connections?
+                bool rxhash = false;
+            };
+
+            // Fanout configuration.
+            class fanout {
+              public:
+                // Constructor.
+                fanout() = default;
+
+                // Destructor.
+                ~fanout() = default;
+
+                // Valid configuration?
+                bool valid() const;
+
+                // Print configuration.
+                void print() const;
+
+                // Show help.
+                static void help();
+
+                // Fanout mode.
+                net::capture::fanout::mode m = net::capture::fanout::mode::hash;
+
+                // Roll over to another worker when the selected one is
+                // full?
+                bool rollover = false;
+
+                // Group id.
+                int group = net::capture::fanout::no_group;
+
+                // Path of the pinned eBPF steering program.
+                const char* program = nullptr;
+            };
+
+            // AF_XDP configuration.
+            class xdp {
+              public:
+                // Constructor.
+                xdp() = default;
+
+                // Destructor.
+                ~xdp() = default;
+
+                // Valid configuration?
+                bool valid() const;
+
+                // Print configuration.
+                void print() const;
+
+                // Show help.
+                static void help();
+
+                // XDP mode.
+                net::capture::xdp::mode m = net::capture::xdp::mode::native;
+
+                // First queue.
+                unsigned queue = 0;
+
+                // Use zero-copy mode?
+                bool zero_copy = false;
+
+                // Frame size.
+                size_t frame_size = net::capture::xdp::default_frame_size;
+
+                // Frame count.
+                size_t frame_count = net::capture::xdp::default_frames;
             };
 
             // Constructor.
@@ -66,15 +144,24 @@ namespace net {
               none,
               pcap,
               ring_buffer,
-              socket
+              socket,
+              xdp
             };
 
             method m = method::none;
 
-            // Name of the capture device (either a PCAP filename or the
-            // name of a network interface).
+            // Maximum number of capture devices (only the capture method
+            // "pcap" supports more than one).
+            static constexpr const size_t max_devices = 256;
+
+            // Name of the capture device (either a PCAP filename / directory
+            // or the name of a network interface).
             const char* device = nullptr;
 
+            // Capture devices (PCAP files / directories).
+            const char* devices[max_devices];
+            size_t ndevices = 0;
+
             // Index of the network interface.
             unsigned ifindex = 0;
 
@@ -84,8 +171,30 @@ namespace net {
             // Enable promiscuous mode?
             bool promiscuous_mode = false;
 
+            // Number of empty checks of the receive ring / socket before
+            // sleeping in poll() (0: don't spin).
+            size_t busy_poll_spins = 0;
+
+            // Value of SO_BUSY_POLL (microseconds, 0: not set).
+            int busy_poll_usecs = 0;
+
+            // Filter expression.
+            const char* filter = nullptr;
+
+            // Snapshot length (0: capture the whole frames).
+            size_t snaplen = 0;
+
+            // Filter expression and snapshot length compiled to classic BPF.
+            net::capture::filter filter_program;
+
+            // Fanout configuration.
+            fanout fo;
+
             // Ring buffer configuration.
             ring_buffer rb;
+
+            // AF_XDP configuration.
+            xdp xsk;
         };
 
         // TCP configuration.
@@ -108,9 +217,14 @@ namespace net {
             static void help();
 
             // Type of the connections class.
-            typedef net::mon::tcp::connections<ipv4::tcp::connection>
+            typedef net::mon::tcp::connections<Connection>
                     connections_type;
 
+            // Type of the table of half-open connections.
+            typedef net::mon::tcp::half_open_table<
+                      typename connections_type::address_type
+                    > half_open_table_type;
+
             // Hash table size.
             size_t size = connections_type::default_size;
 
@@ -122,6 +236,37 @@ namespace net {
 
             // TCP time wait (seconds).
             uint64_t time_wait = connections_type::default_time_wait;
+
+            // Interval of the 'Update TCP connection' events (seconds, 0:
+            // no events).
+            uint64_t update_interval = 0;
+
+            // Type of hash table.
+            net::mon::tcp::table table = net::mon::tcp::table::chained;
+
+            // Hash function.
+            net::mon::tcp::hash_function hash =
+                                         net::mon::tcp::hash_function::lookup3;
+
+            // Number of entries of the cache of untracked connections (0:
+            // disabled).
+            size_t untracked = net::mon::tcp::untracked_cache::default_entries;
+
+            // Adopt the connections whose establishment has not been seen?
+            bool adopt = false;
+
+            // Number of entries of the table of half-open connections (0:
+            // the SYNs create connections).
+            size_t half_open = 0;
+
+            // Number of failed connection attempts per second which
+            // generate a 'Half-open TCP connections' event (0: no events).
+            uint32_t syn_flood_threshold =
+                     connections_type::default_syn_flood_threshold;
+
+            // Memory (bytes) of the TCP connections of all the workers,
+            // shared by IPv4 and IPv6 (0: no limit).
+            size_t memory = 0;
         };
 
         // Constructor.
@@ -145,6 +290,9 @@ namespace net {
         // Show help.
         void help(const char* program);
 
+        // Get the options of the TCP connections of the workers.
+        net::mon::tcp::options tcp_options() const;
+
         // Number of workers.
         size_t nworkers = 0;
 
@@ -160,9 +308,34 @@ namespace net {
         // File allocation size.
         uint64_t file_allocation_size = fs::file::default_allocation_size;
 
+        // Append to the event files with direct I/O?
+        bool direct_io = false;
+
         // Buffer size of the event writer.
         size_t buffer_size = event::writer::default_buffer_size;
 
+        // Compression of the blocks of the event files.
+        event::compression compression = event::compression::none;
+
+        // Number of buffers handed over to the I/O thread of the event
+        // writer (0: the workers write the events themselves).
+        size_t writer_buffers = 0;
+
+        // What the event writer does when all its buffers are in flight.
+        event::backpressure backpressure = event::backpressure::wait;
+
+        // Rotate the event files when they reach this size (uncompressed
+        // bytes, including the headers, 0: disabled).
+        uint64_t rotation_size = 0;
+
+        // Rotate the event files every 'rotation_interval' seconds (0:
+        // disabled).
+        uint64_t rotation_interval = 0;
+
+        // File where to merge the event files of the workers (only for the
+        // capture method "pcap").
+        const char* merge_filename = nullptr;
+
         // Capture configuration.
         capture cap;
 
@@ -208,6 +381,28 @@ namespace net {
 
       return false;
     }
+
+    inline net::mon::tcp::options configuration::tcp_options() const
+    {
+      // The options shared by IPv4 and IPv6 are set in both.
+      net::mon::tcp::options options;
+      options.ipv4_size = tcp4.size;
+      options.ipv6_size = tcp6.size;
+      options.ipv4_maxconns = tcp4.maxconns;
+      options.ipv6_maxconns = tcp6.maxconns;
+      options.timeout = tcp4.timeout;
+      options.time_wait = tcp4.time_wait;
+      options.update_interval = tcp4.update_interval;
+      options.table = tcp4.table;
+      options.hash = tcp4.hash;
+      options.untracked = tcp4.untracked;
+      options.adopt = tcp4.adopt;
+      options.half_open = tcp4.half_open;
+      options.syn_flood_threshold = tcp4.syn_flood_threshold;
+      options.memory = tcp4.memory;
+
+      return options;
+    }
   }
 }
 
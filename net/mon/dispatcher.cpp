@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <memory>
+#include "net/mon/dispatcher.h"
+#include "net/capture/fanout.h"
+#include "net/flow.h"
+
+bool net::mon::dispatcher::create(unsigned ifindex,
+                                  int rcvbuf_size,
+                                  bool promiscuous_mode,
+                                  size_t ring_buffer_block_size,
+                                  size_t ring_buffer_frame_size,
+                                  size_t ring_buffer_frame_count,
+                                  bool rxhash,
+                                  size_t nqueues,
+                                  size_t queue_size)
+{
+  if ((nqueues > 0) &&
+      (queue_size >= min_queue_size) &&
+      (queue_size <= max_queue_size)) {
+    // The dispatcher is the only member of its fanout group.
+    capture::fanout fanout;
+
+    // Create ring buffer.
+    if (_M_ring_buffer.create(ifindex,
+                              rcvbuf_size,
+                              promiscuous_mode,
+                              ring_buffer_block_size,
+                              ring_buffer_frame_size,
+                              ring_buffer_frame_count,
+                              fanout)) {
+      // Create worker queues.
+      if (((_M_queues = new (std::nothrow)
+                            worker::packet_queue[nqueues]) != nullptr) &&
+          ((_M_statistics = new (std::nothrow)
+                                statistics[nqueues]) != nullptr) &&
+          ((_M_marks = new (std::nothrow)
+                           size_t[_M_ring_buffer.count() * nqueues]) !=
+           nullptr)) {
+        _M_nqueues = nqueues;
+        _M_rxhash = rxhash;
+
+        for (size_t i = 0; i < nqueues; i++) {
+          if (!_M_queues[i].init(queue_size)) {
+            return false;
+          }
+        }
+
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool net::mon::dispatcher::start()
+{
+  return (_M_running = (pthread_create(&_M_thread,
+                                       nullptr,
+                                       run,
+                                       this) == 0));
+}
+
+bool net::mon::dispatcher::show_statistics()
+{
+  printf("Dispatcher:\n");
+
+  if (_M_ring_buffer.show_statistics()) {
+    // Compute the average number of packets per queue.
+    uint64_t total = 0;
+    uint64_t max = 0;
+    for (size_t i = 0; i < _M_nqueues; i++) {
+      total += _M_statistics[i].packets;
+
+      if (_M_statistics[i].packets > max) {
+        max = _M_statistics[i].packets;
+      }
+    }
+
+    printf("  %llu packets dispatched.\n",
+           static_cast<unsigned long long>(total));
+
+    for (size_t i = 0; i < _M_nqueues; i++) {
+      const statistics& stats = _M_statistics[i];
+
+      printf("  Queue %zu: %llu packets (%.2f%%), found full %llu times, "
+             "occupancy: average %.2f, maximum %zu.\n",
+             i,
+             static_cast<unsigned long long>(stats.packets),
+             (total > 0) ? (100.0 * stats.packets) / total : 0.0,
+             static_cast<unsigned long long>(stats.full),
+             (_M_samples > 0) ?
+               static_cast<double>(stats.occupancy) / _M_samples :
+               0.0,
+             stats.max_occupancy);
+    }
+
+    // Imbalance: busiest queue relative to the average.
+    printf("  Imbalance (maximum / average): %.2f.\n",
+           (total > 0) ?
+             static_cast<double>(max * _M_nqueues) / total :
+             0.0);
+
+    return true;
+  }
+
+  return false;
+}
+
+bool net::mon::dispatcher::dispatch(const void* buf,
+                                    size_t len,
+                                    size_t wirelen,
+                                    const struct timeval& timestamp,
+                                    uint32_t rxhash)
+{
+  // Select worker queue (the hash computed by the kernel is not used,
+  // because it is not symmetric for IPv6).
+  size_t n = flow::hash_ethernet(buf, len) % _M_nqueues;
+  worker::packet_queue& queue = _M_queues[n];
+
+  // Wait for a free slot.
+  worker::packet* pkt;
+  if ((pkt = queue.back()) == nullptr) {
+    _M_statistics[n].full++;
+
+    do {
+      capture::busy_poll::relax();
+    } while ((pkt = queue.back()) == nullptr);
+  }
+
+  pkt->buf = buf;
+  pkt->len = static_cast<uint32_t>(len);
+  pkt->wirelen = static_cast<uint32_t>(wirelen);
+  pkt->timestamp = timestamp;
+  pkt->rxhash = rxhash;
+  pkt->t = worker::packet::type::ethernet;
+
+  queue.push();
+
+  _M_statistics[n].packets++;
+
+  return true;
+}
+
+void net::mon::dispatcher::held(void* user)
+{
+  dispatcher* d = static_cast<dispatcher*>(user);
+
+  size_t* marks = d->_M_marks + (d->_M_next * d->_M_nqueues);
+
+  for (size_t i = 0; i < d->_M_nqueues; i++) {
+    // Save the number of packets pushed to the queue so far: the block /
+    // frame can be returned to the kernel once the worker has popped them.
+    marks[i] = d->_M_queues[i].pushed();
+
+    // Sample the queue occupancy.
+    size_t occupancy = marks[i] - d->_M_queues[i].popped();
+
+    d->_M_statistics[i].occupancy += occupancy;
+
+    if (occupancy > d->_M_statistics[i].max_occupancy) {
+      d->_M_statistics[i].max_occupancy = occupancy;
+    }
+  }
+
+  d->_M_samples++;
+
+  d->_M_next = (d->_M_next + 1) % d->_M_ring_buffer.count();
+}
+
+bool net::mon::dispatcher::releasable(void* user)
+{
+  dispatcher* d = static_cast<dispatcher*>(user);
+
+  const size_t* marks = d->_M_marks + (d->_M_oldest * d->_M_nqueues);
+
+  for (size_t i = 0; i < d->_M_nqueues; i++) {
+    if (d->_M_queues[i].popped() < marks[i]) {
+      return false;
+    }
+  }
+
+  d->_M_oldest = (d->_M_oldest + 1) % d->_M_ring_buffer.count();
+
+  return true;
+}
@@ -0,0 +1,232 @@
+#ifndef NET_MON_DISPATCHER_H
+#define NET_MON_DISPATCHER_H
+
+#include <pthread.h>
+#include "net/mon/worker.h"
+#include "net/capture/ring_buffer.h"
+
+namespace net {
+  namespace mon {
+    // Software RSS: a single thread captures the packets with a ring buffer
+    // and dispatches them to the workers by the hash of their flow.
+    //
+    // The workers receive pointers to the frames of the ring buffer, which
+    // holds the blocks (TPACKET_V3) / frames (TPACKET_V2) until all their
+    // packets have been processed by the workers.
+    class dispatcher {
+      public:
+        static constexpr const size_t min_queue_size = 64;
+        static constexpr const size_t max_queue_size = 1024 * 1024;
+        static constexpr const size_t default_queue_size = 16 * 1024;
+
+        // Constructor.
+        dispatcher() = default;
+
+        // Destructor.
+        ~dispatcher();
+
+        // Create.
+        // 'rxhash': whether the hash computed by the kernel is passed to
+        // the workers.
+        // 'nqueues': number of worker queues.
+        // 'queue_size': size of each worker queue (power of 2).
+        bool create(unsigned ifindex,
+                    int rcvbuf_size,
+                    bool promiscuous_mode,
+                    size_t ring_buffer_block_size,
+                    size_t ring_buffer_frame_size,
+                    size_t ring_buffer_frame_count,
+                    bool rxhash,
+                    size_t nqueues,
+                    size_t queue_size);
+
+        // Get worker queue.
+        worker::packet_queue* queue(size_t n);
+
+        // Enable busy poll.
+        bool enable_busy_poll(size_t spins, int usecs);
+
+        // Attach filter.
+        bool attach_filter(const capture::filter& filter);
+
+        // Start.
+        bool start();
+
+        // Stop.
+        void stop();
+
+        // Show statistics.
+        bool show_statistics();
+
+      private:
+        // Statistics of a worker queue.
+        struct statistics {
+          // Number of packets dispatched.
+          uint64_t packets = 0;
+
+          // Number of times the queue was full.
+          uint64_t full = 0;
+
+          // Sum of the samples of the queue occupancy.
+          uint64_t occupancy = 0;
+
+          // Maximum occupancy.
+          size_t max_occupancy = 0;
+        };
+
+        // Ring buffer.
+        capture::ring_buffer _M_ring_buffer;
+
+        // Worker queues.
+        worker::packet_queue* _M_queues = nullptr;
+        size_t _M_nqueues = 0;
+
+        // Statistics of the worker queues.
+        statistics* _M_statistics = nullptr;
+
+        // Number of samples of the queue occupancy.
+        uint64_t _M_samples = 0;
+
+        // Pass the hash computed by the kernel to the workers?
+        bool _M_rxhash = false;
+
+        // Number of packets pushed to each queue after each of the held
+        // blocks / frames ('_M_marks[block * _M_nqueues + queue]').
+        size_t* _M_marks = nullptr;
+
+        // Index of the oldest held block / frame.
+        size_t _M_oldest = 0;
+
+        // Index where to save the marks of the next held block / frame.
+        size_t _M_next = 0;
+
+        // Thread.
+        pthread_t _M_thread;
+
+        // Running?
+        bool _M_running = false;
+
+        // Dispatch ethernet frame.
+        bool dispatch(const void* buf,
+                      size_t len,
+                      size_t wirelen,
+                      const struct timeval& timestamp,
+                      uint32_t rxhash);
+
+        // Dispatch ethernet frame.
+        static bool process_ethernet(const void* buf,
+                                     size_t len,
+                                     size_t wirelen,
+                                     const struct timeval& timestamp,
+                                     void* user);
+
+        // Dispatch batch of ethernet frames.
+        static bool process_batch(const capture::frame* frames,
+                                  size_t nframes,
+                                  void* user);
+
+        // A block / frame has been processed.
+        static void held(void* user);
+
+        // Have the workers processed all the packets of the oldest held
+        // block / frame?
+        static bool releasable(void* user);
+
+        // Run.
+        static void* run(void* arg);
+
+        // Disable copy constructor and assignment operator.
+        dispatcher(const dispatcher&) = delete;
+        dispatcher& operator=(const dispatcher&) = delete;
+    };
+
+    inline dispatcher::~dispatcher()
+    {
+      stop();
+
+      if (_M_marks) {
+        delete [] _M_marks;
+      }
+
+      if (_M_statistics) {
+        delete [] _M_statistics;
+      }
+
+      if (_M_queues) {
+        delete [] _M_queues;
+      }
+    }
+
+    inline worker::packet_queue* dispatcher::queue(size_t n)
+    {
+      return &_M_queues[n];
+    }
+
+    inline bool dispatcher::enable_busy_poll(size_t spins, int usecs)
+    {
+      return _M_ring_buffer.enable_busy_poll(spins, usecs);
+    }
+
+    inline bool dispatcher::attach_filter(const capture::filter& filter)
+    {
+      return _M_ring_buffer.attach_filter(filter);
+    }
+
+    inline void dispatcher::stop()
+    {
+      if (_M_running) {
+        _M_running = false;
+
+        _M_ring_buffer.stop();
+
+        pthread_join(_M_thread, nullptr);
+      }
+    }
+
+    inline bool dispatcher::process_ethernet(const void* buf,
+                                             size_t len,
+                                             size_t wirelen,
+                                             const struct timeval& timestamp,
+                                             void* user)
+    {
+      return static_cast<dispatcher*>(user)->dispatch(buf,
+                                                      len,
+                                                      wirelen,
+                                                      timestamp,
+                                                      0);
+    }
+
+    inline bool dispatcher::process_batch(const capture::frame* frames,
+                                          size_t nframes,
+                                          void* user)
+    {
+      dispatcher* d = static_cast<dispatcher*>(user);
+
+      for (size_t i = 0; i < nframes; i++) {
+        d->dispatch(frames[i].buf,
+                    frames[i].len,
+                    frames[i].wirelen,
+                    frames[i].timestamp,
+                    d->_M_rxhash ? frames[i].rxhash : 0);
+      }
+
+      return true;
+    }
+
+    inline void* dispatcher::run(void* arg)
+    {
+      capture::callbacks callbacks(process_ethernet,
+                                   nullptr,
+                                   held,
+                                   releasable);
+
+      callbacks.batch = process_batch;
+
+      static_cast<dispatcher*>(arg)->_M_ring_buffer.loop(callbacks, arg);
+
+      return nullptr;
+    }
+  }
+}
+
+#endif // NET_MON_DISPATCHER_H
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "util/node.h"
+#include "util/slab_allocator.h"
 #include "string/buffer.h"
 
 namespace net {
@@ -46,8 +47,6 @@ namespace net {
           const char* host(const address_type& addr) const;
 
         private:
-          static constexpr const size_t entry_allocation = 1024;
-
           // Buffer where to store the hostnames.
           string::buffer _M_buf;
 
@@ -69,17 +68,8 @@ namespace net {
           // Mask (for performing modulo).
           size_t _M_mask;
 
-          // Free entries.
-          entry* _M_free = nullptr;
-
-          // Erase entries.
-          static void erase(util::node* header);
-
-          // Get free entry.
-          entry* get_free_entry();
-
-          // Allocate entries.
-          bool allocate_entries(size_t count);
+          // Allocator of the entries.
+          util::slab_allocator _M_allocator;
 
           // Disable copy constructor and assignment operator.
           inverted_cache(const inverted_cache&) = delete;
@@ -96,23 +86,13 @@ namespace net {
       void inverted_cache<Address>::clear()
       {
         if (_M_entries) {
-          for (size_t i = 0; i < _M_size; i++) {
-            erase(&_M_entries[i]);
-          }
-
           free(_M_entries);
           _M_entries = nullptr;
         }
 
         _M_size = 0;
 
-        while (_M_free) {
-          entry* next = static_cast<entry*>(_M_free->next);
-
-          free(_M_free);
-
-          _M_free = next;
-        }
+        _M_allocator.clear();
 
         _M_buf.clear();
       }
@@ -124,21 +104,19 @@ namespace net {
             (size <= max_size) &&
             ((size & (size - 1)) == 0)) {
           // Allocate memory for the entries.
-          if ((_M_entries = static_cast<util::node*>(
-                              malloc(size * sizeof(util::node))
-                            )) != nullptr) {
+          if ((_M_allocator.init(sizeof(entry), -1)) &&
+              ((_M_entries = static_cast<util::node*>(
+                               malloc(size * sizeof(util::node))
+                             )) != nullptr)) {
             for (size_t i = 0; i < size; i++) {
               _M_entries[i].prev = &_M_entries[i];
               _M_entries[i].next = &_M_entries[i];
             }
 
-            // Allocate free entries.
-            if (allocate_entries(entry_allocation)) {
-              _M_size = size;
-              _M_mask = size - 1;
+            _M_size = size;
+            _M_mask = size - 1;
 
-              return true;
-            }
+            return true;
           }
         }
 
@@ -185,7 +163,7 @@ namespace net {
 
         size_t off = _M_buf.length();
 
-        if (((e = get_free_entry()) != nullptr) &&
+        if (((e = static_cast<entry*>(_M_allocator.allocate())) != nullptr) &&
             (_M_buf.append(host, hostlen)) &&
             (_M_buf.append('\0'))) {
           e->prev = header;
@@ -225,51 +203,6 @@ namespace net {
         // Entry not found.
         return nullptr;
       }
-
-      template<typename Address>
-      inline void inverted_cache<Address>::erase(util::node* header)
-      {
-        util::node* n = header->next;
-
-        while (n != header) {
-          util::node* next = n->next;
-
-          free(n);
-
-          n = next;
-        }
-      }
-
-      template<typename Address>
-      inline typename inverted_cache<Address>::entry*
-      inverted_cache<Address>::get_free_entry()
-      {
-        if ((_M_free) || (allocate_entries(entry_allocation))) {
-          entry* e = _M_free;
-
-          _M_free = static_cast<entry*>(_M_free->next);
-
-          return e;
-        }
-
-        return nullptr;
-      }
-
-      template<typename Address>
-      bool inverted_cache<Address>::allocate_entries(size_t count)
-      {
-        for (size_t i = 0; i < count; i++) {
-          entry* e;
-          if ((e = static_cast<entry*>(malloc(sizeof(entry)))) != nullptr) {
-            e->next = _M_free;
-            _M_free = e;
-          } else {
-            return (_M_free != nullptr);
-          }
-        }
-
-        return true;
-      }
     }
   }
 }
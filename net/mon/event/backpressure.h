@@ -0,0 +1,20 @@
+#ifndef NET_MON_EVENT_BACKPRESSURE_H
+#define NET_MON_EVENT_BACKPRESSURE_H
+
+namespace net {
+  namespace mon {
+    namespace event {
+      // What the event writer does with a full buffer when all the buffers
+      // are being written by the I/O thread.
+      enum class backpressure {
+        // Wait for the I/O thread to give a buffer back.
+        wait,
+
+        // Drop the events of the buffer.
+        drop
+      };
+    }
+  }
+}
+
+#endif // NET_MON_EVENT_BACKPRESSURE_H
@@ -21,7 +21,9 @@ namespace net {
         dns,
         tcp_begin,
         tcp_data,
-        tcp_end
+        tcp_end,
+        tcp_half_open,
+        tcp_update
       };
 
       // Minimum length of an event (size of the base event for IPv4).
@@ -0,0 +1,20 @@
+#ifndef NET_MON_EVENT_COMPRESSION_H
+#define NET_MON_EVENT_COMPRESSION_H
+
+namespace net {
+  namespace mon {
+    namespace event {
+      // Compression of the blocks of the event files.
+      enum class compression {
+        // The blocks are not compressed (event files of version 2).
+        none,
+
+        // LZ4 block format (event files of version 3), the blocks are
+        // compressed by the I/O thread of the event writer.
+        lz4
+      };
+    }
+  }
+}
+
+#endif // NET_MON_EVENT_COMPRESSION_H
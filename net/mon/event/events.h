@@ -7,5 +7,7 @@
 #include "net/mon/event/tcp_begin.h"
 #include "net/mon/event/tcp_data.h"
 #include "net/mon/event/tcp_end.h"
+#include "net/mon/event/tcp_half_open.h"
+#include "net/mon/event/tcp_update.h"
 
 #endif // NET_MON_EVENT_EVENTS_H
@@ -2,20 +2,42 @@
 #define NET_MON_EVENT_FILE_H
 
 #include <stdint.h>
+#include <string.h>
 #include <sys/types.h>
+#include <arpa/inet.h>
+#include "net/mon/event/base.h"
 #include "net/mon/event/util.h"
 
 namespace net {
   namespace mon {
     namespace event {
       // Event file.
+      //
+      // Version 1: header followed by the events.
+      // Version 2: header followed by blocks of events. Each block starts
+      // with a block header (the index of the block: number of bytes and
+      // number of events, range of timestamps, types of events and ranges
+      // of addresses and ports), so the reader can skip the blocks which
+      // cannot contain events matching the filter.
+      // Version 3: as version 2, but the block header is followed by the
+      // number of bytes of the events in the file; if it is less than the
+      // length of the block, the events are compressed with LZ4.
       class file {
         public:
           // Event file header.
           class header {
             public:
-              // Magic number.
-              static constexpr const uint64_t magic = 0x6e65746d6f6e0001;
+              // Magic number (version 1).
+              static constexpr const uint64_t magic_v1 = 0x6e65746d6f6e0001;
+
+              // Magic number (version 2).
+              static constexpr const uint64_t magic_v2 = 0x6e65746d6f6e0002;
+
+              // Magic number (version 3).
+              static constexpr const uint64_t magic_v3 = 0x6e65746d6f6e0003;
+
+              // Version of the file format.
+              unsigned version = 2;
 
               // Timestamp of the first and last events.
               struct {
@@ -24,7 +46,7 @@ namespace net {
               } timestamp;
 
               // Header size.
-              static constexpr const size_t size = sizeof(magic) +
+              static constexpr const size_t size = sizeof(magic_v1) +
                                                    sizeof(timestamp);
 
               // Constructor.
@@ -39,12 +61,113 @@ namespace net {
               // Deserialize.
               ssize_t deserialize(const void* buf, size_t size);
           };
+
+          // Block header (versions 2 and 3).
+          class block {
+            public:
+              // Range of values.
+              template<typename T>
+              struct range {
+                T min;
+                T max;
+              };
+
+              // Range of addresses (network byte order).
+              template<size_t N>
+              struct address_range {
+                uint8_t min[N];
+                uint8_t max[N];
+              };
+
+              // Number of bytes of the events of the block.
+              uint32_t length;
+
+              // Number of events.
+              uint32_t count;
+
+              // Timestamps of the oldest and newest events.
+              range<uint64_t> timestamp;
+
+              // Types of the events (bit 'type').
+              uint32_t types;
+
+              // Source and destination IPv4 addresses (0: source, 1:
+              // destination).
+              address_range<4> ipv4[2];
+
+              // Source and destination IPv6 addresses.
+              address_range<16> ipv6[2];
+
+              // Source and destination ports (host byte order, only the
+              // events which have ports).
+              range<uint16_t> port[2];
+
+              // Number of bytes of the events in the file (version 3, less
+              // than 'length' if the events are compressed).
+              uint32_t stored;
+
+              // Block header size (version 2).
+              static constexpr const size_t size_v2 = 4 +      // Length.
+                                                      4 +      // Count.
+                                                      16 +     // Timestamps.
+                                                      4 +      // Types.
+                                                      2 * 8 +  // IPv4.
+                                                      2 * 32 + // IPv6.
+                                                      2 * 4;   // Ports.
+
+              // Block header size (version 3).
+              static constexpr const size_t size_v3 = size_v2 + 4; // Stored.
+
+              // Constructor.
+              block();
+
+              // Destructor.
+              ~block() = default;
+
+              // Clear.
+              void clear();
+
+              // Add (serialized) event.
+              void add(const void* event);
+
+              // Has the block events of type 't'?
+              bool has(type t) const;
+
+              // Get the block header size of the version 'version'.
+              static size_t size(unsigned version);
+
+              // Serialize.
+              ssize_t serialize(void* buf, size_t size, unsigned version) const;
+
+              // Deserialize.
+              ssize_t deserialize(const void* buf,
+                                  size_t size,
+                                  unsigned version);
+
+            private:
+              // Add address.
+              template<size_t N>
+              static void add(address_range<N>& r, const uint8_t* addr);
+
+              // Add port.
+              static void add(range<uint16_t>& r, uint16_t port);
+          };
       };
 
       inline ssize_t file::header::serialize(void* buf, size_t size) const
       {
         if (size >= header::size) {
-          buf = event::serialize(buf, magic);
+          switch (version) {
+            case 1:
+              buf = event::serialize(buf, magic_v1);
+              break;
+            case 2:
+              buf = event::serialize(buf, magic_v2);
+              break;
+            default:
+              buf = event::serialize(buf, magic_v3);
+          }
+
           buf = event::serialize(buf, timestamp.first);
           event::serialize(buf, timestamp.last);
 
@@ -57,13 +180,27 @@ namespace net {
       inline ssize_t file::header::deserialize(const void* buf, size_t size)
       {
         uint64_t n;
-        if ((size >= header::size) && (event::deserialize(n, buf) == magic)) {
+        if (size >= header::size) {
+          switch (event::deserialize(n, buf)) {
+            case magic_v1:
+              version = 1;
+              break;
+            case magic_v2:
+              version = 2;
+              break;
+            case magic_v3:
+              version = 3;
+              break;
+            default:
+              return -1;
+          }
+
           event::deserialize(timestamp.first,
-                             static_cast<const uint8_t*>(buf) + sizeof(magic));
+                             static_cast<const uint8_t*>(buf) + sizeof(n));
 
           event::deserialize(timestamp.last,
                              static_cast<const uint8_t*>(buf) +
-                             sizeof(magic) +
+                             sizeof(n) +
                              8);
 
           return header::size;
@@ -71,6 +208,203 @@ namespace net {
 
         return -1;
       }
+
+      inline file::block::block()
+      {
+        clear();
+      }
+
+      inline void file::block::clear()
+      {
+        length = 0;
+        count = 0;
+
+        timestamp.min = UINT64_MAX;
+        timestamp.max = 0;
+
+        types = 0;
+
+        // Empty ranges (min > max).
+        for (size_t i = 0; i < 2; i++) {
+          memset(ipv4[i].min, 0xff, sizeof(ipv4[i].min));
+          memset(ipv4[i].max, 0, sizeof(ipv4[i].max));
+
+          memset(ipv6[i].min, 0xff, sizeof(ipv6[i].min));
+          memset(ipv6[i].max, 0, sizeof(ipv6[i].max));
+
+          port[i].min = UINT16_MAX;
+          port[i].max = 0;
+        }
+
+        stored = 0;
+      }
+
+      inline void file::block::add(const void* event)
+      {
+        // Precondition: the event has been validated.
+
+        const uint8_t* b = static_cast<const uint8_t*>(event);
+
+        length += base::extract_length(b);
+        count++;
+
+        uint64_t t = base::extract_timestamp(b);
+        if (t < timestamp.min) {
+          timestamp.min = t;
+        }
+
+        if (t > timestamp.max) {
+          timestamp.max = t;
+        }
+
+        type evtype = base::extract_type(b);
+        types |= (static_cast<uint32_t>(1) << static_cast<unsigned>(evtype));
+
+        // Make 'b' point to the address length.
+        b += sizeof(evlen_t) + 8 + sizeof(type);
+
+        size_t addrlen = *b++;
+        if (addrlen == 4) {
+          add(ipv4[0], b);
+          add(ipv4[1], b + 4);
+        } else {
+          add(ipv6[0], b);
+          add(ipv6[1], b + 16);
+        }
+
+        // All the events but ICMP have the ports after the addresses.
+        if (evtype != type::icmp) {
+          b += 2 * addrlen;
+
+          uint16_t sport, dport;
+          add(port[0], ntohs(event::deserialize(sport, b)));
+          add(port[1], ntohs(event::deserialize(dport, b + 2)));
+        }
+      }
+
+      inline bool file::block::has(type t) const
+      {
+        return ((types &
+                 (static_cast<uint32_t>(1) << static_cast<unsigned>(t))) != 0);
+      }
+
+      inline size_t file::block::size(unsigned version)
+      {
+        return (version == 2) ? size_v2 : size_v3;
+      }
+
+      inline ssize_t file::block::serialize(void* buf,
+                                            size_t size,
+                                            unsigned version) const
+      {
+        if (size >= block::size(version)) {
+          buf = event::serialize(buf, length);
+          buf = event::serialize(buf, count);
+          buf = event::serialize(buf, timestamp.min);
+          buf = event::serialize(buf, timestamp.max);
+          buf = event::serialize(buf, types);
+
+          uint8_t* b = static_cast<uint8_t*>(buf);
+
+          for (size_t i = 0; i < 2; i++) {
+            memcpy(b, ipv4[i].min, 4);
+            memcpy(b + 4, ipv4[i].max, 4);
+
+            b += 8;
+          }
+
+          for (size_t i = 0; i < 2; i++) {
+            memcpy(b, ipv6[i].min, 16);
+            memcpy(b + 16, ipv6[i].max, 16);
+
+            b += 32;
+          }
+
+          for (size_t i = 0; i < 2; i++) {
+            b = static_cast<uint8_t*>(event::serialize(b, port[i].min));
+            b = static_cast<uint8_t*>(event::serialize(b, port[i].max));
+          }
+
+          if (version == 3) {
+            event::serialize(b, stored);
+          }
+
+          return block::size(version);
+        }
+
+        return -1;
+      }
+
+      inline ssize_t file::block::deserialize(const void* buf,
+                                              size_t size,
+                                              unsigned version)
+      {
+        if (size >= block::size(version)) {
+          const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+          event::deserialize(length, b);
+          event::deserialize(count, b + 4);
+          event::deserialize(timestamp.min, b + 8);
+          event::deserialize(timestamp.max, b + 16);
+          event::deserialize(types, b + 24);
+
+          b += 28;
+
+          for (size_t i = 0; i < 2; i++) {
+            memcpy(ipv4[i].min, b, 4);
+            memcpy(ipv4[i].max, b + 4, 4);
+
+            b += 8;
+          }
+
+          for (size_t i = 0; i < 2; i++) {
+            memcpy(ipv6[i].min, b, 16);
+            memcpy(ipv6[i].max, b + 16, 16);
+
+            b += 32;
+          }
+
+          for (size_t i = 0; i < 2; i++) {
+            event::deserialize(port[i].min, b);
+            event::deserialize(port[i].max, b + 2);
+
+            b += 4;
+          }
+
+          if (version == 3) {
+            event::deserialize(stored, b);
+          } else {
+            stored = length;
+          }
+
+          return block::size(version);
+        }
+
+        return -1;
+      }
+
+      template<size_t N>
+      inline void file::block::add(address_range<N>& r, const uint8_t* addr)
+      {
+        if (memcmp(addr, r.min, N) < 0) {
+          memcpy(r.min, addr, N);
+        }
+
+        if (memcmp(addr, r.max, N) > 0) {
+          memcpy(r.max, addr, N);
+        }
+      }
+
+      inline void file::block::add(range<uint16_t>& r, uint16_t port)
+      {
+        if (port < r.min) {
+          r.min = port;
+        }
+
+        if (port > r.max) {
+          r.max = port;
+        }
+      }
     }
   }
 }
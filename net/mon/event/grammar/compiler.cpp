@@ -0,0 +1,742 @@
+#include <stdio.h>
+#include <netinet/in.h>
+#include <net/ethernet.h>
+#include <linux/if_ether.h>
+#include "net/mon/event/grammar/compiler.h"
+
+// Offsets relative to the network header.
+static constexpr const uint32_t net_offset =
+  static_cast<uint32_t>(SKF_NET_OFF);
+
+static constexpr const uint32_t protocol_offset =
+  static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PROTOCOL);
+
+// IPv4 header.
+static constexpr const uint32_t ipv4_protocol = 9;
+static constexpr const uint32_t ipv4_source = 12;
+static constexpr const uint32_t ipv4_destination = 16;
+
+// IPv6 header.
+static constexpr const uint32_t ipv6_next_header = 6;
+static constexpr const uint32_t ipv6_source = 8;
+static constexpr const uint32_t ipv6_destination = 24;
+static constexpr const uint32_t ipv6_header_length = 40;
+
+// Transport header.
+static constexpr const uint32_t source_port = 0;
+static constexpr const uint32_t destination_port = 2;
+static constexpr const uint32_t icmp_type = 0;
+static constexpr const uint32_t icmp_code = 1;
+
+// DNS port.
+static constexpr const uint32_t dns_port = 53;
+
+bool
+net::mon::event::grammar::compiler::compile(const conditional_expression* expr,
+                                            size_t snaplen,
+                                            capture::filter& filter)
+{
+  _M_filter = &filter;
+  _M_filter->clear();
+
+  _M_nlabels = 0;
+  _M_nfixups = 0;
+
+  label laccept, lreject;
+  if ((!create_label(laccept)) ||
+      (!create_label(lreject)) ||
+      ((expr) && (!compile(expr, laccept, lreject, laccept)))) {
+    return false;
+  }
+
+  place(laccept);
+
+  if (snaplen == 0) {
+    // Accept the whole packet.
+    if (!emit(BPF_RET | BPF_K, 0xffffffff)) {
+      return false;
+    }
+  } else {
+    // DNS messages are parsed, capture them whole.
+    label lwhole, lheaders;
+    if ((!create_label(lwhole)) ||
+        (!create_label(lheaders)) ||
+        (!compile_port(direction::any,
+                       relational_operator::equal_to,
+                       dns_port,
+                       false,
+                       lwhole,
+                       lheaders))) {
+      return false;
+    }
+
+    // Accept the first 'snaplen' bytes of the packet.
+    place(lheaders);
+    if (!emit(BPF_RET | BPF_K, static_cast<uint32_t>(snaplen))) {
+      return false;
+    }
+
+    // Accept the whole packet.
+    place(lwhole);
+    if (!emit(BPF_RET | BPF_K, 0xffffffff)) {
+      return false;
+    }
+  }
+
+  if (expr) {
+    // Drop packet.
+    place(lreject);
+    if (!emit(BPF_RET | BPF_K, 0)) {
+      return false;
+    }
+  }
+
+  return resolve();
+}
+
+bool
+net::mon::event::grammar::compiler::compile(const conditional_expression* expr,
+                                            label ltrue,
+                                            label lfalse,
+                                            label lnext)
+{
+  label lright;
+
+  const logical_and_expression* and_expr;
+  const logical_or_expression* or_expr;
+  const equality_expression* equality_expr;
+  const relational_expression* relational_expr;
+
+  if ((and_expr = dynamic_cast<const logical_and_expression*>(expr))) {
+    if ((create_label(lright)) &&
+        (compile(and_expr->left(), lright, lfalse, lright))) {
+      place(lright);
+      return compile(and_expr->right(), ltrue, lfalse, lnext);
+    }
+  } else if ((or_expr = dynamic_cast<const logical_or_expression*>(expr))) {
+    if ((create_label(lright)) &&
+        (compile(or_expr->left(), ltrue, lright, lright))) {
+      place(lright);
+      return compile(or_expr->right(), ltrue, lfalse, lnext);
+    }
+  } else if ((equality_expr =
+              dynamic_cast<const equality_expression*>(expr))) {
+    return compile(equality_expr,
+                   static_cast<relational_operator>(
+                     static_cast<unsigned>(equality_expr->op())
+                   ),
+                   ltrue,
+                   lfalse,
+                   lnext);
+  } else if ((relational_expr =
+              dynamic_cast<const relational_expression*>(expr))) {
+    return compile(relational_expr,
+                   static_cast<relational_operator>(
+                     static_cast<unsigned>(relational_expr->op())
+                   ),
+                   ltrue,
+                   lfalse,
+                   lnext);
+  } else {
+    fprintf(stderr,
+            "The NOT operator cannot be compiled into a BPF filter.\n");
+  }
+
+  return false;
+}
+
+bool
+net::mon::event::grammar::compiler::compile(const event_expression* expr,
+                                            relational_operator op,
+                                            label ltrue,
+                                            label lfalse,
+                                            label lnext)
+{
+  // Create the labels where the code of the expression jumps to.
+  label lt, lf;
+  if ((!create_label(lt)) || (!create_label(lf))) {
+    return false;
+  }
+
+  bool equality = ((op == relational_operator::equal_to) ||
+                   (op == relational_operator::not_equal_to));
+
+  bool ret;
+
+  switch (expr->id()) {
+    case identifier::source_ip:
+    case identifier::destination_ip:
+    case identifier::ip:
+      if (!equality) {
+        fprintf(stderr,
+                "Identifier '%s' only supports the operators == and !=.\n",
+                to_string(expr->id()));
+
+        return false;
+      }
+
+      ret = compile_ip((expr->id() == identifier::source_ip) ?
+                         direction::source :
+                         (expr->id() == identifier::destination_ip) ?
+                           direction::destination :
+                           direction::any,
+                       op == relational_operator::equal_to,
+                       expr->netmask(),
+                       lt,
+                       lf);
+
+      break;
+    case identifier::source_port:
+    case identifier::destination_port:
+    case identifier::port:
+      ret = compile_port((expr->id() == identifier::source_port) ?
+                           direction::source :
+                           (expr->id() == identifier::destination_port) ?
+                             direction::destination :
+                             direction::any,
+                         op,
+                         static_cast<uint32_t>(expr->number()),
+                         true,
+                         lt,
+                         lf);
+
+      break;
+    case identifier::icmp_type:
+    case identifier::icmp_code:
+      ret = compile_icmp((expr->id() == identifier::icmp_type) ? icmp_type :
+                                                                 icmp_code,
+                         op,
+                         static_cast<uint32_t>(expr->number()),
+                         lt,
+                         lf);
+
+      break;
+    case identifier::event_type:
+      if (!equality) {
+        fprintf(stderr,
+                "Identifier '%s' only supports the operators == and !=.\n",
+                to_string(expr->id()));
+
+        return false;
+      }
+
+      ret = compile_event_type(op == relational_operator::equal_to,
+                               static_cast<event::type>(expr->number()),
+                               lt,
+                               lf);
+
+      break;
+    default:
+      fprintf(stderr,
+              "Identifier '%s' is not available at packet level and cannot "
+              "be compiled into a BPF filter (packet-level identifiers: ip, "
+              "source_ip, destination_ip, port, source_port, "
+              "destination_port, icmp_type, icmp_code and event_type).\n",
+              to_string(expr->id()));
+
+      return false;
+  }
+
+  if (ret) {
+    // Jump to the targets of the expression (the conditional jumps have
+    // a limited range).
+    if (lnext == ltrue) {
+      place(lf);
+      if (emit_jump(lfalse)) {
+        place(lt);
+        return true;
+      }
+    } else {
+      place(lt);
+      if (emit_jump(ltrue)) {
+        place(lf);
+        return (lnext == lfalse) ? true : emit_jump(lfalse);
+      }
+    }
+  }
+
+  return false;
+}
+
+bool net::mon::event::grammar::compiler::compile_ip(direction dir,
+                                                    bool equal_to,
+                                                    const mask& netmask,
+                                                    label ltrue,
+                                                    label lfalse)
+{
+  // Labels for when the address matches / doesn't match.
+  label lmatch = equal_to ? ltrue : lfalse;
+  label lnomatch = equal_to ? lfalse : ltrue;
+
+  label lipv4, lipv6;
+  if ((!create_label(lipv4)) ||
+      (!create_label(lipv6)) ||
+      (!check_network_protocol(lipv4, lipv6, ltrue, lfalse))) {
+    return false;
+  }
+
+  for (unsigned i = 0; i < 2; i++) {
+    bool ipv4 = (i == 0);
+
+    place(ipv4 ? lipv4 : lipv6);
+
+    // If the address family doesn't match...
+    if (ipv4 != netmask.ipv4()) {
+      if (!emit_jump(lnomatch)) {
+        return false;
+      }
+
+      continue;
+    }
+
+    uint32_t src = ipv4 ? ipv4_source : ipv6_source;
+    uint32_t dest = ipv4 ? ipv4_destination : ipv6_destination;
+
+    label lsecond, lexact;
+    if ((!create_label(lsecond)) || (!create_label(lexact))) {
+      return false;
+    }
+
+    switch (dir) {
+      case direction::any:
+        // (source matches) || (destination matches).
+        if ((!test_address(src, netmask, lmatch, lsecond))) {
+          return false;
+        }
+
+        break;
+      default:
+        // The source of UDP and ICMP events is the source of the packet,
+        // TCP events might have been generated from a packet of the
+        // other direction.
+        if ((!emit(BPF_LD | BPF_B | BPF_ABS,
+                   net_offset +
+                   (ipv4 ? ipv4_protocol : ipv6_next_header))) ||
+            (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K,
+                        IPPROTO_UDP,
+                        lexact,
+                        next)) ||
+            (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K,
+                        ipv4 ? static_cast<uint32_t>(IPPROTO_ICMP) :
+                               static_cast<uint32_t>(IPPROTO_ICMPV6),
+                        lexact,
+                        next))) {
+          return false;
+        }
+
+        // (source 'op' address) || (destination 'op' address).
+        if ((!test_address(src,
+                           netmask,
+                           equal_to ? ltrue : lsecond,
+                           equal_to ? lsecond : ltrue))) {
+          return false;
+        }
+
+        break;
+    }
+
+    place(lsecond);
+    if (!test_address(dest, netmask, lmatch, lnomatch)) {
+      return false;
+    }
+
+    if (dir != direction::any) {
+      place(lexact);
+      if (!test_address((dir == direction::source) ? src : dest,
+                        netmask,
+                        lmatch,
+                        lnomatch)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool net::mon::event::grammar::compiler::compile_port(direction dir,
+                                                      relational_operator op,
+                                                      uint32_t port,
+                                                      bool tcp,
+                                                      label ltrue,
+                                                      label lfalse)
+{
+  label lipv4, lipv6, lboth, lexact;
+  if ((!create_label(lipv4)) ||
+      (!create_label(lipv6)) ||
+      (!create_label(lboth)) ||
+      (!create_label(lexact)) ||
+      (!check_network_protocol(lipv4, lipv6, ltrue, lfalse))) {
+    return false;
+  }
+
+  // Both ports have to be checked for TCP packets (the source of a TCP
+  // event is the client).
+  label ltcp = tcp ? ((dir == direction::any) ? lexact : lboth) : lfalse;
+
+  // IPv4.
+  place(lipv4);
+  if ((!load_ipv4_header_length()) ||
+      (!emit(BPF_LD | BPF_B | BPF_ABS, net_offset + ipv4_protocol)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, ltcp, next)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, lexact, lfalse))) {
+    return false;
+  }
+
+  // IPv6 (the transport header cannot be found when there are extension
+  // headers).
+  place(lipv6);
+  if ((!emit(BPF_LDX | BPF_W | BPF_IMM, ipv6_header_length)) ||
+      (!emit(BPF_LD | BPF_B | BPF_ABS, net_offset + ipv6_next_header)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, ltcp, next)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, lexact, next)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K,
+                  IPPROTO_ICMPV6,
+                  lfalse,
+                  ltrue))) {
+    return false;
+  }
+
+  if (dir != direction::any) {
+    // (source port 'op' port) || (destination port 'op' port).
+    place(lboth);
+    if ((!emit(BPF_LD | BPF_H | BPF_IND, net_offset + source_port)) ||
+        (!test_value(op, port, ltrue, next)) ||
+        (!emit(BPF_LD | BPF_H | BPF_IND, net_offset + destination_port)) ||
+        (!test_value(op, port, ltrue, lfalse))) {
+      return false;
+    }
+
+    place(lexact);
+    return ((emit(BPF_LD | BPF_H | BPF_IND,
+                  net_offset +
+                  ((dir == direction::source) ? source_port :
+                                                destination_port))) &&
+            (test_value(op, port, ltrue, lfalse)));
+  }
+
+  place(lexact);
+
+  if (op == relational_operator::not_equal_to) {
+    // !((source port == port) || (destination port == port)).
+    return ((emit(BPF_LD | BPF_H | BPF_IND, net_offset + source_port)) &&
+            (test_value(relational_operator::equal_to,
+                        port,
+                        lfalse,
+                        next)) &&
+            (emit(BPF_LD | BPF_H | BPF_IND, net_offset + destination_port)) &&
+            (test_value(relational_operator::equal_to,
+                        port,
+                        lfalse,
+                        ltrue)));
+  }
+
+  // (source port 'op' port) || (destination port 'op' port).
+  return ((emit(BPF_LD | BPF_H | BPF_IND, net_offset + source_port)) &&
+          (test_value(op, port, ltrue, next)) &&
+          (emit(BPF_LD | BPF_H | BPF_IND, net_offset + destination_port)) &&
+          (test_value(op, port, ltrue, lfalse)));
+}
+
+bool net::mon::event::grammar::compiler::compile_icmp(uint32_t offset,
+                                                      relational_operator op,
+                                                      uint32_t n,
+                                                      label ltrue,
+                                                      label lfalse)
+{
+  label lipv4, lipv6, licmpv6;
+  if ((!create_label(lipv4)) ||
+      (!create_label(lipv6)) ||
+      (!create_label(licmpv6)) ||
+      (!check_network_protocol(lipv4, lipv6, ltrue, lfalse))) {
+    return false;
+  }
+
+  // IPv4.
+  place(lipv4);
+  if ((!emit(BPF_LD | BPF_B | BPF_ABS, net_offset + ipv4_protocol)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_ICMP, next, lfalse)) ||
+      (!load_ipv4_header_length()) ||
+      (!emit(BPF_LD | BPF_B | BPF_IND, net_offset + offset)) ||
+      (!test_value(op, n, ltrue, lfalse))) {
+    return false;
+  }
+
+  // IPv6 (the ICMPv6 header cannot be found when there are extension
+  // headers).
+  place(lipv6);
+  if ((!emit(BPF_LD | BPF_B | BPF_ABS, net_offset + ipv6_next_header)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_ICMPV6, licmpv6, next)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, lfalse, next)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, lfalse, ltrue))) {
+    return false;
+  }
+
+  place(licmpv6);
+  return ((emit(BPF_LD | BPF_B | BPF_ABS,
+                net_offset + ipv6_header_length + offset)) &&
+          (test_value(op, n, ltrue, lfalse)));
+}
+
+bool net::mon::event::grammar::compiler::compile_event_type(bool equal_to,
+                                                            event::type type,
+                                                            label ltrue,
+                                                            label lfalse)
+{
+  uint8_t ipv4_proto, ipv6_proto;
+
+  switch (type) {
+    case event::type::icmp:
+      ipv4_proto = IPPROTO_ICMP;
+      ipv6_proto = IPPROTO_ICMPV6;
+      break;
+    case event::type::udp:
+      // UDP packets might generate UDP or DNS events.
+      if (!equal_to) {
+        return check_network_protocol(ltrue, ltrue, ltrue, lfalse);
+      }
+
+      ipv4_proto = IPPROTO_UDP;
+      ipv6_proto = IPPROTO_UDP;
+      break;
+    case event::type::dns:
+      // UDP packets to / from port 53 might generate UDP or DNS events.
+      return equal_to ? compile_port(direction::any,
+                                     relational_operator::equal_to,
+                                     dns_port,
+                                     false,
+                                     ltrue,
+                                     lfalse) :
+                        check_network_protocol(ltrue, ltrue, ltrue, lfalse);
+    default:
+      // TCP packets might generate any of the TCP events.
+      if (!equal_to) {
+        return check_network_protocol(ltrue, ltrue, ltrue, lfalse);
+      }
+
+      ipv4_proto = IPPROTO_TCP;
+      ipv6_proto = IPPROTO_TCP;
+      break;
+  }
+
+  label lmatch = equal_to ? ltrue : lfalse;
+  label lnomatch = equal_to ? lfalse : ltrue;
+
+  label lipv4, lipv6;
+  if ((!create_label(lipv4)) ||
+      (!create_label(lipv6)) ||
+      (!check_network_protocol(lipv4, lipv6, ltrue, lfalse))) {
+    return false;
+  }
+
+  // IPv4.
+  place(lipv4);
+  if ((!emit(BPF_LD | BPF_B | BPF_ABS, net_offset + ipv4_protocol)) ||
+      (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K, ipv4_proto, lmatch, lnomatch))) {
+    return false;
+  }
+
+  // IPv6 (the transport protocol is not known when there are extension
+  // headers).
+  place(lipv6);
+  return ((emit(BPF_LD | BPF_B | BPF_ABS, net_offset + ipv6_next_header)) &&
+          (emit_jump(BPF_JMP | BPF_JEQ | BPF_K, ipv6_proto, lmatch, next)) &&
+          (emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, lnomatch, next)) &&
+          (emit_jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, lnomatch, next)) &&
+          (emit_jump(BPF_JMP | BPF_JEQ | BPF_K,
+                     IPPROTO_ICMPV6,
+                     lnomatch,
+                     ltrue)));
+}
+
+bool net::mon::event::grammar::compiler::check_network_protocol(label lipv4,
+                                                                label lipv6,
+                                                                label lmpls,
+                                                                label lother)
+{
+  return ((emit(BPF_LD | BPF_W | BPF_ABS, protocol_offset)) &&
+          (emit_jump(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, lipv4, next)) &&
+          (emit_jump(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, lipv6, next)) &&
+          (emit_jump(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_MPLS_UC, lmpls, next)) &&
+          (emit_jump(BPF_JMP | BPF_JEQ | BPF_K,
+                     ETH_P_MPLS_MC,
+                     lmpls,
+                     lother)));
+}
+
+bool net::mon::event::grammar::compiler::test_address(uint32_t offset,
+                                                      const mask& netmask,
+                                                      label lmatch,
+                                                      label lnomatch)
+{
+  // Find the last word of the mask which is not zero.
+  int last = -1;
+  for (int i = netmask.ipv4() ? 0 : 3; i >= 0; i--) {
+    if (netmask.netmask(i) != 0) {
+      last = i;
+      break;
+    }
+  }
+
+  // If the mask is zero, every address matches.
+  if (last == -1) {
+    return emit_jump(lmatch);
+  }
+
+  for (int i = 0; i <= last; i++) {
+    uint32_t m;
+    if ((m = netmask.netmask(i)) != 0) {
+      if ((!emit(BPF_LD | BPF_W | BPF_ABS, net_offset + offset + (i << 2))) ||
+          ((m != 0xffffffff) && (!emit(BPF_ALU | BPF_AND | BPF_K, m))) ||
+          (!emit_jump(BPF_JMP | BPF_JEQ | BPF_K,
+                      netmask.network(i) & m,
+                      (i == last) ? lmatch : next,
+                      lnomatch))) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool net::mon::event::grammar::compiler::test_value(relational_operator op,
+                                                    uint32_t n,
+                                                    label ltrue,
+                                                    label lfalse)
+{
+  switch (op) {
+    case relational_operator::equal_to:
+      return emit_jump(BPF_JMP | BPF_JEQ | BPF_K, n, ltrue, lfalse);
+    case relational_operator::not_equal_to:
+      return emit_jump(BPF_JMP | BPF_JEQ | BPF_K, n, lfalse, ltrue);
+    case relational_operator::less:
+      return emit_jump(BPF_JMP | BPF_JGE | BPF_K, n, lfalse, ltrue);
+    case relational_operator::greater:
+      return emit_jump(BPF_JMP | BPF_JGT | BPF_K, n, ltrue, lfalse);
+    case relational_operator::less_or_equal:
+      return emit_jump(BPF_JMP | BPF_JGT | BPF_K, n, lfalse, ltrue);
+    case relational_operator::greater_or_equal:
+      return emit_jump(BPF_JMP | BPF_JGE | BPF_K, n, ltrue, lfalse);
+    default:
+      return false;
+  }
+}
+
+bool net::mon::event::grammar::compiler::load_ipv4_header_length()
+{
+  // X = (first byte of the IPv4 header & 0x0f) * 4.
+  return ((emit(BPF_LD | BPF_B | BPF_ABS, net_offset)) &&
+          (emit(BPF_ALU | BPF_AND | BPF_K, 0x0f)) &&
+          (emit(BPF_ALU | BPF_LSH | BPF_K, 2)) &&
+          (emit(BPF_MISC | BPF_TAX, 0)));
+}
+
+bool net::mon::event::grammar::compiler::create_label(label& l)
+{
+  if (_M_nlabels < max_labels) {
+    l = _M_nlabels;
+    _M_labels[_M_nlabels++] = unplaced;
+
+    return true;
+  }
+
+  fprintf(stderr, "Expression too complex to be compiled into a BPF filter.\n");
+
+  return false;
+}
+
+void net::mon::event::grammar::compiler::place(label l)
+{
+  _M_labels[l] = _M_filter->size();
+}
+
+bool net::mon::event::grammar::compiler::emit(uint16_t code, uint32_t k)
+{
+  if (_M_filter->add(code, k)) {
+    return true;
+  }
+
+  fprintf(stderr,
+          "Expression too complex to be compiled into a BPF filter (more "
+          "than %zu instructions).\n",
+          capture::filter::max_instructions);
+
+  return false;
+}
+
+bool net::mon::event::grammar::compiler::emit_jump(uint16_t code,
+                                                   uint32_t k,
+                                                   label ljt,
+                                                   label ljf)
+{
+  return ((emit(code, k)) &&
+          ((ljt == next) || (add_fixup(ljt, fixup::field::jt))) &&
+          ((ljf == next) || (add_fixup(ljf, fixup::field::jf))));
+}
+
+bool net::mon::event::grammar::compiler::emit_jump(label l)
+{
+  return ((emit(BPF_JMP | BPF_JA, 0)) && (add_fixup(l, fixup::field::k)));
+}
+
+bool net::mon::event::grammar::compiler::add_fixup(label l, fixup::field f)
+{
+  if (_M_nfixups < max_fixups) {
+    fixup* fix = &_M_fixups[_M_nfixups++];
+
+    fix->insn = _M_filter->size() - 1;
+    fix->lbl = l;
+    fix->f = f;
+
+    return true;
+  }
+
+  fprintf(stderr, "Expression too complex to be compiled into a BPF filter.\n");
+
+  return false;
+}
+
+bool net::mon::event::grammar::compiler::resolve()
+{
+  for (size_t i = 0; i < _M_nfixups; i++) {
+    const fixup& fix = _M_fixups[i];
+
+    // Classic BPF only supports forward jumps.
+    size_t target = _M_labels[fix.lbl];
+    if ((target == unplaced) || (target <= fix.insn)) {
+      fprintf(stderr, "Invalid jump while generating the BPF filter.\n");
+      return false;
+    }
+
+    size_t offset = target - fix.insn - 1;
+
+    struct sock_filter& insn = (*_M_filter)[fix.insn];
+
+    switch (fix.f) {
+      case fixup::field::jt:
+      case fixup::field::jf:
+        // The offset of conditional jumps is 8 bits.
+        if (offset > 0xff) {
+          fprintf(stderr,
+                  "Expression too complex to be compiled into a BPF filter "
+                  "(jump out of range).\n");
+
+          return false;
+        }
+
+        if (fix.f == fixup::field::jt) {
+          insn.jt = static_cast<uint8_t>(offset);
+        } else {
+          insn.jf = static_cast<uint8_t>(offset);
+        }
+
+        break;
+      case fixup::field::k:
+        insn.k = static_cast<uint32_t>(offset);
+        break;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,182 @@
+#ifndef NET_MON_EVENT_GRAMMAR_COMPILER_H
+#define NET_MON_EVENT_GRAMMAR_COMPILER_H
+
+#include "net/mon/event/grammar/expressions.h"
+#include "net/capture/filter.h"
+
+namespace net {
+  namespace mon {
+    namespace event {
+      namespace grammar {
+        // Compiler of filter expressions into classic BPF programs.
+        //
+        // Only packet-level identifiers can be compiled (ip, source_ip,
+        // destination_ip, port, source_port, destination_port, icmp_type,
+        // icmp_code and event_type).
+        //
+        // The generated program accepts a superset of the packets from which
+        // events matching the expression can be generated:
+        //   - Both directions of a TCP connection are accepted (the source of
+        //     a TCP event is the client, which is not known per packet).
+        //   - IPv6 packets with extension headers are accepted when the
+        //     transport header is needed.
+        //   - MPLS packets are accepted.
+        //
+        // If a snapshot length is given, only the first 'snaplen' bytes of
+        // the accepted packets are captured, except for the UDP packets from /
+        // to port 53 (DNS), which are captured whole.
+        class compiler {
+          public:
+            // Constructor.
+            compiler() = default;
+
+            // Destructor.
+            ~compiler() = default;
+
+            // Compile expression.
+            // 'expr': filter expression (nullptr: accept all the packets).
+            // 'snaplen': snapshot length (0: capture the whole packets).
+            bool compile(const conditional_expression* expr,
+                         size_t snaplen,
+                         capture::filter& filter);
+
+          private:
+            static constexpr const size_t
+                   max_labels = capture::filter::max_instructions;
+
+            static constexpr const size_t
+                   max_fixups = 2 * capture::filter::max_instructions;
+
+            // Label.
+            typedef size_t label;
+
+            // Next instruction.
+            static constexpr const label next = static_cast<label>(-1);
+
+            // Label not placed yet.
+            static constexpr const size_t unplaced = static_cast<size_t>(-1);
+
+            // Jump to be resolved when all the labels have been placed.
+            struct fixup {
+              enum class field {
+                jt,
+                jf,
+                k
+              };
+
+              size_t insn;
+              label lbl;
+              field f;
+            };
+
+            // Direction.
+            enum class direction {
+              source,
+              destination,
+              any
+            };
+
+            // Filter being generated.
+            capture::filter* _M_filter;
+
+            // Position of each label.
+            size_t _M_labels[max_labels];
+            size_t _M_nlabels;
+
+            // Fixups.
+            fixup _M_fixups[max_fixups];
+            size_t _M_nfixups;
+
+            // Compile expression.
+            bool compile(const conditional_expression* expr,
+                         label ltrue,
+                         label lfalse,
+                         label lnext);
+
+            // Compile event expression.
+            bool compile(const event_expression* expr,
+                         relational_operator op,
+                         label ltrue,
+                         label lfalse,
+                         label lnext);
+
+            // Compile IP address expression.
+            bool compile_ip(direction dir,
+                            bool equal_to,
+                            const mask& netmask,
+                            label ltrue,
+                            label lfalse);
+
+            // Compile port expression.
+            // 'tcp': whether TCP packets can match.
+            bool compile_port(direction dir,
+                              relational_operator op,
+                              uint32_t port,
+                              bool tcp,
+                              label ltrue,
+                              label lfalse);
+
+            // Compile ICMP type / code expression.
+            bool compile_icmp(uint32_t offset,
+                              relational_operator op,
+                              uint32_t n,
+                              label ltrue,
+                              label lfalse);
+
+            // Compile event type expression.
+            bool compile_event_type(bool equal_to,
+                                    event::type type,
+                                    label ltrue,
+                                    label lfalse);
+
+            // Jump to 'lipv4', 'lipv6', 'lmpls' or 'lother' depending on the
+            // network protocol.
+            bool check_network_protocol(label lipv4,
+                                        label lipv6,
+                                        label lmpls,
+                                        label lother);
+
+            // Test address:
+            // (address at 'offset' matches 'netmask') ? lmatch : lnomatch.
+            bool test_address(uint32_t offset,
+                              const mask& netmask,
+                              label lmatch,
+                              label lnomatch);
+
+            // Test value in A: ('A' 'op' 'n') ? ltrue : lfalse.
+            bool test_value(relational_operator op,
+                            uint32_t n,
+                            label ltrue,
+                            label lfalse);
+
+            // Load in X the offset of the transport header relative to the
+            // IPv4 header.
+            bool load_ipv4_header_length();
+
+            // Create label.
+            bool create_label(label& l);
+
+            // Place label.
+            void place(label l);
+
+            // Emit instruction.
+            bool emit(uint16_t code, uint32_t k);
+
+            // Emit conditional jump.
+            bool emit_jump(uint16_t code, uint32_t k, label ljt, label ljf);
+
+            // Emit unconditional jump.
+            bool emit_jump(label l);
+
+            // Add fixup.
+            bool add_fixup(label l, fixup::field f);
+
+            // Resolve jumps.
+            bool resolve();
+        };
+      }
+    }
+  }
+}
+
+#endif // NET_MON_EVENT_GRAMMAR_COMPILER_H
@@ -126,13 +126,13 @@ namespace net {
             case identifier::source_hostname:
               return evaluate_hostname(srchostname);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_ip:
               return evaluate_destination_ip(ev);
             case identifier::destination_hostname:
               return evaluate_hostname(desthostname);
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::ip:
               return evaluate_ip(ev);
             case identifier::hostname:
@@ -161,13 +161,13 @@ namespace net {
             case identifier::source_hostname:
               return evaluate_hostname(srchostname);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_ip:
               return evaluate_destination_ip(ev);
             case identifier::destination_hostname:
               return evaluate_hostname(desthostname);
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::ip:
               return evaluate_ip(ev);
             case identifier::hostname:
@@ -214,13 +214,13 @@ namespace net {
             case identifier::source_hostname:
               return evaluate_hostname(srchostname);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_ip:
               return evaluate_destination_ip(ev);
             case identifier::destination_hostname:
               return evaluate_hostname(desthostname);
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::ip:
               return evaluate_ip(ev);
             case identifier::hostname:
@@ -247,13 +247,13 @@ namespace net {
             case identifier::source_hostname:
               return evaluate_hostname(srchostname);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_ip:
               return evaluate_destination_ip(ev);
             case identifier::destination_hostname:
               return evaluate_hostname(desthostname);
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::ip:
               return evaluate_ip(ev);
             case identifier::hostname:
@@ -282,13 +282,87 @@ namespace net {
             case identifier::source_hostname:
               return evaluate_hostname(srchostname);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_ip:
               return evaluate_destination_ip(ev);
             case identifier::destination_hostname:
               return evaluate_hostname(desthostname);
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
+            case identifier::ip:
+              return evaluate_ip(ev);
+            case identifier::hostname:
+              return evaluate_hostnames(srchostname, desthostname);
+            case identifier::port:
+              return evaluate_port(ev);
+            case identifier::creation:
+              return evaluate_number(ev.creation);
+            case identifier::duration:
+              return evaluate_number(ev.timestamp - ev.creation);
+            case identifier::transferred_client:
+              return evaluate_number(ev.transferred_client);
+            case identifier::transferred_server:
+              return evaluate_number(ev.transferred_server);
+            default:
+              return false;
+          }
+        }
+
+        bool equality_expression::evaluate(const tcp_half_open& ev,
+                                           const char* srchostname,
+                                           const char* desthostname) const
+        {
+          // Check identifier.
+          switch (id()) {
+            case identifier::date:
+              return evaluate_number(ev.timestamp);
+            case identifier::event_type:
+              return evaluate_event_type(event::type::tcp_half_open);
+            case identifier::source_ip:
+              return evaluate_source_ip(ev);
+            case identifier::source_hostname:
+              return evaluate_hostname(srchostname);
+            case identifier::source_port:
+              return evaluate_number(ntohs(ev.sport));
+            case identifier::destination_ip:
+              return evaluate_destination_ip(ev);
+            case identifier::destination_hostname:
+              return evaluate_hostname(desthostname);
+            case identifier::destination_port:
+              return evaluate_number(ntohs(ev.dport));
+            case identifier::ip:
+              return evaluate_ip(ev);
+            case identifier::hostname:
+              return evaluate_hostnames(srchostname, desthostname);
+            case identifier::port:
+              return evaluate_port(ev);
+            default:
+              return false;
+          }
+        }
+
+        bool equality_expression::evaluate(const tcp_update& ev,
+                                           const char* srchostname,
+                                           const char* desthostname) const
+        {
+          // Check identifier.
+          switch (id()) {
+            case identifier::date:
+              return evaluate_number(ev.timestamp);
+            case identifier::event_type:
+              return evaluate_event_type(event::type::tcp_update);
+            case identifier::source_ip:
+              return evaluate_source_ip(ev);
+            case identifier::source_hostname:
+              return evaluate_hostname(srchostname);
+            case identifier::source_port:
+              return evaluate_number(ntohs(ev.sport));
+            case identifier::destination_ip:
+              return evaluate_destination_ip(ev);
+            case identifier::destination_hostname:
+              return evaluate_hostname(desthostname);
+            case identifier::destination_port:
+              return evaluate_number(ntohs(ev.dport));
             case identifier::ip:
               return evaluate_ip(ev);
             case identifier::hostname:
@@ -376,9 +450,9 @@ namespace net {
             case identifier::date:
               return evaluate_number(ev.timestamp);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::port:
               return evaluate_port(ev);
             case identifier::transferred:
@@ -397,9 +471,9 @@ namespace net {
             case identifier::date:
               return evaluate_number(ev.timestamp);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::port:
               return evaluate_port(ev);
             case identifier::transferred:
@@ -422,9 +496,9 @@ namespace net {
             case identifier::date:
               return evaluate_number(ev.timestamp);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::port:
               return evaluate_port(ev);
             default:
@@ -441,9 +515,9 @@ namespace net {
             case identifier::date:
               return evaluate_number(ev.timestamp);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::port:
               return evaluate_port(ev);
             case identifier::payload:
@@ -462,9 +536,55 @@ namespace net {
             case identifier::date:
               return evaluate_number(ev.timestamp);
             case identifier::source_port:
-              return evaluate_number(ev.sport);
+              return evaluate_number(ntohs(ev.sport));
+            case identifier::destination_port:
+              return evaluate_number(ntohs(ev.dport));
+            case identifier::port:
+              return evaluate_port(ev);
+            case identifier::creation:
+              return evaluate_number(ev.creation);
+            case identifier::duration:
+              return evaluate_number(ev.timestamp - ev.creation);
+            case identifier::transferred_client:
+              return evaluate_number(ev.transferred_client);
+            case identifier::transferred_server:
+              return evaluate_number(ev.transferred_server);
+            default:
+              return false;
+          }
+        }
+
+        bool relational_expression::evaluate(const tcp_half_open& ev,
+                                             const char* srchostname,
+                                             const char* desthostname) const
+        {
+          // Check identifier.
+          switch (id()) {
+            case identifier::date:
+              return evaluate_number(ev.timestamp);
+            case identifier::source_port:
+              return evaluate_number(ntohs(ev.sport));
+            case identifier::destination_port:
+              return evaluate_number(ntohs(ev.dport));
+            case identifier::port:
+              return evaluate_port(ev);
+            default:
+              return false;
+          }
+        }
+
+        bool relational_expression::evaluate(const tcp_update& ev,
+                                             const char* srchostname,
+                                             const char* desthostname) const
+        {
+          // Check identifier.
+          switch (id()) {
+            case identifier::date:
+              return evaluate_number(ev.timestamp);
+            case identifier::source_port:
+              return evaluate_number(ntohs(ev.sport));
             case identifier::destination_port:
-              return evaluate_number(ev.dport);
+              return evaluate_number(ntohs(ev.dport));
             case identifier::port:
               return evaluate_port(ev);
             case identifier::creation:
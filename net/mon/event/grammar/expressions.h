@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <arpa/inet.h>
 #include "net/mon/event/events.h"
 #include "net/mask.h"
 
@@ -43,6 +44,14 @@ namespace net {
             virtual bool evaluate(const tcp_end& ev,
                                   const char* srchostname,
                                   const char* desthostname) const = 0;
+
+            virtual bool evaluate(const tcp_half_open& ev,
+                                  const char* srchostname,
+                                  const char* desthostname) const = 0;
+
+            virtual bool evaluate(const tcp_update& ev,
+                                  const char* srchostname,
+                                  const char* desthostname) const = 0;
         };
 
         // Logical AND expression.
@@ -80,6 +89,20 @@ namespace net {
                           const char* srchostname,
                           const char* desthostname) const final;
 
+            bool evaluate(const tcp_half_open& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            bool evaluate(const tcp_update& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            // Get left expression.
+            const conditional_expression* left() const;
+
+            // Get right expression.
+            const conditional_expression* right() const;
+
           private:
             conditional_expression* _M_left;
             conditional_expression* _M_right;
@@ -126,6 +149,20 @@ namespace net {
                           const char* srchostname,
                           const char* desthostname) const final;
 
+            bool evaluate(const tcp_half_open& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            bool evaluate(const tcp_update& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            // Get left expression.
+            const conditional_expression* left() const;
+
+            // Get right expression.
+            const conditional_expression* right() const;
+
           private:
             conditional_expression* _M_left;
             conditional_expression* _M_right;
@@ -171,6 +208,17 @@ namespace net {
                           const char* srchostname,
                           const char* desthostname) const final;
 
+            bool evaluate(const tcp_half_open& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            bool evaluate(const tcp_update& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            // Get expression.
+            const conditional_expression* expr() const;
+
           private:
             conditional_expression* _M_expr;
 
@@ -310,6 +358,17 @@ namespace net {
                           const char* srchostname,
                           const char* desthostname) const final;
 
+            bool evaluate(const tcp_half_open& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            bool evaluate(const tcp_update& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            // Get operator.
+            equality_operator op() const;
+
           private:
             // Equality operator.
             equality_operator _M_operator;
@@ -405,6 +464,17 @@ namespace net {
                           const char* srchostname,
                           const char* desthostname) const final;
 
+            bool evaluate(const tcp_half_open& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            bool evaluate(const tcp_update& ev,
+                          const char* srchostname,
+                          const char* desthostname) const final;
+
+            // Get operator.
+            relational_operator op() const;
+
           private:
             // Relational operator.
             relational_operator _M_operator;
@@ -438,6 +508,18 @@ namespace net {
           delete _M_right;
         }
 
+        inline
+        const conditional_expression* logical_and_expression::left() const
+        {
+          return _M_left;
+        }
+
+        inline
+        const conditional_expression* logical_and_expression::right() const
+        {
+          return _M_right;
+        }
+
         inline
         bool logical_and_expression::evaluate(const icmp& ev,
                                               const char* srchostname,
@@ -486,6 +568,22 @@ namespace net {
           return evaluate_(ev, srchostname, desthostname);
         }
 
+        inline
+        bool logical_and_expression::evaluate(const tcp_half_open& ev,
+                                              const char* srchostname,
+                                              const char* desthostname) const
+        {
+          return evaluate_(ev, srchostname, desthostname);
+        }
+
+        inline
+        bool logical_and_expression::evaluate(const tcp_update& ev,
+                                              const char* srchostname,
+                                              const char* desthostname) const
+        {
+          return evaluate_(ev, srchostname, desthostname);
+        }
+
         template<typename Event>
         inline
         bool logical_and_expression::evaluate_(const Event& ev,
@@ -517,6 +615,18 @@ namespace net {
           delete _M_right;
         }
 
+        inline
+        const conditional_expression* logical_or_expression::left() const
+        {
+          return _M_left;
+        }
+
+        inline
+        const conditional_expression* logical_or_expression::right() const
+        {
+          return _M_right;
+        }
+
         inline
         bool logical_or_expression::evaluate(const icmp& ev,
                                              const char* srchostname,
@@ -565,6 +675,22 @@ namespace net {
           return evaluate_(ev, srchostname, desthostname);
         }
 
+        inline
+        bool logical_or_expression::evaluate(const tcp_half_open& ev,
+                                             const char* srchostname,
+                                             const char* desthostname) const
+        {
+          return evaluate_(ev, srchostname, desthostname);
+        }
+
+        inline
+        bool logical_or_expression::evaluate(const tcp_update& ev,
+                                             const char* srchostname,
+                                             const char* desthostname) const
+        {
+          return evaluate_(ev, srchostname, desthostname);
+        }
+
         template<typename Event>
         inline
         bool logical_or_expression::evaluate_(const Event& ev,
@@ -592,6 +718,11 @@ namespace net {
           delete _M_expr;
         }
 
+        inline const conditional_expression* not_expression::expr() const
+        {
+          return _M_expr;
+        }
+
         inline
         bool not_expression::evaluate(const icmp& ev,
                                       const char* srchostname,
@@ -640,6 +771,22 @@ namespace net {
           return evaluate_(ev, srchostname, desthostname);
         }
 
+        inline
+        bool not_expression::evaluate(const tcp_half_open& ev,
+                                      const char* srchostname,
+                                      const char* desthostname) const
+        {
+          return evaluate_(ev, srchostname, desthostname);
+        }
+
+        inline
+        bool not_expression::evaluate(const tcp_update& ev,
+                                      const char* srchostname,
+                                      const char* desthostname) const
+        {
+          return evaluate_(ev, srchostname, desthostname);
+        }
+
         template<typename Event>
         inline
         bool not_expression::evaluate_(const Event& ev,
@@ -723,6 +870,12 @@ namespace net {
         {
         }
 
+        inline equality_expression::equality_operator
+        equality_expression::op() const
+        {
+          return _M_operator;
+        }
+
         inline
         bool equality_expression::evaluate_event_type(event::type type) const
         {
@@ -779,7 +932,8 @@ namespace net {
         inline
         bool equality_expression::evaluate_port(const Event& ev) const
         {
-          bool res = ((ev.sport == number()) || (ev.dport == number()));
+          bool res = ((ntohs(ev.sport) == number()) ||
+                      (ntohs(ev.dport) == number()));
 
           return (_M_operator == equality_operator::equal_to) ? res : !res;
         }
@@ -811,19 +965,29 @@ namespace net {
         {
         }
 
+        inline relational_expression::relational_operator
+        relational_expression::op() const
+        {
+          return _M_operator;
+        }
+
         template<typename Event>
         inline
         bool relational_expression::evaluate_port(const Event& ev) const
         {
           switch (_M_operator) {
             case relational_operator::less:
-              return ((ev.sport < number()) || (ev.dport < number()));
+              return ((ntohs(ev.sport) < number()) ||
+                      (ntohs(ev.dport) < number()));
             case relational_operator::greater:
-              return ((ev.sport > number()) || (ev.dport > number()));
+              return ((ntohs(ev.sport) > number()) ||
+                      (ntohs(ev.dport) > number()));
             case relational_operator::less_or_equal:
-              return ((ev.sport <= number()) || (ev.dport <= number()));
+              return ((ntohs(ev.sport) <= number()) ||
+                      (ntohs(ev.dport) <= number()));
             case relational_operator::greater_or_equal:
-              return ((ev.sport >= number()) || (ev.dport >= number()));
+              return ((ntohs(ev.sport) >= number()) ||
+                      (ntohs(ev.dport) >= number()));
             default:
               return false;
           }
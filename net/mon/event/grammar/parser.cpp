@@ -814,6 +814,20 @@ bool net::mon::event::grammar::parser::from_string(const char* s,
         t = type::tcp_end;
         return true;
       }
+
+      break;
+    case 13:
+      if (strncasecmp(s, "tcp-half-open", len) == 0) {
+        t = type::tcp_half_open;
+        return true;
+      }
+
+      break;
+    case 10:
+      if (strncasecmp(s, "tcp-update", len) == 0) {
+        t = type::tcp_update;
+        return true;
+      }
   }
 
   return false;
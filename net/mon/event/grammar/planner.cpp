@@ -0,0 +1,167 @@
+#include "net/mon/event/grammar/planner.h"
+
+bool
+net::mon::event::grammar::planner::match(const conditional_expression* expr,
+                                         const file::block& block)
+{
+  const logical_and_expression* and_expr;
+  const logical_or_expression* or_expr;
+  const equality_expression* equality_expr;
+  const relational_expression* relational_expr;
+
+  if ((and_expr = dynamic_cast<const logical_and_expression*>(expr))) {
+    return ((match(and_expr->left(), block)) &&
+            (match(and_expr->right(), block)));
+  } else if ((or_expr = dynamic_cast<const logical_or_expression*>(expr))) {
+    return ((match(or_expr->left(), block)) ||
+            (match(or_expr->right(), block)));
+  } else if ((equality_expr =
+              dynamic_cast<const equality_expression*>(expr))) {
+    return match(equality_expr,
+                 static_cast<relational_operator>(
+                   static_cast<unsigned>(equality_expr->op())
+                 ),
+                 block);
+  } else if ((relational_expr =
+              dynamic_cast<const relational_expression*>(expr))) {
+    return match(relational_expr,
+                 static_cast<relational_operator>(
+                   static_cast<unsigned>(relational_expr->op())
+                 ),
+                 block);
+  } else {
+    // NOT expression.
+    return true;
+  }
+}
+
+bool
+net::mon::event::grammar::planner::match(const event_expression* expr,
+                                         relational_operator op,
+                                         const file::block& block)
+{
+  switch (expr->id()) {
+    case identifier::date:
+      return match_range(block.timestamp.min,
+                         block.timestamp.max,
+                         op,
+                         expr->number());
+    case identifier::event_type:
+      {
+        const uint32_t bit = static_cast<uint32_t>(1) << expr->number();
+
+        switch (op) {
+          case relational_operator::equal_to:
+            return ((block.types & bit) != 0);
+          case relational_operator::not_equal_to:
+            return ((block.types & ~bit) != 0);
+          default:
+            return true;
+        }
+      }
+    case identifier::source_ip:
+    case identifier::destination_ip:
+    case identifier::ip:
+      // Only the operator == can discard blocks.
+      if (op == relational_operator::equal_to) {
+        switch (expr->id()) {
+          case identifier::source_ip:
+            return match_ip(block, 0, expr->netmask());
+          case identifier::destination_ip:
+            return match_ip(block, 1, expr->netmask());
+          default:
+            return ((match_ip(block, 0, expr->netmask())) ||
+                    (match_ip(block, 1, expr->netmask())));
+        }
+      }
+
+      return true;
+    case identifier::source_port:
+      return match_range(block.port[0].min,
+                         block.port[0].max,
+                         op,
+                         expr->number());
+    case identifier::destination_port:
+      return match_range(block.port[1].min,
+                         block.port[1].max,
+                         op,
+                         expr->number());
+    case identifier::port:
+      // An event matches if any of its ports matches (except for the
+      // operator !=, which requires both).
+      if (op != relational_operator::not_equal_to) {
+        return ((match_range(block.port[0].min,
+                             block.port[0].max,
+                             op,
+                             expr->number())) ||
+                (match_range(block.port[1].min,
+                             block.port[1].max,
+                             op,
+                             expr->number())));
+      } else {
+        return ((match_range(block.port[0].min,
+                             block.port[0].max,
+                             op,
+                             expr->number())) &&
+                (match_range(block.port[1].min,
+                             block.port[1].max,
+                             op,
+                             expr->number())));
+      }
+    default:
+      return true;
+  }
+}
+
+bool net::mon::event::grammar::planner::match_ip(const file::block& block,
+                                                 size_t dir,
+                                                 const mask& netmask)
+{
+  // Build the first and last addresses of the network.
+  uint8_t first[16], last[16];
+  const size_t nwords = netmask.ipv4() ? 1 : 4;
+
+  for (size_t i = 0; i < nwords; i++) {
+    const uint32_t network = netmask.network(i) & netmask.netmask(i);
+
+    serialize(first + (i * 4), network);
+    serialize(last + (i * 4), network | ~netmask.netmask(i));
+  }
+
+  // Does the range of the network overlap the range of addresses?
+  if (netmask.ipv4()) {
+    return ((memcmp(first, block.ipv4[dir].max, 4) <= 0) &&
+            (memcmp(last, block.ipv4[dir].min, 4) >= 0));
+  } else {
+    return ((memcmp(first, block.ipv6[dir].max, 16) <= 0) &&
+            (memcmp(last, block.ipv6[dir].min, 16) >= 0));
+  }
+}
+
+bool net::mon::event::grammar::planner::match_range(uint64_t min,
+                                                    uint64_t max,
+                                                    relational_operator op,
+                                                    uint64_t n)
+{
+  // If the range is empty (no event has the field)...
+  if (min > max) {
+    return false;
+  }
+
+  switch (op) {
+    case relational_operator::equal_to:
+      return ((min <= n) && (n <= max));
+    case relational_operator::not_equal_to:
+      return ((min != n) || (max != n));
+    case relational_operator::less:
+      return (min < n);
+    case relational_operator::greater:
+      return (max > n);
+    case relational_operator::less_or_equal:
+      return (min <= n);
+    case relational_operator::greater_or_equal:
+      return (max >= n);
+    default:
+      return true;
+  }
+}
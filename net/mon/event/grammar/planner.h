@@ -0,0 +1,50 @@
+#ifndef NET_MON_EVENT_GRAMMAR_PLANNER_H
+#define NET_MON_EVENT_GRAMMAR_PLANNER_H
+
+#include "net/mon/event/grammar/expressions.h"
+#include "net/mon/event/file.h"
+
+namespace net {
+  namespace mon {
+    namespace event {
+      namespace grammar {
+        // Planner of the reads of the event files: decides from the header
+        // of a block (range of timestamps, types of events and ranges of
+        // addresses and ports) whether the block might contain events
+        // matching a filter expression.
+        //
+        // Only the identifiers date, event_type, source_ip, destination_ip,
+        // ip, source_port, destination_port and port are checked; any other
+        // expression (and any NOT expression) might match.
+        class planner {
+          public:
+            // Might the block contain events matching the expression?
+            static bool match(const conditional_expression* expr,
+                              const file::block& block);
+
+          private:
+            // Might the block contain events matching the event
+            // expression?
+            static bool match(const event_expression* expr,
+                              relational_operator op,
+                              const file::block& block);
+
+            // Might the addresses of the block (0: source, 1: destination)
+            // match the network mask?
+            static bool match_ip(const file::block& block,
+                                 size_t dir,
+                                 const mask& netmask);
+
+            // Might a value in the range ['min', 'max'] satisfy
+            // 'value' 'op' 'n'?
+            static bool match_range(uint64_t min,
+                                    uint64_t max,
+                                    relational_operator op,
+                                    uint64_t n);
+        };
+      }
+    }
+  }
+}
+
+#endif // NET_MON_EVENT_GRAMMAR_PLANNER_H
@@ -5,12 +5,12 @@
 #include <memory>
 #include "net/mon/event/merger.h"
 #include "net/mon/event/reader.h"
-#include "fs/file.h"
-#include "string/buffer.h"
+#include "net/mon/event/writer.h"
 
 bool net::mon::event::merger::merge(const char** infiles,
                                     size_t ninfiles,
-                                    const char* outfile)
+                                    const char* outfile,
+                                    compression c)
 {
   struct stat sbuf;
   if ((ninfiles >= 2) && (stat(outfile, &sbuf) < 0)) {
@@ -25,8 +25,8 @@ bool net::mon::event::merger::merge(const char** infiles,
       }
 
       // Open output file.
-      fs::file output;
-      if (output.open(outfile)) {
+      writer output(fs::file::default_allocation_size, max_buffer_size, c);
+      if ((output.init()) && (output.open(outfile))) {
         struct entry {
           const void* event;
           size_t len;
@@ -35,26 +35,16 @@ bool net::mon::event::merger::merge(const char** infiles,
 
         entry* entries;
         if ((entries = new (std::nothrow) entry[ninfiles]) != nullptr) {
-          file::header header;
-          header.timestamp.first = ULLONG_MAX;
-          header.timestamp.last = 0;
-
           // Fill entries with the first event of each input file.
           for (size_t i = 0; i < ninfiles; i++) {
-            if (readers[i].next(entries[i].event,
-                                entries[i].len,
-                                entries[i].timestamp)) {
-              if (entries[i].timestamp < header.timestamp.first) {
-                header.timestamp.first = entries[i].timestamp;
-              }
-            } else {
+            if (!readers[i].next(entries[i].event,
+                                 entries[i].len,
+                                 entries[i].timestamp)) {
               entries[i].timestamp = ULLONG_MAX;
             }
           }
 
-          string::buffer buf;
-
-          uint64_t off = file::header::size;
+          size_t nevents = 0;
 
           do {
             uint64_t timestamp = ULLONG_MAX;
@@ -72,29 +62,9 @@ bool net::mon::event::merger::merge(const char** infiles,
 
             // If there are still events...
             if (timestamp != ULLONG_MAX) {
-              // Add event to the buffer.
-              if (buf.append(static_cast<const char*>(entries[idx].event),
-                             entries[idx].len)) {
-                header.timestamp.last = timestamp;
-
-                // If the buffer is full...
-                if (buf.length() >= max_buffer_size) {
-                  // Write buffer to disk.
-                  if (output.pwrite(buf.data(), buf.length(), off)) {
-                    off += buf.length();
-
-                    buf.clear();
-                  } else {
-                    output.close();
-
-                    unlink(outfile);
-
-                    delete [] entries;
-                    delete [] readers;
-
-                    return false;
-                  }
-                }
+              // Write event (the writer builds the blocks).
+              if (output.write(entries[idx].event, entries[idx].len)) {
+                nevents++;
 
                 // Read next event.
                 if (!readers[idx].next(entries[idx].event,
@@ -121,26 +91,23 @@ bool net::mon::event::merger::merge(const char** infiles,
           delete [] readers;
 
           // If there are events...
-          if (header.timestamp.first != ULLONG_MAX) {
-            if ((buf.empty()) ||
-                (output.pwrite(buf.data(), buf.length(), off))) {
-              // Serialize header.
-              uint8_t buf[file::header::size];
-              header.serialize(buf, sizeof(buf));
-
-              // Write header at the beginning of the file.
-              if (output.pwrite(buf, sizeof(buf), 0)) {
-                return true;
-              }
+          if (nevents > 0) {
+            // Flush the last block and write the header.
+            if (output.close()) {
+              return true;
             }
+          } else {
+            output.close();
           }
 
-          output.close();
-
           unlink(outfile);
 
-          return (header.timestamp.first == ULLONG_MAX);
+          return (nevents == 0);
         }
+
+        output.close();
+
+        unlink(outfile);
       }
 
       delete [] readers;
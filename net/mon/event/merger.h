@@ -2,6 +2,7 @@
 #define NET_MON_EVENT_MERGER_H
 
 #include <sys/types.h>
+#include "net/mon/event/compression.h"
 
 namespace net {
   namespace mon {
@@ -12,10 +13,12 @@ namespace net {
           // Merge events in the input files into the output file.
           static bool merge(const char** infiles,
                             size_t ninfiles,
-                            const char* outfile);
+                            const char* outfile,
+                            compression c = compression::none);
 
         private:
-          // Maximum buffer size before writing the events to disk.
+          // Maximum buffer size before writing the events to disk (size of
+          // the blocks of the output file).
           static constexpr const size_t max_buffer_size = 64 * 1024;
       };
     }
@@ -63,6 +63,18 @@ namespace net {
                                const char* srchost,
                                const char* dsthost) = 0;
 
+            // Print 'Half-open TCP connections' event.
+            virtual void print(uint64_t nevent,
+                               const event::tcp_half_open& ev,
+                               const char* srchost,
+                               const char* dsthost) = 0;
+
+            // Print 'Update TCP connection' event.
+            virtual void print(uint64_t nevent,
+                               const event::tcp_update& ev,
+                               const char* srchost,
+                               const char* dsthost) = 0;
+
           protected:
             // File.
             FILE* _M_file = nullptr;
@@ -53,6 +53,18 @@ namespace net {
                        const char* srchost,
                        const char* dsthost) final;
 
+            // Print 'Half-open TCP connections' event.
+            void print(uint64_t nevent,
+                       const event::tcp_half_open& ev,
+                       const char* srchost,
+                       const char* dsthost) final;
+
+            // Print 'Update TCP connection' event.
+            void print(uint64_t nevent,
+                       const event::tcp_update& ev,
+                       const char* srchost,
+                       const char* dsthost) final;
+
           private:
             // CSV separator.
             char _M_separator;
@@ -118,6 +130,22 @@ namespace net {
           print_(nevent, ev, srchost, dsthost);
         }
 
+        inline void csv::print(uint64_t nevent,
+                               const event::tcp_half_open& ev,
+                               const char* srchost,
+                               const char* dsthost)
+        {
+          print_(nevent, ev, srchost, dsthost);
+        }
+
+        inline void csv::print(uint64_t nevent,
+                               const event::tcp_update& ev,
+                               const char* srchost,
+                               const char* dsthost)
+        {
+          print_(nevent, ev, srchost, dsthost);
+        }
+
         template<typename Event>
         inline void csv::print_(uint64_t nevent,
                                 const Event& ev,
@@ -9,7 +9,7 @@ bool net::mon::event::printer::db::sqlite::close()
   // If the database has been opened...
   if (_M_db) {
     // Finalize statements.
-    for (size_t i = 0; i < 6; i++) {
+    for (size_t i = 0; i < ARRAY_SIZE(_M_statements); i++) {
       if (_M_statements[i]) {
         sqlite3_finalize(_M_statements[i]);
         _M_statements[i] = nullptr;
@@ -200,6 +200,71 @@ net::mon::event::printer::db::sqlite::print(uint64_t nevent,
   }
 }
 
+void
+net::mon::event::printer::db::sqlite::print(uint64_t nevent,
+                                            const event::tcp_half_open& ev,
+                                            const char* srchost,
+                                            const char* dsthost)
+{
+  static constexpr const size_t idx = 6;
+
+  if ((bind(idx, ev, srchost, dsthost)) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          6,
+                          ntohs(ev.sport)) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          7,
+                          ntohs(ev.dport)) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          8,
+                          ev.attempts) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          9,
+                          ev.established) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          10,
+                          ev.reset) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          11,
+                          ev.unanswered) == SQLITE_OK)) {
+    sqlite3_step(_M_statements[idx]);
+  }
+}
+
+void
+net::mon::event::printer::db::sqlite::print(uint64_t nevent,
+                                            const event::tcp_update& ev,
+                                            const char* srchost,
+                                            const char* dsthost)
+{
+  static constexpr const size_t idx = 7;
+
+  if ((bind(idx, ev, srchost, dsthost)) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          6,
+                          ntohs(ev.sport)) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          7,
+                          ntohs(ev.dport)) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          8,
+                          ev.creation) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          9,
+                          ev.transferred_client) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          10,
+                          ev.transferred_server) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          11,
+                          ev.packets_client) == SQLITE_OK) &&
+      (sqlite3_bind_int64(_M_statements[idx],
+                          12,
+                          ev.packets_server) == SQLITE_OK)) {
+    sqlite3_step(_M_statements[idx]);
+  }
+}
+
 bool net::mon::event::printer::db::sqlite::configure()
 {
   static constexpr const char* const commands =
@@ -272,7 +337,32 @@ bool net::mon::event::printer::db::sqlite::create_tables()
                          "destination_port     INTEGER NOT NULL,"
                          "creation             INTEGER NOT NULL,"
                          "transferred_client   INTEGER NOT NULL,"
-                         "transferred_server   INTEGER NOT NULL);";
+                         "transferred_server   INTEGER NOT NULL);"
+
+    "CREATE TABLE tcp_half_open(timestamp            INTEGER NOT NULL,"
+                               "source_address       TEXT    NOT NULL,"
+                               "destination_address  TEXT    NOT NULL,"
+                               "source_hostname      TEXT,"
+                               "destination_hostname TEXT,"
+                               "source_port          INTEGER NOT NULL,"
+                               "destination_port     INTEGER NOT NULL,"
+                               "attempts             INTEGER NOT NULL,"
+                               "established          INTEGER NOT NULL,"
+                               "reset                INTEGER NOT NULL,"
+                               "unanswered           INTEGER NOT NULL);"
+
+    "CREATE TABLE tcp_update(timestamp            INTEGER NOT NULL,"
+                            "source_address       TEXT    NOT NULL,"
+                            "destination_address  TEXT    NOT NULL,"
+                            "source_hostname      TEXT,"
+                            "destination_hostname TEXT,"
+                            "source_port          INTEGER NOT NULL,"
+                            "destination_port     INTEGER NOT NULL,"
+                            "creation             INTEGER NOT NULL,"
+                            "transferred_client   INTEGER NOT NULL,"
+                            "transferred_server   INTEGER NOT NULL,"
+                            "packets_client       INTEGER NOT NULL,"
+                            "packets_server       INTEGER NOT NULL);";
 
   // Execute statements.
   return (sqlite3_exec(_M_db,
@@ -299,7 +389,12 @@ bool net::mon::event::printer::db::sqlite::create_indices()
     "CREATE INDEX idx_tcp_data_timestamp ON tcp_data(timestamp);"
     "CREATE INDEX idx_tcp_data_creation ON tcp_data(creation);"
 
-    "CREATE INDEX idx_tcp_end_timestamp ON tcp_end(timestamp);";
+    "CREATE INDEX idx_tcp_end_timestamp ON tcp_end(timestamp);"
+
+    "CREATE INDEX idx_tcp_half_open_timestamp ON tcp_half_open(timestamp);"
+
+    "CREATE INDEX idx_tcp_update_timestamp ON tcp_update(timestamp);"
+    "CREATE INDEX idx_tcp_update_creation ON tcp_update(creation);";
 
   // Execute statements.
   return (sqlite3_exec(_M_db,
@@ -312,12 +407,14 @@ bool net::mon::event::printer::db::sqlite::create_indices()
 bool net::mon::event::printer::db::sqlite::prepare_statements()
 {
   static constexpr const char* const statements[] = {
-    "INSERT INTO icmp      VALUES(?, ?, ?, ?, ?, ?, ?, ?)",
-    "INSERT INTO udp       VALUES(?, ?, ?, ?, ?, ?, ?, ?)",
-    "INSERT INTO dns       VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)",
-    "INSERT INTO tcp_begin VALUES(?, ?, ?, ?, ?, ?, ?)",
-    "INSERT INTO tcp_data  VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)",
-    "INSERT INTO tcp_end   VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+    "INSERT INTO icmp          VALUES(?, ?, ?, ?, ?, ?, ?, ?)",
+    "INSERT INTO udp           VALUES(?, ?, ?, ?, ?, ?, ?, ?)",
+    "INSERT INTO dns           VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)",
+    "INSERT INTO tcp_begin     VALUES(?, ?, ?, ?, ?, ?, ?)",
+    "INSERT INTO tcp_data      VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)",
+    "INSERT INTO tcp_end       VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+    "INSERT INTO tcp_half_open VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+    "INSERT INTO tcp_update    VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
   };
 
   // Prepare statements.
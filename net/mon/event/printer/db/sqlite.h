@@ -64,12 +64,24 @@ namespace net {
                          const char* srchost,
                          const char* dsthost) final;
 
+              // Print 'Half-open TCP connections' event.
+              void print(uint64_t nevent,
+                         const event::tcp_half_open& ev,
+                         const char* srchost,
+                         const char* dsthost) final;
+
+              // Print 'Update TCP connection' event.
+              void print(uint64_t nevent,
+                         const event::tcp_update& ev,
+                         const char* srchost,
+                         const char* dsthost) final;
+
             private:
               // SQLite database handle.
               sqlite3* _M_db = nullptr;
 
               // SQL statements.
-              sqlite3_stmt* _M_statements[6];
+              sqlite3_stmt* _M_statements[8];
 
               char _M_src[INET6_ADDRSTRLEN];
               char _M_dst[INET6_ADDRSTRLEN];
@@ -108,6 +120,8 @@ namespace net {
                             nullptr,
                             nullptr,
                             nullptr,
+                            nullptr,
+                            nullptr,
                             nullptr}
           {
           }
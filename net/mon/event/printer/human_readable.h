@@ -51,6 +51,18 @@ namespace net {
                        const char* srchost,
                        const char* dsthost) final;
 
+            // Print 'Half-open TCP connections' event.
+            void print(uint64_t nevent,
+                       const event::tcp_half_open& ev,
+                       const char* srchost,
+                       const char* dsthost) final;
+
+            // Print 'Update TCP connection' event.
+            void print(uint64_t nevent,
+                       const event::tcp_update& ev,
+                       const char* srchost,
+                       const char* dsthost) final;
+
           private:
             // Print format.
             format _M_format;
@@ -116,6 +128,22 @@ namespace net {
           print_(nevent, ev, srchost, dsthost);
         }
 
+        inline void human_readable::print(uint64_t nevent,
+                                          const event::tcp_half_open& ev,
+                                          const char* srchost,
+                                          const char* dsthost)
+        {
+          print_(nevent, ev, srchost, dsthost);
+        }
+
+        inline void human_readable::print(uint64_t nevent,
+                                          const event::tcp_update& ev,
+                                          const char* srchost,
+                                          const char* dsthost)
+        {
+          print_(nevent, ev, srchost, dsthost);
+        }
+
         template<typename Event>
         inline void human_readable::print_(uint64_t nevent,
                                            const Event& ev,
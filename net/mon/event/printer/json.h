@@ -56,6 +56,18 @@ namespace net {
                        const char* srchost,
                        const char* dsthost) final;
 
+            // Print 'Half-open TCP connections' event.
+            void print(uint64_t nevent,
+                       const event::tcp_half_open& ev,
+                       const char* srchost,
+                       const char* dsthost) final;
+
+            // Print 'Update TCP connection' event.
+            void print(uint64_t nevent,
+                       const event::tcp_update& ev,
+                       const char* srchost,
+                       const char* dsthost) final;
+
           private:
             // Print format.
             format _M_format;
@@ -145,6 +157,22 @@ namespace net {
           print_(nevent, ev, srchost, dsthost);
         }
 
+        inline void json::print(uint64_t nevent,
+                                const event::tcp_half_open& ev,
+                                const char* srchost,
+                                const char* dsthost)
+        {
+          print_(nevent, ev, srchost, dsthost);
+        }
+
+        inline void json::print(uint64_t nevent,
+                                const event::tcp_update& ev,
+                                const char* srchost,
+                                const char* dsthost)
+        {
+          print_(nevent, ev, srchost, dsthost);
+        }
+
         template<typename Event>
         inline void json::print_(uint64_t nevent,
                                  const Event& ev,
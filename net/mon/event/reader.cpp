@@ -2,6 +2,7 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include "net/mon/event/reader.h"
+#include "util/lz4.h"
 
 bool net::mon::event::reader::open(const char* filename)
 {
@@ -18,7 +19,7 @@ bool net::mon::event::reader::open(const char* filename)
                           _M_fd,
                           0)) != MAP_FAILED) {
         // Deserialize header.
-        if (_M_header.deserialize(_M_base, sbuf.st_size)) {
+        if (_M_header.deserialize(_M_base, sbuf.st_size) > 0) {
           // Initialize DNS caches.
           using namespace net::mon::dns;
           if ((_M_ipv4_dns_cache.init(inverted_cache<ipv4::address>::
@@ -31,9 +32,13 @@ bool net::mon::event::reader::open(const char* filename)
             // Make '_M_end' point to the end.
             _M_end = static_cast<const uint8_t*>(_M_base) + _M_filesize;
 
-            // Make '_M_ptr' point to the first event.
+            // Make '_M_ptr' point to the first event (version 1) or to the
+            // first block.
             _M_ptr = static_cast<const uint8_t*>(_M_base) + file::header::size;
 
+            _M_block_end = (_M_header.version == 1) ? _M_end : _M_ptr;
+            _M_next_block = _M_ptr;
+
             return true;
           }
         }
@@ -47,8 +52,13 @@ bool net::mon::event::reader::open(const char* filename)
 bool net::mon::event::reader::next(const grammar::conditional_expression* expr)
 {
   if (_M_printer) {
+    // If all the events of the current block have been read...
+    if ((_M_ptr == _M_block_end) && (!next_block(expr))) {
+      return false;
+    }
+
     size_t left;
-    while ((left = _M_end - _M_ptr) >= minlen) {
+    while ((left = _M_block_end - _M_ptr) >= minlen) {
       // Extract event length.
       evlen_t len = base::extract_length(_M_ptr);
 
@@ -105,33 +115,9 @@ bool net::mon::event::reader::next(const grammar::conditional_expression* expr)
               // Build 'DNS' event.
               dns ev;
               if (ev.build(_M_ptr, len)) {
-                // If it is a response...
-                if (ev.nresponses > 0) {
-                  // For each response...
-                  for (size_t i = 0; i < ev.nresponses; i++) {
-                    // IPv4?
-                    if (ev.responses[i].addrlen == 4) {
-                      ipv4::address addr(ev.responses[i].addr);
-
-                      // Add pair (address, host) to the IPv4 DNS inverted
-                      // cache.
-                      if (!_M_ipv4_dns_cache.add(addr,
-                                                 ev.domain,
-                                                 ev.domainlen)) {
-                        return false;
-                      }
-                    } else {
-                      ipv6::address addr(ev.responses[i].addr);
-
-                      // Add pair (address, host) to the IPv6 DNS inverted
-                      // cache.
-                      if (!_M_ipv6_dns_cache.add(addr,
-                                                 ev.domain,
-                                                 ev.domainlen)) {
-                        return false;
-                      }
-                    }
-                  }
+                // Add the responses (if any) to the DNS caches.
+                if (!add_dns_responses(ev)) {
+                  return false;
                 }
 
                 if ((!expr) || (expr->evaluate(ev, nullptr, nullptr))) {
@@ -212,6 +198,50 @@ bool net::mon::event::reader::next(const grammar::conditional_expression* expr)
               }
             }
 
+            break;
+          case type::tcp_half_open:
+            {
+              // Build 'Half-open TCP connections' event.
+              tcp_half_open ev;
+              if (ev.build(_M_ptr, len)) {
+                const char* srchostname = source_host(ev);
+                const char* desthostname = destination_host(ev);
+
+                if ((!expr) ||
+                    (expr->evaluate(ev, srchostname, desthostname))) {
+                  _M_printer->print(++_M_nevent, ev, srchostname, desthostname);
+                }
+
+                _M_ptr += len;
+
+                return true;
+              } else {
+                return false;
+              }
+            }
+
+            break;
+          case type::tcp_update:
+            {
+              // Build 'Update TCP connection' event.
+              tcp_update ev;
+              if (ev.build(_M_ptr, len)) {
+                const char* srchostname = source_host(ev);
+                const char* desthostname = destination_host(ev);
+
+                if ((!expr) ||
+                    (expr->evaluate(ev, srchostname, desthostname))) {
+                  _M_printer->print(++_M_nevent, ev, srchostname, desthostname);
+                }
+
+                _M_ptr += len;
+
+                return true;
+              } else {
+                return false;
+              }
+            }
+
             break;
         }
       } else {
@@ -227,8 +257,13 @@ bool net::mon::event::reader::next(const void*& event,
                                    size_t& len,
                                    uint64_t& timestamp)
 {
+  // If all the events of the current block have been read...
+  if ((_M_ptr == _M_block_end) && (!next_block(nullptr))) {
+    return false;
+  }
+
   size_t left;
-  if ((left = _M_end - _M_ptr) >= minlen) {
+  if ((left = _M_block_end - _M_ptr) >= minlen) {
     // Extract event length.
     evlen_t l = base::extract_length(_M_ptr);
 
@@ -248,3 +283,122 @@ bool net::mon::event::reader::next(const void*& event,
 
   return false;
 }
+
+bool
+net::mon::event::reader::next_block(const grammar::conditional_expression* expr)
+{
+  // If the events are not in blocks...
+  if (_M_header.version == 1) {
+    return false;
+  }
+
+  const size_t size = file::block::size(_M_header.version);
+
+  size_t left;
+  while ((left = _M_end - _M_next_block) >= size) {
+    // Deserialize block header.
+    _M_block.deserialize(_M_next_block, left, _M_header.version);
+
+    // If the block is empty, is not valid or doesn't fit...
+    if ((_M_block.stored == 0) ||
+        (_M_block.stored > _M_block.length) ||
+        (_M_block.stored > left - size)) {
+      return false;
+    }
+
+    const uint8_t* data = _M_next_block + size;
+    _M_next_block = data + _M_block.stored;
+
+    // If the block might contain events matching the filter...
+    if ((!expr) || (grammar::planner::match(expr, _M_block))) {
+      return load_block(data);
+    }
+
+    // If the block has DNS events...
+    if (_M_block.has(type::dns)) {
+      // Add their responses to the DNS caches (the hostnames of the next
+      // events depend on them).
+      if ((!load_block(data)) || (!skip_block())) {
+        return false;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool net::mon::event::reader::load_block(const uint8_t* data)
+{
+  // If the events are not compressed...
+  if (_M_block.stored == _M_block.length) {
+    _M_ptr = data;
+  } else {
+    _M_events.clear();
+
+    // Decompress events.
+    if ((!_M_events.allocate(_M_block.length)) ||
+        (!util::lz4::decompress(data,
+                                _M_block.stored,
+                                _M_events.data(),
+                                _M_block.length))) {
+      return false;
+    }
+
+    _M_ptr = reinterpret_cast<const uint8_t*>(_M_events.data());
+  }
+
+  _M_block_end = _M_ptr + _M_block.length;
+
+  return true;
+}
+
+bool net::mon::event::reader::skip_block()
+{
+  // Add the responses of the DNS events to the DNS caches.
+  while (_M_ptr < _M_block_end) {
+    size_t left = _M_block_end - _M_ptr;
+
+    evlen_t len;
+    if ((left < minlen) ||
+        ((len = base::extract_length(_M_ptr)) > left) ||
+        (len < minlen)) {
+      return false;
+    }
+
+    if (base::extract_type(_M_ptr) == type::dns) {
+      dns ev;
+      if ((!ev.build(_M_ptr, len)) || (!add_dns_responses(ev))) {
+        return false;
+      }
+    }
+
+    _M_ptr += len;
+  }
+
+  return true;
+}
+
+bool net::mon::event::reader::add_dns_responses(const dns& ev)
+{
+  // For each response...
+  for (size_t i = 0; i < ev.nresponses; i++) {
+    // IPv4?
+    if (ev.responses[i].addrlen == 4) {
+      ipv4::address addr(ev.responses[i].addr);
+
+      // Add pair (address, host) to the IPv4 DNS inverted cache.
+      if (!_M_ipv4_dns_cache.add(addr, ev.domain, ev.domainlen)) {
+        return false;
+      }
+    } else {
+      ipv6::address addr(ev.responses[i].addr);
+
+      // Add pair (address, host) to the IPv6 DNS inverted cache.
+      if (!_M_ipv6_dns_cache.add(addr, ev.domain, ev.domainlen)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
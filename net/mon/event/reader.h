@@ -8,9 +8,11 @@
 #include "net/mon/event/file.h"
 #include "net/mon/event/printer/base.h"
 #include "net/mon/event/grammar/expressions.h"
+#include "net/mon/event/grammar/planner.h"
 #include "net/mon/dns/inverted_cache.h"
 #include "net/mon/ipv4/address.h"
 #include "net/mon/ipv6/address.h"
+#include "string/buffer.h"
 
 namespace net {
   namespace mon {
@@ -31,7 +33,8 @@ namespace net {
           // Close event file.
           void close();
 
-          // Get next event.
+          // Get next event (the blocks which cannot contain events matching
+          // the expression are skipped).
           bool next(const grammar::conditional_expression* expr = nullptr);
 
           // Get next event.
@@ -57,9 +60,22 @@ namespace net {
           // Pointer to the next event.
           const uint8_t* _M_ptr;
 
+          // Pointer to the end of the current block (version 1: end of the
+          // file).
+          const uint8_t* _M_block_end;
+
+          // Pointer to the next block in the file.
+          const uint8_t* _M_next_block;
+
+          // Events of the current block (if compressed).
+          string::buffer _M_events;
+
           // Event file header.
           file::header _M_header;
 
+          // Header of the current block.
+          file::block _M_block;
+
           // Printer.
           printer::base* _M_printer = nullptr;
 
@@ -83,6 +99,21 @@ namespace net {
           // Get host.
           const char* host(const void* addr, size_t addrlen) const;
 
+          // Move to the next block which might contain events matching the
+          // expression.
+          bool next_block(const grammar::conditional_expression* expr);
+
+          // Load the events of the current block (decompressing them if
+          // needed).
+          bool load_block(const uint8_t* data);
+
+          // Skip the events of the current block (adding the responses of
+          // the DNS events to the DNS caches).
+          bool skip_block();
+
+          // Add the responses of a DNS event to the DNS caches.
+          bool add_dns_responses(const dns& ev);
+
           // Disable copy constructor and assignment operator.
           reader(const reader&) = delete;
           reader& operator=(const reader&) = delete;
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include "net/mon/event/tcp_half_open.h"
+
+bool net::mon::event::tcp_half_open::build(const void* buf, size_t len)
+{
+  if ((base::build(buf, len)) && (size() == len)) {
+    // Make 'b' point after the base event.
+    const uint8_t* const b = static_cast<const uint8_t* const>(buf) +
+                             base::size();
+
+    // Extract source port.
+    deserialize(sport, b);
+
+    // Extract destination port.
+    deserialize(dport, b + 2);
+
+    // Extract number of connection attempts.
+    deserialize(attempts, b + 4);
+
+    // Extract number of connections established.
+    deserialize(established, b + 8);
+
+    // Extract number of connection attempts reset.
+    deserialize(reset, b + 12);
+
+    // Extract number of connection attempts not answered.
+    deserialize(unanswered, b + 16);
+
+    return true;
+  }
+
+  return false;
+}
+
+bool net::mon::event::tcp_half_open::serialize(string::buffer& buf) const
+{
+  // Allocate memory for the event.
+  if (buf.allocate(maxlen)) {
+    // Save a pointer to the position where the length will be stored.
+    void* begin = buf.end();
+
+    // Serialize base event.
+    void* b = base::serialize(begin, t);
+
+    // Serialize source port.
+    b = event::serialize(b, sport);
+
+    // Serialize destination port.
+    b = event::serialize(b, dport);
+
+    // Serialize number of connection attempts.
+    b = event::serialize(b, attempts);
+
+    // Serialize number of connections established.
+    b = event::serialize(b, established);
+
+    // Serialize number of connection attempts reset.
+    b = event::serialize(b, reset);
+
+    // Serialize number of connection attempts not answered.
+    b = event::serialize(b, unanswered);
+
+    // Compute length.
+    size_t len = static_cast<const uint8_t*>(b) -
+                 static_cast<const uint8_t*>(begin);
+
+    // Increment buffer length.
+    buf.increment_length(len);
+
+    // Store length.
+    event::serialize(begin, static_cast<evlen_t>(len));
+
+    return true;
+  }
+
+  return false;
+}
+
+void
+net::mon::event::tcp_half_open::print_human_readable(FILE* file,
+                                                     printer::format fmt,
+                                                     const char* srchost,
+                                                     const char* dsthost) const
+{
+  base::print_human_readable(file, fmt, srchost, dsthost, sport, dport);
+
+  if (fmt == printer::format::pretty_print) {
+    fprintf(file, "  Event type: 'Half-open TCP connections'\n");
+
+    fprintf(file, "  Attempts: %u\n", attempts);
+
+    fprintf(file, "  Established: %u\n", established);
+
+    fprintf(file, "  Reset: %u\n", reset);
+
+    fprintf(file, "  Unanswered: %u\n", unanswered);
+  } else {
+    fprintf(file, "[Half-open TCP connections] ");
+
+    fprintf(file, "attempts: %u, ", attempts);
+
+    fprintf(file, "established: %u, ", established);
+
+    fprintf(file, "reset: %u, ", reset);
+
+    fprintf(file, "unanswered: %u", unanswered);
+  }
+}
+
+void net::mon::event::tcp_half_open::print_json(FILE* file,
+                                                printer::format fmt,
+                                                const char* srchost,
+                                                const char* dsthost) const
+{
+  base::print_json(file, fmt, srchost, dsthost, sport, dport);
+
+  if (fmt == printer::format::pretty_print) {
+    fprintf(file, "    \"event-type\": \"half-open-tcp-connections\",\n");
+
+    fprintf(file, "    \"attempts\": %u,\n", attempts);
+
+    fprintf(file, "    \"established\": %u,\n", established);
+
+    fprintf(file, "    \"reset\": %u,\n", reset);
+
+    fprintf(file, "    \"unanswered\": %u\n", unanswered);
+  } else {
+    fprintf(file, "\"event-type\":\"half-open-tcp-connections\",");
+
+    fprintf(file, "\"attempts\":%u,", attempts);
+
+    fprintf(file, "\"established\":%u,", established);
+
+    fprintf(file, "\"reset\":%u,", reset);
+
+    fprintf(file, "\"unanswered\":%u", unanswered);
+  }
+}
+
+void net::mon::event::tcp_half_open::print_csv(FILE* file,
+                                               char separator,
+                                               const char* srchost,
+                                               const char* dsthost) const
+{
+  base::print_csv(file, separator, srchost, dsthost, sport, dport);
+
+  fprintf(file, "half-open-tcp-connections%c", separator);
+
+  fprintf(file, "%u%c", attempts, separator);
+
+  fprintf(file, "%u%c", established, separator);
+
+  fprintf(file, "%u%c", reset, separator);
+
+  fprintf(file, "%u", unanswered);
+}
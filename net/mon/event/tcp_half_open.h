@@ -0,0 +1,82 @@
+#ifndef NET_MON_EVENT_TCP_HALF_OPEN_H
+#define NET_MON_EVENT_TCP_HALF_OPEN_H
+
+#include "net/mon/event/base.h"
+#include "string/buffer.h"
+
+namespace net {
+  namespace mon {
+    namespace event {
+      // 'Half-open TCP connections' event (generated when too many
+      // connection attempts fail in one second).
+      // The addresses and ports are the ones of the last failed attempt
+      // (client -> server).
+      struct tcp_half_open : public base {
+        static constexpr const type t = type::tcp_half_open;
+
+        // Source port.
+        in_port_t sport;
+
+        // Destination port.
+        in_port_t dport;
+
+        // # of connection attempts (SYNs).
+        uint32_t attempts;
+
+        // # of connections established.
+        uint32_t established;
+
+        // # of connection attempts reset.
+        uint32_t reset;
+
+        // # of connection attempts not answered (or not completed).
+        uint32_t unanswered;
+
+        // Build 'Half-open TCP connections' event.
+        bool build(const void* buf, size_t len);
+
+        // Get size.
+        size_t size() const;
+
+        // Serialize.
+        bool serialize(string::buffer& buf) const;
+
+        // Print human readable.
+        void print_human_readable(FILE* file,
+                                  printer::format fmt,
+                                  const char* srchost,
+                                  const char* dsthost) const;
+
+        // Print JSON.
+        void print_json(FILE* file,
+                        printer::format fmt,
+                        const char* srchost,
+                        const char* dsthost) const;
+
+        // Print CSV.
+        void print_csv(FILE* file,
+                       char separator,
+                       const char* srchost,
+                       const char* dsthost) const;
+      };
+
+      static_assert(sizeof(evlen_t) +
+                    sizeof(type) +
+                    sizeof(tcp_half_open) <= maxlen,
+                    "'maxlen' is smaller than sizeof(tcp_half_open)");
+
+      inline size_t tcp_half_open::size() const
+      {
+        return base::size()      + // Size of the base event.
+               sizeof(in_port_t) + // Source port.
+               sizeof(in_port_t) + // Destination port.
+               4                 + // # of connection attempts.
+               4                 + // # of connections established.
+               4                 + // # of connection attempts reset.
+               4;                  // # of connection attempts not answered.
+      }
+    }
+  }
+}
+
+#endif // NET_MON_EVENT_TCP_HALF_OPEN_H
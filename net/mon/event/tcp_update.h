@@ -0,0 +1,84 @@
+#ifndef NET_MON_EVENT_TCP_UPDATE_H
+#define NET_MON_EVENT_TCP_UPDATE_H
+
+#include "net/mon/event/base.h"
+#include "string/buffer.h"
+
+namespace net {
+  namespace mon {
+    namespace event {
+      // 'Update TCP connection' event: traffic of a connection since its
+      // previous update (or since it began).
+      struct tcp_update : public base {
+        static constexpr const type t = type::tcp_update;
+
+        // Source port.
+        in_port_t sport;
+
+        // Destination port.
+        in_port_t dport;
+
+        // Creation timestamp.
+        uint64_t creation;
+
+        // # of bytes sent by the client.
+        uint64_t transferred_client;
+
+        // # of bytes sent by the server.
+        uint64_t transferred_server;
+
+        // # of packets sent by the client.
+        uint64_t packets_client;
+
+        // # of packets sent by the server.
+        uint64_t packets_server;
+
+        // Build 'Update TCP connection' event.
+        bool build(const void* buf, size_t len);
+
+        // Get size.
+        size_t size() const;
+
+        // Serialize.
+        bool serialize(string::buffer& buf) const;
+
+        // Print human readable.
+        void print_human_readable(FILE* file,
+                                  printer::format fmt,
+                                  const char* srchost,
+                                  const char* dsthost) const;
+
+        // Print JSON.
+        void print_json(FILE* file,
+                        printer::format fmt,
+                        const char* srchost,
+                        const char* dsthost) const;
+
+        // Print CSV.
+        void print_csv(FILE* file,
+                       char separator,
+                       const char* srchost,
+                       const char* dsthost) const;
+      };
+
+      static_assert(sizeof(evlen_t) +
+                    sizeof(type) +
+                    sizeof(tcp_update) <= maxlen,
+                    "'maxlen' is smaller than sizeof(tcp_update)");
+
+      inline size_t tcp_update::size() const
+      {
+        return base::size()      + // Size of the base event.
+               sizeof(in_port_t) + // Source port.
+               sizeof(in_port_t) + // Destination port.
+               8                 + // Creation timestamp.
+               8                 + // # of bytes sent by the client.
+               8                 + // # of bytes sent by the server.
+               8                 + // # of packets sent by the client.
+               8;                  // # of packets sent by the server.
+      }
+    }
+  }
+}
+
+#endif // NET_MON_EVENT_TCP_UPDATE_H
@@ -1,33 +1,101 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
 #include "net/mon/event/writer.h"
 
+bool net::mon::event::writer::init()
+{
+  size_t size = file::block::size_v3 + _M_buffer_size * 2;
+
+  if (!_M_buf.allocate(size)) {
+    return false;
+  }
+
+  // If the blocks are written by the I/O thread...
+  if (_M_nbuffers > 0) {
+    // The queue of free buffers has room for all the buffers, the queue
+    // of full buffers also for the files to be sealed.
+    size_t qsize = util::spsc_queue<pending>::min_size;
+    while (qsize < _M_nbuffers) {
+      qsize <<= 1;
+    }
+
+    if (((_M_buffers = new (std::nothrow) string::buffer[_M_nbuffers]) ==
+         nullptr) ||
+        (!_M_full.init(qsize * 2)) ||
+        (!_M_free.init(qsize))) {
+      return false;
+    }
+
+    for (size_t i = 0; i < _M_nbuffers; i++) {
+      if (!_M_buffers[i].allocate(size)) {
+        return false;
+      }
+
+      *_M_free.back() = &_M_buffers[i];
+      _M_free.push();
+    }
+
+    if ((_M_compression != compression::none) &&
+        (!_M_compressed.allocate(size))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool net::mon::event::writer::open(const char* filename)
 {
+  // Save the name of the file (a new file is opened with the same name
+  // when the file is rotated).
+  size_t len = strlen(filename);
+  if (len >= sizeof(_M_filename)) {
+    return false;
+  }
+
+  memcpy(_M_filename, filename, len + 1);
+
   // Open file.
   if (_M_file.open(filename)) {
-    uint8_t header[file::header::size];
-
     // If the file is not empty...
     if (!_M_file.empty()) {
+      uint8_t header[file::header::size];
+
       // Read header.
       if (_M_file.pread(header, sizeof(header), 0) ==
           static_cast<ssize_t>(sizeof(header))) {
         // Deserialize header.
-        if (_M_header.deserialize(header, sizeof(header))) {
-          return true;
+        if (_M_header.deserialize(header, sizeof(header)) > 0) {
+          // The events of a file of version 1 are not in blocks.
+          set_blocks(_M_header.version >= 2);
+
+          // The blocks are compressed only in the files of version 3.
+          _M_compress = (_M_header.version == 3) &&
+                        (_M_compression != compression::none);
+
+          _M_segment_size = _M_file.size();
+
+          // The file is rotated by the time of its first event.
+          if (_M_header.timestamp.first != 0) {
+            set_rotation_deadline();
+          }
+
+          if ((_M_header.version < 2) || (_M_nbuffers == 0) || (start())) {
+            return true;
+          }
         }
       }
     } else {
       // File is empty.
 
       // Initialize header.
-      _M_header.timestamp.first = 0;
-      _M_header.timestamp.last = 0;
+      new_file();
 
-      // Serialize header.
-      _M_header.serialize(header, sizeof(header));
+      _M_compress = (_M_compression != compression::none);
 
       // Write header at the beginning of the file.
-      if (_M_file.pwrite(header, sizeof(header), 0)) {
+      if ((write_header(_M_header)) && ((_M_nbuffers == 0) || (start()))) {
         return true;
       }
     }
@@ -40,26 +108,323 @@ bool net::mon::event::writer::open(const char* filename)
 
 bool net::mon::event::writer::close()
 {
+  // Wait for the I/O thread (if running) to give all the buffers back, so
+  // the last block is not dropped (and to seal the files handed over).
+  sync();
+
   // If the file is open...
   if (_M_file.open()) {
     // Flush remaining data (if any).
-    if (flush()) {
-      // Serialize header.
-      uint8_t header[file::header::size];
-      _M_header.serialize(header, sizeof(header));
+    bool ret = (_M_buf.length() > _M_offset) ? flush_() : true;
 
+    // Stop I/O thread (if running).
+    if ((stop()) && (ret)) {
       // Write header at the beginning of the file.
-      bool ret = _M_file.pwrite(header, sizeof(header), 0);
+      ret = write_header(_M_header);
+    } else {
+      ret = false;
+    }
+
+    _M_file.close();
+
+    return ret;
+  } else if (_M_running) {
+    // The I/O thread couldn't open the next file.
+    stop();
+
+    return false;
+  } else {
+    return true;
+  }
+}
+
+bool net::mon::event::writer::start()
+{
+  _M_error = false;
+
+  // Set '_M_running' before starting the thread (the thread exits when it
+  // is not set and there are no full buffers).
+  _M_running = true;
+
+  if (pthread_create(&_M_thread, nullptr, run, this) == 0) {
+    return true;
+  }
+
+  _M_running = false;
+
+  return false;
+}
+
+bool net::mon::event::writer::stop()
+{
+  if (_M_running) {
+    // Wait for the I/O thread to write the full buffers.
+    sync();
+
+    __atomic_store_n(&_M_running, false, __ATOMIC_RELEASE);
+
+    pthread_join(_M_thread, nullptr);
+  }
+
+  return !_M_error;
+}
+
+bool net::mon::event::writer::hand_over()
+{
+  string::buffer** free;
+
+  // If all the buffers are in flight...
+  if ((free = _M_free.front()) == nullptr) {
+    if (_M_backpressure == backpressure::drop) {
+      _M_io.dropped_blocks++;
+      _M_io.dropped_events += _M_block.count;
+
+      // Drop the events and reuse the buffer.
+      _M_buf.clear();
+      _M_buf.increment_length(_M_offset);
+
+      _M_block.clear();
+
+      return true;
+    }
+
+    // Wait for the I/O thread to give a buffer back.
+    uint64_t start = now();
+
+    do {
+      usleep(wait_sleep);
+    } while ((free = _M_free.front()) == nullptr);
+
+    _M_io.stalls++;
+    _M_io.stall_time += now() - start;
+  }
+
+  // If the I/O thread couldn't write a block...
+  if (__atomic_load_n(&_M_error, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+
+  string::buffer* buf = *free;
+  _M_free.pop();
+
+  // Hand over the buffer and continue with the free one (emptied by the
+  // I/O thread).
+  buf->swap(_M_buf);
+
+  // There is room for the buffer (unless the queue is full of files to be
+  // sealed).
+  pending* p;
+  while ((p = _M_full.back()) == nullptr) {
+    usleep(wait_sleep);
+  }
+
+  p->buf = buf;
+  p->timestamp = now();
+
+  _M_full.push();
 
-      _M_file.close();
+  _M_io.blocks++;
 
-      return ret;
+  // Make room for the header of the next block.
+  _M_buf.increment_length(_M_offset);
+
+  _M_block.clear();
+
+  return true;
+}
+
+bool net::mon::event::writer::rotate()
+{
+  // Flush the last block of the file.
+  if ((_M_buf.length() > _M_offset) && (!flush_())) {
+    return false;
+  }
+
+  // If the I/O thread is running...
+  if (_M_running) {
+    // Hand over the file to be sealed (after its blocks).
+    pending* p;
+    while ((p = _M_full.back()) == nullptr) {
+      usleep(wait_sleep);
+    }
+
+    p->buf = nullptr;
+    p->timestamp = now();
+    p->header = _M_header;
+
+    _M_full.push();
+
+    new_file();
+
+    return true;
+  }
+
+  if (seal(_M_header)) {
+    new_file();
+
+    // The new file might be written by the I/O thread (if the previous
+    // file was of version 1).
+    return ((_M_nbuffers == 0) || (start()));
+  }
+
+  return false;
+}
+
+bool net::mon::event::writer::seal(const file::header& header)
+{
+  // Write the final header and close the file.
+  if ((!write_header(header)) || (!_M_file.close())) {
+    return false;
+  }
+
+  // Name of the sealed file: the original name (without the extension
+  // ".bin") followed by the time of the first event.
+  size_t len = strlen(_M_filename);
+  if ((len > 4) && (strcmp(_M_filename + len - 4, ".bin") == 0)) {
+    len -= 4;
+  }
+
+  time_t t = static_cast<time_t>(header.timestamp.first / 1000000);
+  struct tm tm;
+  gmtime_r(&t, &tm);
+
+  for (unsigned i = 0; i < max_segment_names; i++) {
+    char name[PATH_MAX];
+    char suffix[16];
+
+    if (i == 0) {
+      *suffix = 0;
     } else {
-      _M_file.close();
+      snprintf(suffix, sizeof(suffix), "-%u", i);
+    }
 
+    if (static_cast<size_t>(snprintf(name,
+                                     sizeof(name),
+                                     "%.*s.%04d%02d%02d-%02d%02d%02d.%06u%s"
+                                     ".bin",
+                                     static_cast<int>(len),
+                                     _M_filename,
+                                     1900 + tm.tm_year,
+                                     1 + tm.tm_mon,
+                                     tm.tm_mday,
+                                     tm.tm_hour,
+                                     tm.tm_min,
+                                     tm.tm_sec,
+                                     static_cast<unsigned>(
+                                       header.timestamp.first % 1000000
+                                     ),
+                                     suffix)) >= sizeof(name)) {
       return false;
     }
-  } else {
-    return true;
+
+    // Rename the file (link() doesn't replace an existing file).
+    if (link(_M_filename, name) == 0) {
+      return ((unlink(_M_filename) == 0) && (create(version())));
+    } else if (errno != EEXIST) {
+      return false;
+    }
+  }
+
+  return false;
+}
+
+bool net::mon::event::writer::create(unsigned version)
+{
+  if (_M_file.open(_M_filename)) {
+    file::header header;
+    header.version = version;
+    header.timestamp.first = 0;
+    header.timestamp.last = 0;
+
+    // The blocks are compressed only in the files of version 3.
+    _M_compress = (version == 3) && (_M_compression != compression::none);
+
+    if (write_header(header)) {
+      return true;
+    }
+
+    _M_file.close();
+  }
+
+  return false;
+}
+
+bool net::mon::event::writer::write_header(const file::header& header)
+{
+  // Serialize header.
+  uint8_t buf[file::header::size];
+  header.serialize(buf, sizeof(buf));
+
+  // Write header at the beginning of the file.
+  return _M_file.pwrite(buf, sizeof(buf), 0);
+}
+
+bool net::mon::event::writer::write_block(const string::buffer& buf)
+{
+  static constexpr const size_t size = file::block::size_v3;
+
+  // If the blocks are not compressed...
+  if (!_M_compress) {
+    return _M_file.write(buf.data(), buf.length());
+  }
+
+  size_t len = buf.length() - size;
+
+  // Compress the events (the block is written uncompressed if it doesn't
+  // get smaller).
+  size_t n = _M_lz4.compress(buf.data() + size,
+                             len,
+                             _M_compressed.data() + size,
+                             len - 1);
+
+  if (n > 0) {
+    // Serialize the block header with the size of the compressed events.
+    file::block block;
+    block.deserialize(buf.data(), size, 3);
+    block.stored = static_cast<uint32_t>(n);
+    block.serialize(_M_compressed.data(), size, 3);
+
+    return _M_file.write(_M_compressed.data(), size + n);
   }
+
+  return _M_file.write(buf.data(), buf.length());
+}
+
+void* net::mon::event::writer::run(void* arg)
+{
+  writer* w = static_cast<writer*>(arg);
+
+  do {
+    pending* p;
+
+    // If there is a full buffer or a file to be sealed...
+    if ((p = w->_M_full.front()) != nullptr) {
+      string::buffer* buf;
+
+      if ((buf = p->buf) != nullptr) {
+        if (!w->write_block(*buf)) {
+          __atomic_store_n(&w->_M_error, true, __ATOMIC_RELEASE);
+        }
+
+        uint64_t latency = now() - p->timestamp;
+        w->_M_io.latency.add((latency < UINT32_MAX) ?
+                               static_cast<uint32_t>(latency) :
+                               UINT32_MAX);
+
+        buf->clear();
+
+        // Give the buffer back (there is always room for it).
+        *w->_M_free.back() = buf;
+        w->_M_free.push();
+      } else if (!w->seal(p->header)) {
+        __atomic_store_n(&w->_M_error, true, __ATOMIC_RELEASE);
+      }
+
+      w->_M_full.pop();
+    } else if (__atomic_load_n(&w->_M_running, __ATOMIC_ACQUIRE)) {
+      usleep(io_sleep);
+    } else {
+      return nullptr;
+    }
+  } while (true);
 }
@@ -1,26 +1,100 @@
 #ifndef NET_MON_EVENT_WRITER_H
 #define NET_MON_EVENT_WRITER_H
 
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <limits.h>
+#include <new>
 #include "net/mon/event/events.h"
 #include "net/mon/event/file.h"
+#include "net/mon/event/compression.h"
+#include "net/mon/event/backpressure.h"
 #include "fs/file.h"
+#include "util/lz4.h"
+#include "util/spsc_queue.h"
+#include "util/histogram.h"
 
 namespace net {
   namespace mon {
     namespace event {
       // Event writer.
+      //
+      // The events are written in blocks (event files of version 2): the
+      // buffer is written as a block when it reaches 'buffer_size' bytes or
+      // when it is flushed. The events are appended to the existing files
+      // of version 1 without blocks.
+      //
+      // With 'nbuffers' > 0, the full buffers are handed over to an I/O
+      // thread, which compresses (event files of version 3) and writes
+      // them, while the events are written to a free buffer (the events
+      // appended to files of version 1 are written synchronously); the
+      // blocks are compressed only by the I/O thread (with compression,
+      // there is at least one buffer). When all the buffers are in flight, the
+      // writer either waits for the I/O thread or drops the events of the
+      // full buffer ('backpressure'); both are counted. The periodic
+      // flushes neither wait nor drop: the buffer is not flushed while
+      // there is no free buffer.
+      //
+      // The event file can be rotated when it reaches 'rotation_size'
+      // bytes (uncompressed, including the file and block headers; the
+      // part of an existing file counts with its size on disk) or when the
+      // time of the events reaches the next multiple of 'rotation_interval'
+      // seconds: the file is sealed (its header is written) and renamed
+      // after the time of its first event
+      // ("<name>.<YYYYmmdd-HHMMSS>.<uuuuuu>.bin", "-<n>" is appended to the
+      // time if the name exists), and a new file is opened with the
+      // original name. With the I/O thread, the file
+      // is sealed by the I/O thread once it has written the blocks of the
+      // file, so the writer doesn't wait.
       class writer {
         public:
           // Minimum buffer size.
           static constexpr const size_t min_buffer_size = event::maxlen;
 
+          // Maximum buffer size (the length of a block is 32-bit).
+          static constexpr const size_t max_buffer_size = 1024 * 1024 * 1024;
+
           // Default buffer size.
           static constexpr const size_t default_buffer_size = 32 * 1024;
 
+          // Maximum number of buffers handed over to the I/O thread.
+          static constexpr const size_t max_buffers = 64;
+
+          // Maximum rotation interval (seconds).
+          static constexpr const uint64_t
+                 max_rotation_interval = 365ull * 24ull * 60ull * 60ull;
+
+          // Counters of the I/O thread.
+          struct io_counters {
+            // Number of blocks handed over to the I/O thread.
+            uint64_t blocks = 0;
+
+            // Number of times the writer waited for a free buffer and
+            // total waiting time (microseconds).
+            uint64_t stalls = 0;
+            uint64_t stall_time = 0;
+
+            // Number of blocks and events dropped because there was no
+            // free buffer.
+            uint64_t dropped_blocks = 0;
+            uint64_t dropped_events = 0;
+
+            // Microseconds from the hand-over of the blocks until they
+            // are written (by the I/O thread).
+            util::basic_histogram<24> latency;
+          };
+
           // Constructor.
           writer(uint64_t file_allocation_size =
                           fs::file::default_allocation_size,
-                 size_t buffer_size = default_buffer_size);
+                 size_t buffer_size = default_buffer_size,
+                 compression c = compression::none,
+                 size_t nbuffers = 0,
+                 backpressure bp = backpressure::wait,
+                 bool direct_io = false,
+                 uint64_t rotation_size = 0,
+                 uint64_t rotation_interval = 0);
 
           // Destructor.
           ~writer();
@@ -38,52 +112,247 @@ namespace net {
           template<typename Event>
           bool write(const Event& ev);
 
+          // Write serialized event.
+          bool write(const void* event, size_t len);
+
           // Flush buffer.
           bool flush();
 
+          // Wait for the I/O thread (if running) to write the blocks
+          // handed over.
+          void sync();
+
+          // Get the number of buffers handed over to the I/O thread.
+          size_t buffers() const;
+
+          // Get the counters of the I/O thread (call sync() first if the
+          // I/O thread is running).
+          const io_counters& io() const;
+
         private:
+          // Sleep time when waiting for the I/O thread (microseconds).
+          static constexpr const useconds_t wait_sleep = 10;
+
+          // Sleep time of the I/O thread when idle (microseconds).
+          static constexpr const useconds_t io_sleep = 100;
+
+          // Block handed over to the I/O thread, or file to be sealed.
+          struct pending {
+            // Block (nullptr: seal the file).
+            string::buffer* buf;
+
+            // Time of the hand-over (microseconds).
+            uint64_t timestamp;
+
+            // Header of the file to be sealed.
+            file::header header;
+          };
+
+          // Maximum number of names tried when renaming a sealed file.
+          static constexpr const unsigned max_segment_names = 1000;
+
           fs::file _M_file;
 
           file::header _M_header;
 
+          // Header of the current block.
+          file::block _M_block;
+
           string::buffer _M_buf;
 
           size_t _M_buffer_size;
 
+          // Offset of the first event in the buffer (room for the block
+          // header).
+          size_t _M_offset = 0;
+
+          // Compression of the blocks.
+          compression _M_compression;
+
+          // Compress the blocks of the current file?
+          bool _M_compress = false;
+
+          // Buffers handed over to the I/O thread.
+          string::buffer* _M_buffers = nullptr;
+          size_t _M_nbuffers;
+
+          // What to do when there is no free buffer.
+          backpressure _M_backpressure;
+
+          // Full buffers (writer -> I/O thread).
+          util::spsc_queue<pending> _M_full;
+
+          // Free buffers (I/O thread -> writer).
+          util::spsc_queue<string::buffer*> _M_free;
+
+          // Compressed block.
+          string::buffer _M_compressed;
+
+          // LZ4 compressor.
+          util::lz4 _M_lz4;
+
+          // I/O thread.
+          pthread_t _M_thread;
+
+          // Is the I/O thread running?
+          bool _M_running = false;
+
+          // Has the I/O thread failed writing a block?
+          bool _M_error = false;
+
+          // Counters of the I/O thread.
+          io_counters _M_io;
+
+          // Name of the event file.
+          char _M_filename[PATH_MAX];
+
+          // Rotate the file when it reaches this size (bytes, 0:
+          // disabled).
+          uint64_t _M_rotation_size;
+
+          // Rotation interval (microseconds, 0: disabled).
+          uint64_t _M_rotation_interval;
+
+          // Size of the current file (uncompressed, including the file and
+          // block headers).
+          uint64_t _M_segment_size = 0;
+
+          // Time of the events when the current file has to be rotated
+          // (microseconds).
+          uint64_t _M_rotation_deadline = 0;
+
+          // Write the events in blocks?
+          void set_blocks(bool blocks);
+
+          // Add the last event of the buffer to the current block.
+          bool add(size_t len, uint64_t timestamp);
+
+          // Rotate the file if it is time to do it (before writing an
+          // event of time 'timestamp').
+          bool check_rotation(uint64_t timestamp);
+
+          // Set the time when the current file has to be rotated.
+          void set_rotation_deadline();
+
+          // Rotate file.
+          bool rotate();
+
+          // Start a new file (writer's state).
+          void new_file();
+
+          // Seal the file and open the next one (I/O thread or writer).
+          bool seal(const file::header& header);
+
+          // Create a new file with the original name.
+          bool create(unsigned version);
+
+          // Write the header at the beginning of the file.
+          bool write_header(const file::header& header);
+
+          // Get the version of the new files.
+          unsigned version() const;
+
           // Flush buffer.
           bool flush_();
 
+          // Start I/O thread.
+          bool start();
+
+          // Stop I/O thread (once it has written the blocks handed over).
+          bool stop();
+
+          // Hand over the buffer to the I/O thread.
+          bool hand_over();
+
+          // Compress (if enabled) and write block (I/O thread).
+          bool write_block(const string::buffer& buf);
+
+          // Get the current time (microseconds).
+          static uint64_t now();
+
+          // Run I/O thread.
+          static void* run(void* arg);
+
           // Disable copy constructor and assignment operator.
           writer(const writer&) = delete;
           writer& operator=(const writer&) = delete;
       };
 
-      inline writer::writer(uint64_t file_allocation_size, size_t buffer_size)
-        : _M_file(file_allocation_size),
-          _M_buffer_size(buffer_size)
+      inline writer::writer(uint64_t file_allocation_size,
+                            size_t buffer_size,
+                            compression c,
+                            size_t nbuffers,
+                            backpressure bp,
+                            bool direct_io,
+                            uint64_t rotation_size,
+                            uint64_t rotation_interval)
+        : _M_file(file_allocation_size, direct_io),
+          _M_buffer_size(buffer_size),
+          _M_compression(c),
+          _M_nbuffers(((c != compression::none) && (nbuffers == 0)) ?
+                        1 :
+                        nbuffers),
+          _M_backpressure(bp),
+          _M_rotation_size(rotation_size),
+          _M_rotation_interval(rotation_interval * 1000000ull)
       {
       }
 
       inline writer::~writer()
       {
         close();
-      }
 
-      inline bool writer::init()
-      {
-        return (_M_buf.allocate(_M_buffer_size * 2));
+        if (_M_buffers) {
+          delete [] _M_buffers;
+        }
       }
 
       template<typename Event>
       inline bool writer::write(const Event& ev)
       {
-        if ((ev.serialize(_M_buf)) &&
-            ((_M_buf.length() < _M_buffer_size) || (flush_()))) {
+        if (check_rotation(ev.timestamp)) {
+          size_t len = _M_buf.length();
+
+          return ((ev.serialize(_M_buf)) &&
+                  (add(_M_buf.length() - len, ev.timestamp)));
+        }
+
+        return false;
+      }
+
+      inline bool writer::write(const void* event, size_t len)
+      {
+        uint64_t timestamp = base::extract_timestamp(event);
+
+        return ((check_rotation(timestamp)) &&
+                (_M_buf.append(static_cast<const char*>(event), len)) &&
+                (add(len, timestamp)));
+      }
+
+      inline void writer::set_blocks(bool blocks)
+      {
+        _M_buf.clear();
+        _M_block.clear();
+
+        // Make room for the header of the first block (if any).
+        _M_offset = blocks ? file::block::size(_M_header.version) : 0;
+        _M_buf.increment_length(_M_offset);
+      }
+
+      inline bool writer::add(size_t len, uint64_t timestamp)
+      {
+        if (_M_offset > 0) {
+          _M_block.add(_M_buf.end() - len);
+        }
+
+        if ((_M_buf.length() - _M_offset < _M_buffer_size) || (flush_())) {
           if (_M_header.timestamp.first == 0) {
-            _M_header.timestamp.first = ev.timestamp;
+            _M_header.timestamp.first = timestamp;
+
+            set_rotation_deadline();
           }
 
-          _M_header.timestamp.last = ev.timestamp;
+          _M_header.timestamp.last = timestamp;
 
           return true;
         }
@@ -93,20 +362,117 @@ namespace net {
 
       inline bool writer::flush()
       {
-        return !_M_buf.empty() ? flush_() : true;
+        // If the buffer is not empty and there is a free buffer (if the
+        // I/O thread is running)...
+        if ((_M_buf.length() > _M_offset) &&
+            ((!_M_running) || (_M_free.front()))) {
+          return flush_();
+        }
+
+        return true;
+      }
+
+      inline bool writer::check_rotation(uint64_t timestamp)
+      {
+        // If the file has events and it is time to rotate it...
+        if ((_M_header.timestamp.first != 0) &&
+            (((_M_rotation_size > 0) &&
+              (_M_segment_size + _M_buf.length() - _M_offset >=
+               _M_rotation_size)) ||
+             ((_M_rotation_interval > 0) &&
+              (timestamp >= _M_rotation_deadline)))) {
+          return rotate();
+        }
+
+        return true;
+      }
+
+      inline void writer::set_rotation_deadline()
+      {
+        // Next multiple of the rotation interval.
+        if (_M_rotation_interval > 0) {
+          _M_rotation_deadline = ((_M_header.timestamp.first /
+                                   _M_rotation_interval) + 1) *
+                                 _M_rotation_interval;
+        }
+      }
+
+      inline void writer::new_file()
+      {
+        _M_header.version = version();
+        _M_header.timestamp.first = 0;
+        _M_header.timestamp.last = 0;
+
+        set_blocks(true);
+
+        _M_segment_size = file::header::size;
+      }
+
+      inline unsigned writer::version() const
+      {
+        return (_M_compression == compression::none) ? 2 : 3;
+      }
+
+      inline void writer::sync()
+      {
+        if (_M_running) {
+          while (!_M_full.empty()) {
+            usleep(wait_sleep);
+          }
+        }
+      }
+
+      inline size_t writer::buffers() const
+      {
+        return _M_nbuffers;
+      }
+
+      inline const writer::io_counters& writer::io() const
+      {
+        return _M_io;
       }
 
       inline bool writer::flush_()
       {
+        _M_segment_size += _M_buf.length();
+
+        // If the events are written in blocks...
+        if (_M_offset > 0) {
+          // Serialize block header at the beginning of the buffer.
+          _M_block.stored = _M_block.length;
+          _M_block.serialize(_M_buf.data(), _M_offset, _M_header.version);
+        }
+
+        // If the blocks are written by the I/O thread...
+        if (_M_running) {
+          return hand_over();
+        }
+
         // Write buffer to file.
         if (_M_file.write(_M_buf.data(), _M_buf.length())) {
           _M_buf.clear();
 
+          if (_M_offset > 0) {
+            // Make room for the header of the next block.
+            _M_buf.increment_length(_M_offset);
+
+            _M_block.clear();
+          }
+
           return true;
         }
 
         return false;
       }
+
+      inline uint64_t writer::now()
+      {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return (static_cast<uint64_t>(ts.tv_sec) * 1000000ull) +
+               (ts.tv_nsec / 1000);
+      }
     }
   }
 }
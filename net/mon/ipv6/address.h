@@ -64,10 +64,7 @@ namespace net {
       {
         static constexpr const uint32_t initval = 0;
 
-        return util::hash::hash_3words(s6_addr32[0] ^ s6_addr32[1],
-                                       s6_addr32[2],
-                                       s6_addr32[3],
-                                       initval);
+        return util::hash::hashword(s6_addr32, 4, initval);
       }
 
       inline address_pair::address_pair(const struct in6_addr& addr1,
@@ -10,7 +10,16 @@ namespace net {
   namespace mon {
     namespace ipv6 {
       namespace tcp {
-        class connection : public net::mon::tcp::connection {
+        // Addresses and ports of a connection.
+        struct connection_key {
+          address_pair _M_addresses;
+          mon::tcp::port_pair _M_ports;
+        };
+
+        // The addresses and ports are at the beginning of the connection,
+        // next to the members used when searching a connection.
+        class connection : private connection_key,
+                           public net::mon::tcp::connection {
           public:
             typedef address address_type;
 
@@ -37,9 +46,6 @@ namespace net {
             const mon::tcp::port_pair& ports() const;
 
           private:
-            address_pair _M_addresses;
-            mon::tcp::port_pair _M_ports;
-
             // Disable copy constructor and assignment operator.
             connection(const connection&) = delete;
             connection& operator=(const connection&) = delete;
@@ -0,0 +1,294 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <limits.h>
+#include <memory>
+#include "net/mon/pcap_workers.h"
+#include "net/mon/event/merger.h"
+#include "net/flow.h"
+
+bool net::mon::pcap_workers::create(size_t nworkers,
+                                    const size_t* processors,
+                                    const char* evdir,
+                                    uint64_t file_allocation_size,
+                                    size_t buffer_size,
+                                    event::compression compression,
+                                    size_t writer_buffers,
+                                    event::backpressure backpressure,
+                                    bool direct_io,
+                                    uint64_t rotation_size,
+                                    uint64_t rotation_interval,
+                                    const tcp::options& tcp_options)
+{
+  if ((nworkers >= workers::min_workers) &&
+      (nworkers <= workers::max_workers) &&
+      (buffer_size >= event::writer::min_buffer_size)) {
+    // Create workers.
+    for (size_t i = 0; i < nworkers; i++) {
+      if ((_M_workers[i] =
+             new (std::nothrow) worker(i,
+                                       processors[i],
+                                       evdir,
+                                       file_allocation_size,
+                                       buffer_size,
+                                       compression,
+                                       writer_buffers,
+                                       backpressure,
+                                       direct_io,
+                                       rotation_size,
+                                       rotation_interval)) == nullptr) {
+        _M_nworkers = i;
+        return false;
+      }
+    }
+
+    _M_nworkers = nworkers;
+
+    // Shared budget of memory of the TCP connections?
+    util::slab_pool* tcp_pool = nullptr;
+    if (tcp_options.memory > 0) {
+      if (!_M_tcp_pool.init(tcp_options.memory /
+                            util::slab_pool::slab_size)) {
+        return false;
+      }
+
+      tcp_pool = &_M_tcp_pool;
+    }
+
+    // Single worker?
+    if (nworkers == 1) {
+      // The packets are processed by the calling thread.
+      return _M_workers[0]->init("pcap",
+                                 tcp_options,
+                                 tcp_pool);
+    }
+
+    // Create packet queues.
+    if ((_M_queues = new (std::nothrow) worker::packet_queue[nworkers]) ==
+        nullptr) {
+      return false;
+    }
+
+    // Initialize workers.
+    for (size_t i = 0; i < nworkers; i++) {
+      if ((!_M_queues[i].init(queue_size)) ||
+          (!_M_workers[i]->init("pcap",
+                                &_M_queues[i],
+                                false,
+                                tcp_options,
+                                tcp_pool))) {
+        return false;
+      }
+    }
+
+    // Start workers.
+    for (size_t i = 0; i < nworkers; i++) {
+      if (!_M_workers[i]->start()) {
+        return false;
+      }
+    }
+
+    _M_started = true;
+
+    return true;
+  }
+
+  return false;
+}
+
+bool net::mon::pcap_workers::process(const char* filename)
+{
+  struct stat sbuf;
+  if (stat(filename, &sbuf) == 0) {
+    // If it is not a directory...
+    if (!S_ISDIR(sbuf.st_mode)) {
+      return process_file(filename);
+    }
+
+    // Get the entries of the directory in alphabetical order.
+    struct dirent** entries;
+    int n;
+    if ((n = scandir(filename, &entries, nullptr, alphasort)) >= 0) {
+      bool ret = true;
+
+      for (int i = 0; i < n; i++) {
+        if ((ret) && (entries[i]->d_name[0] != '.')) {
+          char path[PATH_MAX];
+          if (static_cast<size_t>(snprintf(path,
+                                           sizeof(path),
+                                           "%s/%s",
+                                           filename,
+                                           entries[i]->d_name)) <
+              sizeof(path)) {
+            // If it is a regular file...
+            if ((stat(path, &sbuf) == 0) && (S_ISREG(sbuf.st_mode))) {
+              ret = process_file(path);
+            }
+          } else {
+            fprintf(stderr, "Filename too long.\n");
+            ret = false;
+          }
+        }
+
+        free(entries[i]);
+      }
+
+      free(entries);
+
+      return ret;
+    }
+
+    fprintf(stderr, "Error reading directory '%s'.\n", filename);
+  } else {
+    fprintf(stderr, "File '%s' doesn't exist.\n", filename);
+  }
+
+  return false;
+}
+
+bool net::mon::pcap_workers::finish()
+{
+  // Stop workers (they process the remaining packets first).
+  if (_M_started) {
+    for (size_t i = 0; i < _M_nworkers; i++) {
+      _M_workers[i]->stop();
+    }
+
+    _M_started = false;
+  }
+
+  bool ret = true;
+
+  for (size_t i = 0; i < _M_nworkers; i++) {
+    // Remove expired connections.
+    _M_workers[i]->remove_expired(_M_last_timestamp);
+
+    // Close event file.
+    if (!_M_workers[i]->close()) {
+      ret = false;
+    }
+  }
+
+  return ret;
+}
+
+bool net::mon::pcap_workers::merge(const char* filename,
+                                   event::compression compression)
+{
+  // If the output file doesn't exist...
+  struct stat sbuf;
+  if (stat(filename, &sbuf) < 0) {
+    if (_M_nworkers > 1) {
+      const char* infiles[workers::max_workers];
+      for (size_t i = 0; i < _M_nworkers; i++) {
+        infiles[i] = _M_workers[i]->filename();
+      }
+
+      // Merge event files.
+      if (event::merger::merge(infiles,
+                               _M_nworkers,
+                               filename,
+                               compression)) {
+        // Remove event files.
+        for (size_t i = 0; i < _M_nworkers; i++) {
+          unlink(infiles[i]);
+        }
+
+        return true;
+      }
+    } else if (_M_nworkers == 1) {
+      // Just rename the event file.
+      return (rename(_M_workers[0]->filename(), filename) == 0);
+    }
+  }
+
+  return false;
+}
+
+bool net::mon::pcap_workers::process_file(const char* filename)
+{
+  // Open PCAP file.
+  pcap::reader reader;
+  if (reader.open(filename)) {
+    pcap::callbacks callbacks;
+    callbacks.ipv4 = ipv4;
+    callbacks.ipv6 = ipv6;
+
+    _M_reader = &reader;
+
+    // Read PCAP file.
+    bool ret = reader.read_all(callbacks, this);
+
+    // The packets point to the mapped file, wait for the workers to
+    // process them before closing it.
+    drain();
+
+    if (ret) {
+      return true;
+    }
+
+    fprintf(stderr, "Error adding packet.\n");
+  } else {
+    fprintf(stderr, "Error opening file '%s' for reading.\n", filename);
+  }
+
+  return false;
+}
+
+bool net::mon::pcap_workers::process(const void* buf,
+                                     size_t len,
+                                     size_t wirelen,
+                                     const pcap::timeval& ts,
+                                     bool ipv6)
+{
+  uint32_t usec = (_M_reader->resolution() ==
+                   pcap::resolution::microseconds) ? ts.tv_usec :
+                                                     ts.tv_usec / 1000;
+
+  const struct timeval timestamp = {static_cast<time_t>(ts.tv_sec),
+                                    static_cast<suseconds_t>(usec)};
+
+  _M_last_timestamp = (ts.tv_sec * 1000000ull) + usec;
+
+  // Single worker?
+  if (_M_nworkers == 1) {
+    return ipv6 ? _M_workers[0]->process_ipv6(buf, len, wirelen, timestamp) :
+                  _M_workers[0]->process_ipv4(buf, len, wirelen, timestamp);
+  }
+
+  // Select worker.
+  worker::packet_queue& queue = _M_queues[(ipv6 ?
+                                             flow::hash_ipv6(buf, len) :
+                                             flow::hash_ipv4(buf, len)) %
+                                          _M_nworkers];
+
+  // Wait for a free slot.
+  worker::packet* pkt;
+  while ((pkt = queue.back()) == nullptr) {
+    usleep(queue_sleep);
+  }
+
+  pkt->buf = buf;
+  pkt->len = static_cast<uint32_t>(len);
+  pkt->wirelen = static_cast<uint32_t>(wirelen);
+  pkt->timestamp = timestamp;
+  pkt->rxhash = 0;
+  pkt->t = ipv6 ? worker::packet::type::ipv6 : worker::packet::type::ipv4;
+
+  queue.push();
+
+  return true;
+}
+
+void net::mon::pcap_workers::drain()
+{
+  if (_M_started) {
+    for (size_t i = 0; i < _M_nworkers; i++) {
+      while (!_M_queues[i].empty()) {
+        usleep(queue_sleep);
+      }
+    }
+  }
+}
@@ -0,0 +1,176 @@
+#ifndef NET_MON_PCAP_WORKERS_H
+#define NET_MON_PCAP_WORKERS_H
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "net/mon/worker.h"
+#include "net/mon/workers.h"
+#include "pcap/reader.h"
+#include "util/slab_pool.h"
+
+namespace net {
+  namespace mon {
+    // Workers processing PCAP files.
+    //
+    // The PCAP files are read by the calling thread, which dispatches each
+    // packet to a worker by the hash of its flow, so all the packets of a
+    // connection are processed by the same worker. Each worker writes its
+    // own event file.
+    //
+    // If there is a single worker, the packets are processed by the calling
+    // thread.
+    class pcap_workers {
+      public:
+        // Size of the packet queue of each worker.
+        static constexpr const size_t queue_size = 16 * 1024;
+
+        // Constructor.
+        pcap_workers() = default;
+
+        // Destructor.
+        ~pcap_workers();
+
+        // Create workers.
+        // 'tcp_options': options of the TCP connections ('memory' is the
+        // memory of the TCP connections of all the workers).
+        bool create(size_t nworkers,
+                    const size_t* processors,
+                    const char* evdir,
+                    uint64_t file_allocation_size,
+                    size_t buffer_size,
+                    event::compression compression,
+                    size_t writer_buffers,
+                    event::backpressure backpressure,
+                    bool direct_io,
+                    uint64_t rotation_size,
+                    uint64_t rotation_interval,
+                    const tcp::options& tcp_options);
+
+        // Process PCAP file or the PCAP files of a directory (in
+        // alphabetical order).
+        bool process(const char* filename);
+
+        // Finish: wait for the workers to process the pending packets,
+        // remove the expired connections and close the event files.
+        bool finish();
+
+        // Merge the event files of the workers into 'filename' and remove
+        // them (finish() must have been called before).
+        bool merge(const char* filename, event::compression compression);
+
+        // Show memory usage of the workers.
+        void show_memory_usage() const;
+
+      private:
+        // Sleep time (microseconds) when a packet queue is full.
+        static constexpr const useconds_t queue_sleep = 10;
+
+        // Workers.
+        worker* _M_workers[workers::max_workers];
+
+        // Packet queues.
+        worker::packet_queue* _M_queues = nullptr;
+
+        // Number of workers.
+        size_t _M_nworkers = 0;
+
+        // Have the worker threads been started?
+        bool _M_started = false;
+
+        // PCAP file being processed.
+        pcap::reader* _M_reader;
+
+        // Timestamp of the last packet (microseconds).
+        uint64_t _M_last_timestamp = 0;
+
+        // Slabs of the TCP connections of all the workers (the workers are
+        // deleted before the pool).
+        util::slab_pool _M_tcp_pool;
+
+        // Process PCAP file.
+        bool process_file(const char* filename);
+
+        // Process packet.
+        bool process(const void* buf,
+                     size_t len,
+                     size_t wirelen,
+                     const pcap::timeval& ts,
+                     bool ipv6);
+
+        // Process IPv4 packet.
+        static bool ipv4(const void* buf,
+                         size_t len,
+                         size_t wirelen,
+                         const pcap::timeval& ts,
+                         void* user);
+
+        // Process IPv6 packet.
+        static bool ipv6(const void* buf,
+                         size_t len,
+                         size_t wirelen,
+                         const pcap::timeval& ts,
+                         void* user);
+
+        // Wait for the workers to empty their packet queues.
+        void drain();
+
+        // Disable copy constructor and assignment operator.
+        pcap_workers(const pcap_workers&) = delete;
+        pcap_workers& operator=(const pcap_workers&) = delete;
+    };
+
+    inline pcap_workers::~pcap_workers()
+    {
+      for (size_t i = 0; i < _M_nworkers; i++) {
+        delete _M_workers[i];
+      }
+
+      if (_M_queues) {
+        delete [] _M_queues;
+      }
+    }
+
+    inline void pcap_workers::show_memory_usage() const
+    {
+      for (size_t i = 0; i < _M_nworkers; i++) {
+        printf("Worker %zu:\n", i);
+
+        _M_workers[i]->show_memory_usage();
+        _M_workers[i]->show_hash_statistics();
+        _M_workers[i]->show_writer_statistics();
+      }
+
+      if (_M_tcp_pool.max_slabs() > 0) {
+        worker::show_pool(_M_tcp_pool);
+      }
+    }
+
+    inline bool pcap_workers::ipv4(const void* buf,
+                                   size_t len,
+                                   size_t wirelen,
+                                   const pcap::timeval& ts,
+                                   void* user)
+    {
+      return static_cast<pcap_workers*>(user)->process(buf,
+                                                       len,
+                                                       wirelen,
+                                                       ts,
+                                                       false);
+    }
+
+    inline bool pcap_workers::ipv6(const void* buf,
+                                   size_t len,
+                                   size_t wirelen,
+                                   const pcap::timeval& ts,
+                                   void* user)
+    {
+      return static_cast<pcap_workers*>(user)->process(buf,
+                                                       len,
+                                                       wirelen,
+                                                       ts,
+                                                       true);
+    }
+  }
+}
+
+#endif // NET_MON_PCAP_WORKERS_H
@@ -0,0 +1,363 @@
+#ifndef NET_MON_TCP_BUCKETED_TABLE_H
+#define NET_MON_TCP_BUCKETED_TABLE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+#include "util/slab_allocator.h"
+
+namespace net {
+  namespace mon {
+    namespace tcp {
+      // Open addressing hash table of connections.
+      //
+      // The table is an array of buckets of 8 slots, each bucket in its own
+      // cache line. A slot holds a tag (7 bits of the hash of the
+      // connection, with the highest bit set) and the index of the
+      // connection in the allocator of the connections, so a lookup
+      // usually reads one cache line of the table and one connection.
+      //
+      // When a bucket is full, the connection is placed in one of the next
+      // buckets (linear probing) and the overflow counter of each full
+      // bucket is incremented, so a lookup stops at the first bucket without
+      // overflows.
+      //
+      // The connections are allocated by the caller, they must have a
+      // public member 'hash' with the hash of the connection.
+      template<typename Connection>
+      class bucketed_table {
+        public:
+          // Number of slots per bucket.
+          static constexpr const size_t slots_per_bucket = 8;
+
+          // Maximum number of connections (the connections are referenced
+          // by their indices in the allocator).
+          static constexpr const size_t
+                 max_connections = util::slab_allocator::max_index;
+
+          // Connection not found.
+          static constexpr const uint32_t none = UINT32_MAX;
+
+          typedef Connection connection_type;
+
+          // Constructor.
+          bucketed_table() = default;
+
+          // Destructor.
+          ~bucketed_table();
+
+          // Clear.
+          void clear();
+
+          // Initialize.
+          // 'maxconns': maximum number of connections (the table is sized so
+          // it is never more than 7/8 full).
+          // 'allocator': allocator of the connections.
+          bool init(size_t maxconns, const util::slab_allocator* allocator);
+
+          // Find connection (returns the index of the connection or 'none').
+          // 'valid': the connections for which 'valid' returns false are
+          // ignored.
+          // 'nprobes': receives the number of buckets read.
+          template<typename Predicate>
+          uint32_t find(const connection_type& key,
+                        uint32_t hash,
+                        Predicate valid,
+                        uint32_t& nprobes) const;
+
+          // Is there a connection with the hash 'hash' for which 'valid'
+          // returns true?
+          template<typename Predicate>
+          bool contains(uint32_t hash, Predicate valid) const;
+
+          // Insert the connection 'idx' with the hash 'hash' (there must not
+          // be more than 'maxconns' connections).
+          // Returns the number of buckets probed.
+          uint32_t insert(uint32_t hash, uint32_t idx);
+
+          // Erase the connection 'idx' with the hash 'hash'.
+          void erase(uint32_t hash, uint32_t idx);
+
+          // Prefetch the bucket.
+          void prefetch(uint32_t hash) const;
+
+          // Get memory used by the buckets (bytes).
+          size_t memory() const;
+
+        private:
+          // Tag of an empty slot.
+          static constexpr const uint8_t empty = 0;
+
+          struct alignas(64) bucket {
+            // Tags.
+            uint8_t tags[slots_per_bucket];
+
+            // Number of connections which belong to this bucket or to a
+            // previous one and have been placed after this bucket.
+            uint32_t overflows;
+
+            // Indices of the connections.
+            uint32_t slots[slots_per_bucket];
+          };
+
+          static_assert(sizeof(bucket) == 64, "Bucket doesn't fit in a cache "
+                                              "line.");
+
+          // Buckets.
+          bucket* _M_buckets = nullptr;
+
+          // Number of buckets - 1.
+          size_t _M_mask = 0;
+
+          // Allocator of the connections.
+          const util::slab_allocator* _M_allocator = nullptr;
+
+          // Get connection.
+          connection_type* connection(uint32_t idx) const;
+
+          // Get tag.
+          static uint8_t tag(uint32_t hash);
+
+          // Get the slots of 'tags' which have the tag 'tag' (one bit per
+          // slot).
+          static unsigned match(const uint8_t* tags, uint8_t tag);
+
+          // Disable copy constructor and assignment operator.
+          bucketed_table(const bucketed_table&) = delete;
+          bucketed_table& operator=(const bucketed_table&) = delete;
+      };
+
+      template<typename Connection>
+      inline bucketed_table<Connection>::~bucketed_table()
+      {
+        clear();
+      }
+
+      template<typename Connection>
+      void bucketed_table<Connection>::clear()
+      {
+        if (_M_buckets) {
+          free(_M_buckets);
+          _M_buckets = nullptr;
+        }
+
+        _M_mask = 0;
+      }
+
+      template<typename Connection>
+      bool
+      bucketed_table<Connection>::init(size_t maxconns,
+                                       const util::slab_allocator* allocator)
+      {
+        if ((maxconns > 0) && (maxconns <= max_connections)) {
+          // Compute the number of buckets (power of 2) for a maximum load of
+          // 7/8.
+          size_t nbuckets = 1;
+          while (nbuckets * (slots_per_bucket - 1) < maxconns) {
+            nbuckets <<= 1;
+          }
+
+          if ((_M_buckets = static_cast<bucket*>(
+                              aligned_alloc(sizeof(bucket),
+                                            nbuckets * sizeof(bucket))
+                            )) != nullptr) {
+            memset(_M_buckets, 0, nbuckets * sizeof(bucket));
+
+            _M_mask = nbuckets - 1;
+            _M_allocator = allocator;
+
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+      template<typename Connection>
+      template<typename Predicate>
+      inline uint32_t
+      bucketed_table<Connection>::find(const connection_type& key,
+                                       uint32_t hash,
+                                       Predicate valid,
+                                       uint32_t& nprobes) const
+      {
+        const uint8_t t = tag(hash);
+        size_t b = hash & _M_mask;
+
+        nprobes = 0;
+
+        do {
+          const bucket& bucket = _M_buckets[b];
+
+          nprobes++;
+
+          // Check the slots with the same tag.
+          for (unsigned m = match(bucket.tags, t); m != 0; m &= m - 1) {
+            const uint32_t idx = bucket.slots[__builtin_ctz(m)];
+            const connection_type* conn = connection(idx);
+
+            if ((conn->hash == hash) && (key == *conn) && (valid(*conn))) {
+              return idx;
+            }
+          }
+
+          // If no connection has been placed after this bucket...
+          if (bucket.overflows == 0) {
+            return none;
+          }
+
+          b = (b + 1) & _M_mask;
+        } while (true);
+      }
+
+      template<typename Connection>
+      template<typename Predicate>
+      bool bucketed_table<Connection>::contains(uint32_t hash,
+                                                Predicate valid) const
+      {
+        const uint8_t t = tag(hash);
+        size_t b = hash & _M_mask;
+
+        do {
+          const bucket& bucket = _M_buckets[b];
+
+          for (unsigned m = match(bucket.tags, t); m != 0; m &= m - 1) {
+            const connection_type* conn =
+                  connection(bucket.slots[__builtin_ctz(m)]);
+
+            if ((conn->hash == hash) && (valid(*conn))) {
+              return true;
+            }
+          }
+
+          // If no connection has been placed after this bucket...
+          if (bucket.overflows == 0) {
+            return false;
+          }
+
+          b = (b + 1) & _M_mask;
+        } while (true);
+      }
+
+      template<typename Connection>
+      uint32_t bucketed_table<Connection>::insert(uint32_t hash,
+                                                  uint32_t idx)
+      {
+        size_t b = hash & _M_mask;
+        uint32_t nprobes = 0;
+
+        // The table is never full, there is always an empty slot.
+        do {
+          bucket& bucket = _M_buckets[b];
+
+          nprobes++;
+
+          unsigned m;
+          if ((m = match(bucket.tags, empty)) != 0) {
+            unsigned slot = __builtin_ctz(m);
+
+            bucket.tags[slot] = tag(hash);
+            bucket.slots[slot] = idx;
+
+            return nprobes;
+          }
+
+          bucket.overflows++;
+
+          b = (b + 1) & _M_mask;
+        } while (true);
+      }
+
+      template<typename Connection>
+      void bucketed_table<Connection>::erase(uint32_t hash, uint32_t idx)
+      {
+        const uint8_t t = tag(hash);
+        const size_t first = hash & _M_mask;
+        size_t b = first;
+
+        do {
+          bucket& bucket = _M_buckets[b];
+
+          for (unsigned m = match(bucket.tags, t); m != 0; m &= m - 1) {
+            unsigned slot = __builtin_ctz(m);
+
+            if (bucket.slots[slot] == idx) {
+              bucket.tags[slot] = empty;
+
+              // Decrement the overflow counters of the buckets where the
+              // connection couldn't be placed.
+              for (size_t i = first; i != b; i = (i + 1) & _M_mask) {
+                _M_buckets[i].overflows--;
+              }
+
+              return;
+            }
+          }
+
+          b = (b + 1) & _M_mask;
+        } while (true);
+      }
+
+      template<typename Connection>
+      inline void bucketed_table<Connection>::prefetch(uint32_t hash) const
+      {
+        __builtin_prefetch(&_M_buckets[hash & _M_mask]);
+      }
+
+      template<typename Connection>
+      inline size_t bucketed_table<Connection>::memory() const
+      {
+        return (_M_buckets) ? (_M_mask + 1) * sizeof(bucket) : 0;
+      }
+
+      template<typename Connection>
+      inline typename bucketed_table<Connection>::connection_type*
+      bucketed_table<Connection>::connection(uint32_t idx) const
+      {
+        return static_cast<connection_type*>(_M_allocator->object(idx));
+      }
+
+      template<typename Connection>
+      inline uint8_t bucketed_table<Connection>::tag(uint32_t hash)
+      {
+        // The bucket is selected by the lowest bits of the hash.
+        return static_cast<uint8_t>(hash >> 24) | 0x80;
+      }
+
+      template<typename Connection>
+      inline unsigned bucketed_table<Connection>::match(const uint8_t* tags,
+                                                        uint8_t tag)
+      {
+#if defined(__SSE2__)
+        const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(
+                                            tags
+                                          ));
+
+        return static_cast<unsigned>(
+                 _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(tag)))
+               ) & 0xff;
+#else
+        static constexpr const uint64_t lsb = 0x0101010101010101ull;
+        static constexpr const uint64_t low7 = 0x7f7f7f7f7f7f7f7full;
+
+        uint64_t v;
+        memcpy(&v, tags, sizeof(v));
+
+        // Zero the bytes which are equal to 'tag'.
+        v ^= lsb * tag;
+
+        // Set the highest bit of the bytes which are zero.
+        v = ~(((v & low7) + low7) | v | low7);
+
+        // Gather the highest bit of each byte (little endian).
+        return static_cast<unsigned>(((v >> 7) * 0x0102040810204080ull) >> 56);
+#endif
+      }
+    }
+  }
+}
+
+#endif // NET_MON_TCP_BUCKETED_TABLE_H
@@ -3,12 +3,17 @@
 
 #include <stdint.h>
 #include <sys/types.h>
-#include "util/node.h"
+#include "util/timer_wheel.h"
 
 namespace net {
   namespace mon {
     namespace tcp {
-      class connection : private util::node {
+      // Connection.
+      //
+      // The members used when searching a connection (hash, state and last
+      // packet) are at the beginning, the connections are linked by 32-bit
+      // indices.
+      class connection {
         template<typename Connection>
         friend class connections;
 
@@ -44,21 +49,39 @@ namespace net {
             from_addr2 = static_cast<uint8_t>(originator::addr2)
           };
 
+          // Hash of the connection.
+          uint32_t hash;
+
           state s;
 
           originator active_opener;
           originator active_closer;
 
-          uint64_t sent[2];
-
           struct {
-            uint64_t creation;
             uint64_t last_packet;
+            uint64_t creation;
           } timestamp;
 
+        private:
+          // Next connection in the bucket (chained hash table).
+          uint32_t next;
+
+        public:
+          // Timer (timing wheel of the connections).
+          util::timer timer;
+
+          uint64_t sent[2];
+
           // Initialize.
           void init(direction dir, uint16_t size, uint64_t now);
 
+          // Initialize a connection whose establishment has not been seen
+          // (its first packet is in the data transfer state).
+          void adopt(direction dir,
+                     originator opener,
+                     uint16_t size,
+                     uint64_t now);
+
           // Process packet.
           bool process_packet(direction dir,
                               uint8_t flags,
@@ -66,6 +89,20 @@ namespace net {
                               uint64_t now);
       };
 
+      // Traffic of a connection since its previous 'Update TCP connection'
+      // event. When the periodic updates are enabled, it is allocated right
+      // after the connection, so the connections don't grow otherwise.
+      struct update_counters {
+        // Time of the next update (microseconds).
+        uint64_t next;
+
+        // # of bytes sent until the previous update.
+        uint64_t sent[2];
+
+        // # of packets sent since the previous update.
+        uint64_t packets[2];
+      };
+
       inline void connection::init(direction dir, uint16_t size, uint64_t now)
       {
         s = state::connection_requested;
@@ -78,6 +115,22 @@ namespace net {
         timestamp.creation = now;
         timestamp.last_packet = now;
       }
+
+      inline void connection::adopt(direction dir,
+                                    originator opener,
+                                    uint16_t size,
+                                    uint64_t now)
+      {
+        s = state::data_transfer;
+
+        active_opener = opener;
+
+        sent[static_cast<size_t>(dir)] = size;
+        sent[!static_cast<size_t>(dir)] = 0;
+
+        timestamp.creation = now;
+        timestamp.last_packet = now;
+      }
     }
   }
 }
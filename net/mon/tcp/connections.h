@@ -6,13 +6,68 @@
 #include <string.h>
 #include <netinet/in.h>
 #include "net/mon/tcp/connection.h"
+#include "net/mon/tcp/table.h"
+#include "net/mon/tcp/hash_function.h"
+#include "net/mon/tcp/bucketed_table.h"
+#include "net/mon/tcp/untracked_cache.h"
+#include "net/mon/tcp/half_open_table.h"
 #include "net/mon/event/writer.h"
 #include "util/hash.h"
+#include "util/histogram.h"
+#include "util/timer_wheel.h"
+#include "util/slab_allocator.h"
 
 namespace net {
   namespace mon {
     namespace tcp {
       // Connection hash table.
+      //
+      // The connections are allocated from a slab allocator and referenced
+      // by their 32-bit indices in the allocator. They are either kept in
+      // chained buckets (singly-linked lists) or in a bucketed open
+      // addressing table (see 'bucketed_table').
+      //
+      // The chained hash table doubles its size when there are more
+      // connections than buckets and halves it when there are less than
+      // 1/8 (but never below the initial size). The connections are moved
+      // to the new table incrementally, a few buckets per packet and per
+      // call to remove_expired(), so there are no pauses; meanwhile a
+      // connection is in the old table if its bucket has not been moved
+      // yet.
+      //
+      // The connections are also kept in a timing wheel by the time they
+      // expire, so removing the expired connections doesn't have to walk
+      // the hash table. The expiration of a connection is not updated on
+      // every packet: when its timer fires, the connection is either
+      // removed or scheduled again. Optionally, the timer also fires every
+      // 'update_interval' seconds to generate an 'Update TCP connection'
+      // event with the traffic of the connection since the previous one.
+      //
+      // Only a SYN creates a connection, the packets of the connections
+      // which were established before the capture started are ignored. The
+      // hashes of these connections are kept in a small cache (see
+      // 'untracked_cache') so their next packets don't search the hash
+      // table. Optionally, these connections can be adopted: an ACK with
+      // payload which doesn't belong to any connection creates a connection
+      // in the data transfer state.
+      //
+      // Optionally, the SYNs don't create connections: they are kept in a
+      // table of half-open connections of fixed size (see
+      // 'half_open_table') and the connection is created when the
+      // handshake completes, so a SYN flood or a port scan doesn't exhaust
+      // the connections. The connection attempts which fail are counted
+      // and, when there are too many in one second, a 'Half-open TCP
+      // connections' event is generated.
+      //
+      // The hash of the connections is keyed with a random key generated
+      // when the table is initialized, so the buckets of the connections
+      // cannot be predicted. SipHash is designed for it; lookup3 is not,
+      // but its key is not easy to guess; CRC32C is linear, the
+      // connections which collide with one key collide with all of them.
+      // The number of connections compared (chained) or buckets read
+      // (bucketed) per lookup and the length of the chain (chained) or the
+      // number of buckets probed (bucketed) when a connection is inserted
+      // are kept in histograms.
       template<typename Connection>
       class connections {
         public:
@@ -49,9 +104,32 @@ namespace net {
           // Default TCP time wait (seconds).
           static constexpr const uint64_t default_time_wait = 2 * 60;
 
+          // Default number of failed connection attempts per second which
+          // generate a 'Half-open TCP connections' event.
+          static constexpr const uint32_t default_syn_flood_threshold = 100;
+
           typedef Connection connection_type;
           typedef typename connection_type::address_type address_type;
 
+          // Counters of the half-open connections.
+          struct half_open_counters {
+            // # of connection attempts (SYNs).
+            uint64_t attempts;
+
+            // # of connections established.
+            uint64_t established;
+
+            // # of connection attempts reset.
+            uint64_t reset;
+
+            // # of connection attempts not answered (or whose handshake
+            // has not completed).
+            uint64_t unanswered;
+
+            // # of half-open connections replaced before they expired.
+            uint64_t evicted;
+          };
+
           // Constructor.
           connections(event::writer& evwriter);
 
@@ -62,12 +140,41 @@ namespace net {
           void clear();
 
           // Initialize.
+          // 'size': initial (and minimum) number of buckets of the chained
+          // hash table (the bucketed table is sized by 'maxconns').
+          // 'update_interval': interval (seconds) of the 'Update TCP
+          // connection' events (0: disabled).
+          // 'hf': hash function.
+          // 'untracked': number of entries of the cache of untracked
+          // connections (0: disabled).
+          // 'adopt': whether the connections whose establishment has not
+          // been seen are adopted.
+          // 'half_open': number of entries of the table of half-open
+          // connections (0: the SYNs create connections).
+          // 'syn_flood_threshold': number of failed connection attempts per
+          // second which generate a 'Half-open TCP connections' event (0:
+          // no events).
+          // 'node': NUMA node where to allocate the connections (-1: any).
+          // 'pool': pool of slabs shared with the other tables (nullptr:
+          // the memory is only limited by 'maxconns').
           bool init(size_t size,
                     size_t maxconns,
                     uint64_t timeout,
-                    uint64_t time_wait);
+                    uint64_t time_wait,
+                    uint64_t update_interval,
+                    table t,
+                    hash_function hf,
+                    size_t untracked,
+                    bool adopt,
+                    size_t half_open,
+                    uint32_t syn_flood_threshold,
+                    int node,
+                    util::slab_pool* pool);
 
           // Add.
+          // 'hash': symmetric hash of the connection provided by the capture
+          // layer (it must be the same for all the packets of the
+          // connection) or 0 for computing the hash here.
           bool add(const address_type& saddr,
                    in_port_t sport,
                    const address_type& daddr,
@@ -75,16 +182,81 @@ namespace net {
                    uint8_t tcpflags,
                    uint16_t pktsize,
                    uint16_t payload_size,
-                   uint64_t now);
+                   uint64_t now,
+                   uint32_t hash = 0);
+
+          // Prefetch the bucket of the connection.
+          void prefetch(const address_type& saddr,
+                        in_port_t sport,
+                        const address_type& daddr,
+                        in_port_t dport,
+                        uint32_t hash = 0) const;
 
           // Remove expired connections.
           void remove_expired(uint64_t now);
 
+          // Get number of connections.
+          size_t count() const;
+
+          // Get memory used (bytes).
+          size_t memory() const;
+
+          // Get maximum memory used (bytes).
+          size_t max_memory() const;
+
+          // Are the half-open connections kept in their own table?
+          bool half_open_enabled() const;
+
+          // Get the counters of the half-open connections.
+          const half_open_counters& half_open() const;
+
+          // Get the histogram of the number of connections compared
+          // (chained) or buckets read (bucketed) per lookup.
+          const util::histogram& probes() const;
+
+          // Get the histogram of the length of the chains (chained) or of
+          // the number of buckets probed (bucketed) when a connection is
+          // inserted.
+          const util::histogram& chains() const;
+
         private:
-          static constexpr const size_t connection_allocation = 1024;
+          typedef typename half_open_table<address_type>::entry
+                  half_open_entry;
 
-          // Connection hash table.
-          util::node* _M_conns = nullptr;
+          // Resolution of the timers (microseconds).
+          static constexpr const uint64_t timer_resolution = 1000000;
+
+          // Number of buckets moved to the new hash table per packet.
+          static constexpr const size_t rehash_per_packet = 4;
+
+          // Number of buckets moved to the new hash table per call to
+          // remove_expired().
+          static constexpr const size_t rehash_per_call = 4096;
+
+          // Type of hash table.
+          table _M_table = table::chained;
+
+          // Hash function.
+          hash_function _M_hash_function = hash_function::lookup3;
+
+          // Key of the hash function.
+          uint64_t _M_hash_key[2];
+
+          // Number of connections compared / buckets read per lookup.
+          util::histogram _M_probes;
+
+          // Length of the chains / buckets probed per insertion.
+          util::histogram _M_chains;
+
+          // No connection.
+          static constexpr const uint32_t none = UINT32_MAX;
+
+          // Connection hash table (chained): first connection of each
+          // bucket.
+          uint32_t* _M_conns = nullptr;
+
+          // Connection hash table (bucketed).
+          bucketed_table<connection_type> _M_bucketed;
 
           // Size of the hash table.
           size_t _M_size = 0;
@@ -92,14 +264,32 @@ namespace net {
           // Mask (for performing modulo).
           size_t _M_mask;
 
+          // Initial size of the hash table.
+          size_t _M_initial_size;
+
+          // Maximum number of buckets (both hash tables while resizing).
+          size_t _M_max_buckets = 0;
+
+          // Previous hash table (while resizing).
+          uint32_t* _M_old = nullptr;
+
+          // Size of the previous hash table.
+          size_t _M_old_size = 0;
+
+          // Mask of the previous hash table.
+          size_t _M_old_mask;
+
+          // Next bucket of the previous hash table to be moved.
+          size_t _M_rehash_idx;
+
           // Maximum number of connections.
           size_t _M_max_connections;
 
           // Number of connections.
           size_t _M_nconnections = 0;
 
-          // Free connections.
-          connection_type* _M_free = nullptr;
+          // Allocator of the connections.
+          util::slab_allocator _M_allocator;
 
           // Connection timeout.
           uint64_t _M_timeout;
@@ -107,17 +297,125 @@ namespace net {
           // Time wait.
           uint64_t _M_time_wait;
 
+          // Interval of the 'Update TCP connection' events (0: disabled).
+          uint64_t _M_update_interval = 0;
+
+          // Timers of the connections.
+          util::timer_wheel<connection_type> _M_timers;
+
+          // Cache of untracked connections.
+          untracked_cache _M_untracked;
+
+          // Adopt the connections whose establishment has not been seen?
+          bool _M_adopt = false;
+
+          // Half-open connections.
+          half_open_table<address_type> _M_half_open;
+
+          // Number of failed connection attempts per second which generate
+          // a 'Half-open TCP connections' event (0: no events).
+          uint32_t _M_syn_flood_threshold = 0;
+
+          // Counters of the half-open connections.
+          half_open_counters _M_half_open_counters;
+
+          // Failed connection attempts of the current second.
+          struct {
+            // Current second.
+            uint64_t second;
+
+            // Counters.
+            half_open_counters counters;
+
+            // Last failed connection attempt.
+            half_open_entry sample;
+          } _M_period;
+
           // Event writer.
           event::writer& _M_evwriter;
 
-          // Erase connections.
-          static void erase(util::node* header);
-
           // Get free connection.
           connection_type* get_free_connection();
 
-          // Allocate connections.
-          bool allocate_connections(size_t count);
+          // Get connection.
+          connection_type* connection(uint32_t idx) const;
+
+          // Get the bucket of the chained hash table for the hash 'hash'.
+          uint32_t* bucket(uint32_t hash) const;
+
+          // Start resizing the chained hash table.
+          bool resize(size_t size);
+
+          // Move up to 'nbuckets' buckets of the previous hash table to the
+          // new one.
+          void rehash(size_t nbuckets);
+
+          // Compute the hash of the connection.
+          uint32_t compute_hash(const address_type& addr1,
+                                in_port_t port1,
+                                const address_type& addr2,
+                                in_port_t port2) const;
+
+          // Has the connection not been closed?
+          static bool open(const connection_type& conn);
+
+          // Any connection (predicate).
+          static bool any(const connection_type& conn);
+
+          // Is there a connection with the hash 'hash' for which 'valid'
+          // returns true?
+          template<typename Predicate>
+          bool contains(uint32_t hash, Predicate valid) const;
+
+          // The packet doesn't belong to any connection: add its hash to
+          // the cache of untracked connections.
+          void untracked(uint32_t hash, uint64_t now);
+
+          // Create a connection for a packet which doesn't belong to any
+          // connection (only a SYN or, if the connections are adopted, an
+          // ACK with payload creates a connection). 'idx' receives the
+          // index of the new connection or 'none'; the caller inserts the
+          // connection in the hash table.
+          // Returns false if there are too many connections.
+          bool create(const address_type& addr1,
+                      in_port_t port1,
+                      const address_type& addr2,
+                      in_port_t port2,
+                      uint8_t tcpflags,
+                      uint16_t pktsize,
+                      uint16_t payload_size,
+                      connection::direction dir,
+                      uint64_t now,
+                      uint32_t hash,
+                      uint32_t& idx);
+
+          // Add SYN to the table of half-open connections.
+          void add_half_open(const address_type& addr1,
+                             in_port_t port1,
+                             const address_type& addr2,
+                             in_port_t port2,
+                             uint16_t pktsize,
+                             connection::direction dir,
+                             uint64_t now,
+                             uint32_t hash);
+
+          // Process a packet of a half-open connection. 'idx' receives the
+          // index of the new connection if the handshake has completed.
+          // Returns false if there are too many connections.
+          bool handshake(half_open_entry* e,
+                         uint8_t tcpflags,
+                         uint16_t pktsize,
+                         uint16_t payload_size,
+                         connection::direction dir,
+                         uint64_t now,
+                         uint32_t& idx);
+
+          // The connection attempt has failed.
+          void failed(const half_open_entry* e, bool reset);
+
+          // Start a new second of failed connection attempts (if 'now' is
+          // in a different second).
+          void next_period(uint64_t now);
 
           // Add.
           bool add(const address_type& addr1,
@@ -128,10 +426,44 @@ namespace net {
                    uint16_t pktsize,
                    uint16_t payload_size,
                    connection::direction dir,
-                   uint64_t now);
+                   uint64_t now,
+                   uint32_t hash);
+
+          // Add (bucketed hash table).
+          bool add_bucketed(const address_type& addr1,
+                            in_port_t port1,
+                            const address_type& addr2,
+                            in_port_t port2,
+                            uint8_t tcpflags,
+                            uint16_t pktsize,
+                            uint16_t payload_size,
+                            connection::direction dir,
+                            uint64_t now,
+                            uint32_t hash);
 
           // Remove connection.
-          void remove(connection_type* conn, uint64_t now);
+          void remove(connection_type* conn, uint32_t idx, uint64_t now);
+
+          // Get the time when the connection expires (microseconds).
+          uint64_t expiration(const connection_type* conn) const;
+
+          // Get the time when the timer of the connection has to fire: when
+          // the connection expires or its next update is due.
+          uint64_t deadline(const connection_type* conn) const;
+
+          // Get the counters of the periodic updates of the connection.
+          update_counters* update(const connection_type* conn) const;
+
+          // Count packet (periodic updates).
+          void count_packet(const connection_type* conn,
+                            connection::direction dir);
+
+          // Add timer of a new connection (and schedule its first update).
+          void add_timer(connection_type* conn, uint32_t idx, uint64_t now);
+
+          // The connection has been closed: reschedule its timer with the
+          // TCP time wait.
+          void closed(connection_type* conn, uint32_t idx);
 
           // Generate 'Begin TCP connection' event.
           void event_tcp_begin(const connection_type* conn, uint64_t now);
@@ -149,6 +481,14 @@ namespace net {
           // Generate 'End TCP connection' event.
           void event_tcp_end(const connection_type* conn, uint64_t now);
 
+          // Generate 'Half-open TCP connections' event.
+          void event_tcp_half_open();
+
+          // Generate 'Update TCP connection' event (if the connection has
+          // sent packets since the previous one) and schedule the next
+          // update.
+          void event_tcp_update(const connection_type* conn, uint64_t now);
+
           // Disable copy constructor and assignment operator.
           connections(const connections&) = delete;
           connections& operator=(const connections&) = delete;
@@ -156,7 +496,8 @@ namespace net {
 
       template<typename Connection>
       inline connections<Connection>::connections(event::writer& evwriter)
-        : _M_evwriter(evwriter)
+        : _M_timers(_M_allocator),
+          _M_evwriter(evwriter)
       {
       }
 
@@ -170,31 +511,46 @@ namespace net {
       void connections<Connection>::clear()
       {
         if (_M_conns) {
-          for (size_t i = 0; i < _M_size; i++) {
-            erase(&_M_conns[i]);
-          }
-
           free(_M_conns);
           _M_conns = nullptr;
         }
 
-        _M_size = 0;
-        _M_nconnections = 0;
+        if (_M_old) {
+          free(_M_old);
+          _M_old = nullptr;
+        }
 
-        while (_M_free) {
-          connection_type* next = static_cast<connection_type*>(_M_free->next);
+        _M_old_size = 0;
+        _M_max_buckets = 0;
 
-          free(_M_free);
+        _M_allocator.clear();
 
-          _M_free = next;
-        }
+        _M_bucketed.clear();
+
+        _M_timers.clear();
+
+        _M_untracked.clear();
+
+        _M_half_open.clear();
+
+        _M_size = 0;
+        _M_nconnections = 0;
       }
 
       template<typename Connection>
       bool connections<Connection>::init(size_t size,
                                          size_t maxconns,
                                          uint64_t timeout,
-                                         uint64_t time_wait)
+                                         uint64_t time_wait,
+                                         uint64_t update_interval,
+                                         table t,
+                                         hash_function hf,
+                                         size_t untracked,
+                                         bool adopt,
+                                         size_t half_open,
+                                         uint32_t syn_flood_threshold,
+                                         int node,
+                                         util::slab_pool* pool)
       {
         if ((size >= min_size) &&
             (size <= max_size) &&
@@ -203,27 +559,67 @@ namespace net {
             (maxconns <= max_connections) &&
             (timeout >= min_timeout) &&
             (time_wait >= min_time_wait)) {
-          // Allocate memory for the connections.
-          if ((_M_conns = static_cast<util::node*>(
-                            malloc(size * sizeof(util::node))
+          _M_table = t;
+
+          _M_hash_function = hf;
+
+          if (!util::hash::random_key(_M_hash_key, sizeof(_M_hash_key))) {
+            return false;
+          }
+
+          _M_probes.clear();
+          _M_chains.clear();
+
+          _M_timeout = timeout * 1000000ull;
+          _M_time_wait = time_wait * 1000000ull;
+
+          _M_update_interval = update_interval * 1000000ull;
+
+          // The counters of the periodic updates follow the connection.
+          static_assert(sizeof(connection_type) %
+                        alignof(update_counters) == 0,
+                        "Misaligned update counters");
+
+          const size_t object_size = sizeof(connection_type) +
+                                     ((update_interval > 0) ?
+                                       sizeof(update_counters) :
+                                       0);
+
+          if ((!_M_allocator.init(object_size, node, pool)) ||
+              (!_M_untracked.init(untracked)) ||
+              (!_M_half_open.init(half_open))) {
+            return false;
+          }
+
+          _M_adopt = adopt;
+
+          _M_syn_flood_threshold = syn_flood_threshold;
+
+          memset(&_M_half_open_counters, 0, sizeof(_M_half_open_counters));
+          memset(&_M_period, 0, sizeof(_M_period));
+
+          _M_max_connections = maxconns;
+
+          // Bucketed hash table?
+          if (t == table::bucketed) {
+            return _M_bucketed.init(maxconns, &_M_allocator);
+          }
+
+          // Allocate memory for the hash table.
+          if ((_M_conns = static_cast<uint32_t*>(
+                            malloc(size * sizeof(uint32_t))
                           )) != nullptr) {
             for (size_t i = 0; i < size; i++) {
-              _M_conns[i].prev = &_M_conns[i];
-              _M_conns[i].next = &_M_conns[i];
+              _M_conns[i] = none;
             }
 
-            _M_max_connections = maxconns;
+            _M_size = size;
+            _M_mask = size - 1;
 
-            // Allocate free connections.
-            if (allocate_connections(connection_allocation)) {
-              _M_size = size;
-              _M_mask = size - 1;
+            _M_initial_size = size;
+            _M_max_buckets = size;
 
-              _M_timeout = timeout * 1000000ull;
-              _M_time_wait = time_wait * 1000000ull;
-
-              return true;
-            }
+            return true;
           }
         }
 
@@ -238,7 +634,8 @@ namespace net {
                                                uint8_t tcpflags,
                                                uint16_t pktsize,
                                                uint16_t payload_size,
-                                               uint64_t now)
+                                               uint64_t now,
+                                               uint32_t hash)
       {
         if (sport < dport) {
           return add(saddr,
@@ -249,7 +646,8 @@ namespace net {
                      pktsize,
                      payload_size,
                      connection::direction::from_addr1,
-                     now);
+                     now,
+                     hash);
         } else if (sport > dport) {
           return add(daddr,
                      dport,
@@ -259,7 +657,8 @@ namespace net {
                      pktsize,
                      payload_size,
                      connection::direction::from_addr2,
-                     now);
+                     now,
+                     hash);
         } else {
           int diff;
           if ((diff = saddr.compare(daddr)) <= 0) {
@@ -271,7 +670,8 @@ namespace net {
                        pktsize,
                        payload_size,
                        connection::direction::from_addr1,
-                       now);
+                       now,
+                       hash);
           } else {
             return add(daddr,
                        dport,
@@ -281,94 +681,206 @@ namespace net {
                        pktsize,
                        payload_size,
                        connection::direction::from_addr2,
-                       now);
+                       now,
+                       hash);
           }
         }
       }
 
+      template<typename Connection>
+      inline void connections<Connection>::prefetch(const address_type& saddr,
+                                                    in_port_t sport,
+                                                    const address_type& daddr,
+                                                    in_port_t dport,
+                                                    uint32_t hash) const
+      {
+        if (hash == 0) {
+          // Same order of the addresses and ports as add().
+          hash = ((sport < dport) ||
+                  ((sport == dport) && (saddr.compare(daddr) <= 0))) ?
+                   compute_hash(saddr, sport, daddr, dport) :
+                   compute_hash(daddr, dport, saddr, sport);
+        }
+
+        if (_M_table == table::chained) {
+          __builtin_prefetch(bucket(hash));
+        } else {
+          _M_bucketed.prefetch(hash);
+        }
+
+        _M_untracked.prefetch(hash);
+      }
+
       template<typename Connection>
       void connections<Connection>::remove_expired(uint64_t now)
       {
-        for (size_t i = 0; i < _M_size; i++) {
-          util::node* header = &_M_conns[i];
-          connection_type* conn = static_cast<connection_type*>(header->next);
+        const uint64_t tick = now / timer_resolution;
 
-          while (static_cast<util::node*>(conn) != header) {
-            // If the connection has not been closed...
-            if (conn->s != connection::state::closed) {
-              // If the connection has not expired...
-              if (conn->timestamp.last_packet + _M_timeout > now) {
-                conn = static_cast<connection_type*>(conn->next);
-              } else {
-                connection_type* next =
-                                 static_cast<connection_type*>(conn->next);
+        // Connections which expire later in the current tick (they are
+        // added back at the end, otherwise they would be returned again).
+        uint32_t later = none;
 
-                remove(conn, now);
+        uint32_t idx;
+        while ((idx = _M_timers.expired(tick)) != none) {
+          connection_type* conn = connection(idx);
 
-                conn = next;
-              }
-            } else if (conn->timestamp.last_packet + _M_time_wait >
-                       now) {
-              conn = static_cast<connection_type*>(conn->next);
-            } else {
-              connection_type* next = static_cast<connection_type*>(conn->next);
+          // If the connection has expired...
+          if (expiration(conn) <= now) {
+            remove(conn, idx, now);
+            continue;
+          }
 
-              remove(conn, now);
+          // If the next update is due...
+          if ((_M_update_interval > 0) &&
+              (conn->s != connection::state::closed) &&
+              (update(conn)->next <= now)) {
+            // Generate 'Update TCP connection' event.
+            event_tcp_update(conn, now);
+          }
 
-              conn = next;
-            }
+          uint64_t expires = deadline(conn);
+
+          if (expires / timer_resolution > tick) {
+            // The connection has received packets since its timer was set
+            // (or the update has been generated).
+            _M_timers.modify(idx, expires / timer_resolution);
+          } else {
+            _M_timers.remove(idx);
+
+            conn->timer.next = later;
+            later = idx;
           }
         }
+
+        while (later != none) {
+          idx = later;
+          later = connection(idx)->timer.next;
+
+          _M_timers.add(idx, tick);
+        }
+
+        // Generate the event of the failed connection attempts of the
+        // previous second (if any).
+        if (_M_half_open.enabled()) {
+          next_period(now);
+        }
+
+        if (_M_table == table::chained) {
+          // If the hash table is being resized...
+          if (_M_old) {
+            rehash(rehash_per_call);
+          } else if ((_M_nconnections < (_M_size / 8)) &&
+                     (_M_size > _M_initial_size)) {
+            resize(_M_size / 2);
+          }
+        }
+      }
+
+      template<typename Connection>
+      inline size_t connections<Connection>::count() const
+      {
+        return _M_nconnections;
       }
 
       template<typename Connection>
-      inline void connections<Connection>::erase(util::node* header)
+      inline size_t connections<Connection>::memory() const
       {
-        util::node* n = header->next;
+        return ((_M_table == table::chained) ?
+                  (_M_size + _M_old_size) * sizeof(uint32_t) :
+                  _M_bucketed.memory()) +
+               _M_allocator.memory() +
+               _M_untracked.memory() +
+               _M_half_open.memory();
+      }
 
-        while (n != header) {
-          util::node* next = n->next;
+      template<typename Connection>
+      inline size_t connections<Connection>::max_memory() const
+      {
+        return ((_M_table == table::chained) ?
+                  _M_max_buckets * sizeof(uint32_t) :
+                  _M_bucketed.memory()) +
+               _M_allocator.max_memory() +
+               _M_untracked.memory() +
+               _M_half_open.memory();
+      }
 
-          free(n);
+      template<typename Connection>
+      inline bool connections<Connection>::half_open_enabled() const
+      {
+        return _M_half_open.enabled();
+      }
 
-          n = next;
-        }
+      template<typename Connection>
+      inline const typename connections<Connection>::half_open_counters&
+      connections<Connection>::half_open() const
+      {
+        return _M_half_open_counters;
+      }
+
+      template<typename Connection>
+      inline const util::histogram& connections<Connection>::probes() const
+      {
+        return _M_probes;
+      }
+
+      template<typename Connection>
+      inline const util::histogram& connections<Connection>::chains() const
+      {
+        return _M_chains;
       }
 
       template<typename Connection>
       inline typename connections<Connection>::connection_type*
       connections<Connection>::get_free_connection()
       {
-        if ((_M_free) || (allocate_connections(connection_allocation))) {
-          connection_type* conn = _M_free;
+        return (_M_nconnections < _M_max_connections) ?
+                 static_cast<connection_type*>(_M_allocator.allocate()) :
+                 nullptr;
+      }
 
-          _M_free = static_cast<connection_type*>(_M_free->next);
+      template<typename Connection>
+      inline typename connections<Connection>::connection_type*
+      connections<Connection>::connection(uint32_t idx) const
+      {
+        return static_cast<connection_type*>(_M_allocator.object(idx));
+      }
 
-          return conn;
+      template<typename Connection>
+      inline uint32_t* connections<Connection>::bucket(uint32_t hash) const
+      {
+        // If the hash table is being resized...
+        if (_M_old) {
+          size_t idx = hash & _M_old_mask;
+
+          // If the bucket has not been moved yet...
+          if (idx >= _M_rehash_idx) {
+            return &_M_old[idx];
+          }
         }
 
-        return nullptr;
+        return &_M_conns[hash & _M_mask];
       }
 
       template<typename Connection>
-      bool connections<Connection>::allocate_connections(size_t count)
+      bool connections<Connection>::resize(size_t size)
       {
-        size_t diff;
-        if ((diff = _M_max_connections - _M_nconnections) > 0) {
-          if (diff < count) {
-            count = diff;
-          }
-
-          for (size_t i = 0; i < count; i++) {
-            connection_type* conn;
-            if ((conn = static_cast<connection_type*>(
-                          malloc(sizeof(connection_type))
-                        )) != nullptr) {
-              conn->next = _M_free;
-              _M_free = conn;
-            } else {
-              return (_M_free != nullptr);
-            }
+        uint32_t* conns;
+        if ((conns = static_cast<uint32_t*>(
+                       malloc(size * sizeof(uint32_t))
+                     )) != nullptr) {
+          // The buckets of the new hash table are initialized as the
+          // buckets of the previous one are moved.
+          _M_old = _M_conns;
+          _M_old_size = _M_size;
+          _M_old_mask = _M_mask;
+          _M_rehash_idx = 0;
+
+          _M_conns = conns;
+          _M_size = size;
+          _M_mask = size - 1;
+
+          if (_M_size + _M_old_size > _M_max_buckets) {
+            _M_max_buckets = _M_size + _M_old_size;
           }
 
           return true;
@@ -377,6 +889,88 @@ namespace net {
         return false;
       }
 
+      template<typename Connection>
+      void connections<Connection>::rehash(size_t nbuckets)
+      {
+        size_t end = _M_rehash_idx + nbuckets;
+        if (end > _M_old_size) {
+          end = _M_old_size;
+        }
+
+        for (; _M_rehash_idx < end; _M_rehash_idx++) {
+          const size_t idx = _M_rehash_idx;
+
+          // Initialize the buckets of the new hash table which receive the
+          // connections of this bucket (when shrinking, the bucket 'idx'
+          // of the new hash table also receives the connections of the
+          // bucket 'idx + _M_size').
+          if (_M_size > _M_old_size) {
+            _M_conns[idx] = none;
+            _M_conns[idx + _M_old_size] = none;
+          } else if (idx < _M_size) {
+            _M_conns[idx] = none;
+          }
+
+          uint32_t i = _M_old[idx];
+          while (i != none) {
+            connection_type* conn = connection(i);
+            uint32_t next = conn->next;
+
+            // Add connection at the beginning of its bucket.
+            uint32_t* head = &_M_conns[conn->hash & _M_mask];
+            conn->next = *head;
+            *head = i;
+
+            i = next;
+          }
+        }
+
+        // If all the buckets have been moved...
+        if (_M_rehash_idx == _M_old_size) {
+          free(_M_old);
+          _M_old = nullptr;
+          _M_old_size = 0;
+        }
+      }
+
+      template<typename Connection>
+      inline uint32_t
+      connections<Connection>::compute_hash(const address_type& addr1,
+                                            in_port_t port1,
+                                            const address_type& addr2,
+                                            in_port_t port2) const
+      {
+        static constexpr const size_t
+               nwords = sizeof(address_type) / sizeof(uint32_t);
+
+        // Addresses and ports.
+        uint32_t key[(2 * nwords) + 1];
+        memcpy(key, &addr1, sizeof(address_type));
+        memcpy(key + nwords, &addr2, sizeof(address_type));
+        key[2 * nwords] = (static_cast<uint32_t>(port1) << 16) | port2;
+
+        switch (_M_hash_function) {
+          case hash_function::crc32c:
+            return util::hash::crc32c(key,
+                                      sizeof(key),
+                                      static_cast<uint32_t>(_M_hash_key[0]));
+          case hash_function::siphash:
+            return static_cast<uint32_t>(
+                     util::hash::siphash13(key, sizeof(key), _M_hash_key)
+                   );
+          default:
+            return util::hash::hashword(key,
+                                        2 * nwords + 1,
+                                        static_cast<uint32_t>(_M_hash_key[0]));
+        }
+      }
+
+      template<typename Connection>
+      inline bool connections<Connection>::open(const connection_type& conn)
+      {
+        return (conn.s != connection::state::closed);
+      }
+
       template<typename Connection>
       bool connections<Connection>::add(const address_type& addr1,
                                         in_port_t port1,
@@ -386,31 +980,73 @@ namespace net {
                                         uint16_t pktsize,
                                         uint16_t payload_size,
                                         connection::direction dir,
-                                        uint64_t now)
+                                        uint64_t now,
+                                        uint32_t hash)
       {
-        static constexpr const uint32_t initval = 0;
+        if (hash == 0) {
+          hash = compute_hash(addr1, port1, addr2, port2);
+        }
+
+        // If the packet is not a SYN and its connection is known not to be
+        // in the hash table...
+        if (((tcpflags & connection::flag_mask) != connection::syn) &&
+            (_M_untracked.find(hash, now))) {
+          // Ignore packet.
+          return true;
+        }
 
-        uint32_t bucket = util::hash::hash_3words(
-                            addr1.hash(),
-                            addr2.hash(),
-                            (static_cast<uint32_t>(port1) << 16) | port2,
-                            initval
-                          ) & _M_mask;
+        // Bucketed hash table?
+        if (_M_table == table::bucketed) {
+          return add_bucketed(addr1,
+                              port1,
+                              addr2,
+                              port2,
+                              tcpflags,
+                              pktsize,
+                              payload_size,
+                              dir,
+                              now,
+                              hash);
+        }
+
+        // If the hash table is being resized...
+        if (_M_old) {
+          rehash(rehash_per_packet);
+        }
 
         // Search connection.
-        util::node* header = &_M_conns[bucket];
-        connection_type* conn = static_cast<connection_type*>(header->next);
+        uint32_t* head = bucket(hash);
+        uint32_t idx = *head;
 
         connection_type c(addr1, port1, addr2, port2);
+        connection_type* conn;
+
+        // Number of connections compared and number of connections of the
+        // bucket (the removed connections are not counted).
+        uint32_t nprobes = 0;
+        uint32_t length = 0;
+
+        while (idx != none) {
+          conn = connection(idx);
+
+          nprobes++;
 
-        while (static_cast<util::node*>(conn) != header) {
           // If the connection has not been closed...
           if (conn->s != connection::state::closed) {
             // If the connection has not expired...
             if (conn->timestamp.last_packet + _M_timeout > now) {
               // If it is the connection we are looking for...
-              if (c == *conn) {
+              if ((conn->hash == hash) && (c == *conn)) {
+                _M_probes.add(nprobes);
+
                 if (conn->process_packet(dir, tcpflags, pktsize, now)) {
+                  count_packet(conn, dir);
+
+                  // If the connection has been closed...
+                  if (conn->s == connection::state::closed) {
+                    closed(conn, idx);
+                  }
+
                   // If there is payload...
                   if (payload_size > 0) {
                     // Generate 'TCP data' event.
@@ -427,81 +1063,624 @@ namespace net {
                   return true;
                 }
 
-                connection_type* next =
-                                   static_cast<connection_type*>(conn->next);
-
-                remove(conn, now);
-
-                conn = next;
+                remove(conn, idx, now);
 
                 // Ignore invalid packet.
                 return true;
               } else {
-                conn = static_cast<connection_type*>(conn->next);
+                idx = conn->next;
+                length++;
               }
             } else {
-              connection_type* next = static_cast<connection_type*>(conn->next);
+              uint32_t next = conn->next;
 
-              remove(conn, now);
+              remove(conn, idx, now);
 
-              conn = next;
+              idx = next;
             }
           } else if (conn->timestamp.last_packet + _M_time_wait >
                      now) {
-            conn = static_cast<connection_type*>(conn->next);
+            idx = conn->next;
+            length++;
           } else {
-            connection_type* next = static_cast<connection_type*>(conn->next);
+            uint32_t next = conn->next;
 
-            remove(conn, now);
+            remove(conn, idx, now);
 
-            conn = next;
+            idx = next;
           }
         }
 
+        _M_probes.add(nprobes);
+
         // Connection not found.
+        if (!create(addr1,
+                    port1,
+                    addr2,
+                    port2,
+                    tcpflags,
+                    pktsize,
+                    payload_size,
+                    dir,
+                    now,
+                    hash,
+                    idx)) {
+          return false;
+        }
 
-        // SYN?
-        if ((tcpflags & connection::flag_mask) == connection::syn) {
-          if ((conn = get_free_connection()) != nullptr) {
-            conn->prev = header;
-            conn->next = header->next;
+        // If a connection has been created...
+        if (idx != none) {
+          connection(idx)->next = *head;
+          *head = idx;
 
-            header->next->prev = conn;
-            header->next = conn;
+          _M_chains.add(length + 1);
 
-            conn->assign(addr1, port1, addr2, port2);
+          // If there are more connections than buckets, double the size of
+          // the hash table.
+          if ((++_M_nconnections > _M_size) &&
+              (!_M_old) &&
+              (_M_size < max_size)) {
+            resize(_M_size * 2);
+          }
+        }
 
-            conn->init(dir, pktsize, now);
+        return true;
+      }
 
-            // Generate 'Begin TCP connection' event.
-            event_tcp_begin(conn, now);
+      template<typename Connection>
+      bool connections<Connection>::add_bucketed(const address_type& addr1,
+                                                 in_port_t port1,
+                                                 const address_type& addr2,
+                                                 in_port_t port2,
+                                                 uint8_t tcpflags,
+                                                 uint16_t pktsize,
+                                                 uint16_t payload_size,
+                                                 connection::direction dir,
+                                                 uint64_t now,
+                                                 uint32_t hash)
+      {
+        connection_type c(addr1, port1, addr2, port2);
 
-            _M_nconnections++;
-          } else {
-            return false;
+        // Search connection (the closed connections are ignored).
+        connection_type* conn;
+        uint32_t idx;
+        uint32_t nprobes;
+        idx = _M_bucketed.find(c, hash, open, nprobes);
+
+        _M_probes.add(nprobes);
+
+        if (idx != none) {
+          conn = connection(idx);
+
+          // If the connection has not expired...
+          if (conn->timestamp.last_packet + _M_timeout > now) {
+            if (conn->process_packet(dir, tcpflags, pktsize, now)) {
+              count_packet(conn, dir);
+
+              // If the connection has been closed...
+              if (conn->s == connection::state::closed) {
+                closed(conn, idx);
+              }
+
+              // If there is payload...
+              if (payload_size > 0) {
+                // Generate 'TCP data' event.
+                event_tcp_data(addr1,
+                               port1,
+                               addr2,
+                               port2,
+                               payload_size,
+                               dir,
+                               now,
+                               conn->timestamp.creation);
+              }
+            } else {
+              // Ignore invalid packet.
+              remove(conn, idx, now);
+            }
+
+            return true;
           }
+
+          remove(conn, idx, now);
+        }
+
+        // Connection not found.
+        if (!create(addr1,
+                    port1,
+                    addr2,
+                    port2,
+                    tcpflags,
+                    pktsize,
+                    payload_size,
+                    dir,
+                    now,
+                    hash,
+                    idx)) {
+          return false;
+        }
+
+        // If a connection has been created...
+        if (idx != none) {
+          _M_chains.add(_M_bucketed.insert(hash, idx));
+
+          _M_nconnections++;
         }
 
         return true;
       }
 
+      template<typename Connection>
+      inline bool connections<Connection>::any(const connection_type& conn)
+      {
+        return true;
+      }
+
+      template<typename Connection>
+      template<typename Predicate>
+      bool connections<Connection>::contains(uint32_t hash,
+                                             Predicate valid) const
+      {
+        if (_M_table == table::chained) {
+          for (uint32_t idx = *bucket(hash); idx != none;) {
+            const connection_type* conn = connection(idx);
+
+            if ((conn->hash == hash) && (valid(*conn))) {
+              return true;
+            }
+
+            idx = conn->next;
+          }
+
+          return false;
+        }
+
+        return _M_bucketed.contains(hash, valid);
+      }
+
+      template<typename Connection>
+      inline void connections<Connection>::untracked(uint32_t hash,
+                                                     uint64_t now)
+      {
+        // The hash is not added if there is an open or half-open connection
+        // with the same hash (its packets would be ignored).
+        if ((_M_untracked.enabled()) &&
+            (!contains(hash, open)) &&
+            (!_M_half_open.contains(hash, now))) {
+          _M_untracked.add(hash, now);
+        }
+      }
+
+      template<typename Connection>
+      bool connections<Connection>::create(const address_type& addr1,
+                                           in_port_t port1,
+                                           const address_type& addr2,
+                                           in_port_t port2,
+                                           uint8_t tcpflags,
+                                           uint16_t pktsize,
+                                           uint16_t payload_size,
+                                           connection::direction dir,
+                                           uint64_t now,
+                                           uint32_t hash,
+                                           uint32_t& idx)
+      {
+        idx = none;
+
+        const uint8_t flags = tcpflags & connection::flag_mask;
+
+        // If the half-open connections are kept in their own table...
+        if (_M_half_open.enabled()) {
+          next_period(now);
+
+          half_open_entry* e;
+          if ((e = _M_half_open.find(addr1,
+                                     port1,
+                                     addr2,
+                                     port2,
+                                     hash,
+                                     now)) != nullptr) {
+            return handshake(e,
+                             tcpflags,
+                             pktsize,
+                             payload_size,
+                             dir,
+                             now,
+                             idx);
+          }
+
+          if (flags == connection::syn) {
+            add_half_open(addr1, port1, addr2, port2, pktsize, dir, now, hash);
+            return true;
+          }
+        }
+
+        // If the packet can't create a connection (only the ACKs with
+        // payload are adopted, not while there is a connection with the
+        // same hash, which might be a closed connection in time wait)...
+        if ((flags != connection::syn) &&
+            ((!_M_adopt) ||
+             (flags != connection::ack) ||
+             (payload_size == 0) ||
+             (contains(hash, any)))) {
+          untracked(hash, now);
+
+          // Ignore packet.
+          return true;
+        }
+
+        connection_type* conn;
+        if ((conn = get_free_connection()) == nullptr) {
+          if (flags != connection::syn) {
+            untracked(hash, now);
+          }
+
+          return false;
+        }
+
+        idx = _M_allocator.index(conn);
+
+        conn->hash = hash;
+
+        conn->assign(addr1, port1, addr2, port2);
+
+        if (flags == connection::syn) {
+          conn->init(dir, pktsize, now);
+
+          // The hash might be in the cache of untracked connections (the
+          // SYNs don't check the cache).
+          _M_untracked.erase(hash);
+        } else {
+          // The client is assumed to be the host with the highest
+          // (ephemeral) port.
+          const uint16_t p1 = ntohs(port1);
+          const uint16_t p2 = ntohs(port2);
+
+          conn->adopt(dir,
+                      (p1 < p2) ? connection::originator::addr2 :
+                      (p1 > p2) ? connection::originator::addr1 :
+                                  static_cast<connection::originator>(dir),
+                      pktsize,
+                      now);
+        }
+
+        add_timer(conn, idx, now);
+
+        count_packet(conn, dir);
+
+        // Generate 'Begin TCP connection' event.
+        event_tcp_begin(conn, now);
+
+        // If the connection has been adopted...
+        if (flags != connection::syn) {
+          // Generate 'TCP data' event.
+          event_tcp_data(addr1,
+                         port1,
+                         addr2,
+                         port2,
+                         payload_size,
+                         dir,
+                         now,
+                         now);
+        }
+
+        return true;
+      }
+
+      template<typename Connection>
+      void connections<Connection>::add_half_open(const address_type& addr1,
+                                                  in_port_t port1,
+                                                  const address_type& addr2,
+                                                  in_port_t port2,
+                                                  uint16_t pktsize,
+                                                  connection::direction dir,
+                                                  uint64_t now,
+                                                  uint32_t hash)
+      {
+        half_open_entry* e = _M_half_open.add(hash);
+
+        // If the entry has a half-open connection (the expired entries
+        // have been erased by next_period())...
+        if (e->expires != 0) {
+          _M_half_open_counters.evicted++;
+
+          failed(e, false);
+        }
+
+        e->creation = now;
+
+        e->addr1 = addr1;
+        e->addr2 = addr2;
+        e->port1 = port1;
+        e->port2 = port2;
+
+        e->hash = hash;
+
+        e->size[0] = pktsize;
+        e->size[1] = 0;
+
+        e->dir = dir;
+
+        e->answered = false;
+
+        _M_half_open.touch(e, now);
+
+        _M_half_open_counters.attempts++;
+        _M_period.counters.attempts++;
+
+        // The hash might be in the cache of untracked connections (the
+        // SYNs don't check the cache).
+        _M_untracked.erase(hash);
+      }
+
+      template<typename Connection>
+      bool connections<Connection>::handshake(half_open_entry* e,
+                                              uint8_t tcpflags,
+                                              uint16_t pktsize,
+                                              uint16_t payload_size,
+                                              connection::direction dir,
+                                              uint64_t now,
+                                              uint32_t& idx)
+      {
+        switch (tcpflags & connection::flag_mask) {
+          case connection::syn:
+            // Retransmission?
+            if (dir == e->dir) {
+              _M_half_open.touch(e, now);
+              return true;
+            }
+
+            break;
+          case connection::syn | connection::ack:
+            if (dir != e->dir) {
+              // If it is not a retransmission...
+              if (!e->answered) {
+                e->size[1] = pktsize;
+                e->answered = true;
+              }
+
+              _M_half_open.touch(e, now);
+
+              return true;
+            }
+
+            break;
+          case connection::ack:
+            if (dir == e->dir) {
+              // If the SYN-ACK has not been seen yet...
+              if (!e->answered) {
+                // Retransmission / out-of-order?
+                return true;
+              }
+
+              // The handshake has completed.
+              connection_type* conn;
+              if ((conn = get_free_connection()) == nullptr) {
+                return false;
+              }
+
+              idx = _M_allocator.index(conn);
+
+              conn->hash = e->hash;
+
+              conn->assign(e->addr1, e->port1, e->addr2, e->port2);
+
+              // Replay the SYN and the SYN-ACK.
+              const connection::direction
+                    reply = (e->dir == connection::direction::from_addr1) ?
+                              connection::direction::from_addr2 :
+                              connection::direction::from_addr1;
+
+              conn->init(e->dir, e->size[0], e->creation);
+
+              conn->process_packet(reply,
+                                   connection::syn | connection::ack,
+                                   e->size[1],
+                                   now);
+
+              conn->process_packet(dir, tcpflags, pktsize, now);
+
+              add_timer(conn, idx, now);
+
+              count_packet(conn, e->dir);
+              count_packet(conn, reply);
+              count_packet(conn, dir);
+
+              // Generate 'Begin TCP connection' event.
+              event_tcp_begin(conn, e->creation);
+
+              // If there is payload...
+              if (payload_size > 0) {
+                // Generate 'TCP data' event.
+                event_tcp_data(e->addr1,
+                               e->port1,
+                               e->addr2,
+                               e->port2,
+                               payload_size,
+                               dir,
+                               now,
+                               e->creation);
+              }
+
+              _M_half_open.erase(e);
+
+              _M_half_open_counters.established++;
+              _M_period.counters.established++;
+
+              return true;
+            }
+
+            break;
+          case connection::rst:
+          case connection::rst | connection::ack:
+            failed(e, true);
+            _M_half_open.erase(e);
+
+            return true;
+        }
+
+        // Invalid packet.
+        failed(e, false);
+        _M_half_open.erase(e);
+
+        return true;
+      }
+
+      template<typename Connection>
+      inline void connections<Connection>::failed(const half_open_entry* e,
+                                                  bool reset)
+      {
+        if (reset) {
+          _M_half_open_counters.reset++;
+          _M_period.counters.reset++;
+        } else {
+          _M_half_open_counters.unanswered++;
+          _M_period.counters.unanswered++;
+        }
+
+        _M_period.sample = *e;
+      }
+
+      template<typename Connection>
+      void connections<Connection>::next_period(uint64_t now)
+      {
+        const uint64_t second = now / 1000000;
+
+        while (second != _M_period.second) {
+          // If there have been too many failed connection attempts...
+          if ((_M_syn_flood_threshold > 0) &&
+              (_M_period.counters.reset + _M_period.counters.unanswered >=
+               _M_syn_flood_threshold)) {
+            // Generate 'Half-open TCP connections' event.
+            event_tcp_half_open();
+          }
+
+          memset(&_M_period.counters, 0, sizeof(_M_period.counters));
+
+          // While there are half-open connections, go through the seconds
+          // one by one (they expire at most 'timeout' seconds later).
+          if ((second > _M_period.second) && (!_M_half_open.empty())) {
+            _M_period.second++;
+          } else {
+            _M_period.second = second;
+          }
+
+          // The connection attempts which expire in the new second have
+          // not been answered.
+          half_open_entry e;
+          size_t n;
+          if ((n = _M_half_open.expire(_M_period.second * 1000000, e)) > 0) {
+            _M_half_open_counters.unanswered += n;
+            _M_period.counters.unanswered += n;
+
+            _M_period.sample = e;
+          }
+        }
+      }
+
       template<typename Connection>
       inline void connections<Connection>::remove(connection_type* conn,
+                                                  uint32_t idx,
                                                   uint64_t now)
       {
         // Generate 'End TCP connection' event.
         event_tcp_end(conn, now);
 
+        // Remove timer.
+        _M_timers.remove(idx);
+
         // Remove connection.
-        conn->prev->next = conn->next;
-        conn->next->prev = conn->prev;
+        if (_M_table == table::chained) {
+          // Search the link to the connection.
+          uint32_t* link = bucket(conn->hash);
+          while (*link != idx) {
+            link = &connection(*link)->next;
+          }
+
+          *link = conn->next;
+        } else {
+          _M_bucketed.erase(conn->hash, idx);
+        }
 
-        conn->next = _M_free;
-        _M_free = conn;
+        _M_allocator.free(conn);
 
         _M_nconnections--;
       }
 
+      template<typename Connection>
+      inline uint64_t
+      connections<Connection>::expiration(const connection_type* conn) const
+      {
+        return conn->timestamp.last_packet +
+               ((conn->s != connection::state::closed) ? _M_timeout :
+                                                         _M_time_wait);
+      }
+
+      template<typename Connection>
+      inline uint64_t
+      connections<Connection>::deadline(const connection_type* conn) const
+      {
+        const uint64_t expires = expiration(conn);
+
+        if ((_M_update_interval > 0) &&
+            (conn->s != connection::state::closed)) {
+          const uint64_t next = update(conn)->next;
+          return (next < expires) ? next : expires;
+        }
+
+        return expires;
+      }
+
+      template<typename Connection>
+      inline update_counters*
+      connections<Connection>::update(const connection_type* conn) const
+      {
+        return reinterpret_cast<update_counters*>(
+                 const_cast<connection_type*>(conn + 1)
+               );
+      }
+
+      template<typename Connection>
+      inline void
+      connections<Connection>::count_packet(const connection_type* conn,
+                                            connection::direction dir)
+      {
+        if (_M_update_interval > 0) {
+          update(conn)->packets[static_cast<size_t>(dir)]++;
+        }
+      }
+
+      template<typename Connection>
+      inline void connections<Connection>::add_timer(connection_type* conn,
+                                                     uint32_t idx,
+                                                     uint64_t now)
+      {
+        // If there are no timers, start the wheel at the current time.
+        if (_M_timers.empty()) {
+          _M_timers.reset(now / timer_resolution);
+        }
+
+        if (_M_update_interval > 0) {
+          update_counters* counters = update(conn);
+
+          counters->next = conn->timestamp.creation + _M_update_interval;
+
+          counters->sent[0] = 0;
+          counters->sent[1] = 0;
+
+          counters->packets[0] = 0;
+          counters->packets[1] = 0;
+        }
+
+        _M_timers.add(idx, deadline(conn) / timer_resolution);
+      }
+
+      template<typename Connection>
+      inline void connections<Connection>::closed(connection_type* conn,
+                                                  uint32_t idx)
+      {
+        _M_timers.modify(idx, deadline(conn) / timer_resolution);
+      }
+
       template<typename Connection>
       void connections<Connection>::event_tcp_begin(const connection_type* conn,
                                                     uint64_t now)
@@ -614,6 +1793,108 @@ namespace net {
         // Write event.
         _M_evwriter.write(ev);
       }
+
+      template<typename Connection>
+      void connections<Connection>::event_tcp_update(
+                                      const connection_type* conn,
+                                      uint64_t now
+                                    )
+      {
+        update_counters* counters = update(conn);
+
+        // Schedule the next update (skip the intervals which have already
+        // elapsed).
+        counters->next += ((now - counters->next) / _M_update_interval + 1) *
+                          _M_update_interval;
+
+        // If the connection has not sent packets since the previous
+        // update...
+        if ((counters->packets[0] == 0) && (counters->packets[1] == 0)) {
+          return;
+        }
+
+        event::tcp_update ev;
+
+        ev.addrlen = static_cast<uint8_t>(sizeof(address_type));
+
+        // If 'addr2' is the client...
+        if (conn->active_opener == connection::originator::addr2) {
+          memcpy(ev.saddr, &conn->addresses().a.address2, sizeof(address_type));
+          memcpy(ev.daddr, &conn->addresses().a.address1, sizeof(address_type));
+
+          ev.sport = conn->ports().p.port2;
+          ev.dport = conn->ports().p.port1;
+
+          ev.transferred_client = conn->sent[1] - counters->sent[1];
+          ev.transferred_server = conn->sent[0] - counters->sent[0];
+
+          ev.packets_client = counters->packets[1];
+          ev.packets_server = counters->packets[0];
+        } else {
+          memcpy(ev.saddr, &conn->addresses().a.address1, sizeof(address_type));
+          memcpy(ev.daddr, &conn->addresses().a.address2, sizeof(address_type));
+
+          ev.sport = conn->ports().p.port1;
+          ev.dport = conn->ports().p.port2;
+
+          ev.transferred_client = conn->sent[0] - counters->sent[0];
+          ev.transferred_server = conn->sent[1] - counters->sent[1];
+
+          ev.packets_client = counters->packets[0];
+          ev.packets_server = counters->packets[1];
+        }
+
+        ev.timestamp = now;
+
+        ev.creation = conn->timestamp.creation;
+
+        counters->sent[0] = conn->sent[0];
+        counters->sent[1] = conn->sent[1];
+
+        counters->packets[0] = 0;
+        counters->packets[1] = 0;
+
+        // Write event.
+        _M_evwriter.write(ev);
+      }
+
+      template<typename Connection>
+      void connections<Connection>::event_tcp_half_open()
+      {
+        const half_open_entry& e = _M_period.sample;
+
+        event::tcp_half_open ev;
+
+        ev.addrlen = static_cast<uint8_t>(sizeof(address_type));
+
+        // If 'addr1' is the client...
+        if (e.dir == connection::direction::from_addr1) {
+          memcpy(ev.saddr, &e.addr1, sizeof(address_type));
+          memcpy(ev.daddr, &e.addr2, sizeof(address_type));
+
+          ev.sport = e.port1;
+          ev.dport = e.port2;
+        } else {
+          memcpy(ev.saddr, &e.addr2, sizeof(address_type));
+          memcpy(ev.daddr, &e.addr1, sizeof(address_type));
+
+          ev.sport = e.port2;
+          ev.dport = e.port1;
+        }
+
+        ev.timestamp = _M_period.second * 1000000;
+
+        ev.attempts = static_cast<uint32_t>(_M_period.counters.attempts);
+        ev.established = static_cast<uint32_t>(
+                           _M_period.counters.established
+                         );
+
+        ev.reset = static_cast<uint32_t>(_M_period.counters.reset);
+        ev.unanswered = static_cast<uint32_t>(_M_period.counters.unanswered);
+
+        // Write event.
+        _M_evwriter.write(ev);
+      }
     }
   }
 }
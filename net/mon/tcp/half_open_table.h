@@ -0,0 +1,330 @@
+#ifndef NET_MON_TCP_HALF_OPEN_TABLE_H
+#define NET_MON_TCP_HALF_OPEN_TABLE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include "net/mon/tcp/connection.h"
+
+namespace net {
+  namespace mon {
+    namespace tcp {
+      // Table of half-open connections.
+      //
+      // A SYN doesn't allocate a connection, its addresses, ports and
+      // timestamp are kept in this table until the handshake completes.
+      // The table has a fixed size: it is an array of sets of 4 entries,
+      // when a set is full the oldest entry is replaced, so a SYN flood
+      // only evicts other half-open connections.
+      //
+      // The entries expire 'timeout' seconds after the last SYN or SYN-ACK,
+      // the expired entries are erased by expire() (called once per second
+      // by the owner, so the failed attempts are counted when they
+      // expire).
+      template<typename Address>
+      class half_open_table {
+        public:
+          // Number of entries per set.
+          static constexpr const size_t entries_per_set = 4;
+
+          // Maximum number of entries (16777216).
+          static constexpr const size_t
+                 max_entries = static_cast<size_t>(1) << 24;
+
+          // Timeout of the half-open connections (seconds) (the SYNs are
+          // retransmitted at most 64 seconds apart).
+          static constexpr const uint32_t timeout = 75;
+
+          struct entry {
+            // Timestamp of the first SYN.
+            uint64_t creation;
+
+            // Addresses and ports (same order as in the connection).
+            Address addr1;
+            Address addr2;
+            in_port_t port1;
+            in_port_t port2;
+
+            // Hash of the connection.
+            uint32_t hash;
+
+            // Expiration (seconds, 0: empty entry).
+            uint32_t expires;
+
+            // Size of the SYN and of the SYN-ACK.
+            uint16_t size[2];
+
+            // Direction of the SYN.
+            connection::direction dir;
+
+            // Has the SYN-ACK been seen?
+            bool answered;
+          };
+
+          // Constructor.
+          half_open_table() = default;
+
+          // Destructor.
+          ~half_open_table();
+
+          // Clear.
+          void clear();
+
+          // Initialize.
+          // 'nentries': number of entries (rounded up to a multiple of
+          // 'entries_per_set' which is a power of 2; 0: disabled).
+          bool init(size_t nentries);
+
+          // Find half-open connection.
+          entry* find(const Address& addr1,
+                      in_port_t port1,
+                      const Address& addr2,
+                      in_port_t port2,
+                      uint32_t hash,
+                      uint64_t now);
+
+          // Is there a half-open connection with the hash 'hash'?
+          bool contains(uint32_t hash, uint64_t now) const;
+
+          // Get an entry for a new half-open connection: an empty entry
+          // of the set of the hash or, if the set is full, the oldest
+          // entry. The caller has to fill it and call touch().
+          entry* add(uint32_t hash);
+
+          // Extend the expiration of the entry.
+          void touch(entry* e, uint64_t now);
+
+          // Erase entry.
+          void erase(entry* e);
+
+          // Erase the entries which have expired at 'now'. Returns the
+          // number of entries erased, 'last' receives a copy of the last
+          // one.
+          size_t expire(uint64_t now, entry& last);
+
+          // Enabled?
+          bool enabled() const;
+
+          // Is the table empty?
+          bool empty() const;
+
+          // Get memory used (bytes).
+          size_t memory() const;
+
+        private:
+          struct alignas(64) set {
+            entry entries[entries_per_set];
+          };
+
+          // Sets.
+          set* _M_sets = nullptr;
+
+          // Number of sets - 1.
+          size_t _M_mask = 0;
+
+          // Number of entries in use.
+          size_t _M_count = 0;
+
+          // Get the first entry of the set of the hash.
+          entry* first(uint32_t hash) const;
+
+          // Convert time (microseconds) to seconds (never 0).
+          static uint32_t seconds(uint64_t now);
+
+          // Disable copy constructor and assignment operator.
+          half_open_table(const half_open_table&) = delete;
+          half_open_table& operator=(const half_open_table&) = delete;
+      };
+
+      template<typename Address>
+      inline half_open_table<Address>::~half_open_table()
+      {
+        clear();
+      }
+
+      template<typename Address>
+      void half_open_table<Address>::clear()
+      {
+        if (_M_sets) {
+          free(_M_sets);
+          _M_sets = nullptr;
+        }
+
+        _M_mask = 0;
+        _M_count = 0;
+      }
+
+      template<typename Address>
+      bool half_open_table<Address>::init(size_t nentries)
+      {
+        if (nentries <= max_entries) {
+          // Disabled?
+          if (nentries == 0) {
+            return true;
+          }
+
+          // Compute the number of sets (power of 2).
+          size_t nsets = 1;
+          while (nsets * entries_per_set < nentries) {
+            nsets <<= 1;
+          }
+
+          if ((_M_sets = static_cast<set*>(
+                           aligned_alloc(alignof(set), nsets * sizeof(set))
+                         )) != nullptr) {
+            memset(_M_sets, 0, nsets * sizeof(set));
+
+            _M_mask = nsets - 1;
+
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+      template<typename Address>
+      inline typename half_open_table<Address>::entry*
+      half_open_table<Address>::find(const Address& addr1,
+                                     in_port_t port1,
+                                     const Address& addr2,
+                                     in_port_t port2,
+                                     uint32_t hash,
+                                     uint64_t now)
+      {
+        entry* const s = first(hash);
+        const uint32_t t = seconds(now);
+
+        for (size_t i = 0; i < entries_per_set; i++) {
+          entry* e = s + i;
+
+          if ((e->hash == hash) &&
+              (e->expires > t) &&
+              (e->port1 == port1) &&
+              (e->port2 == port2) &&
+              (e->addr1 == addr1) &&
+              (e->addr2 == addr2)) {
+            return e;
+          }
+        }
+
+        return nullptr;
+      }
+
+      template<typename Address>
+      inline bool half_open_table<Address>::contains(uint32_t hash,
+                                                     uint64_t now) const
+      {
+        if (_M_sets) {
+          const entry* const s = first(hash);
+          const uint32_t t = seconds(now);
+
+          for (size_t i = 0; i < entries_per_set; i++) {
+            if ((s[i].hash == hash) && (s[i].expires > t)) {
+              return true;
+            }
+          }
+        }
+
+        return false;
+      }
+
+      template<typename Address>
+      inline typename half_open_table<Address>::entry*
+      half_open_table<Address>::add(uint32_t hash)
+      {
+        entry* const s = first(hash);
+
+        // Search the entry which expires first (the empty entries expire
+        // at 0), the oldest one if several expire in the same second.
+        entry* oldest = s;
+        for (size_t i = 1; i < entries_per_set; i++) {
+          if ((s[i].expires < oldest->expires) ||
+              ((s[i].expires == oldest->expires) &&
+               (s[i].creation < oldest->creation))) {
+            oldest = s + i;
+          }
+        }
+
+        return oldest;
+      }
+
+      template<typename Address>
+      inline void half_open_table<Address>::touch(entry* e, uint64_t now)
+      {
+        if (e->expires == 0) {
+          _M_count++;
+        }
+
+        e->expires = seconds(now) + timeout;
+      }
+
+      template<typename Address>
+      inline void half_open_table<Address>::erase(entry* e)
+      {
+        e->expires = 0;
+        _M_count--;
+      }
+
+      template<typename Address>
+      size_t half_open_table<Address>::expire(uint64_t now, entry& last)
+      {
+        size_t n = 0;
+
+        if (_M_count > 0) {
+          const uint32_t t = seconds(now);
+
+          for (size_t i = 0; i <= _M_mask; i++) {
+            entry* const s = _M_sets[i].entries;
+
+            for (size_t j = 0; j < entries_per_set; j++) {
+              if ((s[j].expires != 0) && (s[j].expires <= t)) {
+                last = s[j];
+                erase(s + j);
+
+                n++;
+              }
+            }
+          }
+        }
+
+        return n;
+      }
+
+      template<typename Address>
+      inline bool half_open_table<Address>::enabled() const
+      {
+        return (_M_sets != nullptr);
+      }
+
+      template<typename Address>
+      inline bool half_open_table<Address>::empty() const
+      {
+        return (_M_count == 0);
+      }
+
+      template<typename Address>
+      inline size_t half_open_table<Address>::memory() const
+      {
+        return (_M_sets) ? (_M_mask + 1) * sizeof(set) : 0;
+      }
+
+      template<typename Address>
+      inline typename half_open_table<Address>::entry*
+      half_open_table<Address>::first(uint32_t hash) const
+      {
+        return _M_sets[hash & _M_mask].entries;
+      }
+
+      template<typename Address>
+      inline uint32_t half_open_table<Address>::seconds(uint64_t now)
+      {
+        const uint32_t t = static_cast<uint32_t>(now / 1000000);
+        return (t != 0) ? t : 1;
+      }
+    }
+  }
+}
+
+#endif // NET_MON_TCP_HALF_OPEN_TABLE_H
@@ -0,0 +1,24 @@
+#ifndef NET_MON_TCP_HASH_FUNCTION_H
+#define NET_MON_TCP_HASH_FUNCTION_H
+
+namespace net {
+  namespace mon {
+    namespace tcp {
+      // Hash function of the connections (all of them use a random key
+      // generated at start-up).
+      enum class hash_function {
+        // Bob Jenkins' lookup3.
+        lookup3,
+
+        // CRC32C (instruction crc32 of SSE4.2 if available). The key
+        // doesn't prevent collisions (the CRC is linear).
+        crc32c,
+
+        // SipHash-1-3.
+        siphash
+      };
+    }
+  }
+}
+
+#endif // NET_MON_TCP_HASH_FUNCTION_H
@@ -0,0 +1,63 @@
+#ifndef NET_MON_TCP_OPTIONS_H
+#define NET_MON_TCP_OPTIONS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "net/mon/tcp/table.h"
+#include "net/mon/tcp/hash_function.h"
+
+namespace net {
+  namespace mon {
+    namespace tcp {
+      // Options of the TCP connections of the workers (the same for IPv4
+      // and IPv6 but the size of the hash table and the maximum number of
+      // connections).
+      struct options {
+        // Hash table size (IPv4 and IPv6).
+        size_t ipv4_size;
+        size_t ipv6_size;
+
+        // Maximum number of connections (IPv4 and IPv6).
+        size_t ipv4_maxconns;
+        size_t ipv6_maxconns;
+
+        // Connection timeout (seconds).
+        uint64_t timeout;
+
+        // TCP time wait (seconds).
+        uint64_t time_wait;
+
+        // Interval of the 'Update TCP connection' events (seconds, 0: no
+        // events).
+        uint64_t update_interval;
+
+        // Type of hash table.
+        net::mon::tcp::table table;
+
+        // Hash function.
+        net::mon::tcp::hash_function hash;
+
+        // Number of entries of the cache of untracked connections (0:
+        // disabled).
+        size_t untracked;
+
+        // Adopt the connections whose establishment has not been seen?
+        bool adopt;
+
+        // Number of entries of the table of half-open connections (0: the
+        // SYNs create connections).
+        size_t half_open;
+
+        // Number of failed connection attempts per second which generate a
+        // 'Half-open TCP connections' event (0: no events).
+        uint32_t syn_flood_threshold;
+
+        // Memory (bytes) of the TCP connections of all the workers, shared
+        // by IPv4 and IPv6 (0: no limit).
+        size_t memory;
+      };
+    }
+  }
+}
+
+#endif // NET_MON_TCP_OPTIONS_H
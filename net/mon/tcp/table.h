@@ -0,0 +1,19 @@
+#ifndef NET_MON_TCP_TABLE_H
+#define NET_MON_TCP_TABLE_H
+
+namespace net {
+  namespace mon {
+    namespace tcp {
+      // Type of the connection hash table.
+      enum class table {
+        // Chained buckets (doubly-linked lists of connections).
+        chained,
+
+        // Open addressing with buckets of 8 slots (one cache line).
+        bucketed
+      };
+    }
+  }
+}
+
+#endif // NET_MON_TCP_TABLE_H
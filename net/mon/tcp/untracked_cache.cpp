@@ -0,0 +1,40 @@
+#include <string.h>
+#include "net/mon/tcp/untracked_cache.h"
+
+void net::mon::tcp::untracked_cache::clear()
+{
+  if (_M_sets) {
+    free(_M_sets);
+    _M_sets = nullptr;
+  }
+
+  _M_mask = 0;
+}
+
+bool net::mon::tcp::untracked_cache::init(size_t nentries)
+{
+  if (nentries <= max_entries) {
+    // Disabled?
+    if (nentries == 0) {
+      return true;
+    }
+
+    // Compute the number of sets (power of 2).
+    size_t nsets = 1;
+    while (nsets * entries_per_set < nentries) {
+      nsets <<= 1;
+    }
+
+    if ((_M_sets = static_cast<set*>(
+                     aligned_alloc(sizeof(set), nsets * sizeof(set))
+                   )) != nullptr) {
+      memset(_M_sets, 0, nsets * sizeof(set));
+
+      _M_mask = nsets - 1;
+
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,186 @@
+#ifndef NET_MON_TCP_UNTRACKED_CACHE_H
+#define NET_MON_TCP_UNTRACKED_CACHE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace net {
+  namespace mon {
+    namespace tcp {
+      // Cache of untracked connections (negative lookup cache).
+      //
+      // Keeps the hashes of the connections whose packets have been seen
+      // without the connection being in the hash table (the connection was
+      // established before the capture started or its SYN was lost), so the
+      // next packets of these connections don't have to search the hash
+      // table.
+      //
+      // The cache is an array of sets of 8 entries (one cache line per
+      // set), each entry has the hash and the time when it expires. When a
+      // set is full, the entry which expires first is replaced.
+      //
+      // The caller must ensure that a hash is never in the cache while
+      // there is a connection with the same hash in the hash table.
+      class untracked_cache {
+        public:
+          // Number of entries per set.
+          static constexpr const size_t entries_per_set = 8;
+
+          // Maximum number of entries (16777216).
+          static constexpr const size_t
+                 max_entries = static_cast<size_t>(1) << 24;
+
+          // Number of entries (default) (65536).
+          static constexpr const size_t
+                 default_entries = static_cast<size_t>(1) << 16;
+
+          // Time to live of the entries (seconds).
+          static constexpr const uint32_t ttl = 60;
+
+          // Constructor.
+          untracked_cache() = default;
+
+          // Destructor.
+          ~untracked_cache();
+
+          // Clear.
+          void clear();
+
+          // Initialize.
+          // 'nentries': number of entries (rounded up to a multiple of
+          // 'entries_per_set' which is a power of 2; 0: disabled).
+          bool init(size_t nentries);
+
+          // Is the hash in the cache?
+          bool find(uint32_t hash, uint64_t now) const;
+
+          // Add hash.
+          void add(uint32_t hash, uint64_t now);
+
+          // Erase hash.
+          void erase(uint32_t hash);
+
+          // Prefetch the set of the hash.
+          void prefetch(uint32_t hash) const;
+
+          // Enabled?
+          bool enabled() const;
+
+          // Get memory used (bytes).
+          size_t memory() const;
+
+        private:
+          struct entry {
+            // Hash of the connection.
+            uint32_t hash;
+
+            // Expiration (seconds, 0: empty entry).
+            uint32_t expires;
+          };
+
+          struct alignas(64) set {
+            entry entries[entries_per_set];
+          };
+
+          static_assert(sizeof(set) == 64, "Set doesn't fit in a cache line.");
+
+          // Sets.
+          set* _M_sets = nullptr;
+
+          // Number of sets - 1.
+          size_t _M_mask = 0;
+
+          // Convert time (microseconds) to seconds (never 0).
+          static uint32_t seconds(uint64_t now);
+
+          // Disable copy constructor and assignment operator.
+          untracked_cache(const untracked_cache&) = delete;
+          untracked_cache& operator=(const untracked_cache&) = delete;
+      };
+
+      inline untracked_cache::~untracked_cache()
+      {
+        clear();
+      }
+
+      inline bool untracked_cache::find(uint32_t hash, uint64_t now) const
+      {
+        if (_M_sets) {
+          const set& s = _M_sets[hash & _M_mask];
+          const uint32_t t = seconds(now);
+
+          for (size_t i = 0; i < entries_per_set; i++) {
+            if ((s.entries[i].hash == hash) && (s.entries[i].expires > t)) {
+              return true;
+            }
+          }
+        }
+
+        return false;
+      }
+
+      inline void untracked_cache::add(uint32_t hash, uint64_t now)
+      {
+        if (_M_sets) {
+          set& s = _M_sets[hash & _M_mask];
+
+          // Search the entry which expires first (the empty entries and
+          // the entry of the hash, if any, expire at 0).
+          size_t oldest = 0;
+          for (size_t i = 0; i < entries_per_set; i++) {
+            if (s.entries[i].hash == hash) {
+              oldest = i;
+              break;
+            }
+
+            if (s.entries[i].expires < s.entries[oldest].expires) {
+              oldest = i;
+            }
+          }
+
+          s.entries[oldest].hash = hash;
+          s.entries[oldest].expires = seconds(now) + ttl;
+        }
+      }
+
+      inline void untracked_cache::erase(uint32_t hash)
+      {
+        if (_M_sets) {
+          set& s = _M_sets[hash & _M_mask];
+
+          for (size_t i = 0; i < entries_per_set; i++) {
+            if (s.entries[i].hash == hash) {
+              s.entries[i].hash = 0;
+              s.entries[i].expires = 0;
+            }
+          }
+        }
+      }
+
+      inline void untracked_cache::prefetch(uint32_t hash) const
+      {
+        if (_M_sets) {
+          __builtin_prefetch(&_M_sets[hash & _M_mask]);
+        }
+      }
+
+      inline bool untracked_cache::enabled() const
+      {
+        return (_M_sets != nullptr);
+      }
+
+      inline size_t untracked_cache::memory() const
+      {
+        return (_M_sets) ? (_M_mask + 1) * sizeof(set) : 0;
+      }
+
+      inline uint32_t untracked_cache::seconds(uint64_t now)
+      {
+        const uint32_t t = static_cast<uint32_t>(now / 1000000);
+        return (t != 0) ? t : 1;
+      }
+    }
+  }
+}
+
+#endif // NET_MON_TCP_UNTRACKED_CACHE_H
@@ -1,3 +1,5 @@
+#include <string.h>
+#include <net/ethernet.h>
 #include <netinet/tcp.h>
 #include <netinet/udp.h>
 #include <netinet/ip_icmp.h>
@@ -13,12 +15,15 @@ static inline uint8_t tcp_flags(const struct tcphdr* tcphdr)
 
 bool net::mon::worker::start()
 {
+  // Set '_M_running' before starting the thread (the thread checks it when
+  // receiving the packets through a packet queue).
+  __atomic_store_n(&_M_running, true, __ATOMIC_RELEASE);
+
   if (_M_nprocessor == no_processor) {
     // Start thread.
-    return (_M_running = (pthread_create(&_M_thread,
-                                         nullptr,
-                                         run,
-                                         this) == 0));
+    if (pthread_create(&_M_thread, nullptr, run, this) == 0) {
+      return true;
+    }
   } else {
     // Initialize thread attributes.
     pthread_attr_t attr;
@@ -33,8 +38,6 @@ bool net::mon::worker::start()
                                       &cpuset) == 0) {
         // Start thread.
         if (pthread_create(&_M_thread, &attr, run, this) == 0) {
-          _M_running = true;
-
           pthread_attr_destroy(&attr);
 
           return true;
@@ -43,19 +46,194 @@ bool net::mon::worker::start()
 
       pthread_attr_destroy(&attr);
     }
+  }
+
+  __atomic_store_n(&_M_running, false, __ATOMIC_RELEASE);
 
-    return false;
+  return false;
+}
+
+void net::mon::worker::dequeue()
+{
+  size_t spins = 0;
+
+  do {
+    const packet* pkt;
+    if ((pkt = _M_queue->front()) != nullptr) {
+      _M_hash = pkt->rxhash;
+
+      // Process packet (errors in a single packet are ignored, as when
+      // capturing from a network interface).
+      switch (pkt->t) {
+        case packet::type::ethernet:
+          process_ethernet(pkt->buf, pkt->len, pkt->wirelen, pkt->timestamp);
+          break;
+        case packet::type::ipv4:
+          process_ipv4(pkt->buf, pkt->len, pkt->wirelen, pkt->timestamp);
+          break;
+        case packet::type::ipv6:
+          process_ipv6(pkt->buf, pkt->len, pkt->wirelen, pkt->timestamp);
+          break;
+      }
+
+      // Release the slot (the producer might reuse the packet buffer once
+      // the queue is empty).
+      _M_queue->pop();
+
+      _M_queued_packets++;
+
+      spins = 0;
+    } else if (__atomic_load_n(&_M_running, __ATOMIC_ACQUIRE)) {
+      if (spins < queue_spins) {
+        capture::busy_poll::relax();
+
+        spins++;
+      } else {
+        if (_M_live) {
+          // Flush event writer buffer and remove expired connections.
+          idle(this);
+        } else {
+          // Flush event writer buffer (if not empty).
+          _M_evwriter.flush();
+        }
+
+        usleep(queue_sleep);
+      }
+    } else if (_M_queue->empty()) {
+      // The worker has been stopped and there are no more packets.
+      _M_evwriter.flush();
+      return;
+    }
+  } while (true);
+}
+
+bool net::mon::worker::process_ethernet(const capture::frame* frames,
+                                        size_t nframes)
+{
+  // Two-stage pipeline: the headers of frame 'i + 2 * prefetch_distance'
+  // are prefetched, the TCP ports of frame 'i + prefetch_distance' are read
+  // for prefetching the bucket of its connection and frame 'i' is
+  // processed.
+  static constexpr const size_t header_distance = 2 * prefetch_distance;
+
+  // Prefetch the headers of the first frames.
+  for (size_t i = 0; (i < header_distance) && (i < nframes); i++) {
+    parser::prefetch(frames[i].buf);
+  }
+
+  // Prefetch the buckets of the first frames.
+  for (size_t i = 0; (i < prefetch_distance) && (i < nframes); i++) {
+    prefetch_connection(frames[i].buf,
+                        frames[i].len,
+                        _M_rxhash ? frames[i].rxhash : 0);
+  }
+
+  bool ret = true;
+
+  for (size_t i = 0; i < nframes; i++) {
+    if (i + header_distance < nframes) {
+      parser::prefetch(frames[i + header_distance].buf);
+    }
+
+    if (i + prefetch_distance < nframes) {
+      const capture::frame& next = frames[i + prefetch_distance];
+
+      prefetch_connection(next.buf, next.len, _M_rxhash ? next.rxhash : 0);
+    }
+
+    _M_hash = _M_rxhash ? frames[i].rxhash : 0;
+
+    // Process frame (an error in a frame doesn't stop the processing of
+    // the batch).
+    if (!process_ethernet(frames[i].buf,
+                          frames[i].len,
+                          frames[i].wirelen,
+                          frames[i].timestamp)) {
+      ret = false;
+    }
+  }
+
+  return ret;
+}
+
+void net::mon::worker::prefetch_connection(const void* buf,
+                                           size_t len,
+                                           uint32_t hash) const
+{
+  // Only the most common encapsulations are considered (ethernet with an
+  // optional VLAN tag, IPv4 without fragmentation and IPv6 without
+  // extension headers).
+  if (len >= sizeof(struct ether_header) + 4) {
+    const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+    size_t off = sizeof(struct ether_header);
+    uint16_t ether_type = (static_cast<uint16_t>(b[off - 2]) << 8) |
+                          b[off - 1];
+
+    if (ether_type == ETH_P_8021Q) {
+      off += 4;
+      ether_type = (static_cast<uint16_t>(b[off - 2]) << 8) | b[off - 1];
+    }
+
+    in_port_t ports[2];
+
+    switch (ether_type) {
+      case ETH_P_IP:
+        if (off + sizeof(struct iphdr) <= len) {
+          const struct iphdr* iphdr = reinterpret_cast<const struct iphdr*>(
+                                        b + off
+                                      );
+
+          off += (static_cast<size_t>(iphdr->ihl) << 2);
+
+          if ((iphdr->protocol == IPPROTO_TCP) &&
+              ((iphdr->frag_off & htons(IP_MF | IP_OFFMASK)) == 0) &&
+              (off + sizeof(ports) <= len)) {
+            memcpy(ports, b + off, sizeof(ports));
+
+            _M_tcp_ipv4.prefetch(
+              static_cast<const ipv4::address&>(iphdr->saddr),
+              ports[0],
+              static_cast<const ipv4::address&>(iphdr->daddr),
+              ports[1],
+              hash
+            );
+          }
+        }
+
+        break;
+      case ETH_P_IPV6:
+        if (off + sizeof(struct ip6_hdr) + sizeof(ports) <= len) {
+          const struct ip6_hdr* iphdr = reinterpret_cast<const struct ip6_hdr*>(
+                                          b + off
+                                        );
+
+          if (iphdr->ip6_nxt == IPPROTO_TCP) {
+            memcpy(ports, b + off + sizeof(struct ip6_hdr), sizeof(ports));
+
+            _M_tcp_ipv6.prefetch(
+              static_cast<const ipv6::address&>(iphdr->ip6_src),
+              ports[0],
+              static_cast<const ipv6::address&>(iphdr->ip6_dst),
+              ports[1]
+            );
+          }
+        }
+
+        break;
+    }
   }
 }
 
 bool net::mon::worker::icmp(const struct iphdr* iphdr,
                             size_t iphdrsize,
                             size_t pktsize,
+                            size_t caplen,
                             const struct timeval& timestamp,
                             void* user)
 {
-  // If the ICMP datagram is big enough...
-  if (pktsize - iphdrsize >= sizeof(struct icmphdr)) {
+  // If the ICMP header has been captured...
+  if (caplen - iphdrsize >= sizeof(struct icmphdr)) {
     const struct icmphdr* icmphdr = reinterpret_cast<const struct icmphdr*>(
                                       reinterpret_cast<const uint8_t*>(iphdr) +
                                       iphdrsize
@@ -86,11 +264,12 @@ bool net::mon::worker::icmp(const struct iphdr* iphdr,
 bool net::mon::worker::icmpv6(const struct ip6_hdr* iphdr,
                               size_t iphdrsize,
                               size_t pktsize,
+                              size_t caplen,
                               const struct timeval& timestamp,
                               void* user)
 {
-  // If the ICMPv6 datagram is big enough...
-  if (pktsize - iphdrsize >= sizeof(struct icmp6_hdr)) {
+  // If the ICMPv6 header has been captured...
+  if (caplen - iphdrsize >= sizeof(struct icmp6_hdr)) {
     const struct icmp6_hdr* icmphdr =
           reinterpret_cast<const struct icmp6_hdr*>(
             reinterpret_cast<const uint8_t*>(iphdr) +
@@ -122,20 +301,25 @@ bool net::mon::worker::icmpv6(const struct ip6_hdr* iphdr,
 bool net::mon::worker::tcp_ipv4(const struct iphdr* iphdr,
                                 size_t iphdrsize,
                                 size_t pktsize,
+                                size_t caplen,
                                 const struct timeval& timestamp,
                                 void* user)
 {
-  // If the TCP segment is big enough...
-  size_t tcpsize;
-  if ((tcpsize = pktsize - iphdrsize) >= sizeof(struct tcphdr)) {
+  // If the TCP header has been captured...
+  if (caplen - iphdrsize >= sizeof(struct tcphdr)) {
     const struct tcphdr* tcphdr = reinterpret_cast<const struct tcphdr*>(
                                     reinterpret_cast<const uint8_t*>(iphdr) +
                                     iphdrsize
                                   );
 
+    // Size of the TCP segment.
+    size_t tcpsize = pktsize - iphdrsize;
+
     // Sanity check.
     if ((tcphdr->doff >= 5) &&
         (tcpsize >= (static_cast<size_t>(tcphdr->doff) << 2))) {
+      // The kernel doesn't include the ports in the hash of the
+      // fragments.
       return static_cast<worker*>(user)->_M_tcp_ipv4.add(
                static_cast<const ipv4::address&>(iphdr->saddr),
                tcphdr->source,
@@ -144,7 +328,10 @@ bool net::mon::worker::tcp_ipv4(const struct iphdr* iphdr,
                tcp_flags(tcphdr),
                pktsize,
                tcpsize - (tcphdr->doff << 2),
-               to_microseconds(timestamp)
+               to_microseconds(timestamp),
+               ((iphdr->frag_off & htons(IP_MF | IP_OFFMASK)) == 0) ?
+                 static_cast<worker*>(user)->_M_hash :
+                 0
              );
     }
   }
@@ -155,20 +342,25 @@ bool net::mon::worker::tcp_ipv4(const struct iphdr* iphdr,
 bool net::mon::worker::tcp_ipv6(const struct ip6_hdr* iphdr,
                                 size_t iphdrsize,
                                 size_t pktsize,
+                                size_t caplen,
                                 const struct timeval& timestamp,
                                 void* user)
 {
-  // If the TCP segment is big enough...
-  size_t tcpsize;
-  if ((tcpsize = pktsize - iphdrsize) >= sizeof(struct tcphdr)) {
+  // If the TCP header has been captured...
+  if (caplen - iphdrsize >= sizeof(struct tcphdr)) {
     const struct tcphdr* tcphdr = reinterpret_cast<const struct tcphdr*>(
                                     reinterpret_cast<const uint8_t*>(iphdr) +
                                     iphdrsize
                                   );
 
+    // Size of the TCP segment.
+    size_t tcpsize = pktsize - iphdrsize;
+
     // Sanity check.
     if ((tcphdr->doff >= 5) &&
         (tcpsize >= (static_cast<size_t>(tcphdr->doff) << 2))) {
+      // The hash computed by the kernel is not used: it includes the flow
+      // label, which is different in each direction.
       return static_cast<worker*>(user)->_M_tcp_ipv6.add(
                static_cast<const ipv6::address&>(iphdr->ip6_src),
                tcphdr->source,
@@ -188,11 +380,12 @@ bool net::mon::worker::tcp_ipv6(const struct ip6_hdr* iphdr,
 bool net::mon::worker::udp_ipv4(const struct iphdr* iphdr,
                                 size_t iphdrsize,
                                 size_t pktsize,
+                                size_t caplen,
                                 const struct timeval& timestamp,
                                 void* user)
 {
-  // If the UDP datagram is big enough...
-  if (pktsize - iphdrsize >= sizeof(struct udphdr)) {
+  // If the UDP header has been captured...
+  if (caplen - iphdrsize >= sizeof(struct udphdr)) {
     const struct udphdr* udphdr = reinterpret_cast<const struct udphdr*>(
                                     reinterpret_cast<const uint8_t*>(iphdr) +
                                     iphdrsize
@@ -201,8 +394,9 @@ bool net::mon::worker::udp_ipv4(const struct iphdr* iphdr,
     // Sanity check.
     uint16_t udplen = ntohs(udphdr->len);
     if ((udplen >= sizeof(struct udphdr)) && (iphdrsize + udplen == pktsize)) {
-      // DNS request or response?
-      if ((udphdr->source == dns::port) || (udphdr->dest == dns::port)) {
+      // DNS request or response (which has been captured whole)?
+      if (((udphdr->source == dns::port) || (udphdr->dest == dns::port)) &&
+          (caplen == pktsize)) {
         // Process 'DNS'.
         dns::message dnsmsg(reinterpret_cast<const uint8_t*>(udphdr) +
                             sizeof(struct udphdr),
@@ -256,11 +450,12 @@ bool net::mon::worker::udp_ipv4(const struct iphdr* iphdr,
 bool net::mon::worker::udp_ipv6(const struct ip6_hdr* iphdr,
                                 size_t iphdrsize,
                                 size_t pktsize,
+                                size_t caplen,
                                 const struct timeval& timestamp,
                                 void* user)
 {
-  // If the UDP datagram is big enough...
-  if (pktsize - iphdrsize >= sizeof(struct udphdr)) {
+  // If the UDP header has been captured...
+  if (caplen - iphdrsize >= sizeof(struct udphdr)) {
     const struct udphdr* udphdr = reinterpret_cast<const struct udphdr*>(
                                     reinterpret_cast<const uint8_t*>(iphdr) +
                                     iphdrsize
@@ -269,8 +464,9 @@ bool net::mon::worker::udp_ipv6(const struct ip6_hdr* iphdr,
     // Sanity check.
     uint16_t udplen = ntohs(udphdr->len);
     if ((udplen >= sizeof(struct udphdr)) && (iphdrsize + udplen == pktsize)) {
-      // DNS request or response?
-      if ((udphdr->source == dns::port) || (udphdr->dest == dns::port)) {
+      // DNS request or response (which has been captured whole)?
+      if (((udphdr->source == dns::port) || (udphdr->dest == dns::port)) &&
+          (caplen == pktsize)) {
         // Process 'DNS'.
         dns::message dnsmsg(reinterpret_cast<const uint8_t*>(udphdr) +
                             sizeof(struct udphdr),
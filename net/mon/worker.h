@@ -2,17 +2,24 @@
 #define NET_MON_WORKER_H
 
 #include <stdio.h>
+#include <unistd.h>
+#include <time.h>
 #include <sys/time.h>
 #include <pthread.h>
 #include <limits.h>
 #include "net/mon/tcp/connections.h"
+#include "net/mon/tcp/options.h"
 #include "net/mon/ipv4/tcp/connection.h"
 #include "net/mon/ipv6/tcp/connection.h"
 #include "net/mon/event/writer.h"
 #include "net/capture/ring_buffer.h"
 #include "net/capture/socket.h"
+#include "net/capture/xdp.h"
 #include "net/capture/method.h"
 #include "net/parser.h"
+#include "util/spsc_queue.h"
+#include "util/slab_allocator.h"
+#include "util/slab_pool.h"
 
 namespace net {
   namespace mon {
@@ -24,49 +31,98 @@ namespace net {
         // Default directory where to save the event files.
         static constexpr const char* const default_directory = ".";
 
+        // Packet passed to the worker through a packet queue.
+        struct packet {
+          enum class type : uint8_t {
+            ethernet,
+            ipv4,
+            ipv6
+          };
+
+          const void* buf;
+          uint32_t len;
+          uint32_t wirelen;
+          struct timeval timestamp;
+
+          // Hash computed by the kernel (0: not available / not used).
+          uint32_t rxhash;
+
+          type t;
+        };
+
+        // Packet queue.
+        typedef util::spsc_queue<packet> packet_queue;
+
         // Constructor.
         worker(size_t nworker,
                size_t nprocessor,
                const char* evdir,
                uint64_t file_allocation_size,
-               size_t buffer_size);
+               size_t buffer_size,
+               event::compression compression,
+               size_t writer_buffers,
+               event::backpressure backpressure,
+               bool direct_io,
+               uint64_t rotation_size,
+               uint64_t rotation_interval);
 
         // Destructor.
         ~worker();
 
         // Initialize.
+        // 'rxhash': whether the hash computed by the kernel (TPACKET_V3) is
+        // used for selecting the bucket of the TCP/IPv4 connections.
+        // 'tcp_pool': pool of slabs of the TCP connections shared with the
+        // other workers (nullptr: the memory is not shared).
         bool init(const char* device,
                   unsigned ifindex,
                   int rcvbuf_size,
                   bool promiscuous_mode,
+                  const capture::fanout& fanout,
                   size_t ring_buffer_block_size,
                   size_t ring_buffer_frame_size,
                   size_t ring_buffer_frame_count,
-                  size_t tcp_ipv4_size,
-                  size_t tcp_ipv4_maxconns,
-                  size_t tcp_ipv6_size,
-                  size_t tcp_ipv6_maxconns,
-                  uint64_t tcp_timeout,
-                  uint64_t tcp_time_wait);
+                  bool rxhash,
+                  const tcp::options& tcp_options,
+                  util::slab_pool* tcp_pool);
 
         bool init(const char* device,
                   unsigned ifindex,
                   int rcvbuf_size,
                   bool promiscuous_mode,
-                  size_t tcp_ipv4_size,
-                  size_t tcp_ipv4_maxconns,
-                  size_t tcp_ipv6_size,
-                  size_t tcp_ipv6_maxconns,
-                  uint64_t tcp_timeout,
-                  uint64_t tcp_time_wait);
+                  size_t snaplen,
+                  const capture::fanout& fanout,
+                  const tcp::options& tcp_options,
+                  util::slab_pool* tcp_pool);
 
         bool init(const char* device,
-                  size_t tcp_ipv4_size,
-                  size_t tcp_ipv4_maxconns,
-                  size_t tcp_ipv6_size,
-                  size_t tcp_ipv6_maxconns,
-                  uint64_t tcp_timeout,
-                  uint64_t tcp_time_wait);
+                  capture::xdp::program& xdp_program,
+                  unsigned xdp_queue,
+                  bool xdp_zero_copy,
+                  size_t xdp_frame_size,
+                  size_t xdp_frame_count,
+                  const tcp::options& tcp_options,
+                  util::slab_pool* tcp_pool);
+
+        // Initialize worker which receives the packets through 'queue'.
+        // 'live': whether the packets are being captured from a network
+        // interface (then the expired connections are removed when the
+        // queue is empty, as when the worker captures the packets).
+        bool init(const char* device,
+                  packet_queue* queue,
+                  bool live,
+                  const tcp::options& tcp_options,
+                  util::slab_pool* tcp_pool);
+
+        bool init(const char* device,
+                  const tcp::options& tcp_options,
+                  util::slab_pool* tcp_pool);
+
+        // Enable busy poll.
+        bool enable_busy_poll(size_t spins, int usecs);
+
+        // Attach filter (only for ring buffer and socket).
+        bool attach_filter(const capture::filter& filter);
 
         // Start.
         bool start();
@@ -74,19 +130,29 @@ namespace net {
         // Stop.
         void stop();
 
+        // Close event file.
+        bool close();
+
         // Process ethernet frame.
         bool process_ethernet(const void* buf,
                               size_t len,
+                              size_t wirelen,
                               const struct timeval& timestamp);
 
+        // Process batch of ethernet frames (the headers of the next frames
+        // and the buckets of their TCP connections are prefetched).
+        bool process_ethernet(const capture::frame* frames, size_t nframes);
+
         // Process IPv4 packet.
         bool process_ipv4(const void* buf,
                           size_t len,
+                          size_t wirelen,
                           const struct timeval& timestamp);
 
         // Process IPv6 packet.
         bool process_ipv6(const void* buf,
                           size_t len,
+                          size_t wirelen,
                           const struct timeval& timestamp);
 
         // Remove expired connections.
@@ -95,10 +161,47 @@ namespace net {
         // Show statistics.
         bool show_statistics();
 
+        // Show memory usage of the connections.
+        void show_memory_usage() const;
+
+        // Show usage of the pool of slabs of the TCP connections.
+        static void show_pool(const util::slab_pool& pool);
+
+        // Show the histograms of the lookups and insertions in the TCP
+        // connection hash tables (it can be called while the worker is
+        // running, the values might then be slightly inconsistent).
+        void show_hash_statistics() const;
+
+        // Show the counters of the I/O thread of the event writer (if
+        // any, the blocks handed over have to be written).
+        void show_writer_statistics() const;
+
+        // Get name of the event file.
+        const char* filename() const;
+
       private:
-        // Check interval of the expired connections.
+        // Check interval of the expired connections (seconds, by the time
+        // of the packets; shorter if the TCP update interval is shorter).
         static constexpr const time_t check_interval = 10;
 
+        // Flush interval of the event writer (seconds, by the monotonic
+        // clock).
+        static constexpr const time_t flush_interval = 1;
+
+        // Number of packets between two reads of the monotonic clock.
+        static constexpr const unsigned clock_check_packets = 256;
+
+        // Number of empty checks of the packet queue before sleeping.
+        static constexpr const size_t queue_spins = 1000;
+
+        // Sleep time (microseconds) when the packet queue is empty.
+        static constexpr const useconds_t queue_sleep = 100;
+
+        // Number of frames ahead whose connection buckets are prefetched
+        // when processing a batch of frames (the headers are prefetched
+        // twice as far ahead).
+        static constexpr const size_t prefetch_distance = 4;
+
         // Worker number.
         size_t _M_nworker;
 
@@ -117,6 +220,26 @@ namespace net {
         // Raw socket.
         capture::socket _M_socket;
 
+        // AF_XDP socket.
+        capture::xdp _M_xdp;
+
+        // Packet queue (nullptr if the worker captures the packets).
+        packet_queue* _M_queue = nullptr;
+
+        // Number of packets received through the packet queue.
+        uint64_t _M_queued_packets = 0;
+
+        // Are the packets of the packet queue being captured from a network
+        // interface?
+        bool _M_live = false;
+
+        // Use the hash computed by the kernel?
+        bool _M_rxhash = false;
+
+        // Hash computed by the kernel of the packet being processed (0: not
+        // available / not used).
+        uint32_t _M_hash = 0;
+
         // Connection hash tables.
         tcp::connections<ipv4::tcp::connection> _M_tcp_ipv4;
         tcp::connections<ipv6::tcp::connection> _M_tcp_ipv6;
@@ -127,11 +250,25 @@ namespace net {
         // Event writer.
         event::writer _M_evwriter;
 
+        // Name of the event file.
+        char _M_filename[PATH_MAX] = {};
+
         // Thread.
         pthread_t _M_thread;
 
-        // Last check.
-        time_t _M_last_check;
+        // Next check of the expired connections (microseconds, by the time
+        // of the packets; 0: not set yet).
+        uint64_t _M_next_check = 0;
+
+        // Check interval of the expired connections (microseconds).
+        uint64_t _M_check_interval = check_interval * 1000000ull;
+
+        // Next flush of the event writer (seconds, by the monotonic clock).
+        time_t _M_next_flush = 0;
+
+        // Number of packets processed since the last read of the monotonic
+        // clock.
+        unsigned _M_npackets = 0;
 
         // Running?
         bool _M_running = false;
@@ -139,13 +276,25 @@ namespace net {
         // Process ethernet frame.
         static bool process_ethernet(const void* buf,
                                      size_t len,
+                                     size_t wirelen,
                                      const struct timeval& timestamp,
                                      void* user);
 
+        // Process batch of ethernet frames.
+        static bool process_batch(const capture::frame* frames,
+                                  size_t nframes,
+                                  void* user);
+
+        // Prefetch the bucket of the TCP connection of the frame (if any).
+        void prefetch_connection(const void* buf,
+                                 size_t len,
+                                 uint32_t hash) const;
+
         // Process ICMP datagram.
         static bool icmp(const struct iphdr* iphdr,
                          size_t iphdrsize,
                          size_t pktsize,
+                         size_t caplen,
                          const struct timeval& timestamp,
                          void* user);
 
@@ -153,6 +302,7 @@ namespace net {
         static bool icmpv6(const struct ip6_hdr* iphdr,
                            size_t iphdrsize,
                            size_t pktsize,
+                           size_t caplen,
                            const struct timeval& timestamp,
                            void* user);
 
@@ -160,6 +310,7 @@ namespace net {
         static bool tcp_ipv4(const struct iphdr* iphdr,
                              size_t iphdrsize,
                              size_t pktsize,
+                             size_t caplen,
                              const struct timeval& timestamp,
                              void* user);
 
@@ -167,6 +318,7 @@ namespace net {
         static bool tcp_ipv6(const struct ip6_hdr* iphdr,
                              size_t iphdrsize,
                              size_t pktsize,
+                             size_t caplen,
                              const struct timeval& timestamp,
                              void* user);
 
@@ -174,6 +326,7 @@ namespace net {
         static bool udp_ipv4(const struct iphdr* iphdr,
                              size_t iphdrsize,
                              size_t pktsize,
+                             size_t caplen,
                              const struct timeval& timestamp,
                              void* user);
 
@@ -181,18 +334,45 @@ namespace net {
         static bool udp_ipv6(const struct ip6_hdr* iphdr,
                              size_t iphdrsize,
                              size_t pktsize,
+                             size_t caplen,
                              const struct timeval& timestamp,
                              void* user);
 
         // Run.
         static void* run(void* arg);
 
+        // Process the packets of the packet queue until the worker is
+        // stopped and the queue is empty.
+        void dequeue();
+
+        // Remove the expired connections and flush the event writer when
+        // they are due (called after processing each packet).
+        void housekeeping(const struct timeval& timestamp);
+
+        // Remove the expired connections if it is time to do it.
+        void check_expired(uint64_t now);
+
+        // Flush the event writer if it is time to do it.
+        void check_flush();
+
         // Idle.
         static void idle(void* user);
 
         // To microseconds.
         static uint64_t to_microseconds(const struct timeval& tv);
 
+        // Show the counters of the half-open TCP connections.
+        template<typename Counters>
+        static void show_half_open(const char* name, const Counters& counters);
+
+        // Show histogram.
+        template<size_t Bins>
+        static void
+        show_histogram(const char* name,
+                       const char* values,
+                       const char* label,
+                       const util::basic_histogram<Bins>& histogram);
+
         // Disable copy constructor and assignment operator.
         worker(const worker&) = delete;
         worker& operator=(const worker&) = delete;
@@ -202,7 +382,13 @@ namespace net {
                           size_t nprocessor,
                           const char* evdir,
                           uint64_t file_allocation_size,
-                          size_t buffer_size)
+                          size_t buffer_size,
+                          event::compression compression,
+                          size_t writer_buffers,
+                          event::backpressure backpressure,
+                          bool direct_io,
+                          uint64_t rotation_size,
+                          uint64_t rotation_interval)
       : _M_nworker(nworker),
         _M_nprocessor(nprocessor),
         _M_evdir(evdir),
@@ -214,8 +400,14 @@ namespace net {
                                     tcp_ipv6,
                                     udp_ipv4,
                                     udp_ipv6), this),
-        _M_evwriter(file_allocation_size, buffer_size),
-        _M_last_check(time(nullptr))
+        _M_evwriter(file_allocation_size,
+                    buffer_size,
+                    compression,
+                    writer_buffers,
+                    backpressure,
+                    direct_io,
+                    rotation_size,
+                    rotation_interval)
     {
     }
 
@@ -228,119 +420,233 @@ namespace net {
                              unsigned ifindex,
                              int rcvbuf_size,
                              bool promiscuous_mode,
+                             const capture::fanout& fanout,
                              size_t ring_buffer_block_size,
                              size_t ring_buffer_frame_size,
                              size_t ring_buffer_frame_count,
-                             size_t tcp_ipv4_size,
-                             size_t tcp_ipv4_maxconns,
-                             size_t tcp_ipv6_size,
-                             size_t tcp_ipv6_maxconns,
-                             uint64_t tcp_timeout,
-                             uint64_t tcp_time_wait)
+                             bool rxhash,
+                             const tcp::options& tcp_options,
+                             util::slab_pool* tcp_pool)
     {
       _M_capture_method = capture::method::ring_buffer;
+      _M_rxhash = rxhash;
 
       return ((_M_ring_buffer.create(ifindex,
                                      rcvbuf_size,
                                      promiscuous_mode,
                                      ring_buffer_block_size,
                                      ring_buffer_frame_size,
-                                     ring_buffer_frame_count)) &&
+                                     ring_buffer_frame_count,
+                                     fanout)) &&
               (init(device,
-                    tcp_ipv4_size,
-                    tcp_ipv4_maxconns,
-                    tcp_ipv6_size,
-                    tcp_ipv6_maxconns,
-                    tcp_timeout,
-                    tcp_time_wait)));
+                    tcp_options,
+                    tcp_pool)));
     }
 
     inline bool worker::init(const char* device,
                              unsigned ifindex,
                              int rcvbuf_size,
                              bool promiscuous_mode,
-                             size_t tcp_ipv4_size,
-                             size_t tcp_ipv4_maxconns,
-                             size_t tcp_ipv6_size,
-                             size_t tcp_ipv6_maxconns,
-                             uint64_t tcp_timeout,
-                             uint64_t tcp_time_wait)
+                             size_t snaplen,
+                             const capture::fanout& fanout,
+                             const tcp::options& tcp_options,
+                             util::slab_pool* tcp_pool)
     {
       _M_capture_method = capture::method::socket;
 
-      return ((_M_socket.create(ifindex, rcvbuf_size, promiscuous_mode)) &&
+      return ((_M_socket.create(ifindex,
+                                rcvbuf_size,
+                                promiscuous_mode,
+                                snaplen,
+                                fanout)) &&
+              (init(device,
+                    tcp_options,
+                    tcp_pool)));
+    }
+
+    inline bool worker::init(const char* device,
+                             capture::xdp::program& xdp_program,
+                             unsigned xdp_queue,
+                             bool xdp_zero_copy,
+                             size_t xdp_frame_size,
+                             size_t xdp_frame_count,
+                             const tcp::options& tcp_options,
+                             util::slab_pool* tcp_pool)
+    {
+      _M_capture_method = capture::method::xdp;
+
+      return ((_M_xdp.create(xdp_program,
+                             xdp_queue,
+                             xdp_zero_copy,
+                             xdp_frame_size,
+                             xdp_frame_count)) &&
               (init(device,
-                    tcp_ipv4_size,
-                    tcp_ipv4_maxconns,
-                    tcp_ipv6_size,
-                    tcp_ipv6_maxconns,
-                    tcp_timeout,
-                    tcp_time_wait)));
+                    tcp_options,
+                    tcp_pool)));
     }
 
     inline bool worker::init(const char* device,
-                             size_t tcp_ipv4_size,
-                             size_t tcp_ipv4_maxconns,
-                             size_t tcp_ipv6_size,
-                             size_t tcp_ipv6_maxconns,
-                             uint64_t tcp_timeout,
-                             uint64_t tcp_time_wait)
+                             packet_queue* queue,
+                             bool live,
+                             const tcp::options& tcp_options,
+                             util::slab_pool* tcp_pool)
+    {
+      _M_queue = queue;
+      _M_live = live;
+
+      return init(device,
+                  tcp_options,
+                  tcp_pool);
+    }
+
+    inline bool worker::init(const char* device,
+                             const tcp::options& tcp_options,
+                             util::slab_pool* tcp_pool)
     {
       // Compose filename.
-      char filename[128];
-      snprintf(filename,
-               sizeof(filename),
+      snprintf(_M_filename,
+               sizeof(_M_filename),
                "%s/events-%s.%04zu.bin",
                _M_evdir,
                device,
                _M_nworker);
 
+      // The periodic updates of the TCP connections are generated when
+      // checking the expired connections.
+      if ((tcp_options.update_interval > 0) &&
+          (tcp_options.update_interval <
+           static_cast<uint64_t>(check_interval))) {
+        _M_check_interval = tcp_options.update_interval * 1000000ull;
+      }
+
+      // Allocate the connections on the NUMA node of the processor.
+      int node = (_M_nprocessor != no_processor) ?
+                   util::slab_allocator::processor_node(_M_nprocessor) :
+                   -1;
+
       return ((_M_evwriter.init()) &&
-              (_M_tcp_ipv4.init(tcp_ipv4_size,
-                                tcp_ipv4_maxconns,
-                                tcp_timeout,
-                                tcp_time_wait)) &&
-              (_M_tcp_ipv6.init(tcp_ipv6_size,
-                                tcp_ipv6_maxconns,
-                                tcp_timeout,
-                                tcp_time_wait)) &&
-              (_M_evwriter.open(filename)));
+              (_M_tcp_ipv4.init(tcp_options.ipv4_size,
+                                tcp_options.ipv4_maxconns,
+                                tcp_options.timeout,
+                                tcp_options.time_wait,
+                                tcp_options.update_interval,
+                                tcp_options.table,
+                                tcp_options.hash,
+                                tcp_options.untracked,
+                                tcp_options.adopt,
+                                tcp_options.half_open,
+                                tcp_options.syn_flood_threshold,
+                                node,
+                                tcp_pool)) &&
+              (_M_tcp_ipv6.init(tcp_options.ipv6_size,
+                                tcp_options.ipv6_maxconns,
+                                tcp_options.timeout,
+                                tcp_options.time_wait,
+                                tcp_options.update_interval,
+                                tcp_options.table,
+                                tcp_options.hash,
+                                tcp_options.untracked,
+                                tcp_options.adopt,
+                                tcp_options.half_open,
+                                tcp_options.syn_flood_threshold,
+                                node,
+                                tcp_pool)) &&
+              (_M_evwriter.open(_M_filename)));
+    }
+
+    inline bool worker::enable_busy_poll(size_t spins, int usecs)
+    {
+      switch (_M_capture_method) {
+        case capture::method::ring_buffer:
+          return _M_ring_buffer.enable_busy_poll(spins, usecs);
+        case capture::method::socket:
+          return _M_socket.enable_busy_poll(spins, usecs);
+        case capture::method::xdp:
+          return _M_xdp.enable_busy_poll(spins, usecs);
+      }
+
+      return false;
+    }
+
+    inline bool worker::attach_filter(const capture::filter& filter)
+    {
+      switch (_M_capture_method) {
+        case capture::method::ring_buffer:
+          return _M_ring_buffer.attach_filter(filter);
+        case capture::method::socket:
+          return _M_socket.attach_filter(filter);
+        default:
+          return false;
+      }
     }
 
     inline void worker::stop()
     {
       if (_M_running) {
-        _M_running = false;
+        __atomic_store_n(&_M_running, false, __ATOMIC_RELEASE);
 
-        if (_M_capture_method == capture::method::ring_buffer) {
-          _M_ring_buffer.stop();
-        } else {
-          _M_socket.stop();
+        // If the worker receives the packets through a packet queue, the
+        // thread exits once the queue is empty.
+        if (_M_queue) {
+          pthread_join(_M_thread, nullptr);
+          return;
+        }
+
+        switch (_M_capture_method) {
+          case capture::method::ring_buffer:
+            _M_ring_buffer.stop();
+            break;
+          case capture::method::socket:
+            _M_socket.stop();
+            break;
+          case capture::method::xdp:
+            _M_xdp.stop();
+            break;
         }
 
         pthread_join(_M_thread, nullptr);
       }
     }
 
+    inline bool worker::close()
+    {
+      return _M_evwriter.close();
+    }
+
     inline bool worker::process_ethernet(const void* buf,
                                          size_t len,
+                                         size_t wirelen,
                                          const struct timeval& timestamp)
     {
-      return _M_parser.process_ethernet(buf, len, timestamp);
+      bool ret = _M_parser.process_ethernet(buf, len, wirelen, timestamp);
+
+      housekeeping(timestamp);
+
+      return ret;
     }
 
     inline bool worker::process_ipv4(const void* buf,
                                      size_t len,
+                                     size_t wirelen,
                                      const struct timeval& timestamp)
     {
-      return _M_parser.process_ipv4(buf, len, timestamp);
+      bool ret = _M_parser.process_ipv4(buf, len, wirelen, timestamp);
+
+      housekeeping(timestamp);
+
+      return ret;
     }
 
     inline bool worker::process_ipv6(const void* buf,
                                      size_t len,
+                                     size_t wirelen,
                                      const struct timeval& timestamp)
     {
-      return _M_parser.process_ipv6(buf, len, timestamp);
+      bool ret = _M_parser.process_ipv6(buf, len, wirelen, timestamp);
+
+      housekeeping(timestamp);
+
+      return ret;
     }
 
     inline void worker::remove_expired(uint64_t now)
@@ -353,26 +659,174 @@ namespace net {
     {
       printf("Worker %zu:\n", _M_nworker);
 
-      if (_M_capture_method == capture::method::ring_buffer) {
-        return _M_ring_buffer.show_statistics();
-      } else {
-        return _M_socket.show_statistics();
+      show_memory_usage();
+      show_hash_statistics();
+
+      // Wait for the I/O thread of the event writer before showing its
+      // counters.
+      _M_evwriter.sync();
+      show_writer_statistics();
+
+      if (_M_queue) {
+        printf("  %llu packets received through the packet queue.\n",
+               static_cast<unsigned long long>(_M_queued_packets));
+
+        return true;
+      }
+
+      switch (_M_capture_method) {
+        case capture::method::ring_buffer:
+          return _M_ring_buffer.show_statistics();
+        case capture::method::socket:
+          return _M_socket.show_statistics();
+        case capture::method::xdp:
+          return _M_xdp.show_statistics();
+      }
+
+      return false;
+    }
+
+    inline void worker::show_memory_usage() const
+    {
+      printf("  TCP/IPv4: %zu connections, %zu KiB (peak: %zu KiB).\n",
+             _M_tcp_ipv4.count(),
+             _M_tcp_ipv4.memory() / 1024,
+             _M_tcp_ipv4.max_memory() / 1024);
+
+      printf("  TCP/IPv6: %zu connections, %zu KiB (peak: %zu KiB).\n",
+             _M_tcp_ipv6.count(),
+             _M_tcp_ipv6.memory() / 1024,
+             _M_tcp_ipv6.max_memory() / 1024);
+
+      if (_M_tcp_ipv4.half_open_enabled()) {
+        show_half_open("TCP/IPv4", _M_tcp_ipv4.half_open());
+        show_half_open("TCP/IPv6", _M_tcp_ipv6.half_open());
+      }
+    }
+
+    inline void worker::show_pool(const util::slab_pool& pool)
+    {
+      printf("TCP memory: %zu MiB of %zu MiB (%zu MiB free).\n",
+             (pool.slabs() * util::slab_pool::slab_size) >> 20,
+             (pool.max_slabs() * util::slab_pool::slab_size) >> 20,
+             (pool.free_slabs() * util::slab_pool::slab_size) >> 20);
+    }
+
+    inline void worker::show_hash_statistics() const
+    {
+      show_histogram("TCP/IPv4", "lookups", "probes", _M_tcp_ipv4.probes());
+      show_histogram("TCP/IPv4",
+                     "insertions",
+                     "chain length",
+                     _M_tcp_ipv4.chains());
+
+      show_histogram("TCP/IPv6", "lookups", "probes", _M_tcp_ipv6.probes());
+      show_histogram("TCP/IPv6",
+                     "insertions",
+                     "chain length",
+                     _M_tcp_ipv6.chains());
+    }
+
+    inline void worker::show_writer_statistics() const
+    {
+      if (_M_evwriter.buffers() > 0) {
+        const event::writer::io_counters& io = _M_evwriter.io();
+
+        printf("  Event writer: %llu blocks handed over to the I/O thread "
+               "(%zu buffer%s), %llu stalls (%llu us), %llu blocks dropped "
+               "(%llu events).\n",
+               static_cast<unsigned long long>(io.blocks),
+               _M_evwriter.buffers(),
+               (_M_evwriter.buffers() != 1) ? "s" : "",
+               static_cast<unsigned long long>(io.stalls),
+               static_cast<unsigned long long>(io.stall_time),
+               static_cast<unsigned long long>(io.dropped_blocks),
+               static_cast<unsigned long long>(io.dropped_events));
+
+        show_histogram("Event writer", "blocks", "latency (us)", io.latency);
+      }
+    }
+
+    template<typename Counters>
+    inline void worker::show_half_open(const char* name,
+                                       const Counters& counters)
+    {
+      printf("  %s: %llu connection attempts, %llu established, %llu reset, "
+             "%llu unanswered (%llu evicted).\n",
+             name,
+             static_cast<unsigned long long>(counters.attempts),
+             static_cast<unsigned long long>(counters.established),
+             static_cast<unsigned long long>(counters.reset),
+             static_cast<unsigned long long>(counters.unanswered),
+             static_cast<unsigned long long>(counters.evicted));
+    }
+
+    template<size_t Bins>
+    inline void
+    worker::show_histogram(const char* name,
+                           const char* values,
+                           const char* label,
+                           const util::basic_histogram<Bins>& histogram)
+    {
+      unsigned long long total = histogram.total();
+
+      if (total == 0) {
+        printf("  %s %s: 0.\n", name, values);
+        return;
+      }
+
+      printf("  %s %s: %llu, %s:", name, values, total, label);
+
+      const char* separator = "";
+
+      for (size_t i = 0; i < Bins; i++) {
+        unsigned long long count = histogram.count(i);
+
+        if (count > 0) {
+          uint32_t lower = util::basic_histogram<Bins>::lower(i);
+          uint32_t upper = util::basic_histogram<Bins>::upper(i);
+
+          if (lower == upper) {
+            printf("%s %u: %llu", separator, lower, count);
+          } else if (upper == UINT32_MAX) {
+            printf("%s %u+: %llu", separator, lower, count);
+          } else {
+            printf("%s %u-%u: %llu", separator, lower, upper, count);
+          }
+
+          separator = ",";
+        }
       }
+
+      printf(" (max: %u).\n", histogram.max());
+    }
+
+    inline const char* worker::filename() const
+    {
+      return _M_filename;
     }
 
     inline void* worker::run(void* arg)
     {
-      if (static_cast<worker*>(arg)->_M_capture_method ==
-          capture::method::ring_buffer) {
-        static_cast<worker*>(arg)->_M_ring_buffer.loop(
-          capture::callbacks(process_ethernet, idle),
-          arg
-        );
-      } else {
-        static_cast<worker*>(arg)->_M_socket.loop(
-          capture::callbacks(process_ethernet, idle),
-          arg
-        );
+      if (static_cast<worker*>(arg)->_M_queue) {
+        static_cast<worker*>(arg)->dequeue();
+        return nullptr;
+      }
+
+      // The frames are received in batches.
+      capture::callbacks callbacks(process_ethernet, idle);
+      callbacks.batch = process_batch;
+
+      switch (static_cast<worker*>(arg)->_M_capture_method) {
+        case capture::method::ring_buffer:
+          static_cast<worker*>(arg)->_M_ring_buffer.loop(callbacks, arg);
+          break;
+        case capture::method::socket:
+          static_cast<worker*>(arg)->_M_socket.loop(callbacks, arg);
+          break;
+        case capture::method::xdp:
+          static_cast<worker*>(arg)->_M_xdp.loop(callbacks, arg);
+          break;
       }
 
       return nullptr;
@@ -380,10 +834,62 @@ namespace net {
 
     inline bool worker::process_ethernet(const void* buf,
                                          size_t len,
+                                         size_t wirelen,
                                          const struct timeval& timestamp,
                                          void* user)
     {
-      return static_cast<worker*>(user)->process_ethernet(buf, len, timestamp);
+      return static_cast<worker*>(user)->process_ethernet(buf,
+                                                          len,
+                                                          wirelen,
+                                                          timestamp);
+    }
+
+    inline bool worker::process_batch(const capture::frame* frames,
+                                      size_t nframes,
+                                      void* user)
+    {
+      return static_cast<worker*>(user)->process_ethernet(frames, nframes);
+    }
+
+    inline void worker::housekeeping(const struct timeval& timestamp)
+    {
+      // The time of the packets drives the expiration of the connections,
+      // so it works the same way when processing PCAP files.
+      check_expired(to_microseconds(timestamp));
+
+      // Reading the clock for every packet is too expensive.
+      if (++_M_npackets == clock_check_packets) {
+        check_flush();
+
+        _M_npackets = 0;
+      }
+    }
+
+    inline void worker::check_expired(uint64_t now)
+    {
+      // If we have to check now the expired connections...
+      if (now >= _M_next_check) {
+        // Not the first check?
+        if (_M_next_check != 0) {
+          remove_expired(now);
+        }
+
+        _M_next_check = now + _M_check_interval;
+      }
+    }
+
+    inline void worker::check_flush()
+    {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+      // If we have to flush now the event writer...
+      if (now.tv_sec >= _M_next_flush) {
+        // Flush event writer buffer (if not empty).
+        _M_evwriter.flush();
+
+        _M_next_flush = now.tv_sec + flush_interval;
+      }
     }
 
     inline void worker::idle(void* user)
@@ -395,13 +901,9 @@ namespace net {
       struct timeval now;
       gettimeofday(&now, nullptr);
 
-      // If we have to check now the expired connections...
-      if (static_cast<worker*>(user)->_M_last_check + check_interval <=
-          now.tv_sec) {
-        static_cast<worker*>(user)->remove_expired(to_microseconds(now));
-
-        static_cast<worker*>(user)->_M_last_check = now.tv_sec;
-      }
+      // Remove the expired connections (there are no packets for driving
+      // the expiration).
+      static_cast<worker*>(user)->check_expired(to_microseconds(now));
     }
 
     inline uint64_t worker::to_microseconds(const struct timeval& tv)
@@ -6,31 +6,54 @@ bool net::mon::workers::create(size_t nworkers,
                                const char* evdir,
                                uint64_t file_allocation_size,
                                size_t buffer_size,
+                               event::compression compression,
+                               size_t writer_buffers,
+                               event::backpressure backpressure,
+                               bool direct_io,
+                               uint64_t rotation_size,
+                               uint64_t rotation_interval,
                                capture::method capture_method,
                                const char* device,
                                unsigned ifindex,
                                int rcvbuf_size,
                                bool promiscuous_mode,
+                               capture::fanout::mode fanout_mode,
+                               bool fanout_rollover,
+                               int fanout_group,
+                               const char* fanout_program,
                                size_t ring_buffer_block_size,
                                size_t ring_buffer_frame_size,
                                size_t ring_buffer_frame_count,
-                               size_t tcp_ipv4_size,
-                               size_t tcp_ipv4_maxconns,
-                               size_t tcp_ipv6_size,
-                               size_t tcp_ipv6_maxconns,
-                               uint64_t tcp_timeout,
-                               uint64_t tcp_time_wait)
+                               bool dispatch,
+                               bool rxhash,
+                               capture::xdp::mode xdp_mode,
+                               unsigned xdp_queue,
+                               bool xdp_zero_copy,
+                               size_t xdp_frame_size,
+                               size_t xdp_frame_count,
+                               size_t busy_poll_spins,
+                               int busy_poll_usecs,
+                               const capture::filter* filter,
+                               size_t snaplen,
+                               const tcp::options& tcp_options)
 {
   if ((nworkers >= min_workers) &&
       (nworkers <= max_workers) &&
       (buffer_size >= event::writer::min_buffer_size)) {
     // Create threads.
     for (size_t i = 0; i < nworkers; i++) {
-      if ((_M_workers[i] = new (std::nothrow) worker(i,
-                                                     processors[i],
-                                                     evdir,
-                                                     file_allocation_size,
-                                                     buffer_size)) == nullptr) {
+      if ((_M_workers[i] =
+             new (std::nothrow) worker(i,
+                                       processors[i],
+                                       evdir,
+                                       file_allocation_size,
+                                       buffer_size,
+                                       compression,
+                                       writer_buffers,
+                                       backpressure,
+                                       direct_io,
+                                       rotation_size,
+                                       rotation_interval)) == nullptr) {
         _M_nworkers = i;
         return false;
       }
@@ -38,6 +61,64 @@ bool net::mon::workers::create(size_t nworkers,
 
     _M_nworkers = nworkers;
 
+    // Shared budget of memory of the TCP connections?
+    util::slab_pool* tcp_pool = nullptr;
+    if (tcp_options.memory > 0) {
+      if (!_M_tcp_pool.init(tcp_options.memory /
+                            util::slab_pool::slab_size)) {
+        return false;
+      }
+
+      tcp_pool = &_M_tcp_pool;
+    }
+
+    // Software RSS?
+    if (dispatch) {
+      if ((capture_method == capture::method::ring_buffer) &&
+          ((_M_dispatcher = new (std::nothrow) dispatcher()) != nullptr) &&
+          (_M_dispatcher->create(ifindex,
+                                 rcvbuf_size,
+                                 promiscuous_mode,
+                                 ring_buffer_block_size,
+                                 ring_buffer_frame_size,
+                                 ring_buffer_frame_count,
+                                 rxhash,
+                                 nworkers,
+                                 dispatcher::default_queue_size))) {
+        // Initialize threads.
+        for (size_t i = 0; i < nworkers; i++) {
+          if (!_M_workers[i]->init(device,
+                                   _M_dispatcher->queue(i),
+                                   true,
+                                   tcp_options,
+                                   tcp_pool)) {
+            return false;
+          }
+        }
+
+        // Enable busy poll.
+        if (((busy_poll_spins > 0) || (busy_poll_usecs > 0)) &&
+            (!_M_dispatcher->enable_busy_poll(busy_poll_spins,
+                                              busy_poll_usecs))) {
+          return false;
+        }
+
+        // Attach filter.
+        return ((!filter) || (_M_dispatcher->attach_filter(*filter)));
+      }
+
+      return false;
+    }
+
+    // Initialize fanout group (not used by the AF_XDP sockets).
+    if ((capture_method != capture::method::xdp) &&
+        (!_M_fanout.init(fanout_mode,
+                         fanout_rollover,
+                         fanout_group,
+                         fanout_program))) {
+      return false;
+    }
+
     // Initialize threads.
     if (capture_method == capture::method::ring_buffer) {
       for (size_t i = 0; i < nworkers; i++) {
@@ -45,15 +126,32 @@ bool net::mon::workers::create(size_t nworkers,
                                  ifindex,
                                  rcvbuf_size,
                                  promiscuous_mode,
+                                 _M_fanout,
                                  ring_buffer_block_size,
                                  ring_buffer_frame_size,
                                  ring_buffer_frame_count,
-                                 tcp_ipv4_size,
-                                 tcp_ipv4_maxconns,
-                                 tcp_ipv6_size,
-                                 tcp_ipv6_maxconns,
-                                 tcp_timeout,
-                                 tcp_time_wait)) {
+                                 rxhash,
+                                 tcp_options,
+                                 tcp_pool)) {
+          return false;
+        }
+      }
+    } else if (capture_method == capture::method::xdp) {
+      // Load the XDP program and attach it to the interface. The worker 'i'
+      // receives the packets of the queue 'xdp_queue + i'.
+      if (!_M_xdp_program.create(ifindex, xdp_mode, xdp_queue + nworkers)) {
+        return false;
+      }
+
+      for (size_t i = 0; i < nworkers; i++) {
+        if (!_M_workers[i]->init(device,
+                                 _M_xdp_program,
+                                 xdp_queue + i,
+                                 xdp_zero_copy,
+                                 xdp_frame_size,
+                                 xdp_frame_count,
+                                 tcp_options,
+                                 tcp_pool)) {
           return false;
         }
       }
@@ -63,12 +161,29 @@ bool net::mon::workers::create(size_t nworkers,
                                  ifindex,
                                  rcvbuf_size,
                                  promiscuous_mode,
-                                 tcp_ipv4_size,
-                                 tcp_ipv4_maxconns,
-                                 tcp_ipv6_size,
-                                 tcp_ipv6_maxconns,
-                                 tcp_timeout,
-                                 tcp_time_wait)) {
+                                 snaplen,
+                                 _M_fanout,
+                                 tcp_options,
+                                 tcp_pool)) {
+          return false;
+        }
+      }
+    }
+
+    // Enable busy poll.
+    if ((busy_poll_spins > 0) || (busy_poll_usecs > 0)) {
+      for (size_t i = 0; i < nworkers; i++) {
+        if (!_M_workers[i]->enable_busy_poll(busy_poll_spins,
+                                             busy_poll_usecs)) {
+          return false;
+        }
+      }
+    }
+
+    // Attach filter.
+    if (filter) {
+      for (size_t i = 0; i < nworkers; i++) {
+        if (!_M_workers[i]->attach_filter(*filter)) {
           return false;
         }
       }
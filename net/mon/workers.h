@@ -3,7 +3,9 @@
 
 #include <sys/types.h>
 #include "net/mon/worker.h"
+#include "net/mon/dispatcher.h"
 #include "net/capture/method.h"
+#include "util/slab_pool.h"
 
 namespace net {
   namespace mon {
@@ -20,25 +22,47 @@ namespace net {
         ~workers();
 
         // Create workers.
+        // 'dispatch': whether a single thread captures the packets with a
+        // ring buffer and dispatches them to the workers (software RSS).
+        // 'rxhash': whether the hash computed by the kernel is used for the
+        // TCP/IPv4 connections.
+        // 'tcp_options': options of the TCP connections ('memory' is the
+        // memory of the TCP connections of all the workers).
         bool create(size_t nworkers,
                     const size_t* processors,
                     const char* evdir,
                     uint64_t file_allocation_size,
                     size_t buffer_size,
+                    event::compression compression,
+                    size_t writer_buffers,
+                    event::backpressure backpressure,
+                    bool direct_io,
+                    uint64_t rotation_size,
+                    uint64_t rotation_interval,
                     capture::method capture_method,
                     const char* device,
                     unsigned ifindex,
                     int rcvbuf_size,
                     bool promiscuous_mode,
+                    capture::fanout::mode fanout_mode,
+                    bool fanout_rollover,
+                    int fanout_group,
+                    const char* fanout_program,
                     size_t ring_buffer_block_size,
                     size_t ring_buffer_frame_size,
                     size_t ring_buffer_frame_count,
-                    size_t tcp_ipv4_size,
-                    size_t tcp_ipv4_maxconns,
-                    size_t tcp_ipv6_size,
-                    size_t tcp_ipv6_maxconns,
-                    uint64_t tcp_timeout,
-                    uint64_t tcp_time_wait);
+                    bool dispatch,
+                    bool rxhash,
+                    capture::xdp::mode xdp_mode,
+                    unsigned xdp_queue,
+                    bool xdp_zero_copy,
+                    size_t xdp_frame_size,
+                    size_t xdp_frame_count,
+                    size_t busy_poll_spins,
+                    int busy_poll_usecs,
+                    const capture::filter* filter,
+                    size_t snaplen,
+                    const tcp::options& tcp_options);
 
         // Start workers.
         bool start();
@@ -49,6 +73,9 @@ namespace net {
         // Show statistics.
         bool show_statistics();
 
+        // Show the histograms of the TCP connection hash tables.
+        void show_hash_statistics() const;
+
       private:
         // Workers.
         worker* _M_workers[max_workers];
@@ -56,6 +83,19 @@ namespace net {
         // Number of workers.
         size_t _M_nworkers = 0;
 
+        // Fanout group (ring buffer and socket capture methods).
+        capture::fanout _M_fanout;
+
+        // XDP program (AF_XDP capture method).
+        capture::xdp::program _M_xdp_program;
+
+        // Dispatcher (software RSS).
+        dispatcher* _M_dispatcher = nullptr;
+
+        // Slabs of the TCP connections of all the workers (the workers are
+        // deleted before the pool).
+        util::slab_pool _M_tcp_pool;
+
         // Disable copy constructor and assignment operator.
         workers(const workers&) = delete;
         workers& operator=(const workers&) = delete;
@@ -63,9 +103,19 @@ namespace net {
 
     inline workers::~workers()
     {
+      // Stop the dispatcher before the workers.
+      if (_M_dispatcher) {
+        _M_dispatcher->stop();
+      }
+
       for (size_t i = 0; i < _M_nworkers; i++) {
         delete _M_workers[i];
       }
+
+      // The workers have processed the packets of the dispatcher.
+      if (_M_dispatcher) {
+        delete _M_dispatcher;
+      }
     }
 
     inline bool workers::start()
@@ -76,11 +126,17 @@ namespace net {
         }
       }
 
-      return true;
+      return _M_dispatcher ? _M_dispatcher->start() : true;
     }
 
     inline void workers::stop()
     {
+      // Stop the dispatcher first (the workers process the packets of their
+      // queues before exiting).
+      if (_M_dispatcher) {
+        _M_dispatcher->stop();
+      }
+
       for (size_t i = 0; i < _M_nworkers; i++) {
         _M_workers[i]->stop();
       }
@@ -88,14 +144,31 @@ namespace net {
 
     inline bool workers::show_statistics()
     {
+      if ((_M_dispatcher) && (!_M_dispatcher->show_statistics())) {
+        return false;
+      }
+
       for (size_t i = 0; i < _M_nworkers; i++) {
         if (!_M_workers[i]->show_statistics()) {
           return false;
         }
       }
 
+      if (_M_tcp_pool.max_slabs() > 0) {
+        worker::show_pool(_M_tcp_pool);
+      }
+
       return true;
     }
+
+    inline void workers::show_hash_statistics() const
+    {
+      for (size_t i = 0; i < _M_nworkers; i++) {
+        printf("Worker %zu:\n", i);
+
+        _M_workers[i]->show_hash_statistics();
+      }
+    }
   }
 }
 
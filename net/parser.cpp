@@ -4,24 +4,26 @@
 
 bool net::parser::process_ethernet(const void* buf,
                                    size_t len,
+                                   size_t wirelen,
                                    const struct timeval& timestamp)
 {
   // If the frame is big enough...
-  if (len > sizeof(struct ether_header)) {
+  if ((len > sizeof(struct ether_header)) && (wirelen >= len)) {
     // Make 'b' point to the ether_type.
     const uint8_t* b = static_cast<const uint8_t*>(buf) +
                        (sizeof(struct ether_addr) << 1);
 
     // Subtract length of the ethernet header.
     len -= sizeof(struct ether_header);
+    wirelen -= sizeof(struct ether_header);
 
     do {
       // Check ether_type.
       switch ((static_cast<uint16_t>(*b) << 8) | b[1]) {
         case ETH_P_IP:
-          return process_ipv4(b + 2, len, timestamp);
+          return process_ipv4(b + 2, len, wirelen, timestamp);
         case ETH_P_IPV6:
-          return process_ipv6(b + 2, len, timestamp);
+          return process_ipv6(b + 2, len, wirelen, timestamp);
         case ETH_P_8021Q:
         case ETH_P_8021AD:
           // If the frame is big enough...
@@ -30,6 +32,7 @@ bool net::parser::process_ethernet(const void* buf,
             b += 4;
 
             len -= 4;
+            wirelen -= 4;
           } else {
             return false;
           }
@@ -49,16 +52,22 @@ bool net::parser::process_ethernet(const void* buf,
                          (static_cast<uint32_t>(b[1]) << 8) |
                          (static_cast<uint32_t>(b[2]) >> 4)) & 0x0fffff) {
                   case 0: // IPv4.
-                    return process_ipv4(b + 4, len - 4, timestamp);
+                    return process_ipv4(b + 4, len - 4, wirelen - 4, timestamp);
                   case 2: // IPv6.
-                    return process_ipv6(b + 4, len - 4, timestamp);
+                    return process_ipv6(b + 4, len - 4, wirelen - 4, timestamp);
                   default:
                     // Check IP version.
                     switch (b[4] & 0xf0) {
                       case 0x40: // IPv4.
-                        return process_ipv4(b + 4, len - 4, timestamp);
+                        return process_ipv4(b + 4,
+                                            len - 4,
+                                            wirelen - 4,
+                                            timestamp);
                       case 0x60: // IPv6.
-                        return process_ipv6(b + 4, len - 4, timestamp);
+                        return process_ipv6(b + 4,
+                                            len - 4,
+                                            wirelen - 4,
+                                            timestamp);
                       default:
                         // Ignore frame.
                         return true;
@@ -69,6 +78,7 @@ bool net::parser::process_ethernet(const void* buf,
                 b += 4;
 
                 len -= 4;
+                wirelen -= 4;
               }
             } else {
               return false;
@@ -88,38 +98,53 @@ bool net::parser::process_ethernet(const void* buf,
 
 bool net::parser::process_ipv4(const void* buf,
                                size_t len,
+                               size_t wirelen,
                                const struct timeval& timestamp)
 {
   // If the packet is big enough...
   if (len > sizeof(struct iphdr)) {
     const struct iphdr* iphdr = static_cast<const struct iphdr*>(buf);
 
-    // Sanity check.
+    // Size of the IP header.
+    size_t iphdrsize = static_cast<size_t>(iphdr->ihl) << 2;
+
+    // Size of the IP packet.
+    size_t pktsize = ntohs(iphdr->tot_len);
+
+    // Sanity check (the frame might have been truncated by the capture and
+    // might include ethernet padding).
     if ((iphdr->ihl >= 5) &&
-        (len > (static_cast<size_t>(iphdr->ihl) << 2)) &&
-        (len == ntohs(iphdr->tot_len))) {
+        (len > iphdrsize) &&
+        (pktsize > iphdrsize) &&
+        (pktsize <= wirelen)) {
+      // Number of bytes of the IP packet captured.
+      size_t caplen = (len < pktsize) ? len : pktsize;
+
       switch (iphdr->protocol) {
         case IPPROTO_ICMP:
           return _M_callbacks.icmp ? 
                    _M_callbacks.icmp(iphdr,
-                                     iphdr->ihl << 2,
-                                     len,
+                                     iphdrsize,
+                                     pktsize,
+                                     caplen,
                                      timestamp,
                                      _M_user) :
                    true;
         case IPPROTO_TCP:
           return _M_callbacks.tcp_ipv4 ? 
                    _M_callbacks.tcp_ipv4(iphdr,
-                                         iphdr->ihl << 2,
-                                         len,
+                                         iphdrsize,
+                                         pktsize,
+                                         caplen,
                                          timestamp,
                                          _M_user) :
                    true;
         case IPPROTO_UDP:
           return _M_callbacks.udp_ipv4 ?
                    _M_callbacks.udp_ipv4(iphdr,
-                                         iphdr->ihl << 2,
-                                         len,
+                                         iphdrsize,
+                                         pktsize,
+                                         caplen,
                                          timestamp,
                                          _M_user) :
                    true;
@@ -135,24 +160,31 @@ bool net::parser::process_ipv4(const void* buf,
 
 bool net::parser::process_ipv6(const void* buf,
                                size_t len,
+                               size_t wirelen,
                                const struct timeval& timestamp)
 {
   // If the packet is big enough...
   if (len > sizeof(struct ip6_hdr)) {
     const struct ip6_hdr* iphdr = static_cast<const struct ip6_hdr*>(buf);
 
-    // Get payload length (including extension headers).
-    uint16_t payload_length = ntohs(iphdr->ip6_plen);
+    // Size of the IP packet (the payload length includes the extension
+    // headers).
+    size_t pktsize = sizeof(struct ip6_hdr) + ntohs(iphdr->ip6_plen);
+
+    // Sanity check (the frame might have been truncated by the capture and
+    // might include ethernet padding).
+    if ((pktsize > sizeof(struct ip6_hdr)) && (pktsize <= wirelen)) {
+      // Number of bytes of the IP packet captured.
+      size_t caplen = (len < pktsize) ? len : pktsize;
 
-    // Sanity check.
-    if (sizeof(struct ip6_hdr) + payload_length == len) {
       uint8_t nxt;
       switch (nxt = iphdr->ip6_nxt) {
         case IPPROTO_ICMPV6:
           return _M_callbacks.icmpv6 ?
                    _M_callbacks.icmpv6(iphdr,
                                        sizeof(struct ip6_hdr),
-                                       len,
+                                       pktsize,
+                                       caplen,
                                        timestamp,
                                        _M_user) :
                    true;
@@ -160,7 +192,8 @@ bool net::parser::process_ipv6(const void* buf,
           return _M_callbacks.tcp_ipv6 ?
                    _M_callbacks.tcp_ipv6(iphdr,
                                          sizeof(struct ip6_hdr),
-                                         len,
+                                         pktsize,
+                                         caplen,
                                          timestamp,
                                          _M_user) :
                    true;
@@ -168,7 +201,8 @@ bool net::parser::process_ipv6(const void* buf,
           return _M_callbacks.udp_ipv6 ?
                    _M_callbacks.udp_ipv6(iphdr,
                                          sizeof(struct ip6_hdr),
-                                         len,
+                                         pktsize,
+                                         caplen,
                                          timestamp,
                                          _M_user) :
                    true;
@@ -176,8 +210,11 @@ bool net::parser::process_ipv6(const void* buf,
           {
             size_t off = sizeof(struct ip6_hdr);
 
+            // Number of bytes captured after the current header.
+            size_t left = caplen - off;
+
             while (is_extension_header(nxt)) {
-              if (payload_length >= sizeof(struct ip6_ext)) {
+              if (left >= sizeof(struct ip6_ext)) {
                 const struct ip6_ext* ext =
                       reinterpret_cast<const struct ip6_ext*>(
                         static_cast<const uint8_t*>(buf) + off
@@ -186,7 +223,7 @@ bool net::parser::process_ipv6(const void* buf,
                 // Compute length of the extension header.
                 size_t extlen = (ext->ip6e_len + 1) << 3;
 
-                if (extlen <= payload_length) {
+                if (extlen < left) {
                   off += extlen;
 
                   switch (nxt = ext->ip6e_nxt) {
@@ -194,7 +231,8 @@ bool net::parser::process_ipv6(const void* buf,
                       return _M_callbacks.icmpv6 ?
                                _M_callbacks.icmpv6(iphdr,
                                                    off,
-                                                   len,
+                                                   pktsize,
+                                                   caplen,
                                                    timestamp,
                                                    _M_user) :
                                true;
@@ -202,7 +240,8 @@ bool net::parser::process_ipv6(const void* buf,
                       return _M_callbacks.tcp_ipv6 ?
                                _M_callbacks.tcp_ipv6(iphdr,
                                                      off,
-                                                     len,
+                                                     pktsize,
+                                                     caplen,
                                                      timestamp,
                                                      _M_user) :
                                true;
@@ -210,12 +249,13 @@ bool net::parser::process_ipv6(const void* buf,
                       return _M_callbacks.udp_ipv6 ?
                                _M_callbacks.udp_ipv6(iphdr,
                                                      off,
-                                                     len,
+                                                     pktsize,
+                                                     caplen,
                                                      timestamp,
                                                      _M_user) :
                                true;
                     default:
-                      payload_length -= extlen;
+                      left -= extlen;
                   }
                 } else {
                   return false;
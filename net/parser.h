@@ -7,16 +7,26 @@
 #include <netinet/in.h>
 #include <netinet/ip.h>
 #include <netinet/ip6.h>
+#include "net/capture/callbacks.h"
 
 namespace net {
   class parser {
     public:
+      // Number of frames ahead whose headers are prefetched when processing
+      // a batch of frames.
+      static constexpr const size_t prefetch_distance = 4;
+
       // Parser callbacks.
+      //
+      // 'pktsize': size of the IP packet on the wire.
+      // 'caplen': number of bytes of the IP packet which have been captured
+      //           (caplen <= pktsize).
       struct callbacks {
         // Process ICMP datagram.
         typedef bool (*icmp_t)(const struct iphdr* iphdr,
                                size_t iphdrsize,
                                size_t pktsize,
+                               size_t caplen,
                                const struct timeval& timestamp,
                                void* user);
 
@@ -24,6 +34,7 @@ namespace net {
         typedef bool (*icmpv6_t)(const struct ip6_hdr* iphdr,
                                  size_t iphdrsize,
                                  size_t pktsize,
+                                 size_t caplen,
                                  const struct timeval& timestamp,
                                  void* user);
 
@@ -31,6 +42,7 @@ namespace net {
         typedef bool (*tcp_ipv4_t)(const struct iphdr* iphdr,
                                    size_t iphdrsize,
                                    size_t pktsize,
+                                   size_t caplen,
                                    const struct timeval& timestamp,
                                    void* user);
 
@@ -38,6 +50,7 @@ namespace net {
         typedef bool (*tcp_ipv6_t)(const struct ip6_hdr* iphdr,
                                    size_t iphdrsize,
                                    size_t pktsize,
+                                   size_t caplen,
                                    const struct timeval& timestamp,
                                    void* user);
 
@@ -45,6 +58,7 @@ namespace net {
         typedef bool (*udp_ipv4_t)(const struct iphdr* iphdr,
                                    size_t iphdrsize,
                                    size_t pktsize,
+                                   size_t caplen,
                                    const struct timeval& timestamp,
                                    void* user);
 
@@ -52,6 +66,7 @@ namespace net {
         typedef bool (*udp_ipv6_t)(const struct ip6_hdr* iphdr,
                                    size_t iphdrsize,
                                    size_t pktsize,
+                                   size_t caplen,
                                    const struct timeval& timestamp,
                                    void* user);
 
@@ -82,18 +97,29 @@ namespace net {
       ~parser() = default;
 
       // Process ethernet frame.
+      // 'len': number of bytes captured.
+      // 'wirelen': length of the frame on the wire.
       bool process_ethernet(const void* buf,
                             size_t len,
+                            size_t wirelen,
                             const struct timeval& timestamp);
 
+      // Process batch of ethernet frames.
+      bool process_ethernet(const capture::frame* frames, size_t nframes);
+
+      // Prefetch the headers of a frame.
+      static void prefetch(const void* buf);
+
       // Process IPv4 packet.
       bool process_ipv4(const void* buf,
                         size_t len,
+                        size_t wirelen,
                         const struct timeval& timestamp);
 
       // Process IPv6 packet.
       bool process_ipv6(const void* buf,
                         size_t len,
+                        size_t wirelen,
                         const struct timeval& timestamp);
 
     private:
@@ -126,6 +152,42 @@ namespace net {
   {
   }
 
+  inline bool parser::process_ethernet(const capture::frame* frames,
+                                       size_t nframes)
+  {
+    // Prefetch the headers of the first frames.
+    for (size_t i = 0; (i < prefetch_distance) && (i < nframes); i++) {
+      prefetch(frames[i].buf);
+    }
+
+    bool ret = true;
+
+    for (size_t i = 0; i < nframes; i++) {
+      // Prefetch the headers of a next frame.
+      if (i + prefetch_distance < nframes) {
+        prefetch(frames[i + prefetch_distance].buf);
+      }
+
+      // Process frame (an error in a frame doesn't stop the processing of
+      // the batch).
+      if (!process_ethernet(frames[i].buf,
+                            frames[i].len,
+                            frames[i].wirelen,
+                            frames[i].timestamp)) {
+        ret = false;
+      }
+    }
+
+    return ret;
+  }
+
+  inline void parser::prefetch(const void* buf)
+  {
+    // Ethernet, IP and TCP / UDP headers (two cache lines).
+    __builtin_prefetch(buf);
+    __builtin_prefetch(static_cast<const uint8_t*>(buf) + 64);
+  }
+
   inline bool parser::is_extension_header(uint8_t nxt)
   {
     switch (nxt) {
@@ -2,33 +2,13 @@
 #include <stdio.h>
 #include <signal.h>
 #include "net/mon/workers.h"
+#include "net/mon/pcap_workers.h"
 #include "net/mon/configuration.h"
 #include "net/capture/method.h"
-#include "pcap/reader.h"
 
-static bool process_pcap_file(const net::mon::configuration& config);
+static bool process_pcap_files(const net::mon::configuration& config);
 static bool process_interface(const net::mon::configuration& config);
 
-static bool ethernet(const void* buf,
-                     size_t len,
-                     const pcap::timeval& ts,
-                     void* user);
-
-static bool ipv4(const void* buf,
-                 size_t len,
-                 const pcap::timeval& ts,
-                 void* user);
-
-static bool ipv6(const void* buf,
-                 size_t len,
-                 const pcap::timeval& ts,
-                 void* user);
-
-struct pcap_argument {
-  net::mon::worker* worker;
-  const pcap::reader* reader;
-};
-
 int main(int argc, const char** argv)
 {
   // Initialize configuration.
@@ -40,7 +20,7 @@ int main(int argc, const char** argv)
       config.print();
 
       if (config.cap.m == net::mon::configuration::capture::method::pcap) {
-        if (process_pcap_file(config)) {
+        if (process_pcap_files(config)) {
           return 0;
         }
       } else {
@@ -58,53 +38,49 @@ int main(int argc, const char** argv)
   return -1;
 }
 
-bool process_pcap_file(const net::mon::configuration& config)
+bool process_pcap_files(const net::mon::configuration& config)
 {
-  // Open PCAP file.
-  pcap::reader reader;
-  if (reader.open(config.cap.device)) {
-    // Initialize netmon worker.
-    net::mon::worker worker(0,
-                            net::mon::worker::no_processor,
-                            config.evdir,
-                            config.file_allocation_size,
-                            config.buffer_size);
-
-    if (worker.init("pcap",
-                    config.tcp4.size,
-                    config.tcp4.maxconns,
-                    config.tcp6.size,
-                    config.tcp6.maxconns,
-                    config.tcp4.timeout,
-                    config.tcp4.time_wait)) {
-      pcap::callbacks callbacks;
-      callbacks.ethernet = ethernet;
-      callbacks.ipv4 = ipv4;
-      callbacks.ipv6 = ipv6;
-
-      pcap_argument arg;
-      arg.worker = &worker;
-      arg.reader = &reader;
-
-      // Read PCAP file.
-      if (reader.read_all(callbacks, &arg)) {
-        // Remove expired connections.
-        const pcap::timeval& timestamp = reader.timestamp();
-
-        worker.remove_expired((timestamp.tv_sec * 1000000ull) +
-                              timestamp.tv_usec);
+  // Create netmon workers.
+  net::mon::pcap_workers workers;
+  if (workers.create(config.nworkers,
+                     config.processors,
+                     config.evdir,
+                     config.file_allocation_size,
+                     config.buffer_size,
+                     config.compression,
+                     config.writer_buffers,
+                     config.backpressure,
+                     config.direct_io,
+                     config.rotation_size,
+                     config.rotation_interval,
+                     config.tcp_options())) {
+    // Process PCAP files.
+    for (size_t i = 0; i < config.cap.ndevices; i++) {
+      if (!workers.process(config.cap.devices[i])) {
+        return false;
+      }
+    }
 
-        return true;
+    if (workers.finish()) {
+      workers.show_memory_usage();
+
+      // If the event files have to be merged...
+      if (config.merge_filename) {
+        if (!workers.merge(config.merge_filename, config.compression)) {
+          fprintf(stderr,
+                  "Error merging the event files into '%s'.\n",
+                  config.merge_filename);
+
+          return false;
+        }
       }
 
-      fprintf(stderr, "Error adding packet.\n");
+      return true;
     } else {
-      fprintf(stderr, "Error initializing netmon worker.\n");
+      fprintf(stderr, "Error closing the event files.\n");
     }
   } else {
-    fprintf(stderr,
-            "Error opening file '%s' for reading.\n",
-            config.cap.device);
+    fprintf(stderr, "Error creating workers.\n");
   }
 
   return false;
@@ -115,6 +91,8 @@ bool process_interface(const net::mon::configuration& config)
   net::capture::method capture_method;
   if (config.cap.m == net::mon::configuration::capture::method::ring_buffer) {
     capture_method = net::capture::method::ring_buffer;
+  } else if (config.cap.m == net::mon::configuration::capture::method::xdp) {
+    capture_method = net::capture::method::xdp;
   } else {
     capture_method = net::capture::method::socket;
   }
@@ -126,33 +104,60 @@ bool process_interface(const net::mon::configuration& config)
                      config.evdir,
                      config.file_allocation_size,
                      config.buffer_size,
+                     config.compression,
+                     config.writer_buffers,
+                     config.backpressure,
+                     config.direct_io,
+                     config.rotation_size,
+                     config.rotation_interval,
                      capture_method,
                      config.cap.device,
                      config.cap.ifindex,
                      config.cap.rcvbuf_size,
                      config.cap.promiscuous_mode,
+                     config.cap.fo.m,
+                     config.cap.fo.rollover,
+                     config.cap.fo.group,
+                     config.cap.fo.program,
                      config.cap.rb.block_size,
                      config.cap.rb.frame_size,
                      config.cap.rb.frame_count,
-                     config.tcp4.size,
-                     config.tcp4.maxconns,
-                     config.tcp6.size,
-                     config.tcp6.maxconns,
-                     config.tcp4.timeout,
-                     config.tcp4.time_wait)) {
-    // Block signals SIGINT and SIGTERM.
+                     config.cap.rb.dispatcher,
+                     config.cap.rb.rxhash,
+                     config.cap.xsk.m,
+                     config.cap.xsk.queue,
+                     config.cap.xsk.zero_copy,
+                     config.cap.xsk.frame_size,
+                     config.cap.xsk.frame_count,
+                     config.cap.busy_poll_spins,
+                     config.cap.busy_poll_usecs,
+                     !config.cap.filter_program.empty() ?
+                       &config.cap.filter_program :
+                       nullptr,
+                     config.cap.snaplen,
+                     config.tcp_options())) {
+    // Block signals SIGINT, SIGTERM and SIGUSR1.
     sigset_t set;
     sigemptyset(&set);
     sigaddset(&set, SIGINT);
     sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGUSR1);
     if (pthread_sigmask(SIG_BLOCK, &set, NULL) == 0) {
       // Start workers.
       if (workers.start()) {
         printf("Waiting for signal to arrive.\n");
 
-        // Wait for signal to arrive.
-        int sig;
-        while (sigwait(&set, &sig) != 0);
+        // Wait for SIGINT or SIGTERM to arrive (SIGUSR1 shows the
+        // histograms of the TCP connection hash tables).
+        int sig = 0;
+        while ((sigwait(&set, &sig) != 0) || (sig == SIGUSR1)) {
+          if (sig == SIGUSR1) {
+            workers.show_hash_statistics();
+            fflush(stdout);
+
+            sig = 0;
+          }
+        }
 
         printf("Signal received.\n");
 
@@ -165,7 +170,7 @@ bool process_interface(const net::mon::configuration& config)
         fprintf(stderr, "Error starting workers.\n");
       }
     } else {
-      fprintf(stderr, "Error blocking signals SIGINT and SIGTERM.\n");
+      fprintf(stderr, "Error blocking signals SIGINT, SIGTERM and SIGUSR1.\n");
     }
   } else {
     fprintf(stderr, "Error creating workers.\n");
@@ -173,45 +178,3 @@ bool process_interface(const net::mon::configuration& config)
 
   return false;
 }
-
-bool ethernet(const void* buf, size_t len, const pcap::timeval& ts, void* user)
-{
-  uint32_t usec = (static_cast<pcap_argument*>(user)->reader->resolution() ==
-                   pcap::resolution::microseconds) ? ts.tv_usec :
-                                                     ts.tv_usec / 1000;
-
-  // Process ethernet frame.
-  return static_cast<pcap_argument*>(user)->worker->process_ethernet(
-           buf,
-           len,
-           {static_cast<time_t>(ts.tv_sec), static_cast<suseconds_t>(usec)}
-         );
-}
-
-bool ipv4(const void* buf, size_t len, const pcap::timeval& ts, void* user)
-{
-  uint32_t usec = (static_cast<pcap_argument*>(user)->reader->resolution() ==
-                   pcap::resolution::microseconds) ? ts.tv_usec :
-                                                     ts.tv_usec / 1000;
-
-  // Process IPv4 packet.
-  return static_cast<pcap_argument*>(user)->worker->process_ipv4(
-           buf,
-           len,
-           {static_cast<time_t>(ts.tv_sec), static_cast<suseconds_t>(usec)}
-         );
-}
-
-bool ipv6(const void* buf, size_t len, const pcap::timeval& ts, void* user)
-{
-  uint32_t usec = (static_cast<pcap_argument*>(user)->reader->resolution() ==
-                   pcap::resolution::microseconds) ? ts.tv_usec :
-                                                     ts.tv_usec / 1000;
-
-  // Process IPv6 packet.
-  return static_cast<pcap_argument*>(user)->worker->process_ipv6(
-           buf,
-           len,
-           {static_cast<time_t>(ts.tv_sec), static_cast<suseconds_t>(usec)}
-         );
-}
@@ -108,7 +108,11 @@ bool pcap::reader::read_ethernet(const callbacks& callbacks, void* user)
     const void* pkt;
 
     while ((pkt = next(pkthdr)) != nullptr) {
-      if (!callbacks.ethernet(pkt, pkthdr.caplen, pkthdr.ts, user)) {
+      if (!callbacks.ethernet(pkt,
+                              pkthdr.caplen,
+                              pkthdr.len,
+                              pkthdr.ts,
+                              user)) {
         return false;
       }
     }
@@ -131,13 +135,21 @@ bool pcap::reader::read_raw(const callbacks& callbacks, void* user)
         // Check IP version.
         switch (*static_cast<const uint8_t*>(pkt) & 0xf0) {
           case 0x40: // IPv4.
-            if (!callbacks.ipv4(pkt, pkthdr.caplen, pkthdr.ts, user)) {
+            if (!callbacks.ipv4(pkt,
+                                pkthdr.caplen,
+                                pkthdr.len,
+                                pkthdr.ts,
+                                user)) {
               return false;
             }
 
             break;
           case 0x60: // IPv6.
-            if (!callbacks.ipv6(pkt, pkthdr.caplen, pkthdr.ts, user)) {
+            if (!callbacks.ipv6(pkt,
+                                pkthdr.caplen,
+                                pkthdr.len,
+                                pkthdr.ts,
+                                user)) {
               return false;
             }
 
@@ -188,21 +200,23 @@ bool pcap::reader::process_ethernet(const pcap_pkthdr& pkthdr,
                                     void* user)
 {
   // If the frame is big enough...
-  if (pkthdr.caplen > sizeof(struct ether_header)) {
+  if ((pkthdr.caplen > sizeof(struct ether_header)) &&
+      (pkthdr.len >= pkthdr.caplen)) {
     // Make 'b' point to the ether_type.
     const uint8_t* b = static_cast<const uint8_t*>(pkt) +
                        (sizeof(struct ether_addr) << 1);
 
     // Subtract length of the ethernet header.
     size_t len = pkthdr.caplen - sizeof(struct ether_header);
+    size_t wirelen = pkthdr.len - sizeof(struct ether_header);
 
     do {
       // Check ether_type.
       switch ((static_cast<uint16_t>(*b) << 8) | b[1]) {
         case ETH_P_IP:
-          return callbacks.ipv4(b + 2, len, pkthdr.ts, user);
+          return callbacks.ipv4(b + 2, len, wirelen, pkthdr.ts, user);
         case ETH_P_IPV6:
-          return callbacks.ipv6(b + 2, len, pkthdr.ts, user);
+          return callbacks.ipv6(b + 2, len, wirelen, pkthdr.ts, user);
         case ETH_P_8021Q:
         case ETH_P_8021AD:
           // If the frame is big enough...
@@ -211,6 +225,7 @@ bool pcap::reader::process_ethernet(const pcap_pkthdr& pkthdr,
             b += 4;
 
             len -= 4;
+            wirelen -= 4;
           } else {
             // Ignore frame.
             return true;
@@ -231,16 +246,32 @@ bool pcap::reader::process_ethernet(const pcap_pkthdr& pkthdr,
                          (static_cast<uint32_t>(b[1]) << 8) |
                          (static_cast<uint32_t>(b[2]) >> 4)) & 0x0fffff) {
                   case 0: // IPv4.
-                    return callbacks.ipv4(b + 4, len - 4, pkthdr.ts, user);
+                    return callbacks.ipv4(b + 4,
+                                          len - 4,
+                                          wirelen - 4,
+                                          pkthdr.ts,
+                                          user);
                   case 2: // IPv6.
-                    return callbacks.ipv6(b + 4, len - 4, pkthdr.ts, user);
+                    return callbacks.ipv6(b + 4,
+                                          len - 4,
+                                          wirelen - 4,
+                                          pkthdr.ts,
+                                          user);
                   default:
                     // Check IP version.
                     switch (b[4] & 0xf0) {
                       case 0x40: // IPv4.
-                        return callbacks.ipv4(b + 4, len - 4, pkthdr.ts, user);
+                        return callbacks.ipv4(b + 4,
+                                              len - 4,
+                                              wirelen - 4,
+                                              pkthdr.ts,
+                                              user);
                       case 0x60: // IPv6.
-                        return callbacks.ipv6(b + 4, len - 4, pkthdr.ts, user);
+                        return callbacks.ipv6(b + 4,
+                                              len - 4,
+                                              wirelen - 4,
+                                              pkthdr.ts,
+                                              user);
                       default:
                         // Ignore frame.
                         return true;
@@ -251,6 +282,7 @@ bool pcap::reader::process_ethernet(const pcap_pkthdr& pkthdr,
                 b += 4;
 
                 len -= 4;
+                wirelen -= 4;
               }
             } else {
               // Ignore frame.
@@ -6,19 +6,24 @@
 
 namespace pcap {
   // Packet callbacks.
+  // 'len': number of bytes captured.
+  // 'wirelen': length of the packet on the wire.
   struct callbacks {
     bool (*ethernet)(const void* buf,
                      size_t len,
+                     size_t wirelen,
                      const struct timeval& timestamp,
                      void* user) = nullptr;
 
     bool (*ipv4)(const void* buf,
                  size_t len,
+                 size_t wirelen,
                  const struct timeval& timestamp,
                  void* user) = nullptr;
 
     bool (*ipv6)(const void* buf,
                  size_t len,
+                 size_t wirelen,
                  const struct timeval& timestamp,
                  void* user) = nullptr;
   };
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdio.h>
 #include "string/buffer.h"
 
@@ -32,16 +33,53 @@ bool string::buffer::allocate(size_t size)
       }
     }
 
-    char* data;
-    if ((data = static_cast<char*>(realloc(_M_data, s))) != nullptr) {
-      _M_data = data;
-      _M_size = s;
+    return reallocate(s);
+  }
 
-      return true;
+  return false;
+}
+
+bool string::buffer::allocate_aligned(size_t size, size_t alignment)
+{
+  _M_alignment = alignment;
+
+  // If the current data is not aligned...
+  if ((_M_data) &&
+      ((reinterpret_cast<uintptr_t>(_M_data) & (alignment - 1)) != 0) &&
+      (!reallocate(_M_size))) {
+    return false;
+  }
+
+  return allocate(size);
+}
+
+bool string::buffer::reallocate(size_t size)
+{
+  char* data;
+
+  if (_M_alignment == 0) {
+    if ((data = static_cast<char*>(realloc(_M_data, size))) == nullptr) {
+      return false;
+    }
+  } else {
+    // realloc() doesn't keep the alignment.
+    void* p;
+    if (posix_memalign(&p, _M_alignment, size) != 0) {
+      return false;
+    }
+
+    data = static_cast<char*>(p);
+
+    if (_M_data) {
+      memcpy(data, _M_data, _M_used);
+      ::free(_M_data);
     }
   }
 
-  return false;
+  _M_data = data;
+  _M_size = size;
+
+  return true;
 }
 
 bool string::buffer::vformat(const char* format, va_list ap)
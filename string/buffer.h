@@ -52,6 +52,10 @@ namespace string {
       // Allocate memory.
       bool allocate(size_t size);
 
+      // Allocate memory aligned to 'alignment' bytes (power of 2, multiple
+      // of sizeof(void*)), the buffer keeps the alignment when it grows.
+      bool allocate_aligned(size_t size, size_t alignment);
+
       // Append.
       bool append(char c);
       bool append(const char* string);
@@ -71,6 +75,12 @@ namespace string {
       size_t _M_size;
       size_t _M_used;
 
+      // Alignment of the data (0: not aligned).
+      size_t _M_alignment;
+
+      // Reallocate the data ('size' >= '_M_used').
+      bool reallocate(size_t size);
+
       // Disable copy constructor and assignment operator.
       buffer(const buffer&) = delete;
       buffer& operator=(const buffer&) = delete;
@@ -79,18 +89,21 @@ namespace string {
   inline buffer::buffer()
     : _M_data(nullptr),
       _M_size(0),
-      _M_used(0)
+      _M_used(0),
+      _M_alignment(0)
   {
   }
 
   inline buffer::buffer(buffer&& other)
     : _M_data(other._M_data),
       _M_size(other._M_size),
-      _M_used(other._M_used)
+      _M_used(other._M_used),
+      _M_alignment(other._M_alignment)
   {
     other._M_data = nullptr;
     other._M_size = 0;
     other._M_used = 0;
+    other._M_alignment = 0;
   }
 
   inline buffer::~buffer()
@@ -103,10 +116,12 @@ namespace string {
     _M_data = other._M_data;
     _M_size = other._M_size;
     _M_used = other._M_used;
+    _M_alignment = other._M_alignment;
 
     other._M_data = nullptr;
     other._M_size = 0;
     other._M_used = 0;
+    other._M_alignment = 0;
 
     return *this;
   }
@@ -124,6 +139,10 @@ namespace string {
     s = _M_used;
     _M_used = other._M_used;
     other._M_used = s;
+
+    s = _M_alignment;
+    _M_alignment = other._M_alignment;
+    other._M_alignment = s;
   }
 
   inline void buffer::free()
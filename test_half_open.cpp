@@ -0,0 +1,238 @@
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "net/mon/tcp/connections.h"
+#include "net/mon/ipv4/tcp/connection.h"
+#include "net/mon/event/writer.h"
+#include "net/mon/event/reader.h"
+
+typedef net::mon::tcp::connections<net::mon::ipv4::tcp::connection>
+        connections;
+
+// Failed connection attempts per second which generate an event.
+static constexpr const uint32_t threshold = 100;
+
+// Entries of the table of half-open connections (1024 sets).
+static constexpr const size_t half_open = 4096;
+
+// Timeout of the half-open connections (seconds).
+static constexpr const uint64_t
+       timeout = net::mon::tcp::half_open_table<net::mon::ipv4::address>::
+                 timeout;
+
+// Time of the first SYN (seconds).
+static constexpr const uint64_t start = 1700000000;
+
+struct flood {
+  // Second of the SYNs (relative to 'start').
+  uint64_t second;
+
+  // Number of SYNs (each one to a different set).
+  size_t nsyns;
+};
+
+static bool run(const flood* floods,
+                size_t nfloods,
+                const uint64_t* expected,
+                size_t nexpected,
+                const char* name);
+
+int main()
+{
+  // A flood whose entries are never reused: the attempts are counted when
+  // they expire (75 seconds later).
+  {
+    static constexpr const flood floods[] = {{0, 200}};
+    static constexpr const uint64_t expected[] = {75};
+
+    if (!run(floods, 1, expected, 1, "single flood")) {
+      return -1;
+    }
+  }
+
+  // Floods in different seconds, the one below the threshold doesn't
+  // generate an event.
+  {
+    static constexpr const flood floods[] = {{0, 150}, {3, 99}, {10, 100}};
+    static constexpr const uint64_t expected[] = {75, 85};
+
+    if (!run(floods, 3, expected, 2, "several floods")) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+bool run(const flood* floods,
+         size_t nfloods,
+         const uint64_t* expected,
+         size_t nexpected,
+         const char* name)
+{
+  char filename[] = "/tmp/test_half_open.XXXXXX";
+  int fd;
+  if ((fd = mkstemp(filename)) == -1) {
+    fprintf(stderr, "Error creating temporary file.\n");
+    return false;
+  }
+
+  close(fd);
+
+  bool ret = false;
+
+  {
+    net::mon::event::writer evwriter;
+    connections conns(evwriter);
+
+    if ((!evwriter.init()) ||
+        (!evwriter.open(filename)) ||
+        (!conns.init(connections::default_size,
+                     connections::default_max_connections,
+                     connections::default_timeout,
+                     connections::default_time_wait,
+                     0,
+                     net::mon::tcp::table::chained,
+                     net::mon::tcp::hash_function::siphash,
+                     0,
+                     false,
+                     half_open,
+                     threshold,
+                     -1,
+                     nullptr))) {
+      fprintf(stderr, "Error initializing connections (%s).\n", name);
+
+      unlink(filename);
+      return false;
+    }
+
+    const net::mon::ipv4::address server(htonl(0xc0a80001));
+    uint32_t hash = 0;
+
+    // Advance the time one second at a time (as the worker does with
+    // the timers).
+    size_t n = 0;
+    for (uint64_t second = 0; second < 100; second++) {
+      const uint64_t now = (start + second) * 1000000;
+
+      conns.remove_expired(now);
+
+      for (; (n < nfloods) && (floods[n].second == second); n++) {
+        for (size_t i = 0; i < floods[n].nsyns; i++) {
+          const net::mon::ipv4::address client(htonl(0x0a000000 + ++hash));
+
+          // Unanswered SYN (the hash selects a different set).
+          if (!conns.add(client,
+                         htons(1024 + (hash % 60000)),
+                         server,
+                         htons(80),
+                         0x02,
+                         60,
+                         0,
+                         now + i,
+                         hash)) {
+            fprintf(stderr, "Error adding SYN (%s).\n", name);
+
+            unlink(filename);
+            return false;
+          }
+        }
+      }
+    }
+
+    evwriter.close();
+
+    size_t nsyns = 0;
+    for (size_t i = 0; i < nfloods; i++) {
+      nsyns += floods[i].nsyns;
+    }
+
+    if (conns.half_open().unanswered != nsyns) {
+      fprintf(stderr,
+              "Unanswered connection attempts: %" PRIu64 ", expected: %zu "
+              "(%s).\n",
+              conns.half_open().unanswered,
+              nsyns,
+              name);
+
+      unlink(filename);
+      return false;
+    }
+
+    // Check the 'Half-open TCP connections' events.
+    net::mon::event::reader evreader;
+    if (evreader.open(filename)) {
+      size_t nevents = 0;
+      bool error = false;
+
+      const void* event;
+      size_t len;
+      uint64_t timestamp;
+      while (evreader.next(event, len, timestamp)) {
+        if (net::mon::event::base::extract_type(event) !=
+            net::mon::event::type::tcp_half_open) {
+          continue;
+        }
+
+        net::mon::event::tcp_half_open ev;
+        if (!ev.build(event, len)) {
+          fprintf(stderr, "Invalid event (%s).\n", name);
+          error = true;
+          break;
+        }
+
+        if ((nevents == nexpected) ||
+            (ev.timestamp != (start + expected[nevents]) * 1000000)) {
+          fprintf(stderr,
+                  "Unexpected event at second %" PRIu64 " (%s).\n",
+                  ev.timestamp / 1000000 - start,
+                  name);
+
+          error = true;
+          break;
+        }
+
+        // The flood of the expected second.
+        size_t nsyns = 0;
+        for (size_t i = 0; i < nfloods; i++) {
+          if (floods[i].second + timeout == expected[nevents]) {
+            nsyns = floods[i].nsyns;
+          }
+        }
+
+        if ((ev.unanswered != nsyns) || (ev.attempts != 0)) {
+          fprintf(stderr,
+                  "Event at second %" PRIu64 ": %u unanswered, expected: %zu "
+                  "(%s).\n",
+                  expected[nevents],
+                  ev.unanswered,
+                  nsyns,
+                  name);
+
+          error = true;
+          break;
+        }
+
+        nevents++;
+      }
+
+      if ((!error) && (nevents == nexpected)) {
+        printf("%s: OK.\n", name);
+        ret = true;
+      } else {
+        fprintf(stderr,
+                "%zu events, expected: %zu (%s).\n",
+                nevents,
+                nexpected,
+                name);
+      }
+    } else {
+      fprintf(stderr, "Error opening event file (%s).\n", name);
+    }
+  }
+
+  unlink(filename);
+
+  return ret;
+}
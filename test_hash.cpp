@@ -0,0 +1,279 @@
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "util/hash.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+
+static bool test_siphash13();
+static bool test_crc32c();
+static bool test_lookup3();
+
+// CRC32C (bit by bit).
+static uint32_t crc32c_reference(const void* key,
+                                 size_t length,
+                                 uint32_t initval);
+
+int main()
+{
+  if ((!test_siphash13()) || (!test_crc32c()) || (!test_lookup3())) {
+    return -1;
+  }
+
+  return 0;
+}
+
+bool test_siphash13()
+{
+  // Keys: zero and the one CPython derives from PYTHONHASHSEED=1.
+  static constexpr const uint64_t keys[][2] = {
+    {0, 0},
+    {0xaed66ce184be2329ull, 0xebe9bbf1f1499052ull}
+  };
+
+  // The messages are the bytes 0, 1, ..., 'length' - 1. The expected
+  // values have been generated with CPython's hash() of bytes (SipHash-1-3,
+  // PYTHONHASHSEED=0 and PYTHONHASHSEED=1).
+  static constexpr const struct {
+    size_t key;
+    size_t length;
+    uint64_t hash;
+  } vectors[] = {
+    {0, 1, 0x68a914128e01e473ull},
+    {0, 2, 0x010bac45c41e3669ull},
+    {0, 3, 0x4d4c9a4a8ef6e0adull},
+    {0, 7, 0x2f098ab0c751325aull},
+    {0, 8, 0xead411e67ebe2eeaull},
+    {0, 9, 0x75927f9d95124362ull},
+    {0, 15, 0xf30eb725bb91c9eaull},
+    {0, 16, 0x8972188433a5c5b7ull},
+    {0, 17, 0x4883c49a2c009c1dull},
+    {0, 63, 0x385d3e39e5f37359ull},
+    {1, 1, 0xecd3e5afcecda4b9ull},
+    {1, 2, 0xbf360f1ea1745965ull},
+    {1, 3, 0x8d5b20ab227ba858ull},
+    {1, 7, 0xfd15e78052a69ddfull},
+    {1, 8, 0xc0b5739e7e28dd01ull},
+    {1, 9, 0x208a1a5a0cbbf778ull},
+    {1, 15, 0xfa87985f39e97a53ull},
+    {1, 16, 0x12e9d283f9f37002ull},
+    {1, 17, 0x9f5bb4237f61907full},
+    {1, 63, 0x542052345bc68274ull}
+  };
+
+  // One more byte to hash the messages unaligned.
+  uint8_t buf[1 + 64];
+
+  for (size_t i = 0; i < ARRAY_SIZE(vectors); i++) {
+    for (size_t offset = 0; offset <= 1; offset++) {
+      for (size_t j = 0; j < vectors[i].length; j++) {
+        buf[offset + j] = static_cast<uint8_t>(j);
+      }
+
+      const uint64_t hash = util::hash::siphash13(buf + offset,
+                                                  vectors[i].length,
+                                                  keys[vectors[i].key]);
+
+      if (hash != vectors[i].hash) {
+        fprintf(stderr,
+                "SipHash-1-3 (key %zu, length %zu, offset %zu): "
+                "0x%016" PRIx64 ", expected: 0x%016" PRIx64 ".\n",
+                vectors[i].key,
+                vectors[i].length,
+                offset,
+                hash,
+                vectors[i].hash);
+
+        return false;
+      }
+    }
+  }
+
+  printf("SipHash-1-3: OK.\n");
+
+  return true;
+}
+
+bool test_crc32c()
+{
+  // RFC 3720 (B.4. CRC Examples) and the check value of CRC-32C.
+  uint8_t zeros[32];
+  uint8_t ones[32];
+  uint8_t incrementing[32];
+  uint8_t decrementing[32];
+
+  for (size_t i = 0; i < 32; i++) {
+    zeros[i] = 0;
+    ones[i] = 0xff;
+    incrementing[i] = static_cast<uint8_t>(i);
+    decrementing[i] = static_cast<uint8_t>(31 - i);
+  }
+
+  static constexpr const uint8_t iscsi[] = {
+    0x01, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+    0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 0x18,
+    0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+  };
+
+  const struct {
+    const void* key;
+    size_t length;
+    uint32_t crc;
+  } vectors[] = {
+    {zeros, sizeof(zeros), 0x8a9136aa},
+    {ones, sizeof(ones), 0x62a8ab43},
+    {incrementing, sizeof(incrementing), 0x46dd794e},
+    {decrementing, sizeof(decrementing), 0x113fdb5c},
+    {iscsi, sizeof(iscsi), 0xd9963a56},
+    {"123456789", 9, 0xe3069283},
+    {"", 0, 0}
+  };
+
+  for (size_t i = 0; i < ARRAY_SIZE(vectors); i++) {
+    const uint32_t crc = util::hash::crc32c(vectors[i].key,
+                                            vectors[i].length,
+                                            0);
+
+    if (crc != vectors[i].crc) {
+      fprintf(stderr,
+              "CRC32C (vector %zu): 0x%08" PRIx32 ", expected: "
+              "0x%08" PRIx32 ".\n",
+              i,
+              crc,
+              vectors[i].crc);
+
+      return false;
+    }
+  }
+
+  // All the lengths and alignments of the SSE4.2 version (8, 4 and 1
+  // bytes at a time), the CRC of the first part is the initial value of
+  // the second one.
+  uint8_t buf[8 + 100];
+  uint32_t x = 0x12345678;
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    x = x * 1103515245 + 12345;
+    buf[i] = static_cast<uint8_t>(x >> 16);
+  }
+
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t length = 0; length <= 100; length++) {
+      const uint8_t* key = buf + offset;
+      const uint32_t expected = crc32c_reference(key, length, 0);
+
+      const size_t half = length / 2;
+      const uint32_t crc = util::hash::crc32c(key, length, 0);
+      const uint32_t chained =
+            util::hash::crc32c(key + half,
+                               length - half,
+                               util::hash::crc32c(key, half, 0));
+
+      if ((crc != expected) || (chained != expected)) {
+        fprintf(stderr,
+                "CRC32C (length %zu, offset %zu): 0x%08" PRIx32 ", "
+                "0x%08" PRIx32 " (chained), expected: 0x%08" PRIx32 ".\n",
+                length,
+                offset,
+                crc,
+                chained,
+                expected);
+
+        return false;
+      }
+    }
+  }
+
+  printf("CRC32C: OK.\n");
+
+  return true;
+}
+
+bool test_lookup3()
+{
+  // Values of the function driver5() of lookup3.c.
+  static constexpr const char* const text = "Four score and seven years ago";
+
+  static constexpr const struct {
+    const char* key;
+    size_t length;
+    uint32_t initval;
+    uint32_t hash;
+  } vectors[] = {
+    {"", 0, 0, 0xdeadbeef},
+    {"", 0, 0xdeadbeef, 0xbd5b7dde},
+    {text, 30, 0, 0x17770551},
+    {text, 30, 1, 0xcd628161}
+  };
+
+  // One more byte to hash the keys unaligned.
+  char buf[1 + 32];
+
+  for (size_t i = 0; i < ARRAY_SIZE(vectors); i++) {
+    for (size_t offset = 0; offset <= 1; offset++) {
+      memcpy(buf + offset, vectors[i].key, vectors[i].length);
+
+      const uint32_t hash = util::hash::hashlittle(buf + offset,
+                                                   vectors[i].length,
+                                                   vectors[i].initval);
+
+      if (hash != vectors[i].hash) {
+        fprintf(stderr,
+                "hashlittle (vector %zu, offset %zu): 0x%08" PRIx32 ", "
+                "expected: 0x%08" PRIx32 ".\n",
+                i,
+                offset,
+                hash,
+                vectors[i].hash);
+
+        return false;
+      }
+    }
+  }
+
+  // The functions which hash 1, 2 and 3 words are hashword() of 1, 2 and
+  // 3 words.
+  static constexpr const uint32_t words[] = {
+    0x0100007f,
+    0xc0a80001,
+    0x00500400
+  };
+
+  for (uint32_t initval = 0; initval < 1000; initval += 7) {
+    if ((util::hash::hash_1word(words[0], initval) !=
+         util::hash::hashword(words, 1, initval)) ||
+        (util::hash::hash_2words(words[0], words[1], initval) !=
+         util::hash::hashword(words, 2, initval)) ||
+        (util::hash::hash_3words(words[0], words[1], words[2], initval) !=
+         util::hash::hashword(words, 3, initval))) {
+      fprintf(stderr,
+              "hash_Nwords() != hashword() (initval %" PRIu32 ").\n",
+              initval);
+
+      return false;
+    }
+  }
+
+  printf("lookup3: OK.\n");
+
+  return true;
+}
+
+uint32_t crc32c_reference(const void* key, size_t length, uint32_t initval)
+{
+  const uint8_t* k = static_cast<const uint8_t*>(key);
+
+  uint32_t crc = ~initval;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= k[i];
+
+    for (unsigned j = 0; j < 8; j++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+    }
+  }
+
+  return ~crc;
+}
@@ -0,0 +1,465 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "util/lz4.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+
+// Guard bytes after the output buffer.
+static constexpr const size_t guard_size = 64;
+static constexpr const uint8_t guard_byte = 0xa5;
+
+static uint32_t random32();
+static void fill_random(uint8_t* buf, size_t len);
+static void fill_compressible(uint8_t* buf, size_t len);
+static bool round_trip(util::lz4& lz4,
+                       const uint8_t* data,
+                       size_t len,
+                       const char* name);
+static bool decompress_guarded(const void* src,
+                               size_t srclen,
+                               size_t dstlen,
+                               bool& ret,
+                               uint8_t** out);
+
+int main()
+{
+  util::lz4 lz4;
+
+  static constexpr const size_t max_len = 3 * 65536;
+  uint8_t* data = static_cast<uint8_t*>(malloc(max_len));
+  if (!data) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return -1;
+  }
+
+  // Round trip of edge sizes (no matches up to 12 bytes, the last match
+  // starts at least 12 bytes before the end).
+  {
+    static constexpr const size_t sizes[] = {
+      0, 1, 4, 5, 11, 12, 13, 14, 15, 16, 17, 255, 256, 270, 4096, 65535,
+      65536, 65537
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+      fill_compressible(data, sizes[i]);
+      if (!round_trip(lz4, data, sizes[i], "compressible, edge size")) {
+        return -1;
+      }
+
+      fill_random(data, sizes[i]);
+      if (!round_trip(lz4, data, sizes[i], "random, edge size")) {
+        return -1;
+      }
+
+      memset(data, 'x', sizes[i]);
+      if (!round_trip(lz4, data, sizes[i], "single byte, edge size")) {
+        return -1;
+      }
+    }
+
+    printf("Round trip of edge sizes: OK.\n");
+  }
+
+  // Round trip of random and compressible data of random sizes.
+  for (size_t i = 0; i < 200; i++) {
+    size_t len = random32() % max_len;
+
+    fill_random(data, len);
+    if (!round_trip(lz4, data, len, "random")) {
+      return -1;
+    }
+
+    fill_compressible(data, len);
+    if (!round_trip(lz4, data, len, "compressible")) {
+      return -1;
+    }
+  }
+
+  printf("Round trip of random and compressible data: OK.\n");
+
+  // Matches with offsets around the maximum offset (65535).
+  {
+    static constexpr const size_t distances[] = {
+      65533, 65534, 65535, 65536, 65537
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(distances); i++) {
+      // Random data followed by a copy of its beginning.
+      size_t len = distances[i] + 1000;
+      fill_random(data, distances[i]);
+      memcpy(data + distances[i], data, len - distances[i]);
+
+      if (!round_trip(lz4, data, len, "offsets near 64 KiB")) {
+        return -1;
+      }
+    }
+
+    printf("Round trip of matches with offsets near 64 KiB: OK.\n");
+  }
+
+  // Blocks compressed by the reference implementation (liblz4 1.9.4,
+  // LZ4_compress_default()).
+  {
+    struct vector {
+      const char* data;
+      size_t len;
+      const uint8_t* compressed;
+      size_t compressedlen;
+    };
+
+    static const uint8_t c1[] = {
+      0x79, 0x6e, 0x65, 0x74, 0x6d, 0x6f, 0x6e, 0x20, 0x07, 0x00, 0x10, 0x3a,
+      0x0f, 0x00, 0xdf, 0x77, 0x6f, 0x72, 0x6b, 0x20, 0x6d, 0x6f, 0x6e, 0x69,
+      0x74, 0x6f, 0x72, 0x2c, 0x11, 0x00, 0x0a, 0x50, 0x69, 0x74, 0x6f, 0x72,
+      0x21
+    };
+
+    // Literals and matches longer than 15 bytes, overlapping match.
+    static const uint8_t c2[] = {
+      0xff, 0x16, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+      0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c,
+      0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+      0x79, 0x7a, 0x41, 0x01, 0x00, 0xff, 0x19, 0x0f, 0x50, 0x01, 0x0c, 0x50,
+      0x76, 0x77, 0x78, 0x79, 0x7a
+    };
+
+    static char d2[372];
+    static const char alnum[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    memcpy(d2, alnum, 36);
+    memset(d2 + 36, 'A', 300);
+    memcpy(d2 + 336, alnum, 36);
+
+    const vector vectors[] = {
+      {
+        "netmon netmon netmon: network monitor, network monitor, network "
+        "monitor!",
+        72,
+        c1,
+        sizeof(c1)
+      },
+      {d2, sizeof(d2), c2, sizeof(c2)}
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(vectors); i++) {
+      const vector& v = vectors[i];
+
+      bool ret;
+      uint8_t* out;
+      if (!decompress_guarded(v.compressed,
+                              v.compressedlen,
+                              v.len,
+                              ret,
+                              &out)) {
+        return -1;
+      }
+
+      bool equal = (ret) && (memcmp(out, v.data, v.len) == 0);
+      free(out);
+
+      if (!equal) {
+        fprintf(stderr, "Error decompressing reference vector %zu.\n", i + 1);
+        return -1;
+      }
+
+      // Our own output decompresses to the same data.
+      if (!round_trip(lz4,
+                      reinterpret_cast<const uint8_t*>(v.data),
+                      v.len,
+                      "reference vector")) {
+        return -1;
+      }
+    }
+
+    printf("Reference vectors: OK.\n");
+  }
+
+  // Truncated input: no prefix of a compressed block is a valid block.
+  {
+    size_t len = 20000;
+    fill_compressible(data, len);
+
+    size_t bound = util::lz4::bound(len);
+    uint8_t* compressed = static_cast<uint8_t*>(malloc(bound));
+    size_t compressedlen;
+
+    if ((!compressed) ||
+        ((compressedlen = lz4.compress(data, len, compressed, bound)) == 0)) {
+      fprintf(stderr, "Error compressing data.\n");
+      return -1;
+    }
+
+    for (size_t n = 0; n < compressedlen; n++) {
+      // Exact-size copy, so reading past the end is detected by the
+      // memory checkers.
+      uint8_t* src = static_cast<uint8_t*>(malloc((n > 0) ? n : 1));
+      memcpy(src, compressed, n);
+
+      bool ret;
+      uint8_t* out;
+      bool guarded = decompress_guarded(src, n, len, ret, &out);
+
+      free(src);
+
+      if (!guarded) {
+        free(compressed);
+        return -1;
+      }
+
+      free(out);
+
+      if (ret) {
+        fprintf(stderr,
+                "Truncated block (%zu of %zu bytes) accepted.\n",
+                n,
+                compressedlen);
+
+        free(compressed);
+        return -1;
+      }
+    }
+
+    // Output buffer too small or too large.
+    static constexpr const size_t deltas[] = {1, 100};
+    for (size_t i = 0; i < ARRAY_SIZE(deltas); i++) {
+      for (size_t j = 0; j < 2; j++) {
+        size_t dstlen = (j == 0) ? len - deltas[i] : len + deltas[i];
+
+        bool ret;
+        uint8_t* out;
+        if (!decompress_guarded(compressed, compressedlen, dstlen, ret, &out)) {
+          free(compressed);
+          return -1;
+        }
+
+        free(out);
+
+        if (ret) {
+          fprintf(stderr,
+                  "Block decompressed into %zu bytes instead of %zu.\n",
+                  dstlen,
+                  len);
+
+          free(compressed);
+          return -1;
+        }
+      }
+    }
+
+    free(compressed);
+
+    printf("Truncated input: OK.\n");
+  }
+
+  // Corrupt input.
+  {
+    struct block {
+      const uint8_t* data;
+      size_t len;
+    };
+
+    // Offset 0.
+    static const uint8_t b1[] = {0x44, 'a', 'b', 'c', 'd', 0x00, 0x00, 0x00};
+
+    // Offset beyond the beginning of the output.
+    static const uint8_t b2[] = {0x44, 'a', 'b', 'c', 'd', 0x05, 0x00, 0x00};
+
+    // Literal length beyond the end of the input.
+    static const uint8_t b3[] = {0xf0, 0xff, 0xff, 0x10, 'a'};
+
+    // Match length beyond the end of the output.
+    static const uint8_t b4[] = {
+      0x1f, 'a', 0x01, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00
+    };
+
+    // Length extension at the end of the input.
+    static const uint8_t b5[] = {0xf0, 0xff};
+
+    static const block blocks[] = {
+      {b1, sizeof(b1)},
+      {b2, sizeof(b2)},
+      {b3, sizeof(b3)},
+      {b4, sizeof(b4)},
+      {b5, sizeof(b5)}
+    };
+
+    for (size_t i = 0; i < ARRAY_SIZE(blocks); i++) {
+      uint8_t* src = static_cast<uint8_t*>(malloc(blocks[i].len));
+      memcpy(src, blocks[i].data, blocks[i].len);
+
+      bool ret;
+      uint8_t* out;
+      bool guarded = decompress_guarded(src, blocks[i].len, 64, ret, &out);
+
+      free(src);
+
+      if (!guarded) {
+        return -1;
+      }
+
+      free(out);
+
+      if (ret) {
+        fprintf(stderr, "Corrupt block %zu accepted.\n", i + 1);
+        return -1;
+      }
+    }
+
+    // Random corruptions of a valid block (the result doesn't matter, but
+    // the decompressor must stay within its buffers).
+    size_t len = 5000;
+    fill_compressible(data, len);
+
+    size_t bound = util::lz4::bound(len);
+    uint8_t* compressed = static_cast<uint8_t*>(malloc(bound));
+    size_t compressedlen;
+
+    if ((!compressed) ||
+        ((compressedlen = lz4.compress(data, len, compressed, bound)) == 0)) {
+      fprintf(stderr, "Error compressing data.\n");
+      return -1;
+    }
+
+    for (size_t i = 0; i < 10000; i++) {
+      uint8_t* src = static_cast<uint8_t*>(malloc(compressedlen));
+      memcpy(src, compressed, compressedlen);
+
+      for (size_t j = random32() % 4; j < 4; j++) {
+        src[random32() % compressedlen] = static_cast<uint8_t>(random32());
+      }
+
+      bool ret;
+      uint8_t* out;
+      bool guarded = decompress_guarded(src, compressedlen, len, ret, &out);
+
+      free(src);
+
+      if (!guarded) {
+        free(compressed);
+        return -1;
+      }
+
+      free(out);
+    }
+
+    free(compressed);
+
+    printf("Corrupt input: OK.\n");
+  }
+
+  free(data);
+
+  return 0;
+}
+
+uint32_t random32()
+{
+  // xorshift32 (deterministic).
+  static uint32_t x = 2463534242u;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+
+  return x;
+}
+
+void fill_random(uint8_t* buf, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = static_cast<uint8_t>(random32());
+  }
+}
+
+void fill_compressible(uint8_t* buf, size_t len)
+{
+  static const char* const words[] = {
+    "tcp", "udp", "dns", "icmp", "192.168.0.1", "10.0.0.1", "netmon",
+    "begin-tcp-connection", "end-tcp-connection", " ", ",", "\n"
+  };
+
+  size_t off = 0;
+  while (off < len) {
+    const char* w = words[random32() % ARRAY_SIZE(words)];
+
+    size_t n = strlen(w);
+    if (n > len - off) {
+      n = len - off;
+    }
+
+    memcpy(buf + off, w, n);
+    off += n;
+  }
+}
+
+bool round_trip(util::lz4& lz4,
+                const uint8_t* data,
+                size_t len,
+                const char* name)
+{
+  size_t bound = util::lz4::bound(len);
+
+  // Exact-size buffers.
+  uint8_t* compressed = static_cast<uint8_t*>(malloc(bound));
+  if (!compressed) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return false;
+  }
+
+  size_t compressedlen;
+  if ((compressedlen = lz4.compress(data, len, compressed, bound)) == 0) {
+    fprintf(stderr, "Error compressing %zu bytes (%s).\n", len, name);
+
+    free(compressed);
+    return false;
+  }
+
+  bool ret;
+  uint8_t* out;
+  if (!decompress_guarded(compressed, compressedlen, len, ret, &out)) {
+    free(compressed);
+    return false;
+  }
+
+  free(compressed);
+
+  bool equal = (ret) && (memcmp(out, data, len) == 0);
+  free(out);
+
+  if (!equal) {
+    fprintf(stderr, "Round trip of %zu bytes failed (%s).\n", len, name);
+    return false;
+  }
+
+  return true;
+}
+
+bool decompress_guarded(const void* src,
+                        size_t srclen,
+                        size_t dstlen,
+                        bool& ret,
+                        uint8_t** out)
+{
+  uint8_t* dst = static_cast<uint8_t*>(malloc(dstlen + guard_size));
+  if (!dst) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return false;
+  }
+
+  memset(dst + dstlen, guard_byte, guard_size);
+
+  ret = util::lz4::decompress(src, srclen, dst, dstlen);
+
+  for (size_t i = 0; i < guard_size; i++) {
+    if (dst[dstlen + i] != guard_byte) {
+      fprintf(stderr, "Decompressor wrote beyond the output buffer.\n");
+
+      free(dst);
+      return false;
+    }
+  }
+
+  *out = dst;
+
+  return true;
+}
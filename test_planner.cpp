@@ -0,0 +1,741 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "net/mon/event/grammar/planner.h"
+#include "net/mon/event/writer.h"
+#include "net/mon/event/reader.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+
+using namespace net::mon::event;
+
+// Printer which counts the events.
+class counter : public printer::base {
+  public:
+    size_t count = 0;
+
+    void print(uint64_t, const icmp&, const char*, const char*) final
+    {
+      count++;
+    }
+
+    void print(uint64_t, const udp&, const char*, const char*) final
+    {
+      count++;
+    }
+
+    void print(uint64_t, const dns&, const char*, const char*) final
+    {
+      count++;
+    }
+
+    void print(uint64_t, const tcp_begin&, const char*, const char*) final
+    {
+      count++;
+    }
+
+    void print(uint64_t, const tcp_data&, const char*, const char*) final
+    {
+      count++;
+    }
+
+    void print(uint64_t, const tcp_end&, const char*, const char*) final
+    {
+      count++;
+    }
+
+    void print(uint64_t, const tcp_half_open&, const char*, const char*) final
+    {
+      count++;
+    }
+
+    void print(uint64_t, const tcp_update&, const char*, const char*) final
+    {
+      count++;
+    }
+};
+
+// Identifiers checked by the planner.
+static constexpr const grammar::identifier identifiers[] = {
+  grammar::identifier::date,
+  grammar::identifier::event_type,
+  grammar::identifier::source_ip,
+  grammar::identifier::destination_ip,
+  grammar::identifier::ip,
+  grammar::identifier::source_port,
+  grammar::identifier::destination_port,
+  grammar::identifier::port
+};
+
+static constexpr const grammar::relational_operator operators[] = {
+  grammar::relational_operator::equal_to,
+  grammar::relational_operator::not_equal_to,
+  grammar::relational_operator::less,
+  grammar::relational_operator::greater,
+  grammar::relational_operator::less_or_equal,
+  grammar::relational_operator::greater_or_equal
+};
+
+static const char* const ipv4_addresses[] = {
+  "10.0.0.1",
+  "10.0.0.2",
+  "10.0.0.3",
+  "10.0.1.1",
+  "192.168.1.1"
+};
+
+static const char* const ipv6_addresses[] = {
+  "2001:db8::1",
+  "2001:db8::2",
+  "2001:db8:0:1::1",
+  "fe80::1"
+};
+
+static const char* const masks[] = {
+  "10.0.0.1",
+  "10.0.0.4",
+  "10.0.0.0/24",
+  "10.0.1.0/24",
+  "10.0.0.0/8",
+  "192.168.0.0/16",
+  "0.0.0.0/1",
+  "2001:db8::1",
+  "2001:db8::3",
+  "2001:db8::/32",
+  "2001:db8:0:1::/64",
+  "fe80::/10",
+  "8000::/1"
+};
+
+static constexpr const uint16_t ports[] = {
+  0, 1, 53, 79, 80, 81, 443, 1024, 65534, 65535
+};
+
+// Number of event types.
+static constexpr const size_t ntypes = 8;
+
+// Number of values of each identifier in the simple expressions.
+static constexpr const size_t nvalues = 16;
+
+// Timestamp of the first event (microseconds).
+static constexpr const uint64_t start = 1700000000000000ull;
+
+// Number of simple expressions (identifier, operator, value).
+static constexpr const size_t nsimple = ARRAY_SIZE(identifiers) *
+                                        ARRAY_SIZE(operators) *
+                                        nvalues;
+
+// Number of combinations (AND, OR and NOT expressions).
+static constexpr const size_t ncombinations = 3000;
+
+// Dates of the simple expressions.
+static uint64_t dates[nvalues];
+
+static uint32_t random32();
+
+static bool generate(string::buffer& buf, size_t nevents, uint32_t types);
+
+static grammar::conditional_expression* create_simple(size_t n);
+static grammar::conditional_expression* create_combination(size_t n);
+
+static bool evaluate(const grammar::conditional_expression* expr,
+                     const void* event,
+                     size_t len);
+
+static bool check_blocks(const string::buffer& buf, const char* name);
+static bool check_empty_block();
+static bool check_files(const string::buffer& buf);
+
+static bool write_file(const char* filename,
+                       unsigned version,
+                       const string::buffer& buf);
+
+static size_t read_file(const char* filename,
+                        const grammar::conditional_expression* expr);
+
+int main()
+{
+  // Events of all the types.
+  string::buffer events;
+  if (!generate(events, 2000, 0xff)) {
+    fprintf(stderr, "Error generating events.\n");
+    return -1;
+  }
+
+  // Only ICMP events (no ports).
+  string::buffer icmp_events;
+  if (!generate(icmp_events,
+                200,
+                static_cast<uint32_t>(1) <<
+                static_cast<unsigned>(type::icmp))) {
+    fprintf(stderr, "Error generating events.\n");
+    return -1;
+  }
+
+  // Timestamp of the last event.
+  uint64_t last = start;
+
+  const uint8_t* ptr = reinterpret_cast<const uint8_t*>(events.data());
+  const uint8_t* end = ptr + events.length();
+  for (; ptr < end; ptr += base::extract_length(ptr)) {
+    last = base::extract_timestamp(ptr);
+  }
+
+  // Dates of the expressions: before the first event, at the first and
+  // last events, after the last event and random dates in between.
+  dates[0] = start - 1;
+  dates[1] = start;
+  dates[2] = last;
+  dates[3] = last + 1;
+
+  for (size_t i = 4; i < nvalues; i++) {
+    dates[i] = start + (random32() % (last - start + 1));
+  }
+
+  // Check the network masks.
+  for (size_t i = 0; i < ARRAY_SIZE(masks); i++) {
+    net::mask netmask;
+    if (!netmask.build(masks[i])) {
+      fprintf(stderr, "Invalid network mask '%s'.\n", masks[i]);
+      return -1;
+    }
+  }
+
+  if ((!check_blocks(events, "all the types")) ||
+      (!check_blocks(icmp_events, "ICMP")) ||
+      (!check_empty_block()) ||
+      (!check_files(events))) {
+    return -1;
+  }
+
+  return 0;
+}
+
+uint32_t random32()
+{
+  // xorshift32 (deterministic).
+  static uint32_t x = 2463534242u;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+
+  return x;
+}
+
+template<typename Event>
+static void fill(Event& ev)
+{
+  ev.sport = htons(ports[random32() % ARRAY_SIZE(ports)]);
+  ev.dport = htons(ports[random32() % ARRAY_SIZE(ports)]);
+}
+
+static void fill(icmp& ev)
+{
+  // ICMP events have no ports.
+}
+
+static void fill(dns& ev)
+{
+  ev.sport = htons(ports[random32() % ARRAY_SIZE(ports)]);
+  ev.dport = htons(ports[random32() % ARRAY_SIZE(ports)]);
+
+  // The DNS events have a domain.
+  ev.domainlen = 11;
+  memcpy(ev.domain, "example.com", ev.domainlen);
+}
+
+template<typename Event>
+static bool add(string::buffer& buf, uint64_t timestamp)
+{
+  Event ev;
+  memset(&ev, 0, sizeof(Event));
+
+  ev.timestamp = timestamp;
+
+  // IPv4 or IPv6.
+  if (random32() % 3) {
+    ev.addrlen = 4;
+
+    inet_pton(AF_INET,
+              ipv4_addresses[random32() % ARRAY_SIZE(ipv4_addresses)],
+              ev.saddr);
+
+    inet_pton(AF_INET,
+              ipv4_addresses[random32() % ARRAY_SIZE(ipv4_addresses)],
+              ev.daddr);
+  } else {
+    ev.addrlen = 16;
+
+    inet_pton(AF_INET6,
+              ipv6_addresses[random32() % ARRAY_SIZE(ipv6_addresses)],
+              ev.saddr);
+
+    inet_pton(AF_INET6,
+              ipv6_addresses[random32() % ARRAY_SIZE(ipv6_addresses)],
+              ev.daddr);
+  }
+
+  fill(ev);
+
+  return ev.serialize(buf);
+}
+
+bool generate(string::buffer& buf, size_t nevents, uint32_t types)
+{
+  uint64_t timestamp = start;
+
+  for (size_t i = 0; i < nevents; i++) {
+    // Some events have the same timestamp.
+    timestamp += (random32() % 3) * 1000000;
+
+    unsigned t;
+    do {
+      t = random32() % ntypes;
+    } while ((types & (static_cast<uint32_t>(1) << t)) == 0);
+
+    bool ret;
+    switch (static_cast<type>(t)) {
+      case type::icmp:
+        ret = add<icmp>(buf, timestamp);
+        break;
+      case type::udp:
+        ret = add<udp>(buf, timestamp);
+        break;
+      case type::dns:
+        ret = add<dns>(buf, timestamp);
+        break;
+      case type::tcp_begin:
+        ret = add<tcp_begin>(buf, timestamp);
+        break;
+      case type::tcp_data:
+        ret = add<tcp_data>(buf, timestamp);
+        break;
+      case type::tcp_end:
+        ret = add<tcp_end>(buf, timestamp);
+        break;
+      case type::tcp_half_open:
+        ret = add<tcp_half_open>(buf, timestamp);
+        break;
+      default:
+        ret = add<tcp_update>(buf, timestamp);
+    }
+
+    if (!ret) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+grammar::conditional_expression* create_simple(size_t n)
+{
+  const size_t value = n % nvalues;
+  n /= nvalues;
+
+  const grammar::relational_operator op = operators[n % ARRAY_SIZE(operators)];
+  const grammar::identifier id = identifiers[n / ARRAY_SIZE(operators)];
+
+  grammar::event_expression* expr;
+  switch (op) {
+    case grammar::relational_operator::equal_to:
+    case grammar::relational_operator::not_equal_to:
+      expr = new grammar::equality_expression(
+               static_cast<grammar::equality_expression::equality_operator>(
+                 static_cast<unsigned>(op)
+               )
+             );
+
+      break;
+    default:
+      expr = new grammar::relational_expression(
+               static_cast<grammar::relational_expression::relational_operator>(
+                 static_cast<unsigned>(op)
+               )
+             );
+  }
+
+  switch (id) {
+    case grammar::identifier::date:
+      expr->init(id, dates[value]);
+      break;
+    case grammar::identifier::event_type:
+      expr->init(id, value % ntypes);
+      break;
+    case grammar::identifier::source_ip:
+    case grammar::identifier::destination_ip:
+    case grammar::identifier::ip:
+      {
+        net::mask netmask;
+        netmask.build(masks[value % ARRAY_SIZE(masks)]);
+
+        expr->init(id, netmask);
+      }
+
+      break;
+    default:
+      expr->init(id, ports[value % ARRAY_SIZE(ports)]);
+  }
+
+  return expr;
+}
+
+grammar::conditional_expression* create_combination(size_t n)
+{
+  // Deterministic choice of the simple expressions.
+  const size_t a = (n * 7919) % nsimple;
+  const size_t b = (n * 104729 + 13) % nsimple;
+  const size_t c = (n * 1299709 + 101) % nsimple;
+
+  switch (n % 5) {
+    case 0:
+      return new grammar::logical_and_expression(create_simple(a),
+                                                 create_simple(b));
+    case 1:
+      return new grammar::logical_or_expression(create_simple(a),
+                                                create_simple(b));
+    case 2:
+      return new grammar::not_expression(create_simple(a));
+    case 3:
+      return new grammar::logical_and_expression(
+               new grammar::logical_or_expression(create_simple(a),
+                                                  create_simple(b)),
+               new grammar::not_expression(create_simple(c))
+             );
+    default:
+      return new grammar::logical_or_expression(
+               new grammar::logical_and_expression(create_simple(a),
+                                                   create_simple(b)),
+               create_simple(c)
+             );
+  }
+}
+
+bool evaluate(const grammar::conditional_expression* expr,
+              const void* event,
+              size_t len)
+{
+  switch (base::extract_type(event)) {
+    case type::icmp:
+      {
+        icmp ev;
+        return ((ev.build(event, len)) &&
+                (expr->evaluate(ev, nullptr, nullptr)));
+      }
+    case type::udp:
+      {
+        udp ev;
+        return ((ev.build(event, len)) &&
+                (expr->evaluate(ev, nullptr, nullptr)));
+      }
+    case type::dns:
+      {
+        dns ev;
+        return ((ev.build(event, len)) &&
+                (expr->evaluate(ev, nullptr, nullptr)));
+      }
+    case type::tcp_begin:
+      {
+        tcp_begin ev;
+        return ((ev.build(event, len)) &&
+                (expr->evaluate(ev, nullptr, nullptr)));
+      }
+    case type::tcp_data:
+      {
+        tcp_data ev;
+        return ((ev.build(event, len)) &&
+                (expr->evaluate(ev, nullptr, nullptr)));
+      }
+    case type::tcp_end:
+      {
+        tcp_end ev;
+        return ((ev.build(event, len)) &&
+                (expr->evaluate(ev, nullptr, nullptr)));
+      }
+    case type::tcp_half_open:
+      {
+        tcp_half_open ev;
+        return ((ev.build(event, len)) &&
+                (expr->evaluate(ev, nullptr, nullptr)));
+      }
+    case type::tcp_update:
+      {
+        tcp_update ev;
+        return ((ev.build(event, len)) &&
+                (expr->evaluate(ev, nullptr, nullptr)));
+      }
+  }
+
+  return false;
+}
+
+bool check_blocks(const string::buffer& buf, const char* name)
+{
+  size_t nblocks = 0;
+  size_t npruned = 0;
+
+  const uint8_t* ptr = reinterpret_cast<const uint8_t*>(buf.data());
+  const uint8_t* end = ptr + buf.length();
+
+  while (ptr < end) {
+    // Blocks of 1 to 40 events.
+    const size_t nevents = 1 + (random32() % 40);
+
+    file::block block;
+
+    const uint8_t* const first = ptr;
+    for (size_t i = 0; (i < nevents) && (ptr < end); i++) {
+      block.add(ptr);
+      ptr += base::extract_length(ptr);
+    }
+
+    // Use the block header read back from a file of version 2 and 3.
+    for (unsigned version = 2; version <= 3; version++) {
+      uint8_t header[file::block::size_v3];
+      file::block b;
+
+      if ((block.serialize(header, sizeof(header), version) < 0) ||
+          (b.deserialize(header, sizeof(header), version) < 0)) {
+        fprintf(stderr, "Error serializing block header (%s).\n", name);
+        return false;
+      }
+
+      for (size_t i = 0; i < nsimple + ncombinations; i++) {
+        grammar::conditional_expression* expr =
+          (i < nsimple) ? create_simple(i) : create_combination(i - nsimple);
+
+        // Has the block events matching the expression?
+        bool matches = false;
+        for (const uint8_t* e = first; e < ptr; e += base::extract_length(e)) {
+          if (evaluate(expr, e, base::extract_length(e))) {
+            matches = true;
+            break;
+          }
+        }
+
+        const bool might_match = grammar::planner::match(expr, b);
+
+        delete expr;
+
+        if ((matches) && (!might_match)) {
+          fprintf(stderr,
+                  "Block %zu with matching events pruned by expression %zu "
+                  "(%s).\n",
+                  nblocks,
+                  i,
+                  name);
+
+          return false;
+        }
+
+        if (!might_match) {
+          npruned++;
+        }
+      }
+    }
+
+    nblocks++;
+  }
+
+  // The planner must prune some blocks.
+  if (npruned == 0) {
+    fprintf(stderr, "No block has been pruned (%s).\n", name);
+    return false;
+  }
+
+  printf("Blocks (%s): OK.\n", name);
+
+  return true;
+}
+
+bool check_empty_block()
+{
+  const file::block block;
+
+  for (size_t i = 0; i < nsimple; i++) {
+    grammar::conditional_expression* expr = create_simple(i);
+
+    const bool might_match = grammar::planner::match(expr, block);
+
+    delete expr;
+
+    // An empty block has no events matching the identifiers of the planner
+    // (relational operators can't prune events by type or address).
+    const grammar::identifier id = identifiers[i / nvalues /
+                                               ARRAY_SIZE(operators)];
+
+    const grammar::relational_operator op = operators[(i / nvalues) %
+                                                      ARRAY_SIZE(operators)];
+
+    switch (id) {
+      case grammar::identifier::event_type:
+        if (op > grammar::relational_operator::not_equal_to) {
+          continue;
+        }
+
+        break;
+      case grammar::identifier::source_ip:
+      case grammar::identifier::destination_ip:
+      case grammar::identifier::ip:
+        if (op != grammar::relational_operator::equal_to) {
+          continue;
+        }
+
+        break;
+      default:
+        break;
+    }
+
+    if (might_match) {
+      fprintf(stderr, "Empty block not pruned by expression %zu.\n", i);
+      return false;
+    }
+  }
+
+  printf("Empty block: OK.\n");
+
+  return true;
+}
+
+bool check_files(const string::buffer& buf)
+{
+  char v1[] = "/tmp/test_planner_v1.XXXXXX";
+  char v2[] = "/tmp/test_planner_v2.XXXXXX";
+
+  int fd1, fd2;
+  if ((fd1 = mkstemp(v1)) == -1) {
+    fprintf(stderr, "Error creating temporary file.\n");
+    return false;
+  }
+
+  if ((fd2 = mkstemp(v2)) == -1) {
+    fprintf(stderr, "Error creating temporary file.\n");
+
+    close(fd1);
+    unlink(v1);
+
+    return false;
+  }
+
+  close(fd1);
+  close(fd2);
+
+  bool ret = false;
+
+  if ((write_file(v1, 1, buf)) && (write_file(v2, 2, buf))) {
+    size_t i;
+    for (i = 0; i < nsimple + ncombinations; i++) {
+      grammar::conditional_expression* expr =
+        (i < nsimple) ? create_simple(i) : create_combination(i - nsimple);
+
+      // Count the events matching the expression.
+      size_t nmatches = 0;
+
+      const uint8_t* ptr = reinterpret_cast<const uint8_t*>(buf.data());
+      const uint8_t* end = ptr + buf.length();
+      for (; ptr < end; ptr += base::extract_length(ptr)) {
+        if (evaluate(expr, ptr, base::extract_length(ptr))) {
+          nmatches++;
+        }
+      }
+
+      // Read the files (version 1: without index).
+      const size_t n1 = read_file(v1, expr);
+      const size_t n2 = read_file(v2, expr);
+
+      delete expr;
+
+      if ((n1 != nmatches) || (n2 != nmatches)) {
+        fprintf(stderr,
+                "Expression %zu: %zu events (version 1), %zu events "
+                "(version 2), expected: %zu.\n",
+                i,
+                n1,
+                n2,
+                nmatches);
+
+        break;
+      }
+    }
+
+    if (i == nsimple + ncombinations) {
+      printf("Event files: OK.\n");
+      ret = true;
+    }
+  }
+
+  unlink(v1);
+  unlink(v2);
+
+  return ret;
+}
+
+bool write_file(const char* filename,
+                unsigned version,
+                const string::buffer& buf)
+{
+  // The writer appends to the files of version 1 (without blocks).
+  if (version == 1) {
+    file::header header;
+    header.version = 1;
+    header.timestamp.first = 0;
+    header.timestamp.last = 0;
+
+    uint8_t b[file::header::size];
+    header.serialize(b, sizeof(b));
+
+    int fd;
+    if ((fd = open(filename, O_WRONLY | O_TRUNC)) == -1) {
+      fprintf(stderr, "Error opening '%s'.\n", filename);
+      return false;
+    }
+
+    const bool ret = (write(fd, b, sizeof(b)) ==
+                      static_cast<ssize_t>(sizeof(b)));
+
+    close(fd);
+
+    if (!ret) {
+      fprintf(stderr, "Error writing to '%s'.\n", filename);
+      return false;
+    }
+  }
+
+  // Small buffer (blocks of a few events).
+  writer evwriter(64 * 1024, writer::min_buffer_size);
+
+  if ((evwriter.init()) && (evwriter.open(filename))) {
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(buf.data());
+    const uint8_t* end = ptr + buf.length();
+
+    for (; ptr < end; ptr += base::extract_length(ptr)) {
+      if (!evwriter.write(ptr, base::extract_length(ptr))) {
+        fprintf(stderr, "Error writing to '%s'.\n", filename);
+        return false;
+      }
+    }
+
+    if (evwriter.close()) {
+      return true;
+    }
+  }
+
+  fprintf(stderr, "Error writing to '%s'.\n", filename);
+
+  return false;
+}
+
+size_t read_file(const char* filename,
+                 const grammar::conditional_expression* expr)
+{
+  counter printer;
+  reader evreader(&printer);
+
+  if (evreader.open(filename)) {
+    while (evreader.next(expr));
+  }
+
+  return printer.count;
+}
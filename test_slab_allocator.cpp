@@ -0,0 +1,275 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "util/slab_allocator.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+
+// Mask of the offset of the indices.
+static constexpr const uint32_t
+       offset_mask = (static_cast<uint32_t>(1) <<
+                      util::slab_allocator::offset_bits) - 1;
+
+static bool test_round_trip(size_t object_size, size_t nslabs);
+
+// Allocate objects until there are more than 'nslabs' slabs.
+static void** allocate(util::slab_allocator& allocator,
+                       size_t nslabs,
+                       size_t& nobjects);
+
+// Check the index and the contents of the objects.
+static bool check(const util::slab_allocator& allocator,
+                  void** objects,
+                  size_t nobjects,
+                  size_t object_size,
+                  size_t nslabs,
+                  const char* step);
+
+// Write the number of the object at the beginning and at the end of it.
+static void mark(void* obj, size_t object_size, uint64_t n);
+
+int main()
+{
+  // Sizes of the objects (including sizes which are not a multiple of the
+  // alignment) and minimum number of slabs (more than the initial
+  // capacity of the array of slabs for the largest objects).
+  static constexpr const struct {
+    size_t object_size;
+    size_t nslabs;
+  } tests[] = {
+    {8, 3},
+    {13, 3},
+    {24, 3},
+    {1000, 3},
+    {4096, 3},
+    {util::slab_allocator::max_object_size, 70}
+  };
+
+  for (size_t i = 0; i < ARRAY_SIZE(tests); i++) {
+    if (!test_round_trip(tests[i].object_size, tests[i].nslabs)) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+bool test_round_trip(size_t object_size, size_t nslabs)
+{
+  util::slab_allocator allocator;
+  if (!allocator.init(object_size, -1)) {
+    fprintf(stderr, "Error initializing allocator.\n");
+    return false;
+  }
+
+  // Allocate objects in more than 'nslabs' slabs.
+  size_t nobjects;
+  void** objects;
+  if ((objects = allocate(allocator, nslabs, nobjects)) == nullptr) {
+    return false;
+  }
+
+  const size_t total = allocator.slabs();
+
+  if (!check(allocator, objects, nobjects, object_size, total, "allocate")) {
+    ::free(objects);
+    return false;
+  }
+
+  // Free every other object and allocate them again (no new slabs have to
+  // be mapped).
+  for (size_t i = 0; i < nobjects; i += 2) {
+    allocator.free(objects[i]);
+  }
+
+  if (allocator.count() != nobjects / 2) {
+    fprintf(stderr,
+            "[object size %zu] %zu objects, expected: %zu.\n",
+            object_size,
+            allocator.count(),
+            nobjects / 2);
+
+    ::free(objects);
+    return false;
+  }
+
+  for (size_t i = 0; i < nobjects; i += 2) {
+    if ((objects[i] = allocator.allocate()) == nullptr) {
+      fprintf(stderr, "Error allocating object.\n");
+
+      ::free(objects);
+      return false;
+    }
+  }
+
+  if ((allocator.slabs() != total) ||
+      (!check(allocator, objects, nobjects, object_size, total, "reuse"))) {
+    fprintf(stderr,
+            "[object size %zu] %zu slabs, expected: %zu (reuse).\n",
+            object_size,
+            allocator.slabs(),
+            total);
+
+    ::free(objects);
+    return false;
+  }
+
+  // Free all the objects (only one slab is kept) and allocate them again:
+  // the numbers of the slabs which have been freed are reused.
+  for (size_t i = 0; i < nobjects; i++) {
+    allocator.free(objects[i]);
+  }
+
+  if ((allocator.count() != 0) || (allocator.slabs() != 1)) {
+    fprintf(stderr,
+            "[object size %zu] %zu objects and %zu slabs after freeing all "
+            "the objects.\n",
+            object_size,
+            allocator.count(),
+            allocator.slabs());
+
+    ::free(objects);
+    return false;
+  }
+
+  for (size_t i = 0; i < nobjects; i++) {
+    if ((objects[i] = allocator.allocate()) == nullptr) {
+      fprintf(stderr, "Error allocating object.\n");
+
+      ::free(objects);
+      return false;
+    }
+  }
+
+  if (!check(allocator, objects, nobjects, object_size, total, "again")) {
+    ::free(objects);
+    return false;
+  }
+
+  ::free(objects);
+
+  printf("Object size %zu (%zu objects, %zu slabs): OK.\n",
+         object_size,
+         nobjects,
+         total);
+
+  return true;
+}
+
+void** allocate(util::slab_allocator& allocator,
+                size_t nslabs,
+                size_t& nobjects)
+{
+  void** objects = nullptr;
+  size_t size = 0;
+  size_t used = 0;
+
+  do {
+    if (used == size) {
+      size_t s = (size > 0) ? (size << 1) : 1024;
+
+      void** objs;
+      if ((objs = static_cast<void**>(
+                    realloc(objects, s * sizeof(void*))
+                  )) == nullptr) {
+        fprintf(stderr, "Error allocating memory.\n");
+
+        ::free(objects);
+        return nullptr;
+      }
+
+      objects = objs;
+      size = s;
+    }
+
+    if ((objects[used] = allocator.allocate()) == nullptr) {
+      fprintf(stderr, "Error allocating object.\n");
+
+      ::free(objects);
+      return nullptr;
+    }
+
+    used++;
+  } while (allocator.slabs() <= nslabs);
+
+  nobjects = used;
+
+  return objects;
+}
+
+bool check(const util::slab_allocator& allocator,
+           void** objects,
+           size_t nobjects,
+           size_t object_size,
+           size_t nslabs,
+           const char* step)
+{
+  // Mark all the objects before checking them (overlapping objects would
+  // overwrite each other).
+  for (size_t i = 0; i < nobjects; i++) {
+    mark(objects[i], object_size, i);
+  }
+
+  for (size_t i = 0; i < nobjects; i++) {
+    const uint8_t* obj = static_cast<const uint8_t*>(objects[i]);
+    const uint32_t idx = allocator.index(obj);
+
+    // Beginning of the slab of the object.
+    const uint8_t* slab = reinterpret_cast<const uint8_t*>(
+                            reinterpret_cast<uintptr_t>(obj) &
+                            ~(static_cast<uintptr_t>(
+                                util::slab_allocator::slab_size
+                              ) - 1)
+                          );
+
+    if ((idx >= util::slab_allocator::max_index) ||
+        ((idx >> util::slab_allocator::offset_bits) >= nslabs) ||
+        ((idx & offset_mask) * 8 != static_cast<size_t>(obj - slab)) ||
+        (allocator.object(idx) != obj)) {
+      fprintf(stderr,
+              "[object size %zu] Wrong index 0x%08x of object %zu (%s).\n",
+              object_size,
+              idx,
+              i,
+              step);
+
+      return false;
+    }
+
+    const uint64_t* first = reinterpret_cast<const uint64_t*>(obj);
+    const uint64_t* last = reinterpret_cast<const uint64_t*>(
+                             obj + ((object_size - 1) & ~7ul)
+                           );
+
+    if ((*first != i) || (*last != i)) {
+      fprintf(stderr,
+              "[object size %zu] Object %zu has been overwritten (%s).\n",
+              object_size,
+              i,
+              step);
+
+      return false;
+    }
+  }
+
+  if (allocator.count() != nobjects) {
+    fprintf(stderr,
+            "[object size %zu] %zu objects, expected: %zu (%s).\n",
+            object_size,
+            allocator.count(),
+            nobjects,
+            step);
+
+    return false;
+  }
+
+  return true;
+}
+
+void mark(void* obj, size_t object_size, uint64_t n)
+{
+  uint8_t* o = static_cast<uint8_t*>(obj);
+
+  *reinterpret_cast<uint64_t*>(o) = n;
+  *reinterpret_cast<uint64_t*>(o + ((object_size - 1) & ~7ul)) = n;
+}
@@ -0,0 +1,292 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "util/slab_allocator.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+
+// Number of threads.
+static constexpr const size_t nthreads = 8;
+
+// Number of iterations per thread.
+static constexpr const size_t iterations = 100000;
+
+// Offset of the owner of a slab taken from the pool (the first word is
+// the link to the next free slab).
+static constexpr const size_t owner_offset = 64;
+
+struct context {
+  // Pool shared by all the threads.
+  util::slab_pool* pool;
+
+  // Number of the thread (starting at 1).
+  uint32_t id;
+
+  // State of the random number generator.
+  uint32_t random;
+
+  // Error?
+  bool error;
+};
+
+static bool test_pop_push();
+static bool test_allocators();
+
+static void* pop_push(void* arg);
+static void* allocate_free(void* arg);
+
+// Run 'fn' in 'nthreads' threads.
+static bool run(util::slab_pool& pool, void* (*fn)(void*));
+
+static uint32_t random32(uint32_t& state);
+
+int main()
+{
+  if ((!test_pop_push()) || (!test_allocators())) {
+    return -1;
+  }
+
+  return 0;
+}
+
+bool test_pop_push()
+{
+  // Fewer slabs than threads, so that the threads compete for them.
+  static constexpr const size_t nslabs = nthreads / 2;
+
+  util::slab_pool pool;
+  if (!pool.init(nslabs)) {
+    fprintf(stderr, "Error initializing pool.\n");
+    return false;
+  }
+
+  // Map all the slabs of the pool and give them back to it.
+  {
+    util::slab_allocator allocator;
+    if (!allocator.init(util::slab_allocator::max_object_size, -1, &pool)) {
+      fprintf(stderr, "Error initializing allocator.\n");
+      return false;
+    }
+
+    while (allocator.allocate() != nullptr);
+
+    if (allocator.slabs() != nslabs) {
+      fprintf(stderr,
+              "%zu slabs mapped, expected: %zu.\n",
+              allocator.slabs(),
+              nslabs);
+
+      return false;
+    }
+  }
+
+  if (pool.free_slabs() != nslabs) {
+    fprintf(stderr,
+            "%zu free slabs, expected: %zu.\n",
+            pool.free_slabs(),
+            nslabs);
+
+    return false;
+  }
+
+  if (!run(pool, pop_push)) {
+    return false;
+  }
+
+  // All the slabs have to be back in the pool, each one only once.
+  void* slabs[nslabs];
+  size_t n = 0;
+  for (; (n < nslabs) && ((slabs[n] = pool.pop()) != nullptr); n++) {
+    for (size_t i = 0; i < n; i++) {
+      if (slabs[i] == slabs[n]) {
+        fprintf(stderr, "Slab in the pool twice.\n");
+        return false;
+      }
+    }
+  }
+
+  if ((n != nslabs) || (pool.pop() != nullptr)) {
+    fprintf(stderr, "Slabs lost or duplicated in the pool.\n");
+    return false;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    pool.push(slabs[i]);
+  }
+
+  printf("Pop / push (%zu threads, %zu slabs): OK.\n", nthreads, nslabs);
+
+  return true;
+}
+
+bool test_allocators()
+{
+  // Two slabs per thread (the allocations fail when the budget is
+  // exhausted).
+  static constexpr const size_t nslabs = 2 * nthreads;
+
+  util::slab_pool pool;
+  if (!pool.init(nslabs)) {
+    fprintf(stderr, "Error initializing pool.\n");
+    return false;
+  }
+
+  if (!run(pool, allocate_free)) {
+    return false;
+  }
+
+  // The allocators have given all their slabs back.
+  if ((pool.slabs() > nslabs) || (pool.free_slabs() != pool.slabs())) {
+    fprintf(stderr,
+            "%zu slabs mapped, %zu free slabs (budget: %zu).\n",
+            pool.slabs(),
+            pool.free_slabs(),
+            nslabs);
+
+    return false;
+  }
+
+  printf("Allocators (%zu threads, %zu slabs): OK.\n", nthreads, nslabs);
+
+  return true;
+}
+
+void* pop_push(void* arg)
+{
+  context* ctx = static_cast<context*>(arg);
+
+  for (size_t i = 0; i < iterations; i++) {
+    // Take up to two slabs.
+    void* slabs[2];
+    size_t n = 0;
+
+    for (size_t j = 1 + (random32(ctx->random) & 1); j > 0; j--) {
+      if ((slabs[n] = ctx->pool->pop()) != nullptr) {
+        uint32_t* owner = reinterpret_cast<uint32_t*>(
+                            static_cast<uint8_t*>(slabs[n]) + owner_offset
+                          );
+
+        // If the slab is owned by another thread...
+        if (__atomic_exchange_n(owner, ctx->id, __ATOMIC_RELAXED) != 0) {
+          fprintf(stderr, "Slab taken twice (thread %u).\n", ctx->id);
+          ctx->error = true;
+        }
+
+        n++;
+      }
+    }
+
+    // Give them back.
+    while (n > 0) {
+      void* slab = slabs[--n];
+
+      uint32_t* owner = reinterpret_cast<uint32_t*>(
+                          static_cast<uint8_t*>(slab) + owner_offset
+                        );
+
+      if (__atomic_exchange_n(owner, 0, __ATOMIC_RELAXED) != ctx->id) {
+        fprintf(stderr, "Slab taken twice (thread %u).\n", ctx->id);
+        ctx->error = true;
+      }
+
+      ctx->pool->push(slab);
+    }
+
+    if (ctx->error) {
+      break;
+    }
+  }
+
+  return nullptr;
+}
+
+void* allocate_free(void* arg)
+{
+  context* ctx = static_cast<context*>(arg);
+
+  // 15 objects per slab.
+  util::slab_allocator allocator;
+  if (!allocator.init(util::slab_allocator::max_object_size,
+                      -1,
+                      ctx->pool)) {
+    fprintf(stderr, "Error initializing allocator.\n");
+    ctx->error = true;
+
+    return nullptr;
+  }
+
+  // Up to four slabs.
+  uint64_t* objects[60];
+
+  for (size_t i = 0; (i < iterations / 10) && (!ctx->error); i++) {
+    // Owner of the objects of this iteration.
+    const uint64_t owner = (static_cast<uint64_t>(ctx->id) << 32) | i;
+
+    size_t n = 0;
+    for (size_t j = random32(ctx->random) % ARRAY_SIZE(objects); j > 0; j--) {
+      // Might fail if the other threads use the rest of the budget.
+      if ((objects[n] = static_cast<uint64_t*>(allocator.allocate())) !=
+          nullptr) {
+        *objects[n++] = owner;
+      }
+    }
+
+    if (ctx->pool->slabs() > ctx->pool->max_slabs()) {
+      fprintf(stderr, "Budget exceeded (thread %u).\n", ctx->id);
+      ctx->error = true;
+    }
+
+    for (size_t j = 0; j < n; j++) {
+      if (*objects[j] != owner) {
+        fprintf(stderr, "Slab used by two threads (thread %u).\n", ctx->id);
+        ctx->error = true;
+      }
+
+      allocator.free(objects[j]);
+    }
+  }
+
+  return nullptr;
+}
+
+bool run(util::slab_pool& pool, void* (*fn)(void*))
+{
+  context contexts[nthreads];
+  pthread_t threads[nthreads];
+
+  size_t n = 0;
+  for (; n < nthreads; n++) {
+    contexts[n].pool = &pool;
+    contexts[n].id = static_cast<uint32_t>(n + 1);
+    contexts[n].random = 2463534242u + static_cast<uint32_t>(n);
+    contexts[n].error = false;
+
+    if (pthread_create(&threads[n], nullptr, fn, &contexts[n]) != 0) {
+      fprintf(stderr, "Error creating thread.\n");
+      break;
+    }
+  }
+
+  bool ret = (n == nthreads);
+
+  for (size_t i = 0; i < n; i++) {
+    pthread_join(threads[i], nullptr);
+
+    if (contexts[i].error) {
+      ret = false;
+    }
+  }
+
+  return ret;
+}
+
+uint32_t random32(uint32_t& state)
+{
+  // Xorshift.
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+
+  return state;
+}
@@ -0,0 +1,244 @@
+#include <stdlib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "util/timer_wheel.h"
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
+
+struct object {
+  util::timer timer;
+
+  // Tick at which the timer must expire.
+  uint64_t expected;
+
+  // Number of times the timer has expired.
+  unsigned nexpired;
+};
+
+typedef util::timer_wheel<object> timer_wheel;
+
+// Maximum number of ticks a timer can be scheduled ahead (see
+// 'util::timer_wheel').
+static constexpr const uint64_t max_ticks = (static_cast<uint64_t>(1) << 26) -
+                                            1;
+
+static bool test_schedule(uint64_t start);
+static bool test_reschedule(uint64_t start);
+
+static object* allocate(util::slab_allocator& allocator);
+
+int main()
+{
+  // First ticks, first level not aligned, lowest 32 bits about to wrap
+  // around.
+  static constexpr const uint64_t starts[] = {
+    0,
+    255,
+    12345,
+    0xffffff00 - 3
+  };
+
+  for (size_t i = 0; i < ARRAY_SIZE(starts); i++) {
+    if ((!test_schedule(starts[i])) || (!test_reschedule(starts[i]))) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+bool test_schedule(uint64_t start)
+{
+  // Ticks ahead (the boundaries of the levels and beyond the maximum).
+  static constexpr const uint64_t deltas[] = {
+    0,
+    1,
+    2,
+    255,
+    256,
+    257,
+    16383,
+    16384,
+    16385,
+    1048575,
+    1048576,
+    1048577,
+    max_ticks - 1,
+    max_ticks,
+    max_ticks + 1,
+    max_ticks + 1000
+  };
+
+  util::slab_allocator allocator;
+  if (!allocator.init(sizeof(object), -1)) {
+    fprintf(stderr, "Error initializing allocator.\n");
+    return false;
+  }
+
+  timer_wheel wheel(allocator);
+  wheel.reset(start);
+
+  // Two timers per expiration (to have several timers in the same slot)
+  // and one which had already expired.
+  for (size_t i = 0; i < 2 * ARRAY_SIZE(deltas) + 1; i++) {
+    object* obj;
+    if ((obj = allocate(allocator)) == nullptr) {
+      return false;
+    }
+
+    if (i < 2 * ARRAY_SIZE(deltas)) {
+      const uint64_t delta = deltas[i % ARRAY_SIZE(deltas)];
+
+      // The timers scheduled too far ahead expire after 'max_ticks'.
+      obj->expected = start + ((delta <= max_ticks) ? delta : max_ticks);
+
+      wheel.add(allocator.index(obj), start + delta);
+    } else {
+      obj->expected = start;
+
+      wheel.add(allocator.index(obj), start - 10);
+    }
+  }
+
+  const size_t ntimers = wheel.count();
+
+  // Advance one tick at a time.
+  size_t nexpired = 0;
+  for (uint64_t now = start; now <= start + max_ticks + 1; now++) {
+    uint32_t idx;
+    while ((idx = wheel.expired(now)) != timer_wheel::none) {
+      object* obj = static_cast<object*>(allocator.object(idx));
+
+      if (obj->expected != now) {
+        fprintf(stderr,
+                "[start %" PRIu64 "] Timer expected at tick %" PRIu64 " "
+                "has expired at tick %" PRIu64 ".\n",
+                start,
+                obj->expected - start,
+                now - start);
+
+        return false;
+      }
+
+      wheel.remove(idx);
+      nexpired++;
+    }
+  }
+
+  if ((nexpired != ntimers) || (!wheel.empty())) {
+    fprintf(stderr,
+            "[start %" PRIu64 "] %zu timers have expired, expected: %zu.\n",
+            start,
+            nexpired,
+            ntimers);
+
+    return false;
+  }
+
+  printf("Schedule (start %" PRIu64 "): OK.\n", start);
+
+  return true;
+}
+
+bool test_reschedule(uint64_t start)
+{
+  util::slab_allocator allocator;
+  if (!allocator.init(sizeof(object), -1)) {
+    fprintf(stderr, "Error initializing allocator.\n");
+    return false;
+  }
+
+  timer_wheel wheel(allocator);
+  wheel.reset(start);
+
+  object* cancelled;
+  object* modified;
+  object* periodic;
+  if (((cancelled = allocate(allocator)) == nullptr) ||
+      ((modified = allocate(allocator)) == nullptr) ||
+      ((periodic = allocate(allocator)) == nullptr)) {
+    return false;
+  }
+
+  const uint32_t cancelled_idx = allocator.index(cancelled);
+  const uint32_t modified_idx = allocator.index(modified);
+  const uint32_t periodic_idx = allocator.index(periodic);
+
+  // Timer in the second level, cancelled and scheduled again in the third
+  // level.
+  wheel.add(cancelled_idx, start + 300);
+  cancelled->expected = start + 100 + 20000;
+
+  // Timer in the third level, brought forward to the first level.
+  wheel.add(modified_idx, start + 50000);
+  modified->expected = start + 100 + 200;
+
+  // Timer scheduled again every time it expires.
+  wheel.add(periodic_idx, start + 1000);
+  periodic->expected = start + 1000;
+
+  for (uint64_t now = start; now <= start + 30000; now++) {
+    if (now == start + 100) {
+      wheel.remove(cancelled_idx);
+      wheel.add(cancelled_idx, now + 20000);
+
+      wheel.modify(modified_idx, now + 200);
+    }
+
+    uint32_t idx;
+    while ((idx = wheel.expired(now)) != timer_wheel::none) {
+      object* obj = static_cast<object*>(allocator.object(idx));
+
+      if (obj->expected != now) {
+        fprintf(stderr,
+                "[start %" PRIu64 "] Timer expected at tick %" PRIu64 " "
+                "has expired at tick %" PRIu64 " (reschedule).\n",
+                start,
+                obj->expected - start,
+                now - start);
+
+        return false;
+      }
+
+      obj->nexpired++;
+
+      if (obj == periodic) {
+        periodic->expected = now + 1000;
+        wheel.modify(idx, periodic->expected);
+      } else {
+        wheel.remove(idx);
+      }
+    }
+  }
+
+  if ((cancelled->nexpired != 1) ||
+      (modified->nexpired != 1) ||
+      (periodic->nexpired != 30) ||
+      (wheel.count() != 1)) {
+    fprintf(stderr,
+            "[start %" PRIu64 "] Wrong number of expirations "
+            "(reschedule).\n",
+            start);
+
+    return false;
+  }
+
+  printf("Reschedule (start %" PRIu64 "): OK.\n", start);
+
+  return true;
+}
+
+object* allocate(util::slab_allocator& allocator)
+{
+  object* obj;
+  if ((obj = static_cast<object*>(allocator.allocate())) != nullptr) {
+    obj->expected = 0;
+    obj->nexpired = 0;
+
+    return obj;
+  }
+
+  fprintf(stderr, "Error allocating object.\n");
+
+  return nullptr;
+}
@@ -1,5 +1,19 @@
+#include <string.h>
+#include <errno.h>
+#include <endian.h>
+#include <sys/random.h>
+#if defined(__x86_64__)
+  #include <nmmintrin.h>
+#endif
 #include "util/hash.h"
 
+#define sip_round(v0, v1, v2, v3) {                           \
+  v0 += v1; v1 = rol64(v1, 13); v1 ^= v0; v0 = rol64(v0, 32); \
+  v2 += v3; v3 = rol64(v3, 16); v3 ^= v2;                     \
+  v0 += v3; v3 = rol64(v3, 21); v3 ^= v0;                     \
+  v2 += v1; v1 = rol64(v1, 17); v1 ^= v2; v2 = rol64(v2, 32); \
+}
+
 uint32_t util::hash::hashlittle(const void* key,
                                 size_t length,
                                 uint32_t initval)
@@ -29,15 +43,15 @@ uint32_t util::hash::hashlittle(const void* key,
     case 11: c += static_cast<uint32_t>(k[10]) << 16; // Fall through.
     case 10: c += static_cast<uint32_t>(k[9]) << 8; // Fall through.
     case 9: c += k[8]; // Fall through.
-    case 8: c += static_cast<uint32_t>(k[7]) << 24; // Fall through.
-    case 7: c += static_cast<uint32_t>(k[6]) << 16; // Fall through.
-    case 6: c += static_cast<uint32_t>(k[5]) << 8; // Fall through.
-    case 5: c += k[4]; // Fall through.
-    case 4: c += static_cast<uint32_t>(k[3]) << 24; // Fall through.
-    case 3: c += static_cast<uint32_t>(k[2]) << 16; // Fall through.
-    case 2: c += static_cast<uint32_t>(k[1]) << 8; // Fall through.
+    case 8: b += static_cast<uint32_t>(k[7]) << 24; // Fall through.
+    case 7: b += static_cast<uint32_t>(k[6]) << 16; // Fall through.
+    case 6: b += static_cast<uint32_t>(k[5]) << 8; // Fall through.
+    case 5: b += k[4]; // Fall through.
+    case 4: a += static_cast<uint32_t>(k[3]) << 24; // Fall through.
+    case 3: a += static_cast<uint32_t>(k[2]) << 16; // Fall through.
+    case 2: a += static_cast<uint32_t>(k[1]) << 8; // Fall through.
     case 1:
-      c += k[0];
+      a += k[0];
 
       hash_final(a, b, c);
       break;
@@ -45,3 +59,149 @@ uint32_t util::hash::hashlittle(const void* key,
 
   return c;
 }
+
+uint32_t util::hash::crc32c(const void* key, size_t length, uint32_t initval)
+{
+#if defined(__x86_64__)
+  // Does the processor support SSE4.2?
+  static const bool sse42 = __builtin_cpu_supports("sse4.2");
+
+  if (sse42) {
+    return crc32c_sse42(key, length, initval);
+  }
+#endif
+
+  return crc32c_generic(key, length, initval);
+}
+
+uint64_t util::hash::siphash13(const void* key,
+                               size_t length,
+                               const uint64_t k[2])
+{
+  uint64_t v0 = 0x736f6d6570736575ull ^ k[0];
+  uint64_t v1 = 0x646f72616e646f6dull ^ k[1];
+  uint64_t v2 = 0x6c7967656e657261ull ^ k[0];
+  uint64_t v3 = 0x7465646279746573ull ^ k[1];
+
+  const uint8_t* p = static_cast<const uint8_t*>(key);
+  const uint8_t* const end = p + (length & ~static_cast<size_t>(7));
+
+  // Compression (1 round per 8-byte word).
+  for (; p < end; p += 8) {
+    uint64_t m;
+    memcpy(&m, p, sizeof(m));
+    m = le64toh(m);
+
+    v3 ^= m;
+    sip_round(v0, v1, v2, v3);
+    v0 ^= m;
+  }
+
+  // Last word: remaining bytes and length.
+  uint64_t b = static_cast<uint64_t>(length) << 56;
+
+  switch (length & 7) {
+    case 7: b |= static_cast<uint64_t>(p[6]) << 48; // Fall through.
+    case 6: b |= static_cast<uint64_t>(p[5]) << 40; // Fall through.
+    case 5: b |= static_cast<uint64_t>(p[4]) << 32; // Fall through.
+    case 4: b |= static_cast<uint64_t>(p[3]) << 24; // Fall through.
+    case 3: b |= static_cast<uint64_t>(p[2]) << 16; // Fall through.
+    case 2: b |= static_cast<uint64_t>(p[1]) << 8; // Fall through.
+    case 1: b |= p[0];
+  }
+
+  v3 ^= b;
+  sip_round(v0, v1, v2, v3);
+  v0 ^= b;
+
+  // Finalization (3 rounds).
+  v2 ^= 0xff;
+  sip_round(v0, v1, v2, v3);
+  sip_round(v0, v1, v2, v3);
+  sip_round(v0, v1, v2, v3);
+
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+bool util::hash::random_key(void* key, size_t length)
+{
+  uint8_t* k = static_cast<uint8_t*>(key);
+
+  while (length > 0) {
+    ssize_t ret;
+    if ((ret = getrandom(k, length, 0)) > 0) {
+      k += ret;
+      length -= ret;
+    } else if ((ret < 0) && (errno != EINTR)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+uint32_t util::hash::crc32c_generic(const void* key,
+                                    size_t length,
+                                    uint32_t initval)
+{
+  // Table of the CRCs of the bytes (reflected polynomial 0x82f63b78).
+  static const struct table {
+    uint32_t crcs[256];
+
+    table()
+    {
+      for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (unsigned j = 0; j < 8; j++) {
+          crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+        }
+
+        crcs[i] = crc;
+      }
+    }
+  } t;
+
+  const uint8_t* k = static_cast<const uint8_t*>(key);
+
+  uint32_t crc = ~initval;
+  for (size_t i = 0; i < length; i++) {
+    crc = t.crcs[(crc ^ k[i]) & 0xff] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+uint32_t util::hash::crc32c_sse42(const void* key,
+                                  size_t length,
+                                  uint32_t initval)
+{
+  const uint8_t* k = static_cast<const uint8_t*>(key);
+
+  uint64_t crc = ~initval;
+
+  for (; length >= 8; k += 8, length -= 8) {
+    uint64_t v;
+    memcpy(&v, k, sizeof(v));
+
+    crc = _mm_crc32_u64(crc, v);
+  }
+
+  if (length >= 4) {
+    uint32_t v;
+    memcpy(&v, k, sizeof(v));
+
+    crc = _mm_crc32_u32(static_cast<uint32_t>(crc), v);
+
+    k += 4;
+    length -= 4;
+  }
+
+  for (; length > 0; k++, length--) {
+    crc = _mm_crc32_u8(static_cast<uint32_t>(crc), *k);
+  }
+
+  return ~static_cast<uint32_t>(crc);
+}
+#endif
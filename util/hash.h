@@ -27,6 +27,24 @@ namespace util {
                                  size_t length,
                                  uint32_t initval);
 
+      // Hash an array of 'length' 32-bit words.
+      static uint32_t hashword(const uint32_t* k,
+                               size_t length,
+                               uint32_t initval);
+
+      // CRC32C (Castagnoli polynomial), it uses the instruction crc32 of
+      // SSE4.2 if the processor supports it.
+      static uint32_t crc32c(const void* key, size_t length, uint32_t initval);
+
+      // SipHash-1-3 (128-bit key):
+      // https://github.com/veorq/SipHash
+      static uint64_t siphash13(const void* key,
+                                size_t length,
+                                const uint64_t k[2]);
+
+      // Generate a random key for the hash functions.
+      static bool random_key(void* key, size_t length);
+
     private:
       static constexpr const uint32_t hash_initval = 0xdeadbeef;
 
@@ -36,7 +54,20 @@ namespace util {
                                    uint32_t c,
                                    uint32_t initval);
 
+      // CRC32C (software).
+      static uint32_t crc32c_generic(const void* key,
+                                     size_t length,
+                                     uint32_t initval);
+
+#if defined(__x86_64__)
+      // CRC32C (SSE4.2).
+      static uint32_t crc32c_sse42(const void* key,
+                                   size_t length,
+                                   uint32_t initval);
+#endif
+
       static uint32_t rol32(uint32_t x, uint32_t k);
+      static uint64_t rol64(uint64_t x, uint32_t k);
       static uint32_t get_unaligned_cpu32(const void* p);
   };
 
@@ -77,6 +108,42 @@ namespace util {
     return hash_nwords(a, b, c, initval + hash_initval + (3 << 2));
   }
 
+  inline uint32_t hash::hashword(const uint32_t* k,
+                                 size_t length,
+                                 uint32_t initval)
+  {
+    uint32_t a, b, c; // Internal state.
+
+    // Set up the internal state.
+    a = b = c = hash_initval + (static_cast<uint32_t>(length) << 2) + initval;
+
+    // Handle most of the key.
+    while (length > 3) {
+      a += k[0];
+      b += k[1];
+      c += k[2];
+
+      hash_mix(a, b, c);
+
+      length -= 3;
+
+      k += 3;
+    }
+
+    // Handle the last 3 words.
+    switch (length) {
+      case 3: c += k[2]; // Fall through.
+      case 2: b += k[1]; // Fall through.
+      case 1:
+        a += k[0];
+
+        hash_final(a, b, c);
+        break;
+    }
+
+    return c;
+  }
+
   inline uint32_t hash::hash_nwords(uint32_t a,
                                     uint32_t b,
                                     uint32_t c,
@@ -96,6 +163,11 @@ namespace util {
     return ((x << k) | (x >> ((-k) & 31)));
   }
 
+  inline uint64_t hash::rol64(uint64_t x, uint32_t k)
+  {
+    return ((x << k) | (x >> ((-k) & 63)));
+  }
+
   inline uint32_t hash::get_unaligned_cpu32(const void* p)
   {
     struct __una_u32 {
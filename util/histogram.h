@@ -0,0 +1,121 @@
+#ifndef UTIL_HISTOGRAM_H
+#define UTIL_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace util {
+  // Histogram with bins of powers of 2: 0, 1, 2-3, 4-7, ..., the last
+  // bin counts the values greater or equal than its lower bound.
+  template<size_t Bins>
+  class basic_histogram {
+    static_assert((Bins >= 2) && (Bins <= 33), "Invalid number of bins");
+
+    public:
+      // Number of bins.
+      static constexpr const size_t nbins = Bins;
+
+      // Constructor.
+      basic_histogram();
+
+      // Destructor.
+      ~basic_histogram() = default;
+
+      // Clear.
+      void clear();
+
+      // Add value.
+      void add(uint32_t value);
+
+      // Get the number of values of the bin.
+      uint64_t count(size_t bin) const;
+
+      // Get the total number of values.
+      uint64_t total() const;
+
+      // Get the maximum value.
+      uint32_t max() const;
+
+      // Get the lower bound of the bin.
+      static uint32_t lower(size_t bin);
+
+      // Get the upper bound of the bin (UINT32_MAX for the last bin).
+      static uint32_t upper(size_t bin);
+
+    private:
+      // Number of values per bin.
+      uint64_t _M_counts[nbins];
+
+      // Maximum value.
+      uint32_t _M_max;
+  };
+
+  // Histogram of 8 bins (0 .. 64+).
+  typedef basic_histogram<8> histogram;
+
+  template<size_t Bins>
+  inline basic_histogram<Bins>::basic_histogram()
+  {
+    clear();
+  }
+
+  template<size_t Bins>
+  inline void basic_histogram<Bins>::clear()
+  {
+    memset(_M_counts, 0, sizeof(_M_counts));
+    _M_max = 0;
+  }
+
+  template<size_t Bins>
+  inline void basic_histogram<Bins>::add(uint32_t value)
+  {
+    // Bin: number of significant bits of the value.
+    size_t bin = (value != 0) ? 32 - __builtin_clz(value) : 0;
+
+    _M_counts[(bin < nbins) ? bin : nbins - 1]++;
+
+    if (value > _M_max) {
+      _M_max = value;
+    }
+  }
+
+  template<size_t Bins>
+  inline uint64_t basic_histogram<Bins>::count(size_t bin) const
+  {
+    return _M_counts[bin];
+  }
+
+  template<size_t Bins>
+  inline uint64_t basic_histogram<Bins>::total() const
+  {
+    uint64_t total = 0;
+    for (size_t i = 0; i < nbins; i++) {
+      total += _M_counts[i];
+    }
+
+    return total;
+  }
+
+  template<size_t Bins>
+  inline uint32_t basic_histogram<Bins>::max() const
+  {
+    return _M_max;
+  }
+
+  template<size_t Bins>
+  inline uint32_t basic_histogram<Bins>::lower(size_t bin)
+  {
+    return (bin != 0) ? static_cast<uint32_t>(1) << (bin - 1) : 0;
+  }
+
+  template<size_t Bins>
+  inline uint32_t basic_histogram<Bins>::upper(size_t bin)
+  {
+    return (bin < nbins - 1) ?
+             (static_cast<uint32_t>(1) << bin) - 1 :
+             UINT32_MAX;
+  }
+}
+
+#endif // UTIL_HISTOGRAM_H
@@ -0,0 +1,223 @@
+#include <string.h>
+#include "util/lz4.h"
+
+static inline uint32_t read32(const uint8_t* p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(uint32_t));
+
+  return v;
+}
+
+size_t util::lz4::compress(const void* src,
+                           size_t srclen,
+                           void* dst,
+                           size_t dstlen)
+{
+  const uint8_t* const base = static_cast<const uint8_t*>(src);
+  const uint8_t* const end = base + srclen;
+  const uint8_t* anchor = base;
+
+  uint8_t* const out = static_cast<uint8_t*>(dst);
+  uint8_t* const outend = out + dstlen;
+  uint8_t* op = out;
+
+  // If the input is long enough for having matches...
+  if (srclen > match_limit) {
+    // Last position where a match can start.
+    const uint8_t* const mflimit = end - match_limit;
+
+    // Matches end before the last literals.
+    const uint8_t* const matchend = end - last_literals;
+
+    memset(_M_table, 0, sizeof(_M_table));
+
+    const uint8_t* ip = base;
+    while (ip <= mflimit) {
+      uint32_t seq = read32(ip);
+      uint32_t h = hash(seq);
+
+      const uint8_t* ref = base + _M_table[h];
+      _M_table[h] = static_cast<uint32_t>(ip - base);
+
+      // If there is a match...
+      if ((ref < ip) &&
+          (static_cast<size_t>(ip - ref) <= max_offset) &&
+          (read32(ref) == seq)) {
+        // Extend the match backwards.
+        while ((ip > anchor) && (ref > base) && (ip[-1] == ref[-1])) {
+          ip--;
+          ref--;
+        }
+
+        // Extend the match forwards.
+        const uint8_t* p = ip + min_match;
+        const uint8_t* q = ref + min_match;
+        while ((p < matchend) && (*p == *q)) {
+          p++;
+          q++;
+        }
+
+        size_t litlen = ip - anchor;
+        size_t matchlen = (p - ip) - min_match;
+
+        // If the sequence might not fit...
+        if (static_cast<size_t>(outend - op) < 1 +                   // Token.
+                                               (litlen / 255) + 1 +  // Length.
+                                               litlen +              // Data.
+                                               2 +                   // Offset.
+                                               (matchlen / 255) + 1) {
+          return 0;
+        }
+
+        // Write literals.
+        uint8_t* token = op++;
+        if (litlen >= 15) {
+          *token = 15 << 4;
+          op = write_length(op, litlen - 15);
+        } else {
+          *token = static_cast<uint8_t>(litlen << 4);
+        }
+
+        memcpy(op, anchor, litlen);
+        op += litlen;
+
+        // Write offset (little endian).
+        size_t offset = ip - ref;
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+
+        // Write match length.
+        if (matchlen >= 15) {
+          *token |= 15;
+          op = write_length(op, matchlen - 15);
+        } else {
+          *token |= static_cast<uint8_t>(matchlen);
+        }
+
+        anchor = ip = p;
+      } else {
+        // Skip faster through the data which doesn't compress.
+        ip += 1 + ((ip - anchor) >> 6);
+      }
+    }
+  }
+
+  // Last literals.
+  size_t litlen = end - anchor;
+  if (static_cast<size_t>(outend - op) < 1 + (litlen / 255) + 1 + litlen) {
+    return 0;
+  }
+
+  if (litlen >= 15) {
+    *op++ = 15 << 4;
+    op = write_length(op, litlen - 15);
+  } else {
+    *op++ = static_cast<uint8_t>(litlen << 4);
+  }
+
+  memcpy(op, anchor, litlen);
+  op += litlen;
+
+  return op - out;
+}
+
+bool util::lz4::decompress(const void* src,
+                           size_t srclen,
+                           void* dst,
+                           size_t dstlen)
+{
+  const uint8_t* ip = static_cast<const uint8_t*>(src);
+  const uint8_t* const end = ip + srclen;
+
+  uint8_t* const out = static_cast<uint8_t*>(dst);
+  uint8_t* const outend = out + dstlen;
+  uint8_t* op = out;
+
+  while (ip < end) {
+    unsigned token = *ip++;
+
+    // Literals.
+    size_t len = token >> 4;
+    if (len == 15) {
+      uint8_t b;
+      do {
+        if (ip == end) {
+          return false;
+        }
+
+        len += (b = *ip++);
+      } while (b == 255);
+    }
+
+    if ((len > static_cast<size_t>(end - ip)) ||
+        (len > static_cast<size_t>(outend - op))) {
+      return false;
+    }
+
+    memcpy(op, ip, len);
+    op += len;
+    ip += len;
+
+    // If it is the last sequence...
+    if (ip == end) {
+      break;
+    }
+
+    // Offset.
+    if (end - ip < 2) {
+      return false;
+    }
+
+    size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+
+    if ((offset == 0) || (offset > static_cast<size_t>(op - out))) {
+      return false;
+    }
+
+    // Match.
+    len = token & 0x0f;
+    if (len == 15) {
+      uint8_t b;
+      do {
+        if (ip == end) {
+          return false;
+        }
+
+        len += (b = *ip++);
+      } while (b == 255);
+    }
+
+    len += min_match;
+
+    if (len > static_cast<size_t>(outend - op)) {
+      return false;
+    }
+
+    const uint8_t* ref = op - offset;
+
+    // If the match doesn't overlap the output...
+    if (offset >= len) {
+      memcpy(op, ref, len);
+      op += len;
+    } else {
+      for (size_t i = 0; i < len; i++) {
+        *op++ = *ref++;
+      }
+    }
+  }
+
+  return (op == outend);
+}
+
+uint8_t* util::lz4::write_length(uint8_t* dst, size_t len)
+{
+  for (; len >= 255; len -= 255) {
+    *dst++ = 255;
+  }
+
+  *dst++ = static_cast<uint8_t>(len);
+
+  return dst;
+}
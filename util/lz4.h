@@ -0,0 +1,80 @@
+#ifndef UTIL_LZ4_H
+#define UTIL_LZ4_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace util {
+  // LZ4 block format:
+  // https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+  //
+  // The compressor looks for matches of 4 bytes through a hash table of
+  // the last positions (greedy, as the fast mode of the reference
+  // implementation), the output can be decompressed by any LZ4
+  // implementation.
+  class lz4 {
+    public:
+      // Constructor.
+      lz4() = default;
+
+      // Destructor.
+      ~lz4() = default;
+
+      // Maximum size of the compressed data.
+      static size_t bound(size_t len);
+
+      // Compress.
+      // Returns the number of bytes of the compressed data or 0 if they
+      // don't fit in 'dstlen' bytes.
+      size_t compress(const void* src, size_t srclen, void* dst, size_t dstlen);
+
+      // Decompress.
+      // Returns true if 'src' decompresses to exactly 'dstlen' bytes.
+      static bool decompress(const void* src,
+                             size_t srclen,
+                             void* dst,
+                             size_t dstlen);
+
+    private:
+      // Minimum length of a match.
+      static constexpr const size_t min_match = 4;
+
+      // The last 5 bytes are always literals.
+      static constexpr const size_t last_literals = 5;
+
+      // The last match starts at least 12 bytes before the end.
+      static constexpr const size_t match_limit = 12;
+
+      // Maximum offset of a match.
+      static constexpr const size_t max_offset = 65535;
+
+      // Number of bits of the hash table.
+      static constexpr const unsigned hash_log = 12;
+
+      // Positions (offset from the beginning of the input) of the last
+      // sequences of 4 bytes.
+      uint32_t _M_table[1u << hash_log];
+
+      // Hash sequence of 4 bytes.
+      static uint32_t hash(uint32_t v);
+
+      // Write length (the rest after the token).
+      static uint8_t* write_length(uint8_t* dst, size_t len);
+
+      // Disable copy constructor and assignment operator.
+      lz4(const lz4&) = delete;
+      lz4& operator=(const lz4&) = delete;
+  };
+
+  inline size_t lz4::bound(size_t len)
+  {
+    return len + (len / 255) + 16;
+  }
+
+  inline uint32_t lz4::hash(uint32_t v)
+  {
+    return (v * 2654435761u) >> (32 - hash_log);
+  }
+}
+
+#endif // UTIL_LZ4_H
@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "util/slab_allocator.h"
+
+bool util::slab_allocator::init(size_t object_size,
+                                int node,
+                                slab_pool* pool)
+{
+  // Round the object size up to a multiple of the alignment (the free
+  // objects store a pointer to the next free object).
+  object_size = (object_size + alignment - 1) & ~(alignment - 1);
+
+  if ((object_size > 0) && (object_size <= max_object_size)) {
+    _M_object_size = object_size;
+    _M_objects_per_slab = (slab_size - header_size) / object_size;
+
+    _M_node = node;
+
+    _M_pool = pool;
+
+    return true;
+  }
+
+  return false;
+}
+
+void util::slab_allocator::clear()
+{
+  node* lists[] = {&_M_partial, &_M_full};
+
+  for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+    while (lists[i]->next != lists[i]) {
+      slab* s = static_cast<slab*>(lists[i]->next);
+
+      unlink(s);
+      free_slab(s);
+    }
+  }
+
+  if (_M_slabs) {
+    ::free(_M_slabs);
+    _M_slabs = nullptr;
+  }
+
+  if (_M_free_ids) {
+    ::free(_M_free_ids);
+    _M_free_ids = nullptr;
+  }
+
+  _M_nfree_ids = 0;
+  _M_nids = 0;
+  _M_capacity = 0;
+
+  _M_count = 0;
+  _M_max_slabs = 0;
+  _M_nempty = 0;
+}
+
+int util::slab_allocator::processor_node(size_t nprocessor)
+{
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%zu", nprocessor);
+
+  // The directory of the processor has an entry "node<number>".
+  DIR* dir;
+  if ((dir = opendir(path)) != nullptr) {
+    int node = -1;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+      if ((strncmp(entry->d_name, "node", 4) == 0) &&
+          (entry->d_name[4] >= '0') &&
+          (entry->d_name[4] <= '9')) {
+        node = atoi(entry->d_name + 4);
+        break;
+      }
+    }
+
+    closedir(dir);
+
+    return node;
+  }
+
+  return -1;
+}
+
+util::slab_allocator::slab* util::slab_allocator::allocate_slab()
+{
+  uint32_t id;
+  if (!allocate_id(id)) {
+    return nullptr;
+  }
+
+  slab* s;
+
+  // Take a free slab of the pool (its field 'huge' is kept).
+  if ((_M_pool) && ((s = static_cast<slab*>(_M_pool->pop())) != nullptr)) {
+    // Reuse slab.
+  } else if ((!_M_pool) || (_M_pool->reserve())) {
+    if ((s = map_slab()) == nullptr) {
+      if (_M_pool) {
+        _M_pool->release();
+      }
+
+      _M_free_ids[_M_nfree_ids++] = id;
+      return nullptr;
+    }
+  } else {
+    // All the slabs of the pool are in use.
+    _M_free_ids[_M_nfree_ids++] = id;
+    return nullptr;
+  }
+
+  s->free = nullptr;
+  s->used = 0;
+  s->untouched = _M_objects_per_slab;
+  s->id = id;
+
+  _M_slabs[id] = s;
+
+  if (++_M_nslabs > _M_max_slabs) {
+    _M_max_slabs = _M_nslabs;
+  }
+
+  if (s->huge) {
+    _M_nhuge++;
+  }
+
+  _M_nempty++;
+
+  return s;
+}
+
+util::slab_allocator::slab* util::slab_allocator::map_slab()
+{
+  void* addr = MAP_FAILED;
+  bool huge = false;
+
+  // Try with reserved huge pages.
+  if (_M_hugetlb) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+
+#ifdef MAP_HUGE_SHIFT
+    // 2 MiB huge pages (the default size might be different).
+    flags |= (21 << MAP_HUGE_SHIFT);
+#endif
+
+    if ((addr = mmap(nullptr,
+                     slab_size,
+                     PROT_READ | PROT_WRITE,
+                     flags,
+                     -1,
+                     0)) != MAP_FAILED) {
+      huge = true;
+    } else {
+      // Don't try again.
+      _M_hugetlb = false;
+    }
+  }
+
+  if (!huge) {
+    // Map twice the size of a slab and keep the aligned part.
+    uint8_t* b;
+    if ((b = static_cast<uint8_t*>(
+               mmap(nullptr,
+                    slab_size << 1,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1,
+                    0)
+             )) == MAP_FAILED) {
+      return nullptr;
+    }
+
+    uint8_t* aligned = reinterpret_cast<uint8_t*>(slab_of(b + slab_size - 1));
+
+    if (aligned > b) {
+      munmap(b, aligned - b);
+    }
+
+    if (aligned + slab_size < b + (slab_size << 1)) {
+      munmap(aligned + slab_size, b + (slab_size << 1) - aligned - slab_size);
+    }
+
+    addr = aligned;
+
+    // Request transparent huge pages.
+    madvise(addr, slab_size, MADV_HUGEPAGE);
+  }
+
+  // If the memory has to be allocated on a specific NUMA node...
+  if ((_M_node >= 0) &&
+      (static_cast<size_t>(_M_node) < sizeof(unsigned long) * 8)) {
+    unsigned long nodemask = 1ul << _M_node;
+
+    // Best effort (the memory has not been touched yet).
+    syscall(SYS_mbind,
+            addr,
+            slab_size,
+            MPOL_PREFERRED,
+            &nodemask,
+            (sizeof(nodemask) * 8) + 1,
+            0);
+  }
+
+  slab* s = static_cast<slab*>(addr);
+  s->huge = huge;
+
+  return s;
+}
+
+bool util::slab_allocator::allocate_id(uint32_t& id)
+{
+  // If there are numbers of slabs which have been freed...
+  if (_M_nfree_ids > 0) {
+    id = _M_free_ids[--_M_nfree_ids];
+    return true;
+  }
+
+  // If there are no more numbers...
+  if (_M_nids == max_slab_ids) {
+    return false;
+  }
+
+  if (_M_nids == _M_capacity) {
+    size_t capacity = (_M_capacity > 0) ? (_M_capacity << 1) : 64;
+
+    slab** slabs;
+    if ((slabs = static_cast<slab**>(
+                   realloc(_M_slabs, capacity * sizeof(slab*))
+                 )) == nullptr) {
+      return false;
+    }
+
+    _M_slabs = slabs;
+
+    uint32_t* ids;
+    if ((ids = static_cast<uint32_t*>(
+                 realloc(_M_free_ids, capacity * sizeof(uint32_t))
+               )) == nullptr) {
+      return false;
+    }
+
+    _M_free_ids = ids;
+
+    _M_capacity = capacity;
+  }
+
+  id = static_cast<uint32_t>(_M_nids++);
+
+  return true;
+}
+
+void util::slab_allocator::free_slab(slab* s)
+{
+  _M_slabs[s->id] = nullptr;
+  _M_free_ids[_M_nfree_ids++] = s->id;
+
+  _M_nslabs--;
+
+  if (s->huge) {
+    _M_nhuge--;
+  }
+
+  // Give the slab back to the pool (if any).
+  if (_M_pool) {
+    _M_pool->push(s);
+  } else {
+    munmap(s, slab_size);
+  }
+}
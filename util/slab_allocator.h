@@ -0,0 +1,393 @@
+#ifndef UTIL_SLAB_ALLOCATOR_H
+#define UTIL_SLAB_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "util/node.h"
+#include "util/slab_pool.h"
+
+namespace util {
+  // Allocator of objects of a fixed size.
+  //
+  // The memory is obtained from the kernel in slabs of 2 MiB aligned to
+  // 2 MiB, backed by huge pages when possible: reserved huge pages
+  // (MAP_HUGETLB) if there are any, otherwise transparent huge pages are
+  // requested with madvise(). Every slab has its own list of free objects,
+  // the objects are allocated from the partially used slabs and the slabs
+  // which become completely free are returned to the kernel (but one).
+  //
+  // The objects can also be referenced by 32-bit indices: the number of
+  // the slab (14 bits) and the offset of the object in the slab in units
+  // of 8 bytes (18 bits), so there can be up to 16383 slabs (almost
+  // 32 GiB) and the indices are lower than 'max_index'.
+  //
+  // Optionally, the slabs are taken from a pool shared with the allocators
+  // of the other workers (see 'slab_pool'), which limits the number of
+  // slabs of all of them; the slabs which become completely free are then
+  // given back to the pool instead of the kernel.
+  //
+  // The allocator is not thread-safe, each worker has its own allocators.
+  class slab_allocator {
+    public:
+      // Size of a slab.
+      static constexpr const size_t slab_size = static_cast<size_t>(2) << 20;
+
+      // Maximum size of an object.
+      static constexpr const size_t max_object_size = slab_size / 16;
+
+      // Number of bits of the index for the offset of the object.
+      static constexpr const unsigned offset_bits = 18;
+
+      // Maximum number of slabs.
+      static constexpr const size_t
+             max_slab_ids = (static_cast<size_t>(1) << (32 - offset_bits)) - 1;
+
+      // Maximum index (exclusive).
+      static constexpr const uint32_t
+             max_index = static_cast<uint32_t>(max_slab_ids << offset_bits);
+
+      // Constructor.
+      slab_allocator();
+
+      // Destructor.
+      ~slab_allocator();
+
+      // Initialize.
+      // 'node': NUMA node where to allocate the memory (-1: the memory is
+      // allocated on the node of the thread which uses it first; the slabs
+      // taken from the pool might be on any node).
+      // 'pool': pool of slabs (nullptr: the slabs are mapped and unmapped
+      // by the allocator).
+      bool init(size_t object_size, int node, slab_pool* pool = nullptr);
+
+      // Free all the objects and return the slabs to the kernel.
+      void clear();
+
+      // Allocate object (returns nullptr if there is no memory).
+      void* allocate();
+
+      // Free object.
+      void free(void* obj);
+
+      // Get the index of an object.
+      uint32_t index(const void* obj) const;
+
+      // Get the object with the index 'idx'.
+      void* object(uint32_t idx) const;
+
+      // Get number of objects allocated.
+      size_t count() const;
+
+      // Get number of slabs.
+      size_t slabs() const;
+
+      // Get number of slabs backed by reserved huge pages.
+      size_t huge_slabs() const;
+
+      // Get maximum number of slabs.
+      size_t max_slabs() const;
+
+      // Get memory used (bytes).
+      size_t memory() const;
+
+      // Get maximum memory used (bytes).
+      size_t max_memory() const;
+
+      // Get the NUMA node of a processor (-1 if unknown).
+      static int processor_node(size_t nprocessor);
+
+    private:
+      // First word of the slab, reserved for the pool (it links the free
+      // slabs of the pool and might be read by another thread after the
+      // slab has been taken from the pool).
+      struct pool_link {
+        uintptr_t link;
+      };
+
+      // Slab header (at the beginning of the slab).
+      struct slab : public pool_link, public node {
+        // Free objects.
+        void* free;
+
+        // Number of objects allocated.
+        size_t used;
+
+        // Number of objects which have never been allocated (they are after
+        // the allocated / free ones).
+        size_t untouched;
+
+        // Number of the slab.
+        uint32_t id;
+
+        // Reserved huge page?
+        bool huge;
+      };
+
+      // Offset of the first object.
+      static constexpr const size_t header_size = 64;
+
+      // Alignment of the objects (the offsets in the indices are in these
+      // units).
+      static constexpr const size_t alignment = 8;
+
+      static_assert((slab_size / alignment) ==
+                    (static_cast<size_t>(1) << offset_bits),
+                    "Wrong number of bits for the offset.");
+      static_assert(sizeof(slab) <= header_size, "Slab header too big.");
+      static_assert(slab_size == slab_pool::slab_size,
+                    "Different size of the slabs of the pool.");
+
+      // Size of the objects.
+      size_t _M_object_size = 0;
+
+      // Number of objects per slab.
+      size_t _M_objects_per_slab = 0;
+
+      // Slabs by number.
+      slab** _M_slabs = nullptr;
+
+      // Numbers of the slabs which have been freed.
+      uint32_t* _M_free_ids = nullptr;
+      size_t _M_nfree_ids = 0;
+
+      // Number of slab numbers assigned.
+      size_t _M_nids = 0;
+
+      // Size of '_M_slabs' and '_M_free_ids'.
+      size_t _M_capacity = 0;
+
+      // NUMA node.
+      int _M_node = -1;
+
+      // Slabs with free objects (the objects are allocated from the first
+      // one).
+      node _M_partial;
+
+      // Full slabs.
+      node _M_full;
+
+      // Number of objects allocated.
+      size_t _M_count = 0;
+
+      // Number of slabs.
+      size_t _M_nslabs = 0;
+
+      // Number of slabs backed by reserved huge pages.
+      size_t _M_nhuge = 0;
+
+      // Maximum number of slabs.
+      size_t _M_max_slabs = 0;
+
+      // Number of completely free slabs.
+      size_t _M_nempty = 0;
+
+      // Try to use reserved huge pages?
+      bool _M_hugetlb = true;
+
+      // Pool of slabs (if any).
+      slab_pool* _M_pool = nullptr;
+
+      // Allocate slab.
+      slab* allocate_slab();
+
+      // Map a new slab.
+      slab* map_slab();
+
+      // Get a number for a new slab (false if there are no more numbers).
+      bool allocate_id(uint32_t& id);
+
+      // Free slab.
+      void free_slab(slab* s);
+
+      // Get the slab of an object.
+      static slab* slab_of(const void* obj);
+
+      // Initialize list.
+      static void init(node* header);
+
+      // Unlink slab.
+      static void unlink(slab* s);
+
+      // Add slab at the beginning of the list.
+      static void push_front(node* header, slab* s);
+
+      // Add slab at the end of the list.
+      static void push_back(node* header, slab* s);
+
+      // Disable copy constructor and assignment operator.
+      slab_allocator(const slab_allocator&) = delete;
+      slab_allocator& operator=(const slab_allocator&) = delete;
+  };
+
+  inline slab_allocator::slab_allocator()
+  {
+    init(&_M_partial);
+    init(&_M_full);
+  }
+
+  inline slab_allocator::~slab_allocator()
+  {
+    clear();
+  }
+
+  inline void* slab_allocator::allocate()
+  {
+    slab* s;
+
+    // If there are no slabs with free objects...
+    if (_M_partial.next == &_M_partial) {
+      if ((s = allocate_slab()) == nullptr) {
+        return nullptr;
+      }
+
+      push_front(&_M_partial, s);
+    } else {
+      s = static_cast<slab*>(_M_partial.next);
+    }
+
+    void* obj;
+
+    // If there are free objects...
+    if (s->free) {
+      obj = s->free;
+      s->free = *static_cast<void**>(obj);
+    } else {
+      obj = reinterpret_cast<uint8_t*>(s) +
+            header_size +
+            ((_M_objects_per_slab - s->untouched) * _M_object_size);
+
+      s->untouched--;
+    }
+
+    // If the slab was empty...
+    if (s->used++ == 0) {
+      _M_nempty--;
+    }
+
+    // If the slab is full...
+    if ((!s->free) && (s->untouched == 0)) {
+      unlink(s);
+      push_front(&_M_full, s);
+    }
+
+    _M_count++;
+
+    return obj;
+  }
+
+  inline void slab_allocator::free(void* obj)
+  {
+    slab* s = slab_of(obj);
+
+    // If the slab was full...
+    if ((!s->free) && (s->untouched == 0)) {
+      // Allocate from the other partially used slabs first.
+      unlink(s);
+      push_back(&_M_partial, s);
+    }
+
+    *static_cast<void**>(obj) = s->free;
+    s->free = obj;
+
+    _M_count--;
+
+    // If the slab is completely free...
+    if (--s->used == 0) {
+      // Keep one completely free slab (unless the slabs are shared with
+      // other allocators).
+      if ((_M_pool) || (_M_nempty > 0)) {
+        unlink(s);
+        free_slab(s);
+      } else {
+        _M_nempty++;
+      }
+    }
+  }
+
+  inline uint32_t slab_allocator::index(const void* obj) const
+  {
+    const slab* s = slab_of(obj);
+
+    return (s->id << offset_bits) |
+           static_cast<uint32_t>((static_cast<const uint8_t*>(obj) -
+                                  reinterpret_cast<const uint8_t*>(s)) /
+                                 alignment);
+  }
+
+  inline void* slab_allocator::object(uint32_t idx) const
+  {
+    static constexpr const uint32_t
+           offset_mask = (static_cast<uint32_t>(1) << offset_bits) - 1;
+
+    return reinterpret_cast<uint8_t*>(_M_slabs[idx >> offset_bits]) +
+           ((idx & offset_mask) * alignment);
+  }
+
+  inline size_t slab_allocator::count() const
+  {
+    return _M_count;
+  }
+
+  inline size_t slab_allocator::slabs() const
+  {
+    return _M_nslabs;
+  }
+
+  inline size_t slab_allocator::huge_slabs() const
+  {
+    return _M_nhuge;
+  }
+
+  inline size_t slab_allocator::max_slabs() const
+  {
+    return _M_max_slabs;
+  }
+
+  inline size_t slab_allocator::memory() const
+  {
+    return _M_nslabs * slab_size;
+  }
+
+  inline size_t slab_allocator::max_memory() const
+  {
+    return _M_max_slabs * slab_size;
+  }
+
+  inline slab_allocator::slab* slab_allocator::slab_of(const void* obj)
+  {
+    return reinterpret_cast<slab*>(reinterpret_cast<uintptr_t>(obj) &
+                                   ~(static_cast<uintptr_t>(slab_size) - 1));
+  }
+
+  inline void slab_allocator::init(node* header)
+  {
+    header->prev = header;
+    header->next = header;
+  }
+
+  inline void slab_allocator::unlink(slab* s)
+  {
+    s->prev->next = s->next;
+    s->next->prev = s->prev;
+  }
+
+  inline void slab_allocator::push_front(node* header, slab* s)
+  {
+    s->prev = header;
+    s->next = header->next;
+
+    header->next->prev = s;
+    header->next = s;
+  }
+
+  inline void slab_allocator::push_back(node* header, slab* s)
+  {
+    s->prev = header->prev;
+    s->next = header;
+
+    header->prev->next = s;
+    header->prev = s;
+  }
+}
+
+#endif // UTIL_SLAB_ALLOCATOR_H
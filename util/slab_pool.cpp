@@ -0,0 +1,27 @@
+#include <sys/mman.h>
+#include "util/slab_pool.h"
+
+void util::slab_pool::clear()
+{
+  void* slab;
+  while ((slab = pop()) != nullptr) {
+    munmap(slab, slab_size);
+  }
+
+  _M_top = 0;
+  _M_nfree = 0;
+  _M_available = 0;
+  _M_max_slabs = 0;
+}
+
+bool util::slab_pool::init(size_t max_slabs)
+{
+  if (max_slabs > 0) {
+    _M_available = max_slabs;
+    _M_max_slabs = max_slabs;
+
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,176 @@
+#ifndef UTIL_SLAB_POOL_H
+#define UTIL_SLAB_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace util {
+  // Pool of free slabs shared by several slab allocators (one per worker).
+  //
+  // The pool limits the number of slabs of all its allocators (the
+  // budget) and keeps the slabs which become completely free: an allocator
+  // takes a free slab from the pool before mapping a new one, so the
+  // memory freed by a worker can be used by any other worker and the
+  // allocations only fail when all the slabs of the budget are in use.
+  //
+  // The free slabs are kept in a lock-free stack. The slabs are aligned to
+  // their size, so the lowest bits of the top of the stack hold a counter
+  // which changes on every operation (otherwise a slab could be taken and
+  // put back between the read of the top and the compare-and-swap). The
+  // first word of a free slab points to the next one; the slabs are only
+  // returned to the kernel when the pool is cleared, so a thread can read
+  // the first word of a slab which has just been taken by another thread
+  // (the allocators don't write it).
+  class slab_pool {
+    public:
+      // Size (and alignment) of the slabs.
+      static constexpr const size_t slab_size = static_cast<size_t>(2) << 20;
+
+      // Constructor.
+      slab_pool() = default;
+
+      // Destructor.
+      ~slab_pool();
+
+      // Return the free slabs to the kernel (the allocators must have been
+      // cleared).
+      void clear();
+
+      // Initialize.
+      // 'max_slabs': maximum number of slabs of all the allocators.
+      bool init(size_t max_slabs);
+
+      // Reserve a slab of the budget for mapping a new slab (returns false
+      // if all the slabs of the budget are mapped).
+      bool reserve();
+
+      // Release a slab of the budget (the new slab couldn't be mapped).
+      void release();
+
+      // Take a free slab (returns nullptr if there are none).
+      void* pop();
+
+      // Put a free slab.
+      void push(void* slab);
+
+      // Get the maximum number of slabs.
+      size_t max_slabs() const;
+
+      // Get the number of slabs mapped.
+      size_t slabs() const;
+
+      // Get the number of free slabs.
+      size_t free_slabs() const;
+
+    private:
+      // Mask of the counter of the top of the stack.
+      static constexpr const uintptr_t
+             counter_mask = static_cast<uintptr_t>(slab_size) - 1;
+
+      // Top of the stack (address of the first free slab | counter).
+      uintptr_t _M_top = 0;
+
+      // Number of free slabs.
+      size_t _M_nfree = 0;
+
+      // Number of slabs of the budget which have not been mapped.
+      size_t _M_available = 0;
+
+      // Maximum number of slabs.
+      size_t _M_max_slabs = 0;
+
+      // Disable copy constructor and assignment operator.
+      slab_pool(const slab_pool&) = delete;
+      slab_pool& operator=(const slab_pool&) = delete;
+  };
+
+  inline slab_pool::~slab_pool()
+  {
+    clear();
+  }
+
+  inline bool slab_pool::reserve()
+  {
+    size_t available = __atomic_load_n(&_M_available, __ATOMIC_RELAXED);
+
+    do {
+      if (available == 0) {
+        return false;
+      }
+    } while (!__atomic_compare_exchange_n(&_M_available,
+                                          &available,
+                                          available - 1,
+                                          true,
+                                          __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+
+    return true;
+  }
+
+  inline void slab_pool::release()
+  {
+    __atomic_fetch_add(&_M_available, 1, __ATOMIC_RELAXED);
+  }
+
+  inline void* slab_pool::pop()
+  {
+    uintptr_t top = __atomic_load_n(&_M_top, __ATOMIC_ACQUIRE);
+    uintptr_t next;
+
+    do {
+      uintptr_t* slab = reinterpret_cast<uintptr_t*>(top & ~counter_mask);
+
+      // If there are no free slabs...
+      if (!slab) {
+        return nullptr;
+      }
+
+      next = __atomic_load_n(slab, __ATOMIC_RELAXED) |
+             ((top + 1) & counter_mask);
+    } while (!__atomic_compare_exchange_n(&_M_top,
+                                          &top,
+                                          next,
+                                          true,
+                                          __ATOMIC_ACQUIRE,
+                                          __ATOMIC_ACQUIRE));
+
+    __atomic_fetch_sub(&_M_nfree, 1, __ATOMIC_RELAXED);
+
+    return reinterpret_cast<void*>(top & ~counter_mask);
+  }
+
+  inline void slab_pool::push(void* slab)
+  {
+    uintptr_t top = __atomic_load_n(&_M_top, __ATOMIC_RELAXED);
+    uintptr_t* first = static_cast<uintptr_t*>(slab);
+
+    do {
+      __atomic_store_n(first, top & ~counter_mask, __ATOMIC_RELAXED);
+    } while (!__atomic_compare_exchange_n(&_M_top,
+                                          &top,
+                                          reinterpret_cast<uintptr_t>(slab) |
+                                          ((top + 1) & counter_mask),
+                                          true,
+                                          __ATOMIC_RELEASE,
+                                          __ATOMIC_RELAXED));
+
+    __atomic_fetch_add(&_M_nfree, 1, __ATOMIC_RELAXED);
+  }
+
+  inline size_t slab_pool::max_slabs() const
+  {
+    return _M_max_slabs;
+  }
+
+  inline size_t slab_pool::slabs() const
+  {
+    return _M_max_slabs - __atomic_load_n(&_M_available, __ATOMIC_RELAXED);
+  }
+
+  inline size_t slab_pool::free_slabs() const
+  {
+    return __atomic_load_n(&_M_nfree, __ATOMIC_RELAXED);
+  }
+}
+
+#endif // UTIL_SLAB_POOL_H
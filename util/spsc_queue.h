@@ -0,0 +1,176 @@
+#ifndef UTIL_SPSC_QUEUE_H
+#define UTIL_SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+
+namespace util {
+  // Bounded lock-free single-producer / single-consumer queue.
+  template<typename T>
+  class spsc_queue {
+    public:
+      static constexpr const size_t min_size = 2;
+      static constexpr const size_t max_size = static_cast<size_t>(1) << 30;
+
+      // Constructor.
+      spsc_queue() = default;
+
+      // Destructor.
+      ~spsc_queue();
+
+      // Initialize ('size' must be a power of 2).
+      bool init(size_t size);
+
+      // Get free slot at the back of the queue (producer).
+      // Returns nullptr if the queue is full.
+      T* back();
+
+      // Make the slot returned by back() visible to the consumer (producer).
+      void push();
+
+      // Get element at the front of the queue (consumer).
+      // Returns nullptr if the queue is empty.
+      T* front();
+
+      // Remove the element at the front of the queue (consumer).
+      void pop();
+
+      // Empty?
+      bool empty() const;
+
+      // Get number of elements in the queue (approximate when called while
+      // the queue is being used).
+      size_t count() const;
+
+      // Get size of the queue.
+      size_t size() const;
+
+      // Get number of elements pushed since the queue was initialized
+      // (producer).
+      size_t pushed() const;
+
+      // Get number of elements popped since the queue was initialized.
+      size_t popped() const;
+
+    private:
+      static constexpr const size_t cache_line_size = 64;
+
+      // Elements.
+      T* _M_elements = nullptr;
+
+      // Size - 1.
+      size_t _M_mask;
+
+      // Producer's index and copy of the consumer's index (only accessed by
+      // the producer).
+      alignas(cache_line_size) size_t _M_tail = 0;
+      size_t _M_head_cache = 0;
+
+      // Consumer's index and copy of the producer's index (only accessed by
+      // the consumer).
+      alignas(cache_line_size) size_t _M_head = 0;
+      size_t _M_tail_cache = 0;
+
+      // Disable copy constructor and assignment operator.
+      spsc_queue(const spsc_queue&) = delete;
+      spsc_queue& operator=(const spsc_queue&) = delete;
+  };
+
+  template<typename T>
+  inline spsc_queue<T>::~spsc_queue()
+  {
+    if (_M_elements) {
+      delete [] _M_elements;
+    }
+  }
+
+  template<typename T>
+  inline bool spsc_queue<T>::init(size_t size)
+  {
+    if ((size >= min_size) &&
+        (size <= max_size) &&
+        ((size & (size - 1)) == 0) &&
+        ((_M_elements = new (std::nothrow) T[size]) != nullptr)) {
+      _M_mask = size - 1;
+      return true;
+    }
+
+    return false;
+  }
+
+  template<typename T>
+  inline T* spsc_queue<T>::back()
+  {
+    if (_M_tail - _M_head_cache > _M_mask) {
+      _M_head_cache = __atomic_load_n(&_M_head, __ATOMIC_ACQUIRE);
+
+      if (_M_tail - _M_head_cache > _M_mask) {
+        return nullptr;
+      }
+    }
+
+    return &_M_elements[_M_tail & _M_mask];
+  }
+
+  template<typename T>
+  inline void spsc_queue<T>::push()
+  {
+    __atomic_store_n(&_M_tail, _M_tail + 1, __ATOMIC_RELEASE);
+  }
+
+  template<typename T>
+  inline T* spsc_queue<T>::front()
+  {
+    if (_M_head == _M_tail_cache) {
+      _M_tail_cache = __atomic_load_n(&_M_tail, __ATOMIC_ACQUIRE);
+
+      if (_M_head == _M_tail_cache) {
+        return nullptr;
+      }
+    }
+
+    return &_M_elements[_M_head & _M_mask];
+  }
+
+  template<typename T>
+  inline void spsc_queue<T>::pop()
+  {
+    __atomic_store_n(&_M_head, _M_head + 1, __ATOMIC_RELEASE);
+  }
+
+  template<typename T>
+  inline bool spsc_queue<T>::empty() const
+  {
+    return (count() == 0);
+  }
+
+  template<typename T>
+  inline size_t spsc_queue<T>::count() const
+  {
+    // Load the consumer's index first (the producer's index cannot be
+    // smaller).
+    size_t head = __atomic_load_n(&_M_head, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&_M_tail, __ATOMIC_ACQUIRE) - head;
+  }
+
+  template<typename T>
+  inline size_t spsc_queue<T>::size() const
+  {
+    return _M_mask + 1;
+  }
+
+  template<typename T>
+  inline size_t spsc_queue<T>::pushed() const
+  {
+    return _M_tail;
+  }
+
+  template<typename T>
+  inline size_t spsc_queue<T>::popped() const
+  {
+    return __atomic_load_n(&_M_head, __ATOMIC_ACQUIRE);
+  }
+}
+
+#endif // UTIL_SPSC_QUEUE_H
@@ -0,0 +1,329 @@
+#ifndef UTIL_TIMER_WHEEL_H
+#define UTIL_TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "util/slab_allocator.h"
+
+namespace util {
+  // Timer of a timing wheel.
+  struct timer {
+    // Links (indices).
+    uint32_t prev;
+    uint32_t next;
+
+    // Expiration (lowest 32 bits of the tick).
+    uint32_t expires;
+  };
+
+  // Hierarchical timing wheel.
+  //
+  // The first level has 256 slots of one tick, the next levels have 64
+  // slots of 256, 16384 and 1048576 ticks. When the current tick reaches
+  // the range of a slot of a higher level, its timers are moved to the
+  // lower levels (cascade), so adding and removing a timer is O(1) and
+  // advancing the wheel only touches the expired timers.
+  //
+  // The timers are intrusive: the objects to expire are allocated from a
+  // 'slab_allocator' and have a public member 'timer', the timers are
+  // linked by the indices of the objects.
+  template<typename Object>
+  class timer_wheel {
+    public:
+      // No timer.
+      static constexpr const uint32_t none = UINT32_MAX;
+
+      // Constructor.
+      timer_wheel(const slab_allocator& allocator);
+
+      // Destructor.
+      ~timer_wheel() = default;
+
+      // Clear (the timers are not touched).
+      void clear();
+
+      // Empty?
+      bool empty() const;
+
+      // Get number of timers.
+      size_t count() const;
+
+      // Set current tick (only if the wheel is empty).
+      void reset(uint64_t now);
+
+      // Add the timer of the object 'idx' (the timer must not be in the
+      // wheel).
+      // Timers which have already expired are added to the current slot.
+      void add(uint32_t idx, uint64_t expires);
+
+      // Remove the timer of the object 'idx'.
+      void remove(uint32_t idx);
+
+      // Change the expiration of a timer which is in the wheel.
+      void modify(uint32_t idx, uint64_t expires);
+
+      // Get the index of an object whose timer has expired ('none' if
+      // there are no timers which expire at or before 'now').
+      // The timer stays in the wheel, the caller has to either remove it or
+      // modify its expiration.
+      uint32_t expired(uint64_t now);
+
+    private:
+      static constexpr const unsigned root_bits = 8;
+      static constexpr const unsigned level_bits = 6;
+
+      static constexpr const size_t root_size =
+             static_cast<size_t>(1) << root_bits;
+
+      static constexpr const size_t level_size =
+             static_cast<size_t>(1) << level_bits;
+
+      static constexpr const uint64_t root_mask = root_size - 1;
+      static constexpr const uint64_t level_mask = level_size - 1;
+
+      // Number of levels (besides the first one).
+      static constexpr const size_t levels = 3;
+
+      // Number of slots.
+      static constexpr const size_t slots = root_size + (levels * level_size);
+
+      // Index of the first slot (the slots are the headers of the lists of
+      // timers, their indices are above the indices of the objects).
+      static constexpr const uint32_t first_slot = slab_allocator::max_index;
+
+      // Maximum number of ticks a timer can be scheduled ahead (timers
+      // scheduled further expire earlier).
+      static constexpr const uint64_t
+             max_ticks = (static_cast<uint64_t>(1) <<
+                          (root_bits + (levels * level_bits))) - 1;
+
+      // Allocator of the objects.
+      const slab_allocator& _M_allocator;
+
+      // Slots: first level and next levels.
+      timer _M_slots[slots];
+
+      // Current tick.
+      uint64_t _M_current = 0;
+
+      // Number of timers.
+      size_t _M_count = 0;
+
+      // Get timer.
+      timer* get(uint32_t idx);
+
+      // Link timer to its slot.
+      void link(uint32_t idx);
+
+      // Move the timers of the slot 'idx' of the level 'level' to the lower
+      // levels.
+      void cascade(size_t level, size_t idx);
+
+      // Unlink timer.
+      void unlink(uint32_t idx);
+
+      // Disable copy constructor and assignment operator.
+      timer_wheel(const timer_wheel&) = delete;
+      timer_wheel& operator=(const timer_wheel&) = delete;
+  };
+
+  template<typename Object>
+  inline timer_wheel<Object>::timer_wheel(const slab_allocator& allocator)
+    : _M_allocator(allocator)
+  {
+    clear();
+  }
+
+  template<typename Object>
+  void timer_wheel<Object>::clear()
+  {
+    for (size_t i = 0; i < slots; i++) {
+      _M_slots[i].prev = first_slot + static_cast<uint32_t>(i);
+      _M_slots[i].next = first_slot + static_cast<uint32_t>(i);
+    }
+
+    _M_current = 0;
+    _M_count = 0;
+  }
+
+  template<typename Object>
+  inline bool timer_wheel<Object>::empty() const
+  {
+    return (_M_count == 0);
+  }
+
+  template<typename Object>
+  inline size_t timer_wheel<Object>::count() const
+  {
+    return _M_count;
+  }
+
+  template<typename Object>
+  inline void timer_wheel<Object>::reset(uint64_t now)
+  {
+    if (_M_count == 0) {
+      _M_current = now;
+    }
+  }
+
+  template<typename Object>
+  inline void timer_wheel<Object>::add(uint32_t idx, uint64_t expires)
+  {
+    get(idx)->expires = static_cast<uint32_t>(expires);
+    link(idx);
+
+    _M_count++;
+  }
+
+  template<typename Object>
+  inline void timer_wheel<Object>::remove(uint32_t idx)
+  {
+    unlink(idx);
+
+    _M_count--;
+  }
+
+  template<typename Object>
+  inline void timer_wheel<Object>::modify(uint32_t idx, uint64_t expires)
+  {
+    unlink(idx);
+
+    get(idx)->expires = static_cast<uint32_t>(expires);
+    link(idx);
+  }
+
+  template<typename Object>
+  uint32_t timer_wheel<Object>::expired(uint64_t now)
+  {
+    do {
+      // If there are no timers...
+      if (_M_count == 0) {
+        if (now > _M_current) {
+          _M_current = now;
+        }
+
+        return none;
+      }
+
+      const size_t slot = static_cast<size_t>(_M_current & root_mask);
+
+      // If there are timers in the current slot...
+      if (_M_slots[slot].next != first_slot + static_cast<uint32_t>(slot)) {
+        return _M_slots[slot].next;
+      }
+
+      if (_M_current >= now) {
+        return none;
+      }
+
+      // Next tick.
+      _M_current++;
+
+      // If the first level has wrapped around...
+      if ((_M_current & root_mask) == 0) {
+        uint64_t n = _M_current >> root_bits;
+
+        for (size_t level = 0; level < levels; level++) {
+          size_t idx = static_cast<size_t>(n & level_mask);
+
+          cascade(level, idx);
+
+          // If this level has not wrapped around...
+          if (idx != 0) {
+            break;
+          }
+
+          n >>= level_bits;
+        }
+      }
+    } while (true);
+  }
+
+  template<typename Object>
+  inline timer* timer_wheel<Object>::get(uint32_t idx)
+  {
+    return (idx >= first_slot) ?
+             &_M_slots[idx - first_slot] :
+             &static_cast<Object*>(_M_allocator.object(idx))->timer;
+  }
+
+  template<typename Object>
+  void timer_wheel<Object>::link(uint32_t idx)
+  {
+    timer* t = get(idx);
+
+    // Ticks until the expiration (the expiration only has the lowest 32
+    // bits, but it is never further than 'max_ticks').
+    int64_t delta = static_cast<int32_t>(
+                      t->expires - static_cast<uint32_t>(_M_current)
+                    );
+
+    size_t slot;
+
+    // If the timer has already expired...
+    if (delta <= 0) {
+      slot = static_cast<size_t>(_M_current & root_mask);
+    } else if (static_cast<uint64_t>(delta) < root_size) {
+      slot = t->expires & root_mask;
+    } else {
+      if (static_cast<uint64_t>(delta) > max_ticks) {
+        delta = max_ticks;
+        t->expires = static_cast<uint32_t>(_M_current + max_ticks);
+      }
+
+      const uint64_t expires = _M_current + delta;
+
+      // Search level.
+      size_t level = 0;
+      unsigned shift = root_bits;
+      while (static_cast<uint64_t>(delta) >> (shift + level_bits)) {
+        level++;
+        shift += level_bits;
+      }
+
+      slot = root_size +
+             (level * level_size) +
+             static_cast<size_t>((expires >> shift) & level_mask);
+    }
+
+    timer* header = &_M_slots[slot];
+
+    // Add timer at the end of the slot.
+    t->prev = header->prev;
+    t->next = first_slot + static_cast<uint32_t>(slot);
+
+    get(header->prev)->next = idx;
+    header->prev = idx;
+  }
+
+  template<typename Object>
+  void timer_wheel<Object>::cascade(size_t level, size_t idx)
+  {
+    const size_t slot = root_size + (level * level_size) + idx;
+    const uint32_t header = first_slot + static_cast<uint32_t>(slot);
+
+    uint32_t t = _M_slots[slot].next;
+
+    _M_slots[slot].prev = header;
+    _M_slots[slot].next = header;
+
+    while (t != header) {
+      uint32_t next = get(t)->next;
+
+      link(t);
+
+      t = next;
+    }
+  }
+
+  template<typename Object>
+  inline void timer_wheel<Object>::unlink(uint32_t idx)
+  {
+    timer* t = get(idx);
+
+    get(t->prev)->next = t->next;
+    get(t->next)->prev = t->prev;
+  }
+}
+
+#endif // UTIL_TIMER_WHEEL_H